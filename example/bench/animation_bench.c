@@ -0,0 +1,181 @@
+/**
+ * Animation benchmark.
+ *
+ * Advances 10,000 animated sprites for a number of updates, first
+ * with one animate schedule per sprite walking the schedule list, then
+ * with the animator pass used by fl_update, and prints the time per
+ * update for each.
+ *
+ * No window or renderer is created, so this can run headless.
+ */
+#include <stdio.h>
+
+#include "core/flurmp_impl.h"
+#include "core/animation.h"
+#include "core/schedule.h"
+
+#define SPRITE_COUNT 10000
+#define UPDATE_COUNT 1000
+#define ANIMATION_COUNT 4
+
+/**
+ * The schedule based animation that the animator pass replaced.
+ * Each frame of the animation is shown for 4 updates.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_schedule - a schedule
+ *   fl_entity - an entity
+ */
+static void animate(fl_context* context, fl_schedule* w, fl_entity* en)
+{
+	fl_animation* a = context->entity_types[0].animations[en->type];
+
+	if (w->counter / 4 >= a->frame_count)
+		w->counter = 0;
+
+	en->frame = &(a->frames[w->counter / 4]);
+
+	w->counter++;
+}
+
+/**
+ * Gets the elapsed time in milliseconds since a performance counter value.
+ *
+ * Params:
+ *   Uint64 - a performance counter value
+ *
+ * Returns:
+ *   double - the elapsed time in milliseconds
+ */
+static double elapsed_ms(Uint64 start)
+{
+	return (double)(SDL_GetPerformanceCounter() - start) * 1000.0
+		/ (double)SDL_GetPerformanceFrequency();
+}
+
+int main(int argc, char** argv)
+{
+	int i, j;
+	Uint64 start;
+	double ms;
+	unsigned long checksum;
+
+	fl_context* context;
+	fl_entity_type type;
+	fl_animation* animations[ANIMATION_COUNT];
+	fl_entity* sprites;
+	fl_schedule* schedules;
+
+	/* Only the parts of the context used by animation are populated. */
+	context = fl_alloc(fl_context, 1);
+	sprites = fl_alloc(fl_entity, SPRITE_COUNT);
+	schedules = fl_alloc(fl_schedule, SPRITE_COUNT);
+
+	if (context == NULL || sprites == NULL || schedules == NULL)
+	{
+		fprintf(stderr, "allocation failure\n");
+		return 1;
+	}
+
+	context->animators.items = NULL;
+	context->animators.count = 0;
+	context->animators.capacity = 0;
+	context->schedules = NULL;
+	context->entity_types = &type;
+
+	/* Animations of different lengths, 4 updates per frame. */
+	for (i = 0; i < ANIMATION_COUNT; i++)
+	{
+		animations[i] = fl_create_animation(i + 2);
+
+		if (animations[i] == NULL)
+		{
+			fprintf(stderr, "allocation failure\n");
+			return 1;
+		}
+
+		for (j = 0; j < i + 2; j++)
+			fl_set_animation_frame(animations[i], j, j * 50, 0, 50, 50, 4);
+	}
+
+	type.animations = animations;
+	type.animation_count = ANIMATION_COUNT;
+
+	/* The entity type field selects the animation in the schedule benchmark. */
+	for (i = 0; i < SPRITE_COUNT; i++)
+	{
+		sprites[i].type = i % ANIMATION_COUNT;
+		sprites[i].frame = NULL;
+		sprites[i].animator = -1;
+		sprites[i].body = -1;
+	}
+
+	/* Schedules: one list node per sprite. */
+	for (i = 0; i < SPRITE_COUNT; i++)
+	{
+		schedules[i].action = animate;
+		schedules[i].counter = 0;
+		schedules[i].limit = -1;
+		schedules[i].done = 0;
+		schedules[i].target.index = i;
+		schedules[i].target.generation = 1;
+		schedules[i].prev = i > 0 ? &(schedules[i - 1]) : NULL;
+		schedules[i].next = i < SPRITE_COUNT - 1 ? &(schedules[i + 1]) : NULL;
+	}
+
+	context->schedules = schedules;
+
+	start = SDL_GetPerformanceCounter();
+
+	for (i = 0; i < UPDATE_COUNT; i++)
+	{
+		fl_schedule* w;
+
+		for (w = context->schedules; w != NULL; w = w->next)
+			w->action(context, w, &(sprites[w->target.index]));
+	}
+
+	ms = elapsed_ms(start);
+
+	for (i = 0, checksum = 0; i < SPRITE_COUNT; i++)
+		checksum += sprites[i].frame->x;
+
+	printf("schedules: %d sprites, %d updates, %.4f ms/update (checksum %lu)\n",
+		SPRITE_COUNT, UPDATE_COUNT, ms / UPDATE_COUNT, checksum);
+
+	/* Animators: one contiguous pass. */
+	for (i = 0; i < SPRITE_COUNT; i++)
+	{
+		if (!fl_add_animator(context, &(sprites[i]), animations[i % ANIMATION_COUNT]))
+		{
+			fprintf(stderr, "allocation failure\n");
+			return 1;
+		}
+	}
+
+	start = SDL_GetPerformanceCounter();
+
+	for (i = 0; i < UPDATE_COUNT; i++)
+		fl_update_animations(context);
+
+	ms = elapsed_ms(start);
+
+	for (i = 0, checksum = 0; i < SPRITE_COUNT; i++)
+		checksum += sprites[i].frame->x;
+
+	printf("animators: %d sprites, %d updates, %.4f ms/update (checksum %lu)\n",
+		SPRITE_COUNT, UPDATE_COUNT, ms / UPDATE_COUNT, checksum);
+
+	/* cleanup */
+	fl_destroy_animators(context);
+
+	for (i = 0; i < ANIMATION_COUNT; i++)
+		fl_destroy_animation(animations[i]);
+
+	fl_free(schedules);
+	fl_free(sprites);
+	fl_free(context);
+
+	return 0;
+}
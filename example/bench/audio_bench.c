@@ -0,0 +1,213 @@
+/**
+ * Audio benchmark.
+ *
+ * Plays the sound effects through SDL's dummy or disk audio driver,
+ * which need no sound card, while a game loop fires play, volume and
+ * stop commands at the mixer every frame. It measures what queueing a
+ * command costs the game thread, which must never wait for the audio
+ * thread, and how long the audio thread takes to mix each buffer
+ * compared to the time the buffer lasts. The results are written to
+ * stdout as one row of CSV and printed to stderr.
+ *
+ * Usage:
+ *   audio_bench [-driver dummy|disk] [-frames N] [-commands N] [-output path]
+ *
+ * The disk driver writes what was mixed to the output file as raw
+ * 16-bit stereo samples at 44100 Hz, whose peak is reported so that a
+ * silent mix shows up. Run the benchmark from the example directory.
+ */
+#include <stdio.h>
+
+#include "flurmp.h"
+#include "core/flurmp_impl.h"
+#include "core/audio.h"
+
+#define DEFAULT_FRAMES   300
+#define DEFAULT_COMMANDS 32
+#define DEFAULT_OUTPUT   "audio_bench.raw"
+
+/* voices the game loop remembers, to change and stop them later */
+#define RECENT_VOICES 8
+
+/**
+ * Converts performance counter ticks into microseconds.
+ *
+ * Params:
+ *   double - a number of ticks
+ *
+ * Returns:
+ *   double - the number of microseconds
+ */
+static double ticks_us(double ticks)
+{
+	return ticks * 1000000.0 / (double)fl_get_performance_frequency();
+}
+
+/**
+ * Finds the loudest sample in a file of raw 16-bit samples.
+ *
+ * Params:
+ *   const char* - the path to the file
+ *
+ * Returns:
+ *   int - the peak, from 0 to 32768, or -1 if the file can't be read
+ */
+static int find_peak(const char* path)
+{
+	short samples[1024];
+	size_t i;
+	size_t count;
+	int peak = 0;
+	FILE* in = fopen(path, "rb");
+
+	if (in == NULL)
+		return -1;
+
+	while ((count = fread(samples, sizeof(short), 1024, in)) > 0)
+	{
+		for (i = 0; i < count; i++)
+		{
+			if (abs(samples[i]) > peak)
+				peak = abs(samples[i]);
+		}
+	}
+
+	fclose(in);
+
+	return peak;
+}
+
+int main(int argc, char** argv)
+{
+	int i;
+	int frame;
+	int frames = DEFAULT_FRAMES;
+	int commands = DEFAULT_COMMANDS;
+	const char* driver = "dummy";
+	const char* output = DEFAULT_OUTPUT;
+	int recent[RECENT_VOICES] = { 0 };
+	int next = 0;
+	int sent = 0;
+	int peak = -1;
+	int ok;
+	unsigned long long start;
+	unsigned long long ticks;
+	unsigned long long queue_ticks = 0;
+	unsigned long long max_queue_ticks = 0;
+	double buffer_us;
+	double mix_us;
+
+	fl_audio* audio;
+
+	for (i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-driver") && (!strcmp(argv[i + 1], "dummy") || !strcmp(argv[i + 1], "disk")))
+			driver = argv[i + 1];
+		else if (!strcmp(argv[i], "-frames"))
+			frames = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-commands"))
+			commands = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-output"))
+			output = argv[i + 1];
+		else
+			break;
+	}
+
+	if (i != argc || frames <= 0 || commands <= 0)
+	{
+		fprintf(stderr, "usage: %s [-driver dummy|disk] [-frames N] [-commands N] [-output path]\n", argv[0]);
+		return 1;
+	}
+
+	/* Neither a display nor a sound card is needed. */
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+	SDL_setenv("SDL_AUDIODRIVER", driver, 1);
+	SDL_setenv("SDL_DISKAUDIOFILE", output, 1);
+
+	if (!fl_initialize())
+	{
+		fprintf(stderr, "initialization failure %s\n", fl_get_error());
+		return 1;
+	}
+
+	audio = fl_create_audio();
+
+	if (audio == NULL || !fl_start_audio(audio))
+	{
+		fprintf(stderr, "audio failure %s\n", fl_get_error());
+		return 1;
+	}
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		for (i = 0; i < commands; i++)
+		{
+			start = fl_get_performance_counter();
+
+			/* Mostly new sounds, with changes to the ones
+			   already playing mixed in. */
+			switch (rand() % 8)
+			{
+			case 0:
+				fl_set_sound_volume(audio, recent[rand() % RECENT_VOICES], (float)(rand() % 100) / 100.0f);
+				break;
+
+			case 1:
+				fl_stop_sound(audio, recent[rand() % RECENT_VOICES]);
+				break;
+
+			case 2:
+				fl_set_master_volume(audio, 0.5f + (float)(rand() % 50) / 100.0f);
+				break;
+
+			default:
+				recent[next] = fl_play_sound(audio, rand() % FLURMP_SOUND_COUNT, 0.5f);
+				next = (next + 1) % RECENT_VOICES;
+				break;
+			}
+
+			ticks = fl_get_performance_counter() - start;
+			queue_ticks += ticks;
+			sent++;
+
+			if (ticks > max_queue_ticks)
+				max_queue_ticks = ticks;
+		}
+
+		/* Give the audio thread a frame's worth of time. */
+		SDL_Delay(16);
+	}
+
+	/* The mixing times may be read once the audio thread has stopped. */
+	fl_stop_audio(audio);
+
+	if (!strcmp(driver, "disk"))
+		peak = find_peak(output);
+
+	buffer_us = FLURMP_AUDIO_FRAMES * 1000000.0 / FLURMP_AUDIO_RATE;
+	mix_us = audio->callbacks > 0 ? ticks_us((double)audio->mix_ticks / audio->callbacks) : 0.0;
+
+	printf("driver,commands,dropped,queue_ns,max_queue_us,buffers,mix_us,max_mix_us,buffer_us,peak\n");
+	printf("%s,%d,%d,%.1f,%.3f,%d,%.3f,%.3f,%.1f,%d\n", driver, sent, audio->dropped,
+		ticks_us((double)queue_ticks / sent) * 1000.0, ticks_us((double)max_queue_ticks),
+		audio->callbacks, mix_us, ticks_us((double)audio->max_mix_ticks), buffer_us, peak);
+
+	fprintf(stderr, "  %s: %d commands, %d dropped, %.1f ns each (max %.3f us)\n",
+		driver, sent, audio->dropped, ticks_us((double)queue_ticks / sent) * 1000.0, ticks_us((double)max_queue_ticks));
+	fprintf(stderr, "  %d buffers mixed in %.3f us each (max %.3f us) of the %.1f us they last",
+		audio->callbacks, mix_us, ticks_us((double)audio->max_mix_ticks), buffer_us);
+
+	if (peak >= 0)
+		fprintf(stderr, ", peak %d", peak);
+
+	fprintf(stderr, "\n");
+
+	/* The driver must have asked for at least one buffer. */
+	ok = audio->callbacks > 0;
+
+	/* cleanup */
+	fl_destroy_audio(audio);
+	fl_terminate();
+
+	return ok ? 0 : 1;
+}
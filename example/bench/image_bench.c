@@ -0,0 +1,304 @@
+/**
+ * Image loading benchmark.
+ *
+ * Generates a large sprite sheet, writes it as a BMP, a baked image
+ * and a QOI image, and then times loading each of them into a texture
+ * several times over. The time taken by each pass is written to stdout
+ * as CSV, and the size of each file and the average time are printed
+ * to stderr.
+ *
+ * Usage:
+ *   image_bench [-size N] [-passes N] [-dir path]
+ *
+ * The sheet is N by N pixels (2048 by default) of 64 by 64 sprites on
+ * the magenta color key. The files are written to the given directory
+ * (the working directory by default), so they are in the page cache
+ * when they are loaded, and the times measure decoding and uploading
+ * rather than the disk.
+ */
+#include <stdio.h>
+
+#include "flurmp.h"
+#include "core/flurmp_impl.h"
+#include "core/image_format.h"
+#include "core/qoi.h"
+
+#define DEFAULT_SIZE   2048
+#define DEFAULT_PASSES 10
+
+#define SPRITE_SIZE 64
+
+#define KEY 0xff00ffffu
+
+#define FORMAT_COUNT 3
+
+static const char* names[FORMAT_COUNT] = { "bmp", "baked", "qoi" };
+static const char* extensions[FORMAT_COUNT] = { ".bmp", FLURMP_BAKED_EXTENSION, FLURMP_QOI_EXTENSION };
+static int (*loaders[FORMAT_COUNT])(fl_context*, const char*, fl_image*) = {
+	fl_load_bmp,
+	fl_load_baked_image,
+	fl_load_qoi
+};
+
+/**
+ * Gets the elapsed time in milliseconds since a performance counter value.
+ *
+ * Params:
+ *   unsigned long long - a performance counter value
+ *
+ * Returns:
+ *   double - the elapsed time in milliseconds
+ */
+static double elapsed_ms(unsigned long long start)
+{
+	return (double)(fl_get_performance_counter() - start) * 1000.0
+		/ (double)fl_get_performance_frequency();
+}
+
+/**
+ * Draws a sheet of shaded round sprites on the color key.
+ *
+ * Params:
+ *   uint32_t* - receives the opaque RGBA8888 pixels
+ *   int - the width and height of the sheet
+ */
+static void draw_sheet(uint32_t* pixels, int size)
+{
+	int x;
+	int y;
+	const int r = SPRITE_SIZE / 2 - 4;
+
+	for (y = 0; y < size; y++)
+	{
+		for (x = 0; x < size; x++)
+		{
+			int cell = (y / SPRITE_SIZE) * (size / SPRITE_SIZE) + x / SPRITE_SIZE;
+			int dx = x % SPRITE_SIZE - SPRITE_SIZE / 2;
+			int dy = y % SPRITE_SIZE - SPRITE_SIZE / 2;
+			int d = dx * dx + dy * dy;
+			uint32_t shade;
+
+			if (d > r * r)
+			{
+				pixels[y * size + x] = KEY;
+				continue;
+			}
+
+			/* Light from the top left, with a hue per sprite. */
+			shade = (uint32_t)(255 - (d * 128) / (r * r) - (dx + dy + 2 * r) / 4);
+
+			pixels[y * size + x] = ((shade * (cell * 37 % 256) / 255) << 24)
+				| ((shade * (cell * 91 % 256) / 255) << 16)
+				| ((shade * (cell * 53 % 256) / 255) << 8)
+				| 255;
+		}
+	}
+}
+
+/**
+ * Writes the sheet in each format.
+ *
+ * Params:
+ *   const uint32_t* - the pixels of the sheet
+ *   int - the width and height of the sheet
+ *   char[][] - the paths to write to, one per format
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int write_sheet(const uint32_t* sheet, int size, char paths[FORMAT_COUNT][1024])
+{
+	size_t i;
+	int ok;
+	size_t count = (size_t)size * size;
+	uint32_t* keyed = fl_alloc(uint32_t, count);
+	unsigned char* qoi = fl_alloc(unsigned char, FLURMP_QOI_MAX_SIZE(size, size));
+	SDL_Surface* surface = NULL;
+	SDL_Surface* bmp = NULL;
+	FILE* out;
+	fl_baked_header header;
+
+	if (keyed == NULL || qoi == NULL)
+	{
+		fl_free(keyed);
+		fl_free(qoi);
+		return 0;
+	}
+
+	/* The color key is transparent black in baked images. With only
+	   opaque pixels left, premultiplying changes nothing. */
+	for (i = 0; i < count; i++)
+		keyed[i] = sheet[i] == KEY ? 0 : sheet[i];
+
+	/* bmp */
+	surface = SDL_CreateRGBSurfaceWithFormatFrom((void*)sheet, size, size, 32, size * 4, SDL_PIXELFORMAT_RGBA8888);
+	bmp = surface != NULL ? SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB24, 0) : NULL;
+	ok = bmp != NULL && SDL_SaveBMP(bmp, paths[0]) == 0;
+
+	SDL_FreeSurface(bmp);
+	SDL_FreeSurface(surface);
+
+	/* baked */
+	if (ok && (out = fopen(paths[1], "wb")) != NULL)
+	{
+		memcpy(header.magic, FLURMP_BAKED_MAGIC, 4);
+		header.version = FLURMP_BAKED_VERSION;
+		header.w = (uint32_t)size;
+		header.h = (uint32_t)size;
+
+		fwrite(&header, sizeof(header), 1, out);
+		fwrite(keyed, sizeof(uint32_t), count, out);
+		ok = fclose(out) == 0;
+	}
+	else
+		ok = 0;
+
+	/* qoi */
+	if (ok && (out = fopen(paths[2], "wb")) != NULL)
+	{
+		fwrite(qoi, 1, fl_encode_qoi(keyed, size, size, qoi), out);
+		ok = fclose(out) == 0;
+	}
+	else
+		ok = 0;
+
+	fl_free(keyed);
+	fl_free(qoi);
+
+	return ok;
+}
+
+/**
+ * Gets the size of a file.
+ *
+ * Params:
+ *   const char* - the path to the file
+ *
+ * Returns:
+ *   long - the size in bytes, or -1 on failure
+ */
+static long file_size(const char* path)
+{
+	long size;
+	FILE* file = fopen(path, "rb");
+
+	if (file == NULL)
+		return -1;
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fclose(file);
+
+	return size;
+}
+
+int main(int argc, char** argv)
+{
+	int i;
+	int j;
+	int size = DEFAULT_SIZE;
+	int passes = DEFAULT_PASSES;
+	const char* dir = ".";
+	char paths[FORMAT_COUNT][1024];
+	uint32_t* sheet;
+	int ok = 1;
+
+	fl_context* context;
+
+	for (i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-size"))
+			size = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-passes"))
+			passes = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-dir"))
+			dir = argv[i + 1];
+		else
+			break;
+	}
+
+	if (i != argc || passes <= 0 || size < SPRITE_SIZE || size > FLURMP_IMAGE_SIZE_LIMIT)
+	{
+		fprintf(stderr, "usage: %s [-size N] [-passes N] [-dir path]\n", argv[0]);
+		return 1;
+	}
+
+	for (i = 0; i < FORMAT_COUNT; i++)
+		snprintf(paths[i], sizeof(paths[i]), "%s/image_bench%s", dir, extensions[i]);
+
+	if (!fl_initialize())
+	{
+		fprintf(stderr, "initialization failure %s\n", fl_get_error());
+		return 1;
+	}
+
+	/* Only the renderer is needed to create textures. */
+	context = fl_alloc(fl_context, 1);
+	sheet = fl_alloc(uint32_t, (size_t)size * size);
+
+	if (context == NULL || sheet == NULL)
+	{
+		fprintf(stderr, "allocation failure\n");
+		return 1;
+	}
+
+	context->window = fl_create_window("image_bench", 0, 0, 64, 64);
+	context->renderer = context->window != NULL ? fl_create_renderer(context->window) : NULL;
+
+	if (context->renderer == NULL)
+	{
+		fprintf(stderr, "renderer creation failure %s\n", fl_get_error());
+		return 1;
+	}
+
+	draw_sheet(sheet, size);
+
+	if (!write_sheet(sheet, size, paths))
+	{
+		fprintf(stderr, "cannot write the sprite sheet to %s\n", dir);
+		return 1;
+	}
+
+	printf("format,pass,ms\n");
+	fprintf(stderr, "%d by %d sprite sheet\n", size, size);
+
+	for (i = 0; ok && i < FORMAT_COUNT; i++)
+	{
+		double total = 0;
+
+		for (j = 0; j < passes; j++)
+		{
+			fl_image image;
+			unsigned long long start = fl_get_performance_counter();
+			double ms;
+
+			if (!loaders[i](context, paths[i], &image))
+			{
+				fprintf(stderr, "%s: failed to load %s: %s\n", names[i], paths[i], fl_get_error());
+				ok = 0;
+				break;
+			}
+
+			fl_destroy_texture(image.texture);
+
+			ms = elapsed_ms(start);
+			total += ms;
+			printf("%s,%d,%.3f\n", names[i], j, ms);
+		}
+
+		if (ok)
+			fprintf(stderr, "  %-6s %10ld bytes %10.3f ms\n", names[i], file_size(paths[i]), total / passes);
+	}
+
+	/* cleanup */
+	for (i = 0; i < FORMAT_COUNT; i++)
+		remove(paths[i]);
+
+	fl_free(sheet);
+	fl_destroy_renderer(context->renderer);
+	fl_destroy_window(context->window);
+	fl_free(context);
+	fl_terminate();
+
+	return ok ? 0 : 1;
+}
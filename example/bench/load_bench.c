@@ -0,0 +1,247 @@
+/**
+ * Asset loading benchmark.
+ *
+ * Loads every image and font the example uses, first from loose files
+ * and then from the asset pack, several times over. The time taken by
+ * each pass is written to stdout as CSV, and the first pass and the
+ * average of the others are printed to stderr for each mode.
+ *
+ * Usage:
+ *   load_bench [-mode loose|pack|both] [-passes N] [-pack path]
+ *
+ * The first pass of a mode reads files that may not be in the page
+ * cache yet, and the others find them there. For a true cold start,
+ * flush the page cache first and run one mode per process, e.g. on
+ * Linux:
+ *
+ *   sync && echo 3 | sudo tee /proc/sys/vm/drop_caches
+ *   load_bench -mode loose -passes 1
+ *
+ * Build the pack with the pack target and run the benchmark
+ * from the example directory.
+ */
+#include <stdio.h>
+
+#include "flurmp.h"
+#include "core/flurmp_impl.h"
+#include "core/pack.h"
+
+#define DEFAULT_PASSES 20
+
+#define MODE_LOOSE 1
+#define MODE_PACK  2
+#define MODE_BOTH  (MODE_LOOSE | MODE_PACK)
+
+static const char* images[] = {
+	"resources/images/person.bmp",
+	"resources/images/sign.bmp",
+	"resources/images/block_200_50.bmp",
+	"resources/images/spike.bmp",
+	"resources/images/door.bmp",
+	"resources/images/pellet.bmp"
+};
+
+static const char* fonts[] = {
+	"resources/fonts/VeraMono.ttf",
+	"resources/fonts/Cousine.ttf",
+	"resources/fonts/Karmilla-Bold.ttf"
+};
+
+#define IMAGE_COUNT ((int)(sizeof(images) / sizeof(images[0])))
+#define FONT_COUNT ((int)(sizeof(fonts) / sizeof(fonts[0])))
+
+/**
+ * Gets the elapsed time in milliseconds since a performance counter value.
+ *
+ * Params:
+ *   unsigned long long - a performance counter value
+ *
+ * Returns:
+ *   double - the elapsed time in milliseconds
+ */
+static double elapsed_ms(unsigned long long start)
+{
+	return (double)(fl_get_performance_counter() - start) * 1000.0
+		/ (double)fl_get_performance_frequency();
+}
+
+/**
+ * Loads and then destroys every image and font.
+ *
+ * Params:
+ *   fl_context - a context with a renderer
+ *
+ * Returns:
+ *   int - 1 if everything loaded, otherwise 0
+ */
+static int load_all(fl_context* context)
+{
+	int i;
+	int ok = 1;
+	fl_image image;
+	fl_ttf* ttf;
+
+	for (i = 0; i < IMAGE_COUNT; i++)
+	{
+		if (!fl_load_bmp(context, images[i], &image))
+		{
+			ok = 0;
+			continue;
+		}
+
+		fl_destroy_texture(image.texture);
+	}
+
+	for (i = 0; i < FONT_COUNT; i++)
+	{
+		ttf = fl_load_ttf(fonts[i], 16);
+
+		if (ttf == NULL)
+		{
+			ok = 0;
+			continue;
+		}
+
+		fl_close_ttf(ttf);
+	}
+
+	return ok;
+}
+
+/**
+ * Times a number of passes over the assets in one mode.
+ *
+ * Params:
+ *   fl_context - a context with a renderer
+ *   int - MODE_LOOSE or MODE_PACK
+ *   const char* - the path to the pack
+ *   int - the number of passes
+ *
+ * Returns:
+ *   int - 1 on success, otherwise 0
+ */
+static int run_mode(fl_context* context, int mode, const char* pack, int passes)
+{
+	int i;
+	unsigned long long start;
+	double ms;
+	double first = 0;
+	double rest = 0;
+	const char* name = mode == MODE_PACK ? "pack" : "loose";
+
+	fl_close_pack();
+
+	for (i = 0; i < passes; i++)
+	{
+		start = fl_get_performance_counter();
+
+		/* Mapping the pack is part of the first load. */
+		if (mode == MODE_PACK && i == 0 && !fl_open_pack(pack))
+		{
+			fprintf(stderr, "cannot open the asset pack %s\n", pack);
+			return 0;
+		}
+
+		if (!load_all(context))
+		{
+			fprintf(stderr, "%s: failed to load the assets: %s\n", name, fl_get_error());
+			return 0;
+		}
+
+		ms = elapsed_ms(start);
+		printf("%s,%d,%.3f\n", name, i, ms);
+
+		if (i == 0)
+			first = ms;
+		else
+			rest += ms;
+	}
+
+	fprintf(stderr, "  %-6s first %8.3f ms", name, first);
+
+	if (passes > 1)
+		fprintf(stderr, ", then %8.3f ms", rest / (passes - 1));
+
+	fprintf(stderr, "\n");
+
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+	int i;
+	int mode = MODE_BOTH;
+	int passes = DEFAULT_PASSES;
+	const char* pack = FLURMP_PACK_PATH;
+	int ok = 1;
+
+	fl_context* context;
+
+	for (i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-mode"))
+		{
+			if (!strcmp(argv[i + 1], "loose"))
+				mode = MODE_LOOSE;
+			else if (!strcmp(argv[i + 1], "pack"))
+				mode = MODE_PACK;
+			else if (!strcmp(argv[i + 1], "both"))
+				mode = MODE_BOTH;
+			else
+				break;
+		}
+		else if (!strcmp(argv[i], "-passes"))
+			passes = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-pack"))
+			pack = argv[i + 1];
+		else
+			break;
+	}
+
+	if (i != argc || passes <= 0)
+	{
+		fprintf(stderr, "usage: %s [-mode loose|pack|both] [-passes N] [-pack path]\n", argv[0]);
+		return 1;
+	}
+
+	if (!fl_initialize())
+	{
+		fprintf(stderr, "initialization failure %s\n", fl_get_error());
+		return 1;
+	}
+
+	/* Only the renderer is needed to create textures. */
+	context = fl_alloc(fl_context, 1);
+
+	if (context == NULL)
+	{
+		fprintf(stderr, "allocation failure\n");
+		return 1;
+	}
+
+	context->window = fl_create_window("load_bench", 0, 0, 64, 64);
+	context->renderer = context->window != NULL ? fl_create_renderer(context->window) : NULL;
+
+	if (context->renderer == NULL)
+	{
+		fprintf(stderr, "renderer creation failure %s\n", fl_get_error());
+		return 1;
+	}
+
+	printf("mode,pass,ms\n");
+	fprintf(stderr, "%d images and %d fonts per pass\n", IMAGE_COUNT, FONT_COUNT);
+
+	if (mode & MODE_LOOSE)
+		ok = run_mode(context, MODE_LOOSE, pack, passes);
+
+	if (ok && (mode & MODE_PACK))
+		ok = run_mode(context, MODE_PACK, pack, passes);
+
+	/* cleanup */
+	fl_destroy_renderer(context->renderer);
+	fl_destroy_window(context->window);
+	fl_free(context);
+	fl_terminate();
+
+	return ok ? 0 : 1;
+}
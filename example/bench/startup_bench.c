@@ -0,0 +1,136 @@
+/**
+ * Startup benchmark.
+ *
+ * Measures the time to the first frame: initializing Flurmp, creating
+ * the context, which loads the fonts, the images and the first scene,
+ * and running and presenting one frame, which draws the data panel.
+ * The times are written to stdout as one row of CSV and printed to
+ * stderr.
+ *
+ * Usage:
+ *   startup_bench [-fonts baked|ttf] [-workers N] [-trace path]
+ *
+ * With -fonts ttf, the fonts are opened and their glyphs rasterized
+ * from the TTFs even if they have been baked, which shows the time to
+ * the first frame before and after baking. -workers sets the number of
+ * threads that load assets while the window is created; with 0,
+ * startup runs one step at a time on the main thread, which shows the
+ * time to the first frame before and after loading in parallel.
+ * -trace writes the timeline of startup, which chrome://tracing and
+ * Perfetto can open.
+ *
+ * Run each mode in a process of its own, since the first font opened
+ * in a process also pays for starting FreeType. Build the bakes with
+ * the bake target and run the benchmark from the example directory.
+ */
+#include <stdio.h>
+
+#include "flurmp.h"
+#include "core/flurmp_impl.h"
+#include "core/resource.h"
+#include "core/startup.h"
+
+/**
+ * Gets the elapsed time in milliseconds since a performance counter value.
+ *
+ * Params:
+ *   unsigned long long - a performance counter value
+ *
+ * Returns:
+ *   double - the elapsed time in milliseconds
+ */
+static double elapsed_ms(unsigned long long start)
+{
+	return (double)(fl_get_performance_counter() - start) * 1000.0
+		/ (double)fl_get_performance_frequency();
+}
+
+int main(int argc, char** argv)
+{
+	int i;
+	int baked = 1;
+	int workers = -1;
+	const char* trace = NULL;
+	char workers_name[16] = "auto";
+	unsigned long long start;
+	unsigned long long phase;
+	double initialize_ms;
+	double context_ms;
+	double frame_ms;
+
+	fl_context* context;
+
+	for (i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-fonts") && !strcmp(argv[i + 1], "baked"))
+			baked = 1;
+		else if (!strcmp(argv[i], "-fonts") && !strcmp(argv[i + 1], "ttf"))
+			baked = 0;
+		else if (!strcmp(argv[i], "-workers"))
+			workers = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-trace"))
+			trace = argv[i + 1];
+		else
+			break;
+	}
+
+	if (i != argc || workers < -1)
+	{
+		fprintf(stderr, "usage: %s [-fonts baked|ttf] [-workers N] [-trace path]\n", argv[0]);
+		return 1;
+	}
+
+	if (workers >= 0)
+		snprintf(workers_name, sizeof(workers_name), "%d", workers);
+
+	/* Presenting the first frame shouldn't wait for the display. */
+	SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+
+	start = fl_get_performance_counter();
+
+	if (!fl_initialize())
+	{
+		fprintf(stderr, "initialization failure %s\n", fl_get_error());
+		return 1;
+	}
+
+	/* The performance counter is usable before SDL is initialized,
+	   so the first reading includes initialization. */
+	initialize_ms = elapsed_ms(start);
+
+	fl_use_baked_fonts(baked);
+	fl_set_startup_workers(workers);
+	fl_set_startup_trace(trace);
+
+	phase = fl_get_performance_counter();
+	context = fl_create_context();
+	context_ms = elapsed_ms(phase);
+
+	if (context == NULL || context->error)
+	{
+		fprintf(stderr, "context creation failure 0x%02X\n", context != NULL ? context->error : 0);
+		return 1;
+	}
+
+	phase = fl_get_performance_counter();
+
+	fl_handle_events(context);
+	fl_handle_input(context);
+	fl_update(context);
+	fl_render(context);
+
+	frame_ms = elapsed_ms(phase);
+
+	printf("fonts,workers,initialize_ms,context_ms,frame_ms,total_ms\n");
+	printf("%s,%s,%.3f,%.3f,%.3f,%.3f\n", baked ? "baked" : "ttf", workers_name,
+		initialize_ms, context_ms, frame_ms, elapsed_ms(start));
+
+	fprintf(stderr, "  %-6s %4s workers: initialize %8.3f ms, context %8.3f ms, first frame %8.3f ms, total %8.3f ms\n",
+		baked ? "baked" : "ttf", workers_name, initialize_ms, context_ms, frame_ms, elapsed_ms(start));
+
+	/* cleanup */
+	fl_destroy_context(context);
+	fl_terminate();
+
+	return 0;
+}
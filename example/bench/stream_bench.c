@@ -0,0 +1,207 @@
+/**
+ * Streaming benchmark.
+ *
+ * Creates a context, replaces the test scene with a streamed world of
+ * one million entities, and flies the camera across the world at a
+ * fixed speed. Each frame, the number of entities in the context, the
+ * resident and active chunks, the chunks loaded, the memory held by
+ * entities and chunk records, and the time spent updating and rendering
+ * are written to stdout as CSV. The averages are printed to stderr.
+ *
+ * Usage:
+ *   stream_bench [-columns N] [-rows N] [-chunk N] [-blocks N]
+ *                [-spikes N] [-doors N] [-pellets N] [-active N]
+ *                [-load N] [-hysteresis N] [-budget N] [-speed N]
+ *                [-seed N] [-frames N]
+ *
+ * The player is removed so that only the benchmark moves the camera.
+ * Frames are not throttled and vsync is disabled. Run it from the
+ * example directory so that the resources can be found.
+ */
+#include <stdio.h>
+
+#include "flurmp.h"
+#include "core/flurmp_impl.h"
+#include "core/memory.h"
+#include "core/stream.h"
+#include "scene/scene.h"
+
+#define DEFAULT_FRAMES 3000
+
+/* camera speed in pixels per frame */
+#define DEFAULT_SPEED 16
+
+/**
+ * Gets the elapsed time in microseconds since a performance counter value.
+ *
+ * Params:
+ *   unsigned long long - a performance counter value
+ *
+ * Returns:
+ *   double - the elapsed time in microseconds
+ */
+static double elapsed_us(unsigned long long start)
+{
+	return (double)(fl_get_performance_counter() - start) * 1000000.0
+		/ (double)fl_get_performance_frequency();
+}
+
+/**
+ * Parses the command line into a world configuration.
+ *
+ * Params:
+ *   int - the number of arguments
+ *   char** - the arguments
+ *   fl_world_config - receives the world configuration
+ *   int* - receives the camera speed
+ *   int* - receives the number of frames to run
+ *
+ * Returns:
+ *   int - 1 if the arguments are valid, otherwise 0
+ */
+static int parse_args(int argc, char** argv, fl_world_config* config, int* speed, int* frames)
+{
+	int i;
+
+	for (i = 1; i + 1 < argc; i += 2)
+	{
+		const char* opt = argv[i];
+		const char* val = argv[i + 1];
+
+		if (!strcmp(opt, "-columns"))         config->columns = atoi(val);
+		else if (!strcmp(opt, "-rows"))       config->rows = atoi(val);
+		else if (!strcmp(opt, "-chunk"))      config->chunk_w = config->chunk_h = atoi(val);
+		else if (!strcmp(opt, "-blocks"))     config->blocks = atoi(val);
+		else if (!strcmp(opt, "-spikes"))     config->spikes = atoi(val);
+		else if (!strcmp(opt, "-doors"))      config->doors = atoi(val);
+		else if (!strcmp(opt, "-pellets"))    config->pellets = atoi(val);
+		else if (!strcmp(opt, "-active"))     config->active_radius = atoi(val);
+		else if (!strcmp(opt, "-load"))       config->load_radius = atoi(val);
+		else if (!strcmp(opt, "-hysteresis")) config->hysteresis = atoi(val);
+		else if (!strcmp(opt, "-budget"))     config->load_budget = atoi(val);
+		else if (!strcmp(opt, "-speed"))      *speed = atoi(val);
+		else if (!strcmp(opt, "-seed"))       config->seed = (unsigned int)strtoul(val, NULL, 10);
+		else if (!strcmp(opt, "-frames"))     *frames = atoi(val);
+		else
+			return 0;
+	}
+
+	/* Every option takes a value. */
+	return i == argc && *frames > 0;
+}
+
+int main(int argc, char** argv)
+{
+	int i;
+	int speed = DEFAULT_SPEED;
+	int frames = DEFAULT_FRAMES;
+	int world_w, start_x;
+	int max_entities = 0;
+	unsigned long long start;
+	double update_us, render_us;
+	double total_update = 0;
+	double total_render = 0;
+	size_t peak = 0;
+
+	fl_context* context;
+	fl_world_config config;
+	fl_memory_stats stats;
+
+	fl_default_world_config(&config);
+
+	if (!parse_args(argc, argv, &config, &speed, &frames))
+	{
+		fprintf(stderr, "usage: %s [-columns N] [-rows N] [-chunk N] [-blocks N] [-spikes N]"
+			" [-doors N] [-pellets N] [-active N] [-load N] [-hysteresis N] [-budget N]"
+			" [-speed N] [-seed N] [-frames N]\n", argv[0]);
+		return 1;
+	}
+
+	/* The renderer would otherwise wait for the display on every frame. */
+	SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+
+	if (!fl_initialize())
+	{
+		fprintf(stderr, "initialization failure %s\n", fl_get_error());
+		return 1;
+	}
+
+	context = fl_create_context();
+
+	if (context == NULL || context->error)
+	{
+		fprintf(stderr, "context creation failure\n");
+		return 1;
+	}
+
+	fl_clear_scene(context);
+	fl_load_stream_scene(context, &config);
+
+	if (context->error)
+	{
+		fprintf(stderr, "stream scene creation failure (error %d)\n", context->error);
+		return 1;
+	}
+
+	fl_despawn_entity(context, context->pco);
+
+	/* Fly east from the center of the world, turning back at the edges. */
+	world_w = config.columns * config.chunk_w;
+	start_x = context->cam_x;
+
+	printf("frame,entities,resident,active,loads,entity_kb,update_us,render_us\n");
+
+	for (i = 0; i < frames && !fl_is_done(context); i++)
+	{
+		int x = start_x + i * speed;
+		int period = 2 * (world_w - FLURMP_WINDOW_WIDTH);
+
+		if (period > 0)
+		{
+			x %= period;
+			context->cam_x = x < period / 2 ? x : period - x;
+		}
+
+		fl_handle_events(context);
+
+		start = fl_get_performance_counter();
+		fl_update(context);
+		update_us = elapsed_us(start);
+
+		start = fl_get_performance_counter();
+		fl_render(context);
+		render_us = elapsed_us(start);
+
+		fl_get_memory_stats(FLURMP_MEMORY_TAG_ENTITY, &stats);
+
+		if (stats.live_bytes > peak)
+			peak = stats.live_bytes;
+
+		if (context->entity_count > max_entities)
+			max_entities = context->entity_count;
+
+		printf("%d,%d,%d,%d,%d,%lu,%.1f,%.1f\n", i, context->entity_count,
+			context->world->resident_count, context->world->active_count, context->world->loads,
+			(unsigned long)(stats.live_bytes / 1024), update_us, render_us);
+
+		total_update += update_us;
+		total_render += render_us;
+	}
+
+	fprintf(stderr, "%d entities in the world, at most %d in the context, %d frames\n",
+		config.columns * config.rows * (config.blocks + config.spikes + config.doors + config.pellets),
+		max_entities, i);
+	fprintf(stderr, "  peak entity memory %lu KB\n", (unsigned long)(peak / 1024));
+
+	if (i > 0)
+	{
+		fprintf(stderr, "  %-8s %10.1f us/frame\n", "update", total_update / i);
+		fprintf(stderr, "  %-8s %10.1f us/frame\n", "render", total_render / i);
+	}
+
+	/* cleanup */
+	fl_destroy_context(context);
+	fl_terminate();
+
+	return 0;
+}
@@ -0,0 +1,288 @@
+/**
+ * Stress benchmark.
+ *
+ * Creates a context, replaces the test scene with a procedurally
+ * generated stress scene, and runs a fixed number of frames while a
+ * script presses the player's action keys. The time spent in each
+ * phase of every frame is written to stdout as CSV, one row per frame,
+ * and the averages are printed to stderr.
+ *
+ * Usage:
+ *   stress_bench [-blocks N] [-spikes N] [-doors N] [-pellets N]
+ *                [-players N] [-particles N] [-layout grid|uniform|clustered]
+ *                [-w N] [-h N] [-seed N] [-frames N]
+ *
+ * With -particles, bursts of particles are emitted around the player
+ * each frame to keep about N of them alive, so that the cost of
+ * particles can be compared with that of the same number of pellets.
+ *
+ * Frames are not throttled and vsync is disabled, so the timings are
+ * those of the engine rather than of the display. Run it from the
+ * example directory so that the resources can be found.
+ */
+#include <stdio.h>
+
+#include "flurmp.h"
+#include "core/flurmp_impl.h"
+#include "core/input.h"
+#include "core/particle.h"
+#include "scene/scene.h"
+
+#define DEFAULT_FRAMES 600
+
+/* number of frames after which the input script repeats */
+#define SCRIPT_PERIOD 240
+
+/* phases of a frame, in the order they run */
+#define PHASE_EVENTS 0
+#define PHASE_INPUT  1
+#define PHASE_UPDATE 2
+#define PHASE_RENDER 3
+#define PHASE_COUNT  4
+
+static const char* phase_names[PHASE_COUNT] = {
+	"events",
+	"input",
+	"update",
+	"render"
+};
+
+/**
+ * An action held from one frame of the script period until another.
+ * An action released on the frame after it is pressed is a single press.
+ */
+typedef struct script_step {
+	int press;
+	int release;
+	int action;
+}script_step;
+
+/* walk right, walk back left, jump, fire and interact along the way */
+static const script_step script[] = {
+	{ 0,   120, FLURMP_ACTION_RIGHT },
+	{ 120, 220, FLURMP_ACTION_LEFT },
+	{ 30,  31,  FLURMP_ACTION_JUMP },
+	{ 90,  91,  FLURMP_ACTION_JUMP },
+	{ 160, 161, FLURMP_ACTION_JUMP },
+	{ 60,  61,  FLURMP_ACTION_SECONDARY },
+	{ 180, 181, FLURMP_ACTION_SECONDARY },
+	{ 230, 231, FLURMP_ACTION_PRIMARY }
+};
+
+/**
+ * Presses and releases the keys that the script calls for
+ * on a frame. This runs after events are handled, in place
+ * of key events from the user.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the frame number
+ */
+static void run_script(fl_context* context, int frame)
+{
+	int i;
+	int t = frame % SCRIPT_PERIOD;
+
+	for (i = 0; i < (int)(sizeof(script) / sizeof(script[0])); i++)
+	{
+		int code = context->input.actions[script[i].action];
+
+		if (t == script[i].press)
+			fl_input_key_down(context, code);
+		else if (t == script[i].release)
+			fl_input_key_up(context, code);
+	}
+}
+
+/**
+ * Tops the particles up to a number, emitting them in bursts
+ * around the player.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the number of particles to keep alive
+ */
+static void top_up_particles(fl_context* context, int particles)
+{
+	int kind;
+	int burst;
+	int missing = particles - fl_get_particle_count(context);
+	fl_entity* pco = fl_get_entity(context, context->pco);
+
+	if (pco == NULL)
+		return;
+
+	for (kind = 0; missing > 0; kind = (kind + 1) % FLURMP_PARTICLE_KIND_COUNT)
+	{
+		burst = missing < 256 ? missing : 256;
+
+		if (fl_emit_particles(context, kind, pco->x + rand() % 400 - 200, pco->y + rand() % 200 - 100, burst) == 0)
+			break;
+
+		missing -= burst;
+	}
+}
+
+/**
+ * Gets the elapsed time in microseconds since a performance counter value.
+ *
+ * Params:
+ *   unsigned long long - a performance counter value
+ *
+ * Returns:
+ *   double - the elapsed time in microseconds
+ */
+static double elapsed_us(unsigned long long start)
+{
+	return (double)(fl_get_performance_counter() - start) * 1000000.0
+		/ (double)fl_get_performance_frequency();
+}
+
+/**
+ * Parses the command line into a stress scene configuration.
+ *
+ * Params:
+ *   int - the number of arguments
+ *   char** - the arguments
+ *   fl_stress_config - receives the scene configuration
+ *   int* - receives the number of frames to run
+ *   int* - receives the number of particles to keep alive
+ *
+ * Returns:
+ *   int - 1 if the arguments are valid, otherwise 0
+ */
+static int parse_args(int argc, char** argv, fl_stress_config* config, int* frames, int* particles)
+{
+	int i;
+
+	for (i = 1; i + 1 < argc; i += 2)
+	{
+		const char* opt = argv[i];
+		const char* val = argv[i + 1];
+
+		if (!strcmp(opt, "-layout"))
+		{
+			if (!strcmp(val, "grid"))
+				config->layout = FLURMP_LAYOUT_GRID;
+			else if (!strcmp(val, "uniform"))
+				config->layout = FLURMP_LAYOUT_UNIFORM;
+			else if (!strcmp(val, "clustered"))
+				config->layout = FLURMP_LAYOUT_CLUSTERED;
+			else
+				return 0;
+		}
+		else if (!strcmp(opt, "-blocks"))  config->blocks = atoi(val);
+		else if (!strcmp(opt, "-spikes"))  config->spikes = atoi(val);
+		else if (!strcmp(opt, "-doors"))   config->doors = atoi(val);
+		else if (!strcmp(opt, "-pellets")) config->pellets = atoi(val);
+		else if (!strcmp(opt, "-players")) config->players = atoi(val);
+		else if (!strcmp(opt, "-w"))       config->w = atoi(val);
+		else if (!strcmp(opt, "-h"))       config->h = atoi(val);
+		else if (!strcmp(opt, "-seed"))    config->seed = (unsigned int)strtoul(val, NULL, 10);
+		else if (!strcmp(opt, "-frames"))  *frames = atoi(val);
+		else if (!strcmp(opt, "-particles")) *particles = atoi(val);
+		else
+			return 0;
+	}
+
+	/* Every option takes a value. */
+	return i == argc && *frames > 0 && *particles >= 0;
+}
+
+int main(int argc, char** argv)
+{
+	int i, p;
+	int frames = DEFAULT_FRAMES;
+	int particles = 0;
+	unsigned long long start;
+	double t[PHASE_COUNT];
+	double total[PHASE_COUNT] = { 0 };
+
+	fl_context* context;
+	fl_stress_config config;
+
+	fl_default_stress_config(&config);
+
+	if (!parse_args(argc, argv, &config, &frames, &particles))
+	{
+		fprintf(stderr, "usage: %s [-blocks N] [-spikes N] [-doors N] [-pellets N] [-players N]"
+			" [-particles N] [-layout grid|uniform|clustered] [-w N] [-h N] [-seed N] [-frames N]\n", argv[0]);
+		return 1;
+	}
+
+	/* The renderer would otherwise wait for the display on every frame. */
+	SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+
+	if (!fl_initialize())
+	{
+		fprintf(stderr, "initialization failure %s\n", fl_get_error());
+		return 1;
+	}
+
+	context = fl_create_context();
+
+	if (context == NULL || context->error)
+	{
+		fprintf(stderr, "context creation failure\n");
+		return 1;
+	}
+
+	fl_clear_scene(context);
+	fl_load_stress_scene(context, &config);
+
+	if (context->error)
+	{
+		fprintf(stderr, "stress scene creation failure (error %d)\n", context->error);
+		return 1;
+	}
+
+	printf("frame,entities,particles");
+
+	for (p = 0; p < PHASE_COUNT; p++)
+		printf(",%s_us", phase_names[p]);
+
+	printf("\n");
+
+	for (i = 0; i < frames && !fl_is_done(context); i++)
+	{
+		start = fl_get_performance_counter();
+		fl_handle_events(context);
+		run_script(context, i);
+		t[PHASE_EVENTS] = elapsed_us(start);
+
+		start = fl_get_performance_counter();
+		fl_handle_input(context);
+		t[PHASE_INPUT] = elapsed_us(start);
+
+		start = fl_get_performance_counter();
+		top_up_particles(context, particles);
+		fl_update(context);
+		t[PHASE_UPDATE] = elapsed_us(start);
+
+		start = fl_get_performance_counter();
+		fl_render(context);
+		t[PHASE_RENDER] = elapsed_us(start);
+
+		printf("%d,%d,%d", i, context->entity_count, fl_get_particle_count(context));
+
+		for (p = 0; p < PHASE_COUNT; p++)
+		{
+			printf(",%.1f", t[p]);
+			total[p] += t[p];
+		}
+
+		printf("\n");
+	}
+
+	fprintf(stderr, "%d entities, %d particles, %d frames\n",
+		context->entity_count, fl_get_particle_count(context), i);
+
+	for (p = 0; p < PHASE_COUNT && i > 0; p++)
+		fprintf(stderr, "  %-8s %10.1f us/frame\n", phase_names[p], total[p] / i);
+
+	/* cleanup */
+	fl_destroy_context(context);
+	fl_terminate();
+
+	return 0;
+}
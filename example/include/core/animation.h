@@ -1,3 +1,14 @@
+/**
+ * Animations and animators.
+ *
+ * An animation is a table of image sections, each shown for a number
+ * of updates given by its duration. Animations are shared by all
+ * entities of an entity type.
+ *
+ * An animator holds the animation state of one entity. Every animator
+ * in a context is advanced once per call to fl_update, and the entity's
+ * frame is pointed at the current section of its animation.
+ */
 #ifndef FLURMP_ANIMATION_H
 #define FLURMP_ANIMATION_H
 
@@ -5,6 +16,7 @@
 
 /**
  * Creates a new animation.
+ * Each frame is initially shown for a single update.
  *
  * Params:
  *   int - the number of frames in the animation
@@ -22,4 +34,78 @@ fl_animation* fl_create_animation(int f);
  */
 void fl_destroy_animation(fl_animation* a);
 
+/**
+ * Sets the image section and duration of an animation frame.
+ *
+ * Params:
+ *   fl_animation - an animation
+ *   int - the index of the frame
+ *   int - the x position of the image section
+ *   int - the y position of the image section
+ *   int - the width of the image section
+ *   int - the height of the image section
+ *   int - the number of updates for which the frame is shown
+ */
+void fl_set_animation_frame(fl_animation* a, int i, int x, int y, int w, int h, int duration);
+
+/**
+ * Creates an animator for an entity and starts playing an animation.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity
+ *   fl_animation - the animation to play
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_add_animator(fl_context* context, fl_entity* entity, fl_animation* animation);
+
+/**
+ * Removes the animator of an entity, if it has one.
+ * The last animator takes its place.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity
+ */
+void fl_remove_animator(fl_context* context, fl_entity* entity);
+
+/**
+ * Switches the animation played by an entity's animator.
+ * If the animation is already playing, it continues uninterrupted,
+ * otherwise it starts from its first frame.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity with an animator
+ *   fl_animation - the animation to play
+ */
+void fl_play_animation(fl_context* context, fl_entity* entity, fl_animation* animation);
+
+/**
+ * Advances every animator in a context by one update.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_update_animations(fl_context* context);
+
+/**
+ * Removes all animators from a context, but keeps their storage.
+ * This should be called when the entities of a context are destroyed.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_clear_animators(fl_context* context);
+
+/**
+ * Frees the memory allocated for the animators of a context.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_destroy_animators(fl_context* context);
+
 #endif
@@ -0,0 +1,123 @@
+/**
+ * Audio.
+ *
+ * Sound effects are decoded up front and mixed on the audio thread.
+ * The game thread never touches the voices: playing, stopping and
+ * changing the volume of sounds queues a command, which the audio
+ * thread applies before it mixes its next buffer. Queueing never
+ * waits, and a command that doesn't fit in the queue is dropped.
+ *
+ * Every function may be given a NULL audio structure, in which
+ * case nothing is played.
+ */
+#ifndef FLURMP_AUDIO_H
+#define FLURMP_AUDIO_H
+
+#include "core/flurmp_impl.h"
+
+#define FLURMP_SOUND_COUNT 3
+
+/* indices for sounds */
+#define FLURMP_SOUND_PELLET 0
+#define FLURMP_SOUND_SPIKE 1
+#define FLURMP_SOUND_DOOR 2
+
+/* paths of the sounds, indexed like the sounds */
+#define FLURMP_SOUND_PATHS { \
+	"resources/sounds/pellet.wav", \
+	"resources/sounds/spike.wav", \
+	"resources/sounds/door.wav" }
+
+/**
+ * Creates an audio structure and decodes the sounds. Sounds that
+ * can't be loaded are silent. Since no device is opened yet, this
+ * may be called on any thread.
+ *
+ * Returns:
+ *   fl_audio - a new audio structure, or NULL on failure
+ */
+fl_audio* fl_create_audio();
+
+/**
+ * Opens the audio device and starts mixing.
+ *
+ * Params:
+ *   fl_audio - an audio structure that isn't playing
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_start_audio(fl_audio* audio);
+
+/**
+ * Closes the audio device. Commands that haven't been applied
+ * yet are discarded.
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ */
+void fl_stop_audio(fl_audio* audio);
+
+/**
+ * Plays a sound from the start.
+ * If every voice is busy, the voice closest to finishing is cut off.
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ *   int - the sound (e.g. FLURMP_SOUND_PELLET)
+ *   float - the volume, from 0 to 1
+ *
+ * Returns:
+ *   int - the id of the voice playing the sound, or 0 if the
+ *         command couldn't be queued
+ */
+int fl_play_sound(fl_audio* audio, int sound, float volume);
+
+/**
+ * Stops a sound. Nothing happens if it has already finished.
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ *   int - the id of the voice playing the sound
+ */
+void fl_stop_sound(fl_audio* audio, int voice);
+
+/**
+ * Changes the volume of a sound while it plays.
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ *   int - the id of the voice playing the sound
+ *   float - the volume, from 0 to 1
+ */
+void fl_set_sound_volume(fl_audio* audio, int voice, float volume);
+
+/**
+ * Sets the volume that every sound is scaled by.
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ *   float - the volume, from 0 to 1
+ */
+void fl_set_master_volume(fl_audio* audio, float volume);
+
+/**
+ * Gets the master volume most recently set.
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ *
+ * Returns:
+ *   float - the volume, from 0 to 1, or 0 without audio
+ */
+float fl_get_master_volume(fl_audio* audio);
+
+/**
+ * Closes the audio device and frees the sounds.
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ */
+void fl_destroy_audio(fl_audio* audio);
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * Bodies.
+ *
+ * Every entity whose type has a body type is given a body when it
+ * joins the world. Bodies are moved along one axis at a time, all of
+ * them in one pass, between the entity updates and collision handling
+ * for that axis. Updates are left to behavior: they change velocities,
+ * and the bodies turn velocities into movement.
+ *
+ * Positions and velocities are kept in fixed point, so a body can move
+ * by a fraction of a pixel per update. Entities still see whole pixels
+ * in x, y, x_v and y_v. Setting any of those (e.g. on a collision)
+ * replaces the body's value, fraction and all.
+ */
+#ifndef FLURMP_BODY_H
+#define FLURMP_BODY_H
+
+#include "core/flurmp_impl.h"
+
+/**
+ * Gives an entity a body if its type has a body type.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity without a body
+ *
+ * Returns:
+ *   int - 1 on success, including when the type has no body type,
+ *         or 0 on failure
+ */
+int fl_add_body(fl_context* context, fl_entity* entity);
+
+/**
+ * Removes the body of an entity, if it has one.
+ * The last body takes its place.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity
+ */
+void fl_remove_body(fl_context* context, fl_entity* entity);
+
+/**
+ * Gets the number of whole pixels an entity's body will move along
+ * an axis when the bodies are next moved, given its current velocity.
+ * This lets an update follow the movement, as the camera does.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity
+ *   int - an axis (e.g. FLURMP_AXIS_X)
+ *
+ * Returns:
+ *   int - the number of pixels, or 0 if the entity has no body
+ */
+int fl_get_body_step(fl_context* context, fl_entity* entity, int axis);
+
+/**
+ * Moves every body in a context along an axis, applying gravity
+ * along the y axis and friction along the x axis.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - an axis
+ */
+void fl_move_bodies(fl_context* context, int axis);
+
+/**
+ * Removes all bodies from a context, but keeps their storage.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_clear_bodies(fl_context* context);
+
+/**
+ * Frees the memory allocated for the bodies of a context.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_destroy_bodies(fl_context* context);
+
+#endif
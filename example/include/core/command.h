@@ -0,0 +1,130 @@
+/**
+ * Console commands.
+ *
+ * Commands are registered by name in a hash table on the context.
+ * A line of input is split into arguments at whitespace, with double
+ * quotes grouping words into a single argument, and the first argument
+ * names the command to run. Lines executed from the console are kept
+ * in a history, and files of commands can be run with the exec command.
+ */
+#ifndef FLURMP_COMMAND_H
+#define FLURMP_COMMAND_H
+
+#include "core/flurmp_impl.h"
+
+/**
+ * Creates the command registry of a context and
+ * registers the built-in commands.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *
+ * Returns:
+ *   int - 1 on success, 0 on failure
+ */
+int fl_create_commands(fl_context* context);
+
+/**
+ * Frees the command registry of a context.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_destroy_commands(fl_context* context);
+
+/**
+ * Registers a command. A command registered under an existing name
+ * replaces the previous command. The name and help strings are not
+ * copied and must remain valid for the lifetime of the context.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - the name of the command
+ *   const char* - a short description of the command
+ *   void(*run) (fl_context*, int, char**) - the handler, which receives
+ *       the argument count and the arguments including the name
+ *
+ * Returns:
+ *   int - 1 on success, 0 on failure
+ */
+int fl_register_command(fl_context* context,
+	const char* name,
+	const char* help,
+	void(*run) (fl_context*, int, char**));
+
+/**
+ * Splits a line into arguments in place. Arguments are separated by
+ * whitespace, and double quotes group words into one argument.
+ *
+ * Params:
+ *   char* - the line, which is modified
+ *   char** - an array to receive the arguments
+ *   int - the capacity of the argument array
+ *
+ * Returns:
+ *   int - the number of arguments
+ */
+int fl_tokenize(char* line, char** argv, int max);
+
+/**
+ * Executes a line of input and records it in the command history.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - a line of input
+ *
+ * Returns:
+ *   int - 1 if a command was run, otherwise 0
+ */
+int fl_execute_command(fl_context* context, const char* line);
+
+/**
+ * Executes each line of a file as a command. Empty lines and
+ * lines starting with '#' are skipped. Scripts are not recorded
+ * in the command history.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - the path of the script
+ *
+ * Returns:
+ *   int - 1 if the script was run, 0 if it could not be opened
+ */
+int fl_execute_script(fl_context* context, const char* path);
+
+/**
+ * Completes the name of a command.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - the start of a command name
+ *   char* - receives the longest prefix shared by the matching names
+ *   int - the size of the output buffer
+ *
+ * Returns:
+ *   int - the number of matching commands
+ */
+int fl_complete_command(fl_context* context, const char* prefix, char* out, int size);
+
+/**
+ * Prints the commands whose names start with a prefix to stdout.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - the start of a command name, or "" for all commands
+ */
+void fl_print_commands(fl_context* context, const char* prefix);
+
+/**
+ * Retrieves a line from the command history.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - how many lines back to look, where 0 is the most recent line
+ *
+ * Returns:
+ *   const char* - the line, or NULL if the history is not that long
+ */
+const char* fl_get_history(fl_context* context, int age);
+
+#endif
@@ -3,9 +3,6 @@
 
 #include "core/flurmp_impl.h"
 
-#define FLURMP_CONSOLE_MOD_SHIFT 0x01
-#define FLURMP_CONSOLE_MOD_CTRL  0x02
-
 /**
  * Creates a console.
  *
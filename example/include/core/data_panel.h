@@ -3,6 +3,11 @@
 
 #include "core/flurmp_impl.h"
 
+/* pages of data shown by a data panel */
+#define FLURMP_PANEL_PAGE_PLAYER 0
+#define FLURMP_PANEL_PAGE_MEMORY 1
+#define FLURMP_PANEL_PAGE_COUNT  2
+
 /**
  * Creates a data panel.
  *
@@ -26,4 +31,14 @@ fl_data_panel* fl_create_data_panel(int x, int y, int w, int h, fl_font* font);
  */
 void fl_destroy_data_panel(fl_data_panel* panel);
 
+/**
+ * Selects the page of data shown by a data panel.
+ * Invalid pages are ignored.
+ *
+ * Params:
+ *   fl_data_panel - a data panel
+ *   int - a page (e.g. FLURMP_PANEL_PAGE_MEMORY)
+ */
+void fl_set_data_panel_page(fl_data_panel* panel, int page);
+
 #endif
@@ -27,14 +27,22 @@ fl_dialog* fl_create_dialog(fl_context* context);
 void fl_destroy_dialog(fl_dialog* context);
 
 /**
- * Creates a new dialog and writes a string of text to its buffer.
+ * Writes a string of text to the dialog of a context and makes it
+ * the active dialog. The dialog is created by the first call and
+ * reused by every later one.
+ * The text is wrapped to the width of the dialog and split into
+ * pages when it does not fit in the dialog.
+ * The string must remain valid for the lifetime of the dialog.
  *
  * Params:
  *   fl_context - a Flurmp context
  *   const char* - a string of text
- *   int - the rate at which the individual characters should appear
+ *   int - the rate at which the individual characters should appear.
+ *         At a rate of 1, 60 characters appear per second. A rate of
+ *         0 or less displays each page immediately.
  *   void(*callback) (fl_context*) - a callback function
- *   int - 1 if the dialog should remain and be destroyed later otherwise 0
+ *   int - 1 if the dialog should remain open until it is closed
+ *         with fl_close_dialog, otherwise 0
  */
 void fl_dialog_write(fl_context* context,
 	const char* msg,
@@ -42,4 +50,14 @@ void fl_dialog_write(fl_context* context,
 	void(*callback) (fl_context*),
 	int hold);
 
+/**
+ * Closes the active dialog and returns input control to the
+ * previous input handler. Dialogs marked as hold must be closed
+ * with this function by their callback.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_close_dialog(fl_context* context);
+
 #endif
\ No newline at end of file
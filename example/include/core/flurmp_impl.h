@@ -16,10 +16,82 @@
 #define FLURMP_WINDOW_WIDTH 640
 #define FLURMP_WINDOW_HEIGHT 480
 
+/* maximum number of bytes of text input received in one frame */
+#define FLURMP_TEXT_INPUT_LIMIT 64
+
+/* input latency histogram */
+#define FLURMP_LATENCY_BUCKETS 25
+#define FLURMP_LATENCY_BUCKET_MS 4
+
+/* profiled sections of a frame */
+#define FLURMP_PROFILE_UPDATE   0
+#define FLURMP_PROFILE_RENDER   1
+#define FLURMP_PROFILE_SECTIONS 2
+
+/* console commands */
+#define FLURMP_COMMAND_BUCKETS 64
+#define FLURMP_COMMAND_LENGTH  208
+#define FLURMP_COMMAND_ARGS    16
+#define FLURMP_HISTORY_LIMIT   32
+
+/* memory tags, which attribute allocations to subsystems */
+#define FLURMP_MEMORY_TAG_GENERAL  0
+#define FLURMP_MEMORY_TAG_ENTITY   1
+#define FLURMP_MEMORY_TAG_SCHEDULE 2
+#define FLURMP_MEMORY_TAG_MENU     3
+#define FLURMP_MEMORY_TAG_DIALOG   4
+#define FLURMP_MEMORY_TAG_TEXT     5
+#define FLURMP_MEMORY_TAG_RESOURCE 6
+#define FLURMP_MEMORY_TAG_AUDIO    7
+#define FLURMP_MEMORY_TAG_PARTICLE 8
+#define FLURMP_MEMORY_TAG_COUNT    9
+
+/* The tag given to fl_alloc. A source file can attribute its
+   allocations to a subsystem by defining this before its includes. */
+#ifndef FLURMP_MEMORY_TAG
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_GENERAL
+#endif
+
+/* task graphs */
+#define FLURMP_TASK_WORKER_LIMIT 8  /* most worker threads running a graph */
+#define FLURMP_TASK_NAME_LENGTH  48
+
+/* threads a task may run on */
+#define FLURMP_TASK_ANY  0 /* any thread; the task is not given the context */
+#define FLURMP_TASK_MAIN 1 /* the thread running the graph */
+
+/* audio */
+#define FLURMP_AUDIO_RATE   44100
+#define FLURMP_AUDIO_FRAMES 512 /* frames in each buffer the device asks for */
+#define FLURMP_AUDIO_VOICES 16  /* most sounds playing at once */
+#define FLURMP_AUDIO_QUEUE  256 /* slots of the command queue, a power of two */
+
+/* audio commands */
+#define FLURMP_AUDIO_PLAY   0
+#define FLURMP_AUDIO_STOP   1
+#define FLURMP_AUDIO_VOLUME 2
+#define FLURMP_AUDIO_MASTER 3
+
+/* most particles of one kind alive at once */
+#define FLURMP_PARTICLE_LIMIT 65536
+
+/* maximum number of projectiles in flight at once */
+#define FLURMP_PROJECTILE_LIMIT 1
+
+/* render layers, drawn in ascending order */
+#define FLURMP_LAYER_SCENERY  0
+#define FLURMP_LAYER_ENTITIES 1
+#define FLURMP_LAYER_UI       2
+#define FLURMP_LAYER_COUNT    3
+
 /* axes */
 #define FLURMP_AXIS_X 0
 #define FLURMP_AXIS_Y 1
 
+/* Bodies move in fixed point, with this many bits below the pixel. */
+#define FLURMP_BODY_SHIFT 8
+#define FLURMP_BODY_ONE   (1 << FLURMP_BODY_SHIFT)
+
 /* camera boundaries */
 #define FLURMP_LEFT_BOUNDARY 220
 #define FLURMP_RIGHT_BOUNDARY 430
@@ -30,14 +102,24 @@
 #define FLURMP_ERR_CONTEXT       0x01
 #define FLURMP_ERR_WINDOW        0x02
 #define FLURMP_ERR_RENDERER      0x03
-#define FLURMP_ERR_INPUT_FLAGS   0x04
+#define FLURMP_ERR_INPUT_ACTIONS 0x04
 #define FLURMP_ERR_ENTITY_TYPES  0x05
 #define FLURMP_ERR_FONTS         0x06
 #define FLURMP_ERR_IMAGES        0x07
 #define FLURMP_ERR_INPUT_HANDLER 0x08
+#define FLURMP_ERR_ENTITY_GROUPS 0x0A
+#define FLURMP_ERR_RENDER_QUEUE  0x0B
+#define FLURMP_ERR_ANIMATORS     0x0C
+#define FLURMP_ERR_MENUS         0x0D
+#define FLURMP_ERR_COMMANDS      0x0E
+#define FLURMP_ERR_ENTITIES      0x0F
+#define FLURMP_ERR_WORLD         0x10
+#define FLURMP_ERR_STARTUP       0x11
+#define FLURMP_ERR_PARTICLES     0x12
 
 /**
  * Memory allocation
+ * The allocation is attributed to the file's FLURMP_MEMORY_TAG.
  *
  * Params:
  *   t - the data type to which the resulting pointer will be cast
@@ -46,7 +128,20 @@
  * Returns:
  *   t - a pointer to a block of memory cast as type t
  */
-#define fl_alloc(t,n) (t*)fl_allocate_(sizeof(t) * n)
+#define fl_alloc(t,n) fl_alloc_tagged(t, n, FLURMP_MEMORY_TAG)
+
+/**
+ * Memory allocation attributed to a subsystem
+ *
+ * Params:
+ *   t - the data type to which the resulting pointer will be cast
+ *   n - the number of elements to allocate
+ *   tag - a memory tag (e.g. FLURMP_MEMORY_TAG_ENTITY)
+ *
+ * Returns:
+ *   t - a pointer to a block of memory cast as type t
+ */
+#define fl_alloc_tagged(t,n,tag) (t*)fl_allocate_(sizeof(t) * (n), tag, __FILE__, __LINE__)
 
 /**
  * Memory release
@@ -74,21 +169,97 @@
  */
 #define fl_zero(a,n) { int i; for (i = 0; i < n; i++) a[i] = '\0'; }
 
+/**
+ * A handle that refers to no entity. Generation 0 is never
+ * given to an entity, so a zeroed handle is also a null handle.
+ */
+#define FLURMP_NULL_HANDLE ((fl_handle){ -1, 0 })
+
 struct fl_image {
 	int w;
 	int h;
 	fl_texture* texture;
 };
 
+/* dimensions of a glyph atlas page in pixels */
+#define FLURMP_GLYPH_PAGE_SIZE 256
+
+/* maximum number of atlas pages held by a font */
+#define FLURMP_GLYPH_PAGE_LIMIT 4
+
+/* number of buckets in the glyph lookup table (a power of two) */
+#define FLURMP_GLYPH_BUCKETS 256
+
+/**
+ * A rasterized code point.
+ * The glyph occupies the src rectangle of an atlas page and is
+ * linked into both its hash bucket and the list of its page.
+ * Glyphs loaded from a baked font have a page of -1: they live in
+ * the baked atlas for as long as the font does.
+ */
+typedef struct fl_glyph {
+	unsigned int code;
+	int size;
+	int page;
+	fl_texture* texture;
+	fl_rect src;
+	struct fl_glyph* next;
+	struct fl_glyph* page_next;
+}fl_glyph;
+
+/**
+ * A texture that glyphs are packed into on shelves.
+ * Glyphs fill the current shelf from left to right, and a new shelf
+ * is started below it when the next glyph does not fit.
+ * The page that was used least recently is recycled once
+ * a font reaches its page limit.
+ */
+typedef struct fl_glyph_page {
+	fl_texture* texture;
+	int shelf_x;
+	int shelf_y;
+	int shelf_h;
+	unsigned long used;
+	fl_glyph* glyphs;
+}fl_glyph_page;
+
 struct fl_font {
-	fl_ttf* impl;
-	int count;
-	fl_image** glyphs;
+	fl_ttf* impl;             /* NULL until needed if the font was baked */
+	char* path;               /* path to the TTF */
+	int size;
+	fl_glyph** buckets;
+	fl_glyph_page pages[FLURMP_GLYPH_PAGE_LIMIT];
+	int page_count;
+	fl_image* baked;          /* atlas of baked glyphs, or NULL */
+	fl_glyph* baked_glyphs;
+	int baked_count;
+	unsigned long clock;
 	fl_color forecolor;
 	fl_color backcolor;
 	int background;
 };
 
+/**
+ * A glyph of a static text run, positioned relative to the
+ * start of the run.
+ */
+typedef struct fl_text_glyph {
+	unsigned int code;
+	int x;
+}fl_text_glyph;
+
+/**
+ * A single line of text that is laid out once and
+ * drawn from the glyph atlas of its font.
+ */
+typedef struct fl_static_text {
+	fl_font* font;
+	fl_text_glyph* glyphs;
+	int glyph_count;
+	int w;
+	int h;
+}fl_static_text;
+
 struct fl_resource {
 	int type;
 	union {
@@ -100,15 +271,26 @@ struct fl_resource {
 struct fl_entity_type {
 	int w;
 	int h;
+	int layer;
+	int z;
 	fl_resource* texture;
 	fl_animation** animations;
 	int animation_count;
+	const fl_body_type* body;
 	void(*collide) (fl_context*, fl_entity*, fl_entity*, int, int);
 	void(*update) (fl_context*, fl_entity*, int);
 	void(*render) (fl_context*, fl_entity*);
+	void(*update_all) (fl_context*, fl_entity**, int, int);
+	void(*render_all) (fl_context*, fl_entity**, int);
+};
+
+struct fl_handle {
+	int index;
+	unsigned int generation;
 };
 
 struct fl_entity {
+	fl_handle handle;
 	int type;
 	unsigned short flags;
 	int x;
@@ -116,6 +298,8 @@ struct fl_entity {
 	int x_v;
 	int y_v;
 	fl_rect* frame;
+	int animator;
+	int body;
 	int life;
 	fl_entity* next;
 	fl_entity* tail;
@@ -123,8 +307,7 @@ struct fl_entity {
 
 struct fl_input_handler {
 	void(*handle_input) (fl_context*, fl_input_handler*);
-	fl_input_handler* child;
-	fl_input_handler* parent;
+	int depth;
 };
 
 struct fl_console {
@@ -136,6 +319,7 @@ struct fl_console {
 	int buffer_count;
 	int cursor_x;
 	int cursor_y;
+	int history_pos;
 	fl_font* font;
 	fl_input_handler* input_handler;
 	void(*render) (fl_context*, fl_console*);
@@ -144,11 +328,12 @@ struct fl_console {
 struct fl_menu_item {
 	int x;
 	int y;
-	fl_image* image;
+	fl_static_text* text;
 	void(*action) (fl_context*, fl_menu*);
 };
 
 struct fl_menu {
+	int id;
 	int x;
 	int y;
 	int w;
@@ -160,20 +345,35 @@ struct fl_menu {
 	void(*render) (fl_context*, fl_menu*);
 	void(*get_cursor_coords) (fl_menu*, int*, int*);
 	void(*callback) (fl_context*);
-	fl_menu* child;
-	fl_menu* parent;
 };
 
+/**
+ * A glyph placed by the dialog layout.
+ * The position is relative to the text area of the dialog
+ * and the row is relative to the page containing the glyph.
+ */
+typedef struct fl_dialog_glyph {
+	unsigned int code;
+	int w;
+	int x;
+	int row;
+}fl_dialog_glyph;
+
 struct fl_dialog {
 	int x;
 	int y;
 	int w;
 	int h;
-	char* buffer;
-	int buffer_count;
 	const char* msg;
-	size_t len;
-	size_t counter;
+	fl_dialog_glyph* glyphs;
+	int glyph_count;
+	int glyph_capacity;
+	int* pages;
+	int page_count;
+	int page_capacity;
+	int page;
+	int revealed;
+	unsigned long page_ticks;
 	int speed;
 	int hold;
 	fl_font* font;
@@ -190,6 +390,7 @@ struct fl_data_panel {
 	int h;
 	char* buffer;
 	int buffer_count;
+	int page;
 	fl_font* font;
 	void(*update) (fl_context*, fl_data_panel*);
 	void(*render) (fl_context*, fl_data_panel*);
@@ -197,19 +398,474 @@ struct fl_data_panel {
 
 struct fl_animation {
 	fl_rect* frames;
+	int* durations;
 	int frame_count;
 };
 
+/**
+ * The animation state of a single entity.
+ * Animators are stored contiguously in the context so that all of them
+ * can be advanced in one pass.
+ */
+typedef struct fl_animator {
+	fl_entity* entity;
+	fl_animation* animation;
+	int frame;
+	int timer;
+}fl_animator;
+
+typedef struct fl_animator_list {
+	fl_animator* items;
+	int count;
+	int capacity;
+}fl_animator_list;
+
+/**
+ * How the bodies of an entity type move, in fixed point pixels
+ * per update (see FLURMP_BODY_ONE).
+ */
+struct fl_body_type {
+	int gravity;  /* added to the y velocity each update */
+	int max_fall; /* y velocity past which gravity stops adding */
+	int friction; /* taken off the x velocity each update */
+};
+
+/**
+ * The bodies of every entity that moves. Each property is kept in an
+ * array of its own, so that moving every body along an axis is one
+ * pass over plain arrays. Positions and velocities are fixed point,
+ * and their whole pixels are copied to and from the entities around
+ * that pass, which keeps the fraction of a pixel between updates.
+ */
+typedef struct fl_body_list {
+	fl_entity** entities;
+	int* x;
+	int* y;
+	int* x_v;
+	int* y_v;
+	int* gravity;
+	int* max_fall;
+	int* friction;
+	int count;
+	int capacity;
+}fl_body_list;
+
 struct fl_schedule {
 	int done;
 	int counter;
 	int limit;
-	void* target;
-	void(*action)(fl_context*, fl_schedule*, void*);
+	fl_handle target;
+	void(*action)(fl_context*, fl_schedule*, fl_entity*);
 	fl_schedule* next;
 	fl_schedule* prev;
 };
 
+/**
+ * All entities of a single type stored contiguously so that
+ * they can be updated and rendered in one pass per type.
+ */
+typedef struct fl_entity_group {
+	int type;
+	fl_entity** entities;
+	int count;
+	int capacity;
+}fl_entity_group;
+
+/**
+ * Input to present latency statistics.
+ * Bucket i of the histogram counts latencies from i * FLURMP_LATENCY_BUCKET_MS
+ * up to the next bucket. The last bucket counts everything beyond that.
+ */
+typedef struct fl_latency {
+	int pending;
+	unsigned int stamp;
+	unsigned int histogram[FLURMP_LATENCY_BUCKETS];
+	unsigned int samples;
+	unsigned long total;
+	unsigned int max;
+}fl_latency;
+
+/**
+ * Time spent in each profiled section of a frame, in performance
+ * counter ticks. Nothing is measured while the profiler is disabled.
+ */
+typedef struct fl_profiler {
+	int enabled;
+	unsigned long long start;
+	unsigned long long total[FLURMP_PROFILE_SECTIONS];
+	unsigned long long peak[FLURMP_PROFILE_SECTIONS];
+	unsigned long samples[FLURMP_PROFILE_SECTIONS];
+}fl_profiler;
+
+/**
+ * A console command. The arguments passed to the handler
+ * include the command name as the first argument.
+ */
+typedef struct fl_command {
+	const char* name;
+	const char* help;
+	void(*run) (fl_context*, int, char**);
+	struct fl_command* next;
+}fl_command;
+
+/**
+ * Console commands hashed by name, and the most recently
+ * executed lines. The history is a ring indexed by the total
+ * number of lines executed.
+ */
+typedef struct fl_command_registry {
+	fl_command** buckets;
+	int count;
+	char history[FLURMP_HISTORY_LIMIT][FLURMP_COMMAND_LENGTH];
+	int history_count;
+}fl_command_registry;
+
+/**
+ * Something to be drawn during the current frame.
+ * Items are drawn in order of layer, then z, then the order
+ * in which they were queued.
+ */
+typedef struct fl_render_item {
+	int layer;
+	int z;
+	int seq;
+	void* target;
+	void(*render) (fl_context*, void*);
+}fl_render_item;
+
+typedef struct fl_render_queue {
+	fl_render_item* items;
+	int count;
+	int capacity;
+}fl_render_queue;
+
+/**
+ * A static layer is drawn once into a cached texture covering
+ * the bounds of its contents in world coordinates. The cache is
+ * redrawn only when the layer is marked dirty.
+ */
+typedef struct fl_render_layer {
+	int is_static;
+	int dirty;
+	fl_texture* cache;
+	fl_rect bounds;
+}fl_render_layer;
+
+/**
+ * A copy of the rendered world used while the world is frozen,
+ * such as while the application is paused or a dialog is open.
+ */
+typedef struct fl_world_snapshot {
+	fl_texture* texture;
+	int valid;
+	int cam_x;
+	int cam_y;
+}fl_world_snapshot;
+
+/**
+ * A stack of input handlers. The handler at the top index receives
+ * input, and each handler records its own index as its depth so that
+ * it can pass input to the handler below it.
+ */
+typedef struct fl_input_stack {
+	fl_input_handler** items;
+	int top;
+	int capacity;
+}fl_input_stack;
+
+/**
+ * A stack of open menus. The menu at the top index is the active menu.
+ */
+typedef struct fl_menu_stack {
+	fl_menu** items;
+	int top;
+	int capacity;
+}fl_menu_stack;
+
+/**
+ * Maps entity handles to entities. Each slot holds an entity and the
+ * generation of the slot, which advances whenever its entity is
+ * removed. Unused slots are kept on a free list for reuse.
+ */
+typedef struct fl_entity_table {
+	fl_entity** slots;
+	unsigned int* generations;
+	int* free_slots;
+	int free_count;
+	int count;
+	int capacity;
+}fl_entity_table;
+
+/* structural changes that can be requested during an update */
+#define FLURMP_ENTITY_COMMAND_SPAWN   0
+#define FLURMP_ENTITY_COMMAND_DESPAWN 1
+#define FLURMP_ENTITY_COMMAND_RETYPE  2
+
+/**
+ * A structural change to the entities of a context, requested
+ * while they are being iterated and applied after the update.
+ */
+typedef struct fl_entity_command {
+	int command;
+	fl_handle target;
+	fl_entity* entity; /* the entity to add, for a spawn */
+	int type;          /* the new entity type, for a type change */
+}fl_entity_command;
+
+/**
+ * The entity commands requested during the current update, in order.
+ * The storage is kept from one update to the next.
+ */
+typedef struct fl_entity_command_list {
+	fl_entity_command* items;
+	int count;
+	int capacity;
+}fl_entity_command_list;
+
+/* states of a world chunk */
+#define FLURMP_CHUNK_UNLOADED 0
+#define FLURMP_CHUNK_LOADED   1
+#define FLURMP_CHUNK_ACTIVE   2
+
+/**
+ * An entity of a world chunk, as it is kept while the chunk is
+ * not active.
+ */
+typedef struct fl_chunk_record {
+	int type;
+	int x;
+	int y;
+}fl_chunk_record;
+
+/**
+ * A rectangular piece of a streamed world. A loaded chunk holds the
+ * records of its entities, and an active chunk has also added those
+ * entities to the context. An unloaded chunk holds nothing.
+ */
+typedef struct fl_chunk {
+	int state;
+	int count;
+	fl_chunk_record* records;
+	fl_handle* handles; /* the entities of an active chunk */
+}fl_chunk;
+
+/**
+ * The size and contents of a streamed world, and how far from the
+ * camera its chunks are kept. Distances are counted in chunks.
+ */
+typedef struct fl_world_config {
+	int columns;
+	int rows;
+	int chunk_w;
+	int chunk_h;
+
+	/* entities in each chunk */
+	int blocks;
+	int spikes;
+	int doors;
+	int pellets;
+
+	int active_radius; /* chunks with entities in the context */
+	int load_radius;   /* chunks with their records in memory */
+	int hysteresis;    /* extra distance before a chunk is let go */
+	int load_budget;   /* chunks loaded ahead of the camera per update */
+
+	unsigned int seed;
+}fl_world_config;
+
+/**
+ * A world divided into chunks, only some of which are resident.
+ */
+typedef struct fl_world {
+	fl_world_config config;
+	fl_chunk* chunks; /* row major */
+
+	/* indices of the loaded and active chunks */
+	int* resident;
+	int resident_count;
+	int resident_capacity;
+
+	int active_count;
+
+	/* chunks loaded and activated during the last update */
+	int loads;
+	int activations;
+}fl_world;
+
+/**
+ * A step of a task graph. A task is started once every task it
+ * depends on has finished. The start and end are performance counter
+ * values, and the thread is 0 for the thread that ran the graph and
+ * counts up from 1 for its workers.
+ */
+typedef struct fl_task {
+	char name[FLURMP_TASK_NAME_LENGTH];
+	void(*run) (fl_context*, void*);
+	void* data;
+	int where;
+	int pending; /* dependencies that haven't finished */
+	int thread;
+	unsigned long long start;
+	unsigned long long end;
+}fl_task;
+
+/**
+ * A worker thread of a task graph.
+ */
+typedef struct fl_task_worker {
+	struct fl_task_graph* graph;
+	fl_thread* thread;
+	int index;
+}fl_task_worker;
+
+/**
+ * Tasks, the dependencies between them, and what runs them.
+ * Each task is queued exactly once, so the queues are as long
+ * as the task list and are only ever appended to.
+ */
+typedef struct fl_task_graph {
+	fl_task* tasks;
+	int count;
+	int capacity;
+
+	/* pairs of a dependency and the task that depends on it */
+	int* edges;
+	int edge_count;
+	int edge_capacity;
+
+	/* tasks ready to run, on the main thread or on any thread */
+	int* main_queue;
+	int main_head;
+	int main_tail;
+	int* any_queue;
+	int any_head;
+	int any_tail;
+
+	int running;
+	int finished;
+	int quit;
+
+	fl_mutex* lock;
+	fl_cond* wake_workers; /* work has been queued, or the graph is done */
+	fl_cond* wake_main;    /* a task has finished */
+	fl_task_worker workers[FLURMP_TASK_WORKER_LIMIT];
+	int worker_count;
+
+	fl_context* context;
+	unsigned long long origin;
+}fl_task_graph;
+
+/**
+ * A sound decoded into interleaved 16-bit stereo samples.
+ */
+typedef struct fl_sound {
+	short* samples;
+	int frames;
+}fl_sound;
+
+/**
+ * A request from the game thread to the audio thread. Voices are
+ * named by the id that fl_play_sound returned for them.
+ */
+typedef struct fl_audio_command {
+	int type;
+	int voice;
+	int sound;
+	float volume;
+}fl_audio_command;
+
+/**
+ * A sound being played. The voice is free when it has no sound.
+ * The position counts samples rather than frames.
+ */
+typedef struct fl_voice {
+	const fl_sound* sound;
+	int id;
+	int position;
+	float volume;
+}fl_voice;
+
+/**
+ * Sounds, and the mixer that plays them on the audio thread.
+ *
+ * The game thread only ever writes commands and the tail of the queue,
+ * and the audio thread only ever reads them and writes the head, so
+ * neither waits for the other. A full queue drops commands instead.
+ * One slot is kept empty to tell a full queue from an empty one.
+ */
+typedef struct fl_audio {
+	fl_audio_device device;
+	fl_sound* sounds;
+	int sound_count;
+
+	fl_audio_command queue[FLURMP_AUDIO_QUEUE];
+	fl_atomic head; /* next command to apply */
+	fl_atomic tail; /* next slot to write */
+
+	/* game thread */
+	int next_voice;
+	float volume;
+	int dropped;
+
+	/* audio thread */
+	fl_voice voices[FLURMP_AUDIO_VOICES];
+	float master;
+	float mix[FLURMP_AUDIO_FRAMES * 2];
+
+	/* mixing times of the audio thread, in performance counter
+	   ticks, which may be read once the device is closed */
+	int callbacks;
+	unsigned long long mix_ticks;
+	unsigned long long max_mix_ticks;
+}fl_audio;
+
+/**
+ * The particles of one kind. Each property is kept in an array of its
+ * own, so that a frame's update is a few passes over plain arrays and
+ * a particle is only ever an index. A pool is drawn as a single batch
+ * of quads, four vertices and six indices per particle.
+ */
+typedef struct fl_particle_pool {
+	int kind;
+	float* x;
+	float* y;
+	float* x_v;
+	float* y_v;
+	float* life; /* frames left to live */
+	int count;
+	int capacity;
+
+	fl_vertex* vertices;
+	int* indices; /* the same for every frame, so only built on growth */
+}fl_particle_pool;
+
+/**
+ * Emits particles from the center of an entity, for a number of
+ * frames or until the entity is gone.
+ */
+typedef struct fl_particle_emitter {
+	int kind;
+	fl_handle target;
+	float rate;    /* particles per frame */
+	float pending; /* part of a particle carried over to the next frame */
+	int frames;    /* frames left, or -1 to last as long as the entity */
+}fl_particle_emitter;
+
+/**
+ * Particles, which live outside the entity list. They don't collide,
+ * and they are updated and drawn by kind rather than one at a time.
+ */
+typedef struct fl_particle_system {
+	fl_particle_pool* pools;
+	int pool_count;
+
+	fl_particle_emitter* emitters;
+	int emitter_count;
+	int emitter_capacity;
+
+	unsigned int seed;
+}fl_particle_system;
+
 typedef struct fl_transition {
 	int scheduled;
 	int from_scene;
@@ -223,8 +879,12 @@ struct fl_context {
 	fl_renderer* renderer;
 	fl_event event;
 	struct {
-		const Uint8* keystates;
-		int* flags;
+		unsigned int held[FLURMP_KEY_WORDS];
+		unsigned int pressed[FLURMP_KEY_WORDS];
+		unsigned int released[FLURMP_KEY_WORDS];
+		int* actions;
+		char text[FLURMP_TEXT_INPUT_LIMIT];
+		int text_count;
 	} input;
 
 	/* Registries */
@@ -235,22 +895,56 @@ struct fl_context {
 	/* Linked list of entities */
 	fl_entity* entities;
 
-	/* Pointer to the projectile entities */
-	fl_entity* projectiles;
+	/* Handles of the entities, and the number despawned since
+	   the entity list was last compacted */
+	fl_entity_table entity_table;
+	int despawned;
+
+	/* Spawns, despawns and type changes waiting for the end of the update */
+	fl_entity_command_list entity_commands;
+
+	/* The streamed world of the current scene, if it has one */
+	fl_world* world;
+
+	/* Entities grouped by type, indexed by entity type */
+	fl_entity_group* entity_groups;
+
+	/* Render layers and the queue of items to draw this frame */
+	fl_render_layer layers[FLURMP_LAYER_COUNT];
+	fl_render_queue render_queue;
+
+	/* The world as it was when it was last frozen */
+	fl_world_snapshot snapshot;
+
+	/* Projectiles in flight */
+	fl_handle projectiles[FLURMP_PROJECTILE_LIMIT];
 
 	/* Linked list of schedules */
 	fl_schedule* schedules;
 
-	/* Linked list of input handlers */
-	fl_input_handler* input_handler;
+	/* Animation state of animated entities */
+	fl_animator_list animators;
+
+	/* Positions and velocities of the entities that move */
+	fl_body_list bodies;
+
+	/* Particle pools and emitters */
+	fl_particle_system particles;
+
+	/* Stack of input handlers, the root input handler at the bottom */
+	fl_input_stack input_handlers;
 
 	/* Structures directly affected by input */
 	fl_console* console;
-	fl_entity* pco;
+	fl_handle pco;
 	fl_dialog* active_dialog;
-	fl_menu* active_menu;
+	fl_menu_stack menu_stack;
 	fl_data_panel* data_panel;
 
+	/* Menus and the dialog kept for reuse after they are closed */
+	fl_menu** menus;
+	fl_dialog* dialog_cache;
+
 	/* Camera position */
 	int cam_x;
 	int cam_y;
@@ -267,6 +961,21 @@ struct fl_context {
 	/* Tick count used for regulating framerate */
 	unsigned long ticks;
 
+	/* Sleep before polling input rather than after rendering */
+	int low_latency;
+
+	/* Sound effects, or NULL when there is no audio device */
+	fl_audio* audio;
+
+	/* Input to present latency statistics */
+	fl_latency latency;
+
+	/* Frame section timings */
+	fl_profiler profiler;
+
+	/* Console commands */
+	fl_command_registry commands;
+
 	/* Completion flag */
 	int done;
 
@@ -314,14 +1023,18 @@ void fl_set_rect(fl_rect* r, int x, int y, int w, int h);
 
 /**
  * A helper function used to manage memory allocation.
+ * Each block is tracked until it is freed; see core/memory.h.
  *
  * Params:
  *   size_t - the size of the memory block to allocated
+ *   int - the memory tag of the subsystem making the allocation
+ *   const char* - the source file making the allocation
+ *   int - the line making the allocation
  *
  * Returns:
  *   void* - a pointer to a newly allocated block of memory
  */
-void* fl_allocate_(size_t s);
+void* fl_allocate_(size_t s, int tag, const char* file, int line);
 
 /**
  * A helper function used to manage the release of dynamically
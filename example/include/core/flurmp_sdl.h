@@ -3,9 +3,11 @@
  * This API provides functions for the following actions:
  *   creating a window
  *   creating a renderer
- *   loading bmp image files
+ *   loading bmp and baked image files
  *   loading ttf font files
+ *   loading wav files and playing audio
  *   rendering data to the screen
+ *   running work on other threads
  */
 #ifndef FLURMP_SDL_H
 #define FLURMP_SDL_H
@@ -15,8 +17,16 @@
 #include <SDL/SDL.h>
 #include <SDL/SDL_ttf.h>
 
-#define FLURMP_QUIT     SDL_QUIT
-#define FLURMP_SC_LIMIT SDL_NUM_SCANCODES
+#define FLURMP_QUIT      SDL_QUIT
+#define FLURMP_KEYDOWN   SDL_KEYDOWN
+#define FLURMP_KEYUP     SDL_KEYUP
+#define FLURMP_TEXTINPUT SDL_TEXTINPUT
+#define FLURMP_RENDER_TARGETS_RESET SDL_RENDER_TARGETS_RESET
+#define FLURMP_SC_LIMIT  SDL_NUM_SCANCODES
+
+/* size of the key bit sets (one bit per scancode) */
+#define FLURMP_KEY_WORD_BITS 32
+#define FLURMP_KEY_WORDS ((FLURMP_SC_LIMIT + FLURMP_KEY_WORD_BITS - 1) / FLURMP_KEY_WORD_BITS)
 
 /* -------------------------------------------------------------- */
 /*                          Scancodes                             */
@@ -77,6 +87,9 @@
 #define FLURMP_SC_MINUS        SDL_SCANCODE_MINUS
 #define FLURMP_SC_EQUALS       SDL_SCANCODE_EQUALS
 #define FLURMP_SC_BACKTICK     SDL_SCANCODE_GRAVE /* 56th */
+#define FLURMP_SC_TAB          SDL_SCANCODE_TAB
+#define FLURMP_SC_UP           SDL_SCANCODE_UP
+#define FLURMP_SC_DOWN         SDL_SCANCODE_DOWN
 
 
 
@@ -86,10 +99,18 @@
 typedef SDL_Rect     fl_rect;
 typedef SDL_Color    fl_color;
 typedef SDL_Texture  fl_texture;
+typedef SDL_Surface  fl_surface;
 typedef TTF_Font     fl_ttf;
 typedef SDL_Window   fl_window;
 typedef SDL_Renderer fl_renderer;
 typedef SDL_Event    fl_event;
+typedef SDL_Thread   fl_thread;
+typedef SDL_mutex    fl_mutex;
+typedef SDL_cond     fl_cond;
+typedef SDL_SpinLock fl_spinlock;
+typedef SDL_atomic_t fl_atomic;
+typedef SDL_AudioDeviceID fl_audio_device;
+typedef SDL_Vertex   fl_vertex;
 
 
 
@@ -141,14 +162,266 @@ fl_renderer* fl_create_renderer(fl_window*);
 void fl_destroy_renderer(fl_renderer* renderer);
 
 /**
- * Gets an array of key states.
- * Each element will have a value of zero if the corresponding
- * key is not actuated, otherwise it will have a non zero value.
+ * Gets the largest texture dimensions supported by a renderer.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int* - a reference to an integer to receive the width
+ *   int* - a reference to an integer to receive the height
+ */
+void fl_get_max_texture_size(fl_context*, int*, int*);
+
+/**
+ * Starts receiving text input events.
+ * Text input should be enabled while a text field such as
+ * the console is accepting input.
+ */
+void fl_start_text_input();
+
+/**
+ * Stops receiving text input events.
+ */
+void fl_stop_text_input();
+
+/**
+ * Reads the high resolution counter used for profiling.
+ *
+ * Returns:
+ *   unsigned long long - the current value of the counter
+ */
+unsigned long long fl_get_performance_counter();
+
+/**
+ * Gets the number of high resolution counter ticks per second.
+ *
+ * Returns:
+ *   unsigned long long - the counter frequency
+ */
+unsigned long long fl_get_performance_frequency();
+
+
+
+/* -------------------------------------------------------------- */
+/*                        Asset Functions                         */
+/* -------------------------------------------------------------- */
+
+/**
+ * Reads the whole of an asset. The contents are returned straight
+ * from the asset pack if the pack has the asset, and are otherwise
+ * read from a file.
+ *
+ * Params:
+ *   const char* - the path to the asset
+ *   size_t* - receives the size of the asset
+ *
+ * Returns:
+ *   const unsigned char* - the contents of the asset, which must be
+ *                          released with fl_release_asset, or NULL
+ *                          on failure
+ */
+const unsigned char* fl_read_asset(const char*, size_t*);
+
+/**
+ * Releases the contents of an asset read with fl_read_asset.
+ *
+ * Params:
+ *   const unsigned char* - the contents of an asset
+ */
+void fl_release_asset(const unsigned char*);
+
+
+
+/* -------------------------------------------------------------- */
+/*                        Thread Functions                        */
+/* -------------------------------------------------------------- */
+
+/**
+ * Starts a thread.
+ *
+ * Params:
+ *   int (*)(void*) - the function the thread runs
+ *   const char* - the name of the thread, for debuggers
+ *   void* - the data passed to the function
+ *
+ * Returns:
+ *   fl_thread - the new thread, or NULL on failure
+ */
+fl_thread* fl_create_thread(int (*)(void*), const char*, void*);
+
+/**
+ * Waits for a thread to return and frees it.
+ *
+ * Params:
+ *   fl_thread - a thread
+ */
+void fl_wait_thread(fl_thread*);
+
+/**
+ * Creates a mutex.
+ *
+ * Returns:
+ *   fl_mutex - a new mutex, or NULL on failure
+ */
+fl_mutex* fl_create_mutex();
+
+/**
+ * Frees the memory allocated for a mutex.
+ *
+ * Params:
+ *   fl_mutex - an unlocked mutex
+ */
+void fl_destroy_mutex(fl_mutex*);
+
+/**
+ * Locks a mutex, waiting for other threads to unlock it.
+ *
+ * Params:
+ *   fl_mutex - a mutex
+ */
+void fl_lock_mutex(fl_mutex*);
+
+/**
+ * Unlocks a mutex.
+ *
+ * Params:
+ *   fl_mutex - a mutex locked by this thread
+ */
+void fl_unlock_mutex(fl_mutex*);
+
+/**
+ * Creates a condition variable.
+ *
+ * Returns:
+ *   fl_cond - a new condition variable, or NULL on failure
+ */
+fl_cond* fl_create_cond();
+
+/**
+ * Frees the memory allocated for a condition variable.
+ *
+ * Params:
+ *   fl_cond - a condition variable nothing is waiting on
+ */
+void fl_destroy_cond(fl_cond*);
+
+/**
+ * Unlocks a mutex and waits until a condition variable is signaled,
+ * then locks the mutex again. Waits may also end spuriously, so the
+ * condition must be checked again afterwards.
+ *
+ * Params:
+ *   fl_cond - a condition variable
+ *   fl_mutex - a mutex locked by this thread
+ */
+void fl_wait_cond(fl_cond*, fl_mutex*);
+
+/**
+ * Wakes every thread waiting on a condition variable.
+ *
+ * Params:
+ *   fl_cond - a condition variable
+ */
+void fl_broadcast_cond(fl_cond*);
+
+/**
+ * Locks a spin lock. Spin locks suit sections that are only
+ * a few instructions long.
+ *
+ * Params:
+ *   fl_spinlock* - a spin lock, which starts out as 0
+ */
+void fl_lock_spin(fl_spinlock*);
+
+/**
+ * Unlocks a spin lock.
+ *
+ * Params:
+ *   fl_spinlock* - a spin lock locked by this thread
+ */
+void fl_unlock_spin(fl_spinlock*);
+
+/**
+ * Reads an atomic integer. Whatever the thread that set the integer
+ * wrote before setting it is visible once its value has been read.
+ *
+ * Params:
+ *   fl_atomic* - an atomic integer
+ *
+ * Returns:
+ *   int - the value of the integer
+ */
+int fl_atomic_get(fl_atomic*);
+
+/**
+ * Sets an atomic integer.
+ *
+ * Params:
+ *   fl_atomic* - an atomic integer
+ *   int - the new value
+ */
+void fl_atomic_set(fl_atomic*, int);
+
+/**
+ * Gets the number of logical CPU cores.
+ *
+ * Returns:
+ *   int - the number of cores, at least 1
+ */
+int fl_get_cpu_count();
+
+
+
+/* -------------------------------------------------------------- */
+/*                        Audio Functions                         */
+/* -------------------------------------------------------------- */
+
+/**
+ * Opens the default audio device and starts playing. The device takes
+ * interleaved signed 16-bit stereo samples, which are converted to
+ * whatever the hardware wants. The callback runs on the audio thread
+ * and must fill the whole buffer every time, so it must not wait on
+ * anything the game thread holds.
+ *
+ * Setting the SDL_AUDIODRIVER environment variable to dummy or disk
+ * before fl_initialize plays to no hardware, or to a file.
+ *
+ * Params:
+ *   int - the sample rate
+ *   int - the number of frames in each buffer, a power of two
+ *   void (*)(void*, unsigned char*, int) - the callback, which is given
+ *                                          the data, a buffer and the
+ *                                          size of the buffer in bytes
+ *   void* - the data passed to the callback
+ *
+ * Returns:
+ *   fl_audio_device - the device, or 0 on failure
+ */
+fl_audio_device fl_open_audio(int, int, void (*)(void*, unsigned char*, int), void*);
+
+/**
+ * Stops and closes an audio device. Once this returns,
+ * the callback won't be called again.
+ *
+ * Params:
+ *   fl_audio_device - an audio device
+ */
+void fl_close_audio(fl_audio_device);
+
+/**
+ * Reads a wav file and converts it into interleaved signed 16-bit
+ * stereo samples at a sample rate. Since no device is touched,
+ * wav files can be loaded on any thread.
+ *
+ * Params:
+ *   const char* - the path to the wav file
+ *   int - the sample rate to convert to
+ *   int* - receives the number of frames
  *
  * Returns:
- *   const unsigned char* an array of key states
+ *   short* - the samples, which must be freed with fl_free,
+ *            or NULL on failure
  */
-const unsigned char* fl_get_key_states();
+short* fl_load_wav(const char*, int, int*);
 
 
 
@@ -169,6 +442,63 @@ const unsigned char* fl_get_key_states();
  */
 int fl_load_bmp(fl_context*, const char*, fl_image*);
 
+/**
+ * Loads an image baked by the flurmp_bake tool into an image structure.
+ * The pixels are uploaded as they are, without any conversion.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - the path to the baked image
+ *   fl_image - a reference to an image structure
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_load_baked_image(fl_context*, const char*, fl_image*);
+
+/**
+ * Loads a QOI image into an image structure.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - the path to the QOI image
+ *   fl_image - a reference to an image structure
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_load_qoi(fl_context*, const char*, fl_image*);
+
+/**
+ * Reads and decodes an image into premultiplied RGBA8888 pixels
+ * without uploading it. Baked and QOI images are recognized by their
+ * extensions, and anything else is loaded as a bmp with the color
+ * 255, 0, 255 made transparent. Since the renderer isn't touched,
+ * images can be decoded on any thread.
+ *
+ * Params:
+ *   const char* - the path to the image
+ *
+ * Returns:
+ *   fl_surface - the decoded pixels, which are destroyed with
+ *                fl_destroy_surface, or NULL on failure
+ */
+fl_surface* fl_decode_image(const char*);
+
+/**
+ * Uploads an image decoded by fl_decode_image into an image structure.
+ * Only the thread that created the renderer may upload images.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_surface - a decoded image, which is not destroyed
+ *   fl_image - a reference to an image structure
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_upload_image(fl_context*, fl_surface*, fl_image*);
+
 /**
  * Frees the memory allocated for an image structure.
  *
@@ -177,6 +507,64 @@ int fl_load_bmp(fl_context*, const char*, fl_image*);
  */
 void fl_destroy_image(fl_image*);
 
+/**
+ * Creates a transparent texture that can be used as a render target.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the width
+ *   int - the height
+ *
+ * Returns:
+ *   fl_texture - a new texture, or NULL on failure
+ */
+fl_texture* fl_create_target_texture(fl_context*, int, int);
+
+/**
+ * Frees the memory allocated for a texture.
+ *
+ * Params:
+ *   fl_texture - a texture
+ */
+void fl_destroy_texture(fl_texture*);
+
+/**
+ * Creates a transparent texture that is filled by uploading pixels.
+ * Unlike render targets, the contents of these textures are kept
+ * when the renderer is reset.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the width
+ *   int - the height
+ *
+ * Returns:
+ *   fl_texture - a new texture, or NULL on failure
+ */
+fl_texture* fl_create_atlas_texture(fl_context*, int, int);
+
+/**
+ * Copies the pixels of a surface into an area of a texture
+ * created with fl_create_atlas_texture.
+ *
+ * Params:
+ *   fl_texture - a texture
+ *   fl_rect - the area of the texture to fill
+ *   fl_surface - a surface the size of the area
+ *
+ * Returns:
+ *   int - 1 on success, 0 on failure
+ */
+int fl_update_texture(fl_texture*, fl_rect*, fl_surface*);
+
+/**
+ * Frees the memory allocated for a surface.
+ *
+ * Params:
+ *   fl_surface - a surface
+ */
+void fl_destroy_surface(fl_surface*);
+
 
 
 /* -------------------------------------------------------------- */
@@ -185,6 +573,8 @@ void fl_destroy_image(fl_image*);
 
 /**
  * Loads a TTF font file into a ttf structure.
+ * Fonts may be opened and closed on any thread, and each font
+ * may be rasterized with on one thread at a time.
  *
  * Params:
  *   const char* - the path to the ttf file
@@ -204,30 +594,19 @@ fl_ttf* fl_load_ttf(const char*, int);
 void fl_close_ttf(fl_ttf*);
 
 /**
- * Creates an image of a single character using a font.
+ * Rasterizes a single code point using a font.
+ * The surface is in the pixel format of atlas textures.
  *
  * Params:
- *   fl_context - a Flurmp context
- *   fl_resource - a font resource
- *   char - the character to convert to an image
+ *   fl_font - a font
+ *   unsigned int - the code point to rasterize
+ *   int* - receives the width of the surface
+ *   int* - receives the height of the surface
  *
  * Returns:
- *   fl_image - an image representing the character
+ *   fl_surface - a surface containing the glyph, or NULL on failure
  */
-fl_image* fl_create_glyph_image(fl_context*, fl_resource*, char);
-
-/**
- * Creates an image of a string of text.
- *
- * Params:
- *   fl_context - a Flurmp context
- *   fl_resource - a font resource
- *   const char* - the text to convert to an image
- *
- * Returns:
- *   fl_image - an image representing the text
- */
-fl_image* fl_create_text_image(fl_context*, fl_resource*, const char*);
+fl_surface* fl_create_glyph_surface(fl_font*, unsigned int, int*, int*);
 
 
 
@@ -289,6 +668,47 @@ void fl_draw_solid_rect(fl_context*, fl_rect*);
  */
 void fl_draw(fl_context*, fl_texture*, fl_rect*, fl_rect*, int);
 
+/**
+ * Renders triangles in a single draw call. Each vertex has a position
+ * on the screen, a color that the texture is multiplied by, and a
+ * texture coordinate from 0 to 1.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_texture - a texture, or NULL to fill the triangles with
+ *                the colors of their vertices
+ *   const fl_vertex* - the vertices
+ *   int - the number of vertices
+ *   const int* - three vertex indices per triangle
+ *   int - the number of indices
+ */
+void fl_draw_geometry(fl_context*, fl_texture*, const fl_vertex*, int, const int*, int);
+
+/**
+ * Directs rendering to a texture instead of the screen.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_texture - a texture created with fl_create_target_texture,
+ *                or NULL to render to the screen
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_set_render_target(fl_context*, fl_texture*);
+
+/**
+ * Gets the texture that rendering is currently directed to.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *
+ * Returns:
+ *   fl_texture - the current render target, or NULL if
+ *                rendering to the screen
+ */
+fl_texture* fl_get_render_target(fl_context*);
+
 /**
  * Removes everything being rendered on the screen.
  *
@@ -0,0 +1,45 @@
+/**
+ * The layout of baked fonts, shared by the engine and the font bake tool.
+ *
+ * A font is baked for one size and one set of colors into two files
+ * next to the TTF, both named after it and the size, such as
+ * "VeraMono-16". The .flimg file is a baked image (see image_format.h)
+ * holding the atlas of glyphs. The .flfont file holds the metrics: a
+ * header followed by one entry per glyph, sorted by code point, giving
+ * the area of the atlas the glyph occupies. Glyphs are rendered one
+ * code point at a time, exactly as the engine renders them from the
+ * TTF, so the width of a glyph is also its advance. Numbers are stored
+ * little endian.
+ */
+#ifndef FLURMP_FONT_FORMAT_H
+#define FLURMP_FONT_FORMAT_H
+
+#include <stdint.h>
+
+#define FLURMP_BAKED_FONT_MAGIC     "FLFN"
+#define FLURMP_BAKED_FONT_VERSION   1
+#define FLURMP_BAKED_FONT_EXTENSION ".flfont"
+
+/* largest number of glyphs in a baked font */
+#define FLURMP_BAKED_GLYPH_LIMIT 65536
+
+typedef struct fl_baked_font_header {
+	char magic[4];
+	uint32_t version;
+	uint32_t size;          /* point size */
+	uint32_t count;         /* number of glyphs */
+	uint8_t forecolor[4];   /* RGBA */
+	uint8_t backcolor[4];   /* RGBA, only used with a background */
+	uint32_t background;    /* 1 if glyphs were rendered on the background color */
+	uint32_t reserved;
+}fl_baked_font_header;
+
+typedef struct fl_baked_glyph {
+	uint32_t code;
+	uint16_t x;
+	uint16_t y;
+	uint16_t w;
+	uint16_t h;
+}fl_baked_glyph;
+
+#endif
@@ -13,4 +13,13 @@
 #define FLURMP_IMAGE_DOOR 4
 #define FLURMP_IMAGE_PELLET 5
 
+/* paths of the images, indexed like the image registry */
+#define FLURMP_IMAGE_PATHS { \
+	"resources/images/person.bmp", \
+	"resources/images/sign.bmp", \
+	"resources/images/block_200_50.bmp", \
+	"resources/images/spike.bmp", \
+	"resources/images/door.bmp", \
+	"resources/images/pellet.bmp" }
+
 #endif
@@ -0,0 +1,36 @@
+/**
+ * The layout of baked images, shared by the engine and the bake tool.
+ *
+ * A baked image (.flimg) is a header followed by the pixels, row by
+ * row with no padding, in the format the engine creates its textures
+ * in: 32-bit RGBA8888 values with red in the high byte. The color key
+ * has already been replaced with transparent pixels and every color is
+ * premultiplied by its alpha, so the pixels can be uploaded exactly as
+ * they are. Numbers and pixels are stored little endian.
+ *
+ * Images can also be baked as QOI (.qoi), a lossless format that is
+ * much smaller than raw pixels and quick to decode. These hold straight
+ * RGBA with the color key already applied, as the QOI specification
+ * requires, and are premultiplied while they are decoded.
+ */
+#ifndef FLURMP_IMAGE_FORMAT_H
+#define FLURMP_IMAGE_FORMAT_H
+
+#include <stdint.h>
+
+#define FLURMP_BAKED_MAGIC     "FLIM"
+#define FLURMP_BAKED_VERSION   1
+#define FLURMP_BAKED_EXTENSION ".flimg"
+#define FLURMP_QOI_EXTENSION   ".qoi"
+
+/* largest width or height accepted when loading an image */
+#define FLURMP_IMAGE_SIZE_LIMIT 16384
+
+typedef struct fl_baked_header {
+	char magic[4];
+	uint32_t version;
+	uint32_t w;
+	uint32_t h;
+}fl_baked_header;
+
+#endif
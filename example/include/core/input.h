@@ -1,13 +1,19 @@
 /**
- * Scancodes, input flags and functions for handling user input.
+ * Actions and functions for handling user input.
  *
- * Scancodes indicate the actuation of certain keys on the keyboard.
+ * Input is collected from events once per iteration of the main loop.
+ * Each key is tracked in three bit sets indexed by scancode:
+ *   held     - the key is currently actuated
+ *   pressed  - the key was actuated during the current frame
+ *   released - the key was released during the current frame
  *
- * Input flags are used to keep track of what inputs have been actuated.
- * When an input is actuated, its input flag is toggled on.
- * By toggling an input flag off, we can allow one action per key press.
- * Alternatively, by leaving an input flag as toggled, we can perform an
+ * Consuming a key clears its pressed bit, which allows one action per
+ * key press. Alternatively, by peeking at the held bit, we can perform an
  * action repeatedly for the duration of a key press.
+ *
+ * Actions are abstract inputs such as "jump" or "pause" that are mapped
+ * to keys through a table in the context. Input handlers should check
+ * actions rather than keys wherever the key could reasonably be remapped.
  */
 #ifndef FLURMP_INPUT_IMPL_H
 #define FLURMP_INPUT_IMPL_H
@@ -18,78 +24,56 @@
 #define FLURMP_INPUT_TYPE_KEYBOARD 1
 #define FLURMP_INPUT_TYPE_MOUSE 2
 
-/* total number of scancodes */
-#define FLURMP_SCANCODE_COUNT 56
-
-/* total number of input flags */
-#define FLURMP_INPUT_FLAG_COUNT 55
-
-/* input flags */
-#define FLURMP_INPUT_UNKNOWN 0
-#define FLURMP_INPUT_A 1
-#define FLURMP_INPUT_B 2
-#define FLURMP_INPUT_C 3
-#define FLURMP_INPUT_D 4
-#define FLURMP_INPUT_E 5
-#define FLURMP_INPUT_F 6
-#define FLURMP_INPUT_G 7
-#define FLURMP_INPUT_H 8
-#define FLURMP_INPUT_I 9
-#define FLURMP_INPUT_J 10
-#define FLURMP_INPUT_K 11
-#define FLURMP_INPUT_L 12
-#define FLURMP_INPUT_M 13
-#define FLURMP_INPUT_N 14
-#define FLURMP_INPUT_O 15
-#define FLURMP_INPUT_P 16
-#define FLURMP_INPUT_Q 17
-#define FLURMP_INPUT_R 18
-#define FLURMP_INPUT_S 19
-#define FLURMP_INPUT_T 20
-#define FLURMP_INPUT_U 21
-#define FLURMP_INPUT_V 22
-#define FLURMP_INPUT_W 23
-#define FLURMP_INPUT_X 24
-#define FLURMP_INPUT_Y 25
-#define FLURMP_INPUT_Z 26
-#define FLURMP_INPUT_0 27
-#define FLURMP_INPUT_1 28
-#define FLURMP_INPUT_2 29
-#define FLURMP_INPUT_3 30
-#define FLURMP_INPUT_4 31
-#define FLURMP_INPUT_5 32
-#define FLURMP_INPUT_6 33
-#define FLURMP_INPUT_7 34
-#define FLURMP_INPUT_8 35
-#define FLURMP_INPUT_9 36
-#define FLURMP_INPUT_COMMA 37
-#define FLURMP_INPUT_PERIOD 38
-#define FLURMP_INPUT_SPACE 39
-#define FLURMP_INPUT_ESCAPE 40
-#define FLURMP_INPUT_SHIFT 41
-#define FLURMP_INPUT_CTRL 42
-#define FLURMP_INPUT_BACKSPACE 43
-#define FLURMP_INPUT_RETURN 44
-#define FLURMP_INPUT_RETURN2 45
-#define FLURMP_INPUT_LEFTBRACKET 46
-#define FLURMP_INPUT_RIGHTBRACKET 47
-#define FLURMP_INPUT_SEMICOLON 48
-#define FLURMP_INPUT_APOSTRAPHE 49
-#define FLURMP_INPUT_SLASH 50
-#define FLURMP_INPUT_BACKSLASH 51
-#define FLURMP_INPUT_MINUS 52
-#define FLURMP_INPUT_EQUALS 53
-#define FLURMP_INPUT_BACKTICK 54
-
-/**
- * Determines the input flag corresponding to the
- * specified input code and type.
- *
- * Params:
- *   int - the type of event (e.g. FLURMP_INPUT_TYPE_KEYBOARD)
- *   int - the input code (e.g. a scancode like FLURMP_SC_A)
- */
-int fl_code_to_flag(int type, int code);
+/* total number of actions */
+#define FLURMP_ACTION_COUNT 8
+
+/* actions */
+#define FLURMP_ACTION_LEFT      0
+#define FLURMP_ACTION_RIGHT     1
+#define FLURMP_ACTION_UP        2
+#define FLURMP_ACTION_DOWN      3
+#define FLURMP_ACTION_JUMP      4
+#define FLURMP_ACTION_PRIMARY   5 /* interact, select, advance dialog */
+#define FLURMP_ACTION_SECONDARY 6 /* fire, cancel, skip dialog */
+#define FLURMP_ACTION_PAUSE     7
+
+/**
+ * Clears the inputs that only last for a single frame.
+ * This should be called once per iteration of the main loop
+ * before any input events are recorded.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_reset_input(fl_context* context);
+
+/**
+ * Records a key press event.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the scancode of the key that was pressed
+ */
+void fl_input_key_down(fl_context* context, int code);
+
+/**
+ * Records a key release event.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the scancode of the key that was released
+ */
+void fl_input_key_up(fl_context* context, int code);
+
+/**
+ * Records text input.
+ * Text that does not fit in the text input buffer is discarded.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - a string of UTF-8 encoded text
+ */
+void fl_input_text(fl_context* context, const char* text);
 
 /**
  * Checks the state of an input event.
@@ -173,6 +157,53 @@ int fl_consume_key(fl_context* context, int code);
  */
 int fl_peek_key(fl_context* context, int code);
 
+/**
+ * Determines whether a key was released during the current frame.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the scancode of the key to check
+ *
+ * Returns:
+ *   int - 1 if the key was released, otherwise 0
+ */
+int fl_key_released(fl_context* context, int code);
+
+/**
+ * Maps an action to a key.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - an action (e.g. FLURMP_ACTION_JUMP)
+ *   int - the scancode of the key that triggers the action
+ */
+void fl_bind_action(fl_context* context, int action, int code);
+
+/**
+ * Checks whether the key mapped to an action was pressed
+ * during the current frame and flags it as consumed.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - an action (e.g. FLURMP_ACTION_JUMP)
+ *
+ * Returns:
+ *   int - 1 if the action was triggered, otherwise 0
+ */
+int fl_consume_action(fl_context* context, int action);
+
+/**
+ * Checks whether the key mapped to an action is held.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - an action (e.g. FLURMP_ACTION_LEFT)
+ *
+ * Returns:
+ *   int - 1 if the action is active, otherwise 0
+ */
+int fl_peek_action(fl_context* context, int action);
+
 /**
  * Creates an input handler.
  *
@@ -194,7 +225,8 @@ fl_input_handler* fl_create_input_handler(void(*handler) (fl_context*, fl_input_
 void fl_destroy_input_handler(fl_input_handler* input);
 
 /**
- * Retrieves the current active input handler.
+ * Retrieves the current active input handler, which is the
+ * input handler at the top of the input handler stack.
  *
  * Params:
  *   fl_context - a Flurmp context.
@@ -205,7 +237,8 @@ void fl_destroy_input_handler(fl_input_handler* input);
 fl_input_handler* fl_get_input_handler(fl_context* context);
 
 /**
- * Appends an input handler to the current context.
+ * Pushes an input handler onto the input handler stack of a context.
+ * The input handler becomes the active input handler.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -214,7 +247,7 @@ fl_input_handler* fl_get_input_handler(fl_context* context);
 void fl_push_input_handler(fl_context* context, fl_input_handler* input);
 
 /**
- * Removes the most recently added input handler from a context.
+ * Removes the input handler at the top of the input handler stack.
  * This does NOT destroy the input handler that was removed.
  *
  * Params:
@@ -222,4 +255,25 @@ void fl_push_input_handler(fl_context* context, fl_input_handler* input);
  */
 void fl_pop_input_handler(fl_context* context);
 
+/**
+ * Passes input on to the input handler directly below an input handler
+ * on the stack. Input handlers call this for input they do not handle
+ * themselves. Nothing happens for the root input handler.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_input_handler - the input handler passing on the input
+ */
+void fl_propagate_input(fl_context* context, fl_input_handler* self);
+
+/**
+ * Destroys the root input handler and frees the input handler stack.
+ * Any other input handlers on the stack are left to the
+ * structures that contain them.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_destroy_input_handlers(fl_context* context);
+
 #endif
@@ -0,0 +1,65 @@
+/**
+ * Input latency measurement.
+ *
+ * Key press events are stamped with the time at which SDL received
+ * them. The oldest stamp that has not yet been presented is carried
+ * through the frame, and when the frame is shown on the screen the
+ * elapsed time is recorded in a histogram.
+ */
+#ifndef FLURMP_LATENCY_H
+#define FLURMP_LATENCY_H
+
+#include "core/flurmp_impl.h"
+
+/**
+ * Records the timestamp of an input event.
+ * Only the oldest timestamp since the last presented frame is kept.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   unsigned int - the event timestamp in milliseconds
+ */
+void fl_latency_input(fl_context* context, unsigned int timestamp);
+
+/**
+ * Records the latency of any pending input.
+ * This should be called immediately after a frame is presented.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   unsigned int - the current time in milliseconds
+ */
+void fl_latency_present(fl_context* context, unsigned int now);
+
+/**
+ * Estimates a percentile of the recorded latencies.
+ * The result is the upper bound of the histogram bucket
+ * containing the percentile.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the percentile ranging from 0 - 100
+ *
+ * Returns:
+ *   unsigned int - the latency in milliseconds, or 0 if no
+ *                  latencies have been recorded
+ */
+unsigned int fl_latency_percentile(fl_context* context, int p);
+
+/**
+ * Prints the latency histogram to stdout.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_latency_report(fl_context* context);
+
+/**
+ * Discards all recorded latencies.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_latency_reset(fl_context* context);
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * Render layers and the render queue.
+ *
+ * Everything drawn during a frame is queued with a layer and a z value,
+ * then the queue is sorted and drawn in one pass. Draw order therefore
+ * no longer depends on the order in which entities were added to a scene.
+ *
+ * A layer marked static is drawn into a cached texture the first time
+ * it is needed and composited at the camera offset on later frames.
+ * Anything that changes the appearance of a static layer must call
+ * fl_invalidate_layer.
+ *
+ * While the world is frozen, every layer below the user interface is
+ * captured once into a snapshot texture and the snapshot is drawn in
+ * place of the entities until the world changes again.
+ */
+#ifndef FLURMP_LAYER_H
+#define FLURMP_LAYER_H
+
+#include "core/flurmp_impl.h"
+
+/**
+ * Sets the layers and render queue of a context to their defaults.
+ * The scenery layer is static. All other layers are redrawn each frame.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_init_layers(fl_context* context);
+
+/**
+ * Frees the cached layer textures and the render queue storage.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_destroy_layers(fl_context* context);
+
+/**
+ * Marks a static layer so that its cache is redrawn before
+ * it is next composited.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - a layer (e.g. FLURMP_LAYER_SCENERY)
+ */
+void fl_invalidate_layer(fl_context* context, int layer);
+
+/**
+ * Marks every static layer as needing to be redrawn.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_invalidate_layers(fl_context* context);
+
+/**
+ * Discards the world snapshot so that it is captured again
+ * the next time the world is frozen.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_invalidate_snapshot(fl_context* context);
+
+/**
+ * Draws the world from the snapshot, capturing the world into the
+ * snapshot first if it is not valid or the camera has moved.
+ * This should only be called while nothing in the world can change.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *
+ * Returns:
+ *   int - 1 if the world was drawn, or 0 if the snapshot could not
+ *         be captured, in which case the world must be drawn normally
+ */
+int fl_draw_snapshot(fl_context* context);
+
+/**
+ * Adds an item to the render queue.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - a layer (e.g. FLURMP_LAYER_UI)
+ *   int - the z order within the layer; higher values are drawn on top
+ *   void(*render)(fl_context*, void*) - a function that draws the target
+ *   void* - the data to be drawn cast as void
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_queue_render(fl_context* context, int layer, int z,
+	void(*render)(fl_context*, void*), void* target);
+
+/**
+ * Adds each non-empty entity group to the render queue using
+ * the layer and z order of its entity type.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_queue_entities(fl_context* context);
+
+/**
+ * Sorts the render queue, draws its contents and empties it.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_flush_render_queue(fl_context* context);
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * Memory tracking.
+ *
+ * Every block allocated with fl_alloc carries a small header recording
+ * its size, memory tag and call site, and stays in a list of live blocks
+ * until it is freed. Live and peak bytes are kept per tag, allocations
+ * are counted per frame, and whatever is still live when the context is
+ * destroyed is reported as a leak along with where it was allocated.
+ * Blocks may be allocated and freed on any thread.
+ *
+ * Allocations made by libraries are not tracked.
+ */
+#ifndef FLURMP_MEMORY_H
+#define FLURMP_MEMORY_H
+
+#include "core/flurmp_impl.h"
+
+/**
+ * Memory statistics for a single tag.
+ */
+typedef struct fl_memory_stats {
+	size_t live_bytes;
+	size_t peak_bytes;
+	int live_blocks;
+	int allocations;
+	int frees;
+	int frame_allocations; /* allocations during the previous frame */
+}fl_memory_stats;
+
+/**
+ * Gets the name of a memory tag.
+ *
+ * Params:
+ *   int - a memory tag (e.g. FLURMP_MEMORY_TAG_ENTITY)
+ *
+ * Returns:
+ *   const char* - the name of the tag
+ */
+const char* fl_memory_tag_name(int tag);
+
+/**
+ * Gets the memory statistics of a tag.
+ *
+ * Params:
+ *   int - a memory tag (e.g. FLURMP_MEMORY_TAG_ENTITY)
+ *   fl_memory_stats - receives the statistics
+ */
+void fl_get_memory_stats(int tag, fl_memory_stats* stats);
+
+/**
+ * Gets the number of allocations made during the previous frame,
+ * across all tags.
+ *
+ * Returns:
+ *   int - the number of allocations
+ */
+int fl_memory_frame_allocations();
+
+/**
+ * Marks the start of a frame. The allocations counted since the
+ * last call become the counts for the previous frame.
+ */
+void fl_memory_frame();
+
+/**
+ * Prints the statistics of every tag to stdout.
+ */
+void fl_memory_report();
+
+/**
+ * Prints the blocks that are still allocated to stdout,
+ * grouped by the call site that allocated them.
+ *
+ * Returns:
+ *   int - the number of blocks that are still allocated
+ */
+int fl_memory_report_leaks();
+
+#endif
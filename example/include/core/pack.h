@@ -0,0 +1,62 @@
+/**
+ * Asset packs.
+ *
+ * An asset pack holds every resource in a single file, which is mapped
+ * into memory when Flurmp is initialized. Loaders look assets up by the
+ * path they would otherwise open, and read them straight out of the
+ * mapping. Assets that are not in the pack, or every asset if there is
+ * no pack, are loaded from loose files as before.
+ *
+ * Packs are built from the resources directory with the flurmp_pack tool.
+ */
+#ifndef FLURMP_PACK_H
+#define FLURMP_PACK_H
+
+#include "core/flurmp_impl.h"
+#include "core/pack_format.h"
+
+/* the pack opened by fl_initialize, relative to the working directory */
+#define FLURMP_PACK_PATH "resources.pack"
+
+/**
+ * Maps an asset pack into memory, replacing any pack already open.
+ *
+ * Params:
+ *   const char* - the path to the pack
+ *
+ * Returns:
+ *   int - 1 on success, or 0 if the file is missing or is not a valid pack
+ */
+int fl_open_pack(const char* path);
+
+/**
+ * Unmaps the open asset pack, if any. Nothing read
+ * from the pack may be used afterwards.
+ */
+void fl_close_pack();
+
+/**
+ * Finds an asset in the open pack.
+ *
+ * Params:
+ *   const char* - the name of the asset
+ *   size_t* - receives the size of the asset
+ *
+ * Returns:
+ *   const void* - the contents of the asset, or NULL if there is
+ *                 no pack or the asset is not in it
+ */
+const void* fl_find_asset(const char* name, size_t* size);
+
+/**
+ * Determines if memory lies within the open pack.
+ *
+ * Params:
+ *   const void* - a pointer
+ *
+ * Returns:
+ *   int - 1 if the pointer points into the open pack, otherwise 0
+ */
+int fl_is_packed(const void* data);
+
+#endif
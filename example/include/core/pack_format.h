@@ -0,0 +1,34 @@
+/**
+ * The layout of an asset pack, shared by the engine and the pack tool.
+ *
+ * A pack starts with a header, followed by one index entry per asset,
+ * sorted by name, followed by the contents of the assets. Each asset
+ * starts on a multiple of FLURMP_PACK_ALIGNMENT bytes from the start of
+ * the file. Names are the paths the assets had relative to the example
+ * directory, such as "resources/images/sign.bmp", padded with zeros.
+ * Numbers are stored little endian.
+ */
+#ifndef FLURMP_PACK_FORMAT_H
+#define FLURMP_PACK_FORMAT_H
+
+#include <stdint.h>
+
+#define FLURMP_PACK_MAGIC       "FLPK"
+#define FLURMP_PACK_VERSION     1
+#define FLURMP_PACK_NAME_LENGTH 56
+#define FLURMP_PACK_ALIGNMENT   16
+
+typedef struct fl_pack_header {
+	char magic[4];
+	uint32_t version;
+	uint32_t count;    /* number of index entries */
+	uint32_t reserved;
+}fl_pack_header;
+
+typedef struct fl_pack_entry {
+	char name[FLURMP_PACK_NAME_LENGTH];
+	uint32_t offset;   /* from the start of the file */
+	uint32_t size;
+}fl_pack_entry;
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * Particles.
+ *
+ * Short lived effects such as sparks are particles rather than
+ * entities. Particles of a kind share their look and their motion,
+ * live in a pool of their own, and are moved and drawn a whole pool at
+ * a time, so tens of thousands of them cost less than a few hundred
+ * entities. They are never collided with anything.
+ *
+ * Particles are either emitted all at once with fl_emit_particles, or
+ * steadily by an emitter that follows an entity.
+ */
+#ifndef FLURMP_PARTICLE_H
+#define FLURMP_PARTICLE_H
+
+#include "core/flurmp_impl.h"
+
+#define FLURMP_PARTICLE_KIND_COUNT 3
+
+/* kinds of particles */
+#define FLURMP_PARTICLE_SPARK 0 /* a pellet hitting something */
+#define FLURMP_PARTICLE_HIT 1   /* the player being hurt */
+#define FLURMP_PARTICLE_TRAIL 2 /* behind a pellet in flight */
+
+/**
+ * Creates a pool for each kind of particle.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_create_particles(fl_context* context);
+
+/**
+ * Frees the particle pools and emitters.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_destroy_particles(fl_context* context);
+
+/**
+ * Removes every particle and emitter, keeping the memory
+ * allocated for them.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_clear_particles(fl_context* context);
+
+/**
+ * Emits a burst of particles from a point. Particles that would
+ * exceed FLURMP_PARTICLE_LIMIT are not emitted.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the kind of particle (e.g. FLURMP_PARTICLE_SPARK)
+ *   int - the x position in the world
+ *   int - the y position in the world
+ *   int - the number of particles
+ *
+ * Returns:
+ *   int - the number of particles emitted
+ */
+int fl_emit_particles(fl_context* context, int kind, int x, int y, int count);
+
+/**
+ * Adds an emitter that follows an entity.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the kind of particle
+ *   fl_handle - the entity to follow
+ *   float - the number of particles per frame, which may be
+ *           less than 1
+ *   int - the number of frames to emit for, or -1 to emit
+ *         for as long as the entity exists
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_add_emitter(fl_context* context, int kind, fl_handle target, float rate, int frames);
+
+/**
+ * Runs the emitters, then moves the particles and removes
+ * those whose lives are over.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_update_particles(fl_context* context);
+
+/**
+ * Adds each pool that has particles to the render queue.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_queue_particles(fl_context* context);
+
+/**
+ * Gets the number of particles alive.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *
+ * Returns:
+ *   int - the number of particles
+ */
+int fl_get_particle_count(fl_context* context);
+
+#endif
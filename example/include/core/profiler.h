@@ -0,0 +1,71 @@
+/**
+ * Frame section profiling.
+ *
+ * Each profiled section of the frame is timed with the high resolution
+ * performance counter while the profiler is enabled. The average and
+ * peak times of each section are kept until the profiler is reset.
+ */
+#ifndef FLURMP_PROFILER_H
+#define FLURMP_PROFILER_H
+
+#include "core/flurmp_impl.h"
+
+/**
+ * Starts timing a section of the frame.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_profile_begin(fl_context* context);
+
+/**
+ * Stops timing a section of the frame and records the elapsed time.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the section (e.g. FLURMP_PROFILE_UPDATE)
+ */
+void fl_profile_end(fl_context* context, int section);
+
+/**
+ * Gets the average time spent in a section of the frame.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the section (e.g. FLURMP_PROFILE_UPDATE)
+ *
+ * Returns:
+ *   unsigned int - the average time in microseconds, or 0 if
+ *                  the section has not been timed
+ */
+unsigned int fl_profile_average(fl_context* context, int section);
+
+/**
+ * Gets the longest time spent in a section of the frame.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the section (e.g. FLURMP_PROFILE_UPDATE)
+ *
+ * Returns:
+ *   unsigned int - the peak time in microseconds
+ */
+unsigned int fl_profile_peak(fl_context* context, int section);
+
+/**
+ * Prints the section timings to stdout.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_profile_report(fl_context* context);
+
+/**
+ * Discards all recorded timings.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_profile_reset(fl_context* context);
+
+#endif
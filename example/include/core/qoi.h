@@ -0,0 +1,67 @@
+/**
+ * QOI image encoding and decoding.
+ *
+ * QOI ("Quite OK Image") is a simple lossless format. Each pixel is
+ * stored as a run of the previous pixel, a reference to one of the 64
+ * pixels seen most recently, a small difference from the previous
+ * pixel, or the full color. Decoding takes one pass with no tables to
+ * build, which makes it several times faster than general purpose
+ * lossless formats.
+ *
+ * Pixels are 32-bit RGBA8888 values with red in the high byte, the
+ * format of the engine's textures. These functions don't allocate
+ * memory or depend on SDL, so the bake tool shares them.
+ */
+#ifndef FLURMP_QOI_H
+#define FLURMP_QOI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* the most bytes needed to encode an image of w by h pixels */
+#define FLURMP_QOI_MAX_SIZE(w, h) (14 + (size_t)(w) * (size_t)(h) * 5 + 8)
+
+/**
+ * Reads the dimensions of a QOI image.
+ *
+ * Params:
+ *   const unsigned char* - the encoded image
+ *   size_t - the size of the encoded image
+ *   int* - receives the width
+ *   int* - receives the height
+ *
+ * Returns:
+ *   int - 1 if the image is a QOI image with a usable size, otherwise 0
+ */
+int fl_qoi_size(const unsigned char* data, size_t size, int* w, int* h);
+
+/**
+ * Decodes a QOI image, premultiplying each color by its alpha.
+ *
+ * Params:
+ *   const unsigned char* - the encoded image
+ *   size_t - the size of the encoded image
+ *   uint32_t* - receives the pixels; it must have room for
+ *               the number of pixels given by fl_qoi_size
+ *
+ * Returns:
+ *   int - 1 on success, or 0 if the image is invalid or truncated
+ */
+int fl_decode_qoi(const unsigned char* data, size_t size, uint32_t* pixels);
+
+/**
+ * Encodes pixels as a QOI image.
+ *
+ * Params:
+ *   const uint32_t* - the pixels, with straight alpha
+ *   int - the width
+ *   int - the height
+ *   unsigned char* - receives the encoded image; it must have
+ *                    room for FLURMP_QOI_MAX_SIZE(w, h) bytes
+ *
+ * Returns:
+ *   size_t - the size of the encoded image
+ */
+size_t fl_encode_qoi(const uint32_t* pixels, int w, int h, unsigned char* out);
+
+#endif
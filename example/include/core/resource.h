@@ -7,7 +7,8 @@
 #define FLURMP_FONT_RESOURCE 2
 
 /**
- * Loads a BMP image.
+ * Loads an image. If the image has been baked by the flurmp_bake
+ * tool, the baked copy next to it is loaded instead of the BMP.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -19,10 +20,40 @@
 fl_resource* fl_load_image(fl_context* context, const char* path);
 
 /**
- * Loads a font.
+ * Does the part of fl_load_image that doesn't need the renderer:
+ * finds the image and decodes it. This may be done on any thread.
  *
  * Params:
  *   const char* - a string containing the path to the resource
+ *
+ * Returns:
+ *   fl_surface - the decoded image, which is destroyed with
+ *                fl_destroy_surface, or NULL on failure
+ */
+fl_surface* fl_prepare_image(const char* path);
+
+/**
+ * Uploads an image decoded by fl_prepare_image.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_surface - the decoded image, which is not destroyed
+ *
+ * Returns:
+ *   fl_resource - a reference to a newly created resource,
+ *                 or NULL on failure
+ */
+fl_resource* fl_finish_image(fl_context* context, fl_surface* pixels);
+
+/**
+ * Loads a font. If the font has been baked by the flurmp_bake_font
+ * tool for the same size and colors, the baked glyphs are loaded
+ * instead, and the TTF is only opened if a glyph that wasn't baked
+ * is drawn.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - a string containing the path to the resource
  *   int - the font size in points
  *   fl_olor - the foreground color
  *   fl_olor - the background color
@@ -34,12 +65,62 @@ fl_resource* fl_load_image(fl_context* context, const char* path);
  * Returns:
  *   fl_resource - a reference to a newly created resource
  */
-fl_resource* fl_load_font(const char* path,
+fl_resource* fl_load_font(fl_context* context,
+	const char* path,
 	int p,
 	fl_color fc, 
 	fl_color bc,
 	int background);
 
+/**
+ * Does the part of fl_load_font that doesn't need the renderer:
+ * reads and decodes the bake of the font, or opens the TTF if there
+ * is no bake. This may be done on any thread. The font can't be
+ * drawn with until it is passed to fl_finish_font.
+ *
+ * Params:
+ *   const char* - a string containing the path to the resource
+ *   int - the font size in points
+ *   fl_color - the foreground color
+ *   fl_color - the background color
+ *   int - a flag indicating whether or not to use a background color
+ *   fl_surface** - receives the decoded atlas of a baked font,
+ *                  or NULL if the font isn't baked
+ *
+ * Returns:
+ *   fl_resource - a reference to a newly created resource,
+ *                 or NULL on failure
+ */
+fl_resource* fl_prepare_font(const char* path,
+	int p,
+	fl_color fc,
+	fl_color bc,
+	int background,
+	fl_surface** atlas);
+
+/**
+ * Uploads the atlas of a font prepared by fl_prepare_font. If the
+ * upload fails, the font falls back to its TTF.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_resource - a font resource from fl_prepare_font
+ *   fl_surface - the atlas from fl_prepare_font, which is not destroyed
+ *
+ * Returns:
+ *   int - 1 if the font can be drawn with, otherwise 0
+ */
+int fl_finish_font(fl_context* context, fl_resource* resource, fl_surface* atlas);
+
+/**
+ * Sets whether fonts loaded from now on use their bakes.
+ * Bakes are used by default.
+ *
+ * Params:
+ *   int - 1 to use baked fonts, or 0 to always rasterize from the TTF
+ */
+void fl_use_baked_fonts(int enabled);
+
 /**
  * Frees the memory allocated for a resource.
  *
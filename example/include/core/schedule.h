@@ -6,18 +6,23 @@
 /**
  * Creates a new schedule.
  *
+ * The action receives the target entity each time it runs. If the
+ * target is removed, or the scene is cleared, the action runs one last
+ * time with a NULL entity so that it can undo anything it set up, such
+ * as an input handler, and the schedule is then destroyed.
+ *
  * Params:
- *   void(*action)(fl_context*, fl_schedule*, void*) - an action to be taken
+ *   void(*action)(fl_context*, fl_schedule*, fl_entity*) - an action to be taken
  *   int - the limit set on the counter in the schedule
- *   void* - a pointer to the data to be modified cast as void
+ *   fl_handle - a handle to the entity to be modified
  *
  * Returns:
  *   fl_schedule - a new schedule
  */
 fl_schedule* fl_create_schedule(
-	void(*action)(fl_context*, fl_schedule*, void*),
+	void(*action)(fl_context*, fl_schedule*, fl_entity*),
 	int limit, 
-	void* target);
+	fl_handle target);
 
 /**
  * Frees the memory allocated for a schedule.
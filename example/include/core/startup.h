@@ -0,0 +1,47 @@
+/**
+ * Startup.
+ *
+ * The assets a context starts with are loaded by a task graph (see
+ * task.h). Images and fonts are read and decoded, and the glyphs of
+ * fonts without a bake rasterized, on worker threads while the window
+ * and renderer are created, and so are the sounds. Only the uploads,
+ * the data panel and the first scene, which need the renderer, and
+ * opening the audio device wait for the main thread.
+ */
+#ifndef FLURMP_STARTUP_H
+#define FLURMP_STARTUP_H
+
+#include "core/flurmp_impl.h"
+
+/**
+ * Creates the window and renderer of a context, loads its fonts,
+ * images and sounds, creates its data panel and loads the first scene.
+ * On failure, the context's error code is set.
+ *
+ * Params:
+ *   fl_context - a Flurmp context with its registries created
+ */
+void fl_run_startup(fl_context* context);
+
+/**
+ * Sets the number of worker threads that contexts created from now on
+ * start with. By default there is one less than the number of cores,
+ * up to FLURMP_TASK_WORKER_LIMIT. With no workers, everything is done
+ * on the main thread, one step at a time.
+ *
+ * Params:
+ *   int - the number of worker threads, or -1 for the default
+ */
+void fl_set_startup_workers(int workers);
+
+/**
+ * Sets a file to write the timeline of each startup to, which can be
+ * opened with chrome://tracing or Perfetto.
+ *
+ * Params:
+ *   const char* - the path to write to, which must remain valid,
+ *                 or NULL to write no timeline
+ */
+void fl_set_startup_trace(const char* path);
+
+#endif
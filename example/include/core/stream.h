@@ -0,0 +1,62 @@
+/**
+ * World streaming.
+ *
+ * A streamed world is divided into chunks. The chunks near the camera
+ * are active: their entities are in the context and take part in every
+ * update. Around them, chunks are loaded ahead of the camera a few at a
+ * time, so that activating them is cheap when the camera gets there.
+ * Everything further away is unloaded and costs nothing but an empty
+ * chunk header. Chunks are only let go once the camera is a little
+ * further away than the distance at which they were taken in, so moving
+ * back and forth over a chunk boundary doesn't load it over and over.
+ *
+ * The entities of a chunk are generated from the world seed when the
+ * chunk is first loaded. When a chunk is deactivated, the positions of
+ * its entities are written back to its records, and entities that were
+ * despawned are dropped, until the chunk is unloaded.
+ */
+#ifndef FLURMP_STREAM_H
+#define FLURMP_STREAM_H
+
+#include "core/flurmp_impl.h"
+
+/**
+ * Fills a world configuration with the defaults: a world of one
+ * million entities in 100 by 100 chunks.
+ *
+ * Params:
+ *   fl_world_config - a world configuration
+ */
+void fl_default_world_config(fl_world_config* config);
+
+/**
+ * Creates a world in which every chunk is unloaded.
+ *
+ * Params:
+ *   fl_world_config - the configuration of the world
+ *
+ * Returns:
+ *   fl_world - a new world, or NULL on failure
+ */
+fl_world* fl_create_world(const fl_world_config* config);
+
+/**
+ * Frees the memory allocated for a world. The entities of active
+ * chunks are not touched, since they belong to the context.
+ *
+ * Params:
+ *   fl_world - a world
+ */
+void fl_destroy_world(fl_world* world);
+
+/**
+ * Loads, activates, deactivates and unloads the chunks of the world
+ * of a context according to their distance from the camera.
+ * This does nothing if the context has no world.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_stream_world(fl_context* context);
+
+#endif
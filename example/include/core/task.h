@@ -0,0 +1,99 @@
+/**
+ * Task graphs.
+ *
+ * A task graph runs a set of tasks, each of which starts once the tasks
+ * it depends on have finished. Tasks that only read files and work on
+ * memory of their own run on worker threads. Tasks that need the
+ * renderer or the context run on the thread that runs the graph, which
+ * also takes on worker tasks while it has nothing else to do. With no
+ * workers, every task runs on that thread, one at a time.
+ *
+ * When and where each task ran is recorded, and can be written out as
+ * a timeline that chrome://tracing and Perfetto can open.
+ */
+#ifndef FLURMP_TASK_H
+#define FLURMP_TASK_H
+
+#include "core/flurmp_impl.h"
+
+/**
+ * Creates an empty task graph.
+ *
+ * Returns:
+ *   fl_task_graph - a new task graph, or NULL on failure
+ */
+fl_task_graph* fl_create_task_graph();
+
+/**
+ * Adds a task to a task graph.
+ *
+ * Params:
+ *   fl_task_graph - a task graph that isn't running
+ *   const char* - the name of the task in the timeline
+ *   int - FLURMP_TASK_MAIN if the task needs the context, which it is
+ *         then given, or FLURMP_TASK_ANY if it may run on any thread,
+ *         in which case it is given NULL for the context
+ *   void (*run) (fl_context*, void*) - the function that does the task
+ *   void* - the data passed to the function
+ *
+ * Returns:
+ *   int - the index of the task, or -1 on failure
+ */
+int fl_add_task(fl_task_graph* graph,
+	const char* name,
+	int where,
+	void(*run) (fl_context*, void*),
+	void* data);
+
+/**
+ * Makes a task wait for another task to finish before it starts.
+ * Dependencies must not form a cycle.
+ *
+ * Params:
+ *   fl_task_graph - a task graph that isn't running
+ *   int - the index of the task that waits
+ *   int - the index of the task it waits for
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_add_dependency(fl_task_graph* graph, int task, int dependency);
+
+/**
+ * Runs every task of a task graph and waits for them to finish.
+ * A graph runs once.
+ *
+ * Params:
+ *   fl_context - a Flurmp context, which main thread tasks are given
+ *   fl_task_graph - a task graph
+ *   int - the number of worker threads to start, up to
+ *         FLURMP_TASK_WORKER_LIMIT. Fewer are used if threads can't
+ *         be started.
+ *
+ * Returns:
+ *   int - 1 if every task ran, or 0 on failure
+ */
+int fl_run_task_graph(fl_context* context, fl_task_graph* graph, int workers);
+
+/**
+ * Writes the timeline of a task graph that has run, in the trace event
+ * format of chrome://tracing. Each thread is a row of the timeline.
+ *
+ * Params:
+ *   fl_task_graph - a task graph
+ *   const char* - the path to write the timeline to
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_write_task_trace(fl_task_graph* graph, const char* path);
+
+/**
+ * Frees the memory allocated for a task graph.
+ *
+ * Params:
+ *   fl_task_graph - a task graph that isn't running
+ */
+void fl_destroy_task_graph(fl_task_graph* graph);
+
+#endif
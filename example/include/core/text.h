@@ -11,39 +11,133 @@
 #define FLURMP_FONT_COUSINE 1
 #define FLURMP_FONT_KARMILLA_BOLD 2
 
+/* code point substituted for malformed UTF-8 */
+#define FLURMP_REPLACEMENT_CHARACTER 0xFFFD
+
+/**
+ * Decodes the next code point of a UTF-8 encoded string and advances
+ * the string past it. Malformed sequences decode to the replacement
+ * character one byte at a time, so decoding always makes progress.
+ *
+ * Params:
+ *   const char** - a pointer to the position in a UTF-8 string
+ *
+ * Returns:
+ *   unsigned int - the code point, or 0 at the end of the string
+ */
+unsigned int fl_utf8_decode(const char** str);
+
 /**
- * Creates a new glyph.
+ * Encodes a code point as UTF-8.
+ * The result is not null terminated.
+ *
+ * Params:
+ *   unsigned int - a code point
+ *   char* - a buffer with room for at least four bytes
+ *
+ * Returns:
+ *   int - the number of bytes written
+ */
+int fl_utf8_encode(unsigned int code, char* out);
+
+/**
+ * Retrieves the glyph that represents a code point in a font.
+ * Glyphs are rasterized into the font's atlas the first time they
+ * are requested, so only the characters that are drawn are paid for.
+ *
+ * The returned glyph remains valid until another glyph is requested
+ * from the same font, which may recycle its atlas page.
  *
  * Params:
  *   fl_context - a Flurmp context
- *   fl_resource - a font resource
- *   char - a character to be represented by the resulting glyph
+ *   fl_font - a font
+ *   unsigned int - the code point to be represented by the glyph
+ *
+ * Returns:
+ *   fl_glyph - a glyph, or NULL if the code point could not be rasterized
  */
-fl_image* fl_create_glyph(fl_context * context, fl_resource * res, char c);
+fl_glyph* fl_get_glyph(fl_context* context, fl_font* font, unsigned int code);
 
 /**
- * Creates a font atlas of a specified font and font size.
+ * Adds a glyph rasterized elsewhere, such as on a worker thread,
+ * to the atlas of a font.
  *
  * Params:
  *   fl_context - a Flurmp context
- *   fl_resource - a font resource
+ *   fl_font - a font that doesn't have the code point yet
+ *   unsigned int - the code point represented by the glyph
+ *   fl_surface - the glyph as made by fl_create_glyph_surface,
+ *                which is not destroyed
+ *
+ * Returns:
+ *   fl_glyph - the new glyph, or NULL on failure
  */
-int fl_create_font_atlas(fl_context* context, fl_resource* res);
+fl_glyph* fl_add_glyph(fl_context* context, fl_font* font, unsigned int code, fl_surface* surface);
 
 /**
- * Retrieves a glyph from a font atlas that represents
- * the specified character.
+ * Loads the glyphs of a font baked by the flurmp_bake_font tool.
+ * The bake is only used if it was made for the size and colors of
+ * the font. Baked glyphs are never evicted, and code points that
+ * were not baked are still rasterized from the TTF when they are
+ * first drawn.
  *
  * Params:
+ *   fl_context - a Flurmp context
+ *   fl_font - a font without baked glyphs
+ *   const char* - the path to the metrics of the baked font
+ *   const char* - the path to the atlas of the baked font
+ *
+ * Returns:
+ *   int - 1 if the glyphs were loaded, otherwise 0
+ */
+int fl_load_baked_glyphs(fl_context* context, fl_font* font, const char* metrics, const char* atlas);
+
+/**
+ * Does the part of fl_load_baked_glyphs that doesn't need the renderer:
+ * reads the metrics and decodes the atlas. This may be done on any
+ * thread, as long as no other thread uses the font meanwhile. The
+ * glyphs can't be drawn until fl_upload_baked_glyphs has uploaded
+ * the atlas.
+ *
+ * Params:
+ *   fl_font - a font without baked glyphs
+ *   const char* - the path to the metrics of the baked font
+ *   const char* - the path to the atlas of the baked font
+ *   fl_surface** - receives the decoded atlas
+ *
+ * Returns:
+ *   int - 1 if the glyphs were read, otherwise 0
+ */
+int fl_read_baked_glyphs(fl_font* font, const char* metrics, const char* atlas, fl_surface** pixels);
+
+/**
+ * Uploads the atlas of glyphs read by fl_read_baked_glyphs.
+ * If the upload fails, the baked glyphs are dropped and the font
+ * rasterizes every glyph from the TTF.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
  *   fl_font - a font
- *   char - the character to be represented by the resulting glyph
+ *   fl_surface - the decoded atlas, which is not destroyed
+ *
+ * Returns:
+ *   int - 1 if the atlas was uploaded, otherwise 0
  */
-fl_image* fl_char_to_glyph(fl_font* font, char c);
+int fl_upload_baked_glyphs(fl_context* context, fl_font* font, fl_surface* pixels);
 
+/**
+ * Frees every glyph and atlas page of a font, including its baked glyphs.
+ *
+ * Params:
+ *   fl_font - a font
+ */
+void fl_destroy_glyph_cache(fl_font* font);
 
 /**
- * Creates an image containing text that doesn't change.
- * The resulting image can be destroyed with the fl_destroy_image function.
+ * Lays out a line of UTF-8 encoded text that doesn't change.
+ * The glyphs are positioned once here, so drawing the text
+ * only looks them up in the font's atlas.
+ * The result can be destroyed with the fl_destroy_static_text function.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -51,10 +145,29 @@ fl_image* fl_char_to_glyph(fl_font* font, char c);
  *   const char* - a string of characters to display
  *
  * Returns:
- *   fl_static_text - a new static text structure
+ *   fl_static_text - a new static text structure, or NULL on failure
  */
-fl_image* fl_create_static_text(fl_context* context,
+fl_static_text* fl_create_static_text(fl_context* context,
 	fl_resource* res,
 	const char* txt);
 
+/**
+ * Draws static text.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_static_text - static text
+ *   int - the x position of the text
+ *   int - the y position of the text
+ */
+void fl_draw_static_text(fl_context* context, fl_static_text* text, int x, int y);
+
+/**
+ * Frees the memory allocated for static text.
+ *
+ * Params:
+ *   fl_static_text - static text
+ */
+void fl_destroy_static_text(fl_static_text* text);
+
 #endif
@@ -32,4 +32,81 @@
 #define FLURMP_FLAG_15       0x4000
 #define FLURMP_FLAG_16       0x8000
 
+/**
+ * Gives an entity a handle from the entity table of a context.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity that is being added to the context
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_assign_handle(fl_context* context, fl_entity* entity);
+
+/**
+ * Returns the handle of an entity to the entity table,
+ * if the handle is still in use.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity
+ */
+void fl_release_handle(fl_context* context, fl_entity* entity);
+
+/**
+ * Adds an entity that already has a handle to the entity list
+ * and to the group of its type, and gives it a body if its
+ * type moves.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+int fl_link_entity(fl_context* context, fl_entity* entity);
+
+/**
+ * Applies the spawns, despawns and type changes requested during
+ * an update, in the order they were requested. This is the only
+ * point at which queued changes reach the entity list and groups.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_apply_entity_commands(fl_context* context);
+
+/**
+ * Frees the entities that have been despawned and removes them from
+ * the entity list, the entity groups and the animators. This does
+ * nothing unless an entity has been despawned since the last call.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_compact_entities(fl_context* context);
+
+/**
+ * Frees every entity in a context, including those waiting to be
+ * spawned, and discards the queued entity commands. Every handle
+ * stops resolving, and the entity groups are emptied but keep
+ * their storage.
+ * Animators are not touched.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_clear_entities(fl_context* context);
+
+/**
+ * Frees every entity in a context along with the entity table
+ * and the entity command storage.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+void fl_destroy_entities(fl_context* context);
+
 #endif
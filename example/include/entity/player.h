@@ -29,7 +29,8 @@ fl_entity* fl_create_player(int, int);
 void fl_register_player_type(fl_context* context, fl_entity_type*);
 
 /**
- * Creates the schedules for a player entity and adds them to a context.
+ * Creates the animator for a player entity.
+ * The player entity should be added to the context first.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -38,7 +39,7 @@ void fl_register_player_type(fl_context* context, fl_entity_type*);
  * Returns:
  *   int - 1 on success, or 0 on failure
  */
-int fl_load_player_schedules(fl_context* context, fl_entity* player);
+int fl_load_player_animations(fl_context* context, fl_entity* player);
 
 int fl_schedule_walk(fl_context* context, fl_entity* player);
 
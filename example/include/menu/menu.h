@@ -3,6 +3,15 @@
 
 #include "core/flurmp_impl.h"
 
+/* total number of cached menus */
+#define FLURMP_MENU_COUNT 4
+
+/* menu ids */
+#define FLURMP_MENU_PAUSE         0
+#define FLURMP_MENU_PAUSE_SUBMENU 1
+#define FLURMP_MENU_FISH_SUBMENU  2
+#define FLURMP_MENU_CONFIRMATION  3
+
 /**
  * Creates a menu.
  *
@@ -54,7 +63,35 @@ fl_menu_item* fl_create_menu_item(fl_context* context,
 void fl_destroy_menu_item(fl_menu_item* item);
 
 /**
- * Retrieves a pointer to the current active menu.
+ * Retrieves a menu from the menu cache of a context, ready to be
+ * pushed. The menu is built with the create function the first time
+ * it is opened and kept afterwards, so later opens only reset its
+ * cursor, links and callback.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - a menu id (e.g. FLURMP_MENU_PAUSE)
+ *   fl_menu*(*create) (fl_context*) - a function that builds the menu
+ *
+ * Returns:
+ *   fl_menu - the menu, or NULL if it could not be built
+ */
+fl_menu* fl_open_menu(fl_context* context, int id, fl_menu*(*create) (fl_context*));
+
+/**
+ * Disposes of a menu that was removed with fl_pop_menu.
+ * Menus from the menu cache are kept for the next time they are
+ * opened, and any other menu is destroyed.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_menu - a menu
+ */
+void fl_close_menu(fl_context* context, fl_menu* menu);
+
+/**
+ * Retrieves a pointer to the current active menu,
+ * which is the menu at the top of the menu stack.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -65,8 +102,8 @@ void fl_destroy_menu_item(fl_menu_item* item);
 fl_menu* fl_get_active_menu(fl_context* context);
 
 /**
- * Appends a menu to the current context.
- * The most recently appended menu becomes the active menu.
+ * Pushes a menu onto the menu stack of a context.
+ * The most recently pushed menu becomes the active menu.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -75,8 +112,8 @@ fl_menu* fl_get_active_menu(fl_context* context);
 void fl_push_menu(fl_context* context, fl_menu* menu);
 
 /**
- * Removes the most recently added menu from a context.
- * Upon removal, the menu's parent becomes the active menu.
+ * Removes the menu at the top of the menu stack of a context.
+ * Upon removal, the menu below it becomes the active menu.
  * This does NOT destroy the menu that was removed.
  * It returns a pointer to the removed menu, and it is the
  * responsibility of the caller of this function to handle
@@ -12,6 +12,30 @@
 #define FLURMP_SCENE_NONE 0
 #define FLURMP_SCENE_TEST_1 1
 #define FLURMP_SCENE_TEST_2 2
+#define FLURMP_SCENE_STRESS 3
+#define FLURMP_SCENE_STREAM 4
+
+/* placement of the entities in a stress scene */
+#define FLURMP_LAYOUT_GRID      0 /* evenly spaced, no overlap    */
+#define FLURMP_LAYOUT_UNIFORM   1 /* uniformly random positions   */
+#define FLURMP_LAYOUT_CLUSTERED 2 /* dense, overlapping clusters */
+
+/**
+ * Describes a procedurally generated scene used for stress tests.
+ * Entities are placed within a region of the given size whose
+ * top left corner is the origin.
+ */
+typedef struct fl_stress_config {
+	int blocks;
+	int spikes;
+	int doors;
+	int pellets;
+	int players;
+	int layout;
+	int w;
+	int h;
+	unsigned int seed;
+}fl_stress_config;
 
 /**
  * Populates a context with entities and resources.
@@ -22,6 +46,40 @@
  */
 void fl_load_scene(fl_context* context, int id);
 
+/**
+ * Sets a stress scene configuration to the defaults used when the
+ * stress scene is loaded by ID: a few thousand entities of each kind
+ * in uniformly random positions.
+ *
+ * Params:
+ *   fl_stress_config - a stress scene configuration
+ */
+void fl_default_stress_config(fl_stress_config* config);
+
+/**
+ * Populates a context with a procedurally generated scene.
+ * The same configuration, including the seed, always produces
+ * the same scene. The first player becomes the primary control
+ * object. Pellets are placed like any other entity, and those that
+ * start out inside a solid entity are despawned on the first update.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_stress_config - the contents of the scene
+ */
+void fl_load_stress_scene(fl_context* context, const fl_stress_config* config);
+
+/**
+ * Populates a context with a streamed world. The player starts on a
+ * platform at the center of the world, and only the chunks around the
+ * camera are loaded. The world is destroyed with the scene.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_world_config - the size and contents of the world
+ */
+void fl_load_stream_scene(fl_context* context, const fl_world_config* config);
+
 /**
  * Removes entities and unloads resources from a context.
  * When a scene is cleared, all entities are destroyed, but some
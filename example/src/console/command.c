@@ -0,0 +1,660 @@
+#include "core/command.h"
+#include "core/latency.h"
+#include "core/profiler.h"
+#include "core/memory.h"
+#include "core/data_panel.h"
+#include "core/audio.h"
+#include "entity/entity.h"
+#include "entity/block_200_50.h"
+#include "entity/spike.h"
+#include "entity/sign.h"
+
+#include <ctype.h>
+
+/* maximum number of scripts that may be running at once,
+   which stops scripts that execute themselves */
+#define SCRIPT_DEPTH_LIMIT 4
+
+/* layout of entities added by the spawn command */
+#define SPAWN_COLUMNS 20
+#define SPAWN_SPACING_X 210
+#define SPAWN_SPACING_Y 60
+#define SPAWN_TOP 600
+
+/* number of scripts currently running */
+static int script_depth_ = 0;
+
+
+
+/* -------------------------------------------------------------- */
+/*                   internal command functions                   */
+/* -------------------------------------------------------------- */
+
+/**
+ * Hashes a command name into a bucket index.
+ *
+ * Params:
+ *   const char* - a command name
+ *
+ * Returns:
+ *   unsigned int - a bucket index
+ */
+static unsigned int hash_name(const char* name);
+
+/**
+ * Finds a registered command.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - the name of the command
+ *
+ * Returns:
+ *   fl_command - the command, or NULL if there is no such command
+ */
+static fl_command* find_command(fl_context* context, const char* name);
+
+/**
+ * Tokenizes a line and runs the command it names.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - a line of input
+ *
+ * Returns:
+ *   int - 1 if a command was run, otherwise 0
+ */
+static int dispatch(fl_context* context, const char* line);
+
+/**
+ * Appends a line to the command history, unless it repeats
+ * the most recent line.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const char* - a line of input
+ */
+static void add_history(fl_context* context, const char* line);
+
+/**
+ * Parses a non-negative integer argument.
+ *
+ * Params:
+ *   const char* - an argument
+ *   int* - receives the value
+ *
+ * Returns:
+ *   int - 1 if the argument is a non-negative integer, otherwise 0
+ */
+static int parse_count(const char* arg, int* value);
+
+/* built-in commands */
+static void help_command(fl_context* context, int argc, char** argv);
+static void quit_command(fl_context* context, int argc, char** argv);
+static void info_command(fl_context* context, int argc, char** argv);
+static void latency_command(fl_context* context, int argc, char** argv);
+static void lowlatency_command(fl_context* context, int argc, char** argv);
+static void profile_command(fl_context* context, int argc, char** argv);
+static void stats_command(fl_context* context, int argc, char** argv);
+static void tickrate_command(fl_context* context, int argc, char** argv);
+static void spawn_command(fl_context* context, int argc, char** argv);
+static void reset_command(fl_context* context, int argc, char** argv);
+static void exec_command(fl_context* context, int argc, char** argv);
+static void memory_command(fl_context* context, int argc, char** argv);
+static void panel_command(fl_context* context, int argc, char** argv);
+static void volume_command(fl_context* context, int argc, char** argv);
+
+
+
+/* -------------------------------------------------------------- */
+/*            internal command functions (implementation)         */
+/* -------------------------------------------------------------- */
+
+static unsigned int hash_name(const char* name)
+{
+	/* FNV-1a */
+	unsigned int hash = 2166136261u;
+
+	while (*name)
+	{
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash & (FLURMP_COMMAND_BUCKETS - 1);
+}
+
+static fl_command* find_command(fl_context* context, const char* name)
+{
+	fl_command* cmd;
+
+	if (context->commands.buckets == NULL)
+		return NULL;
+
+	for (cmd = context->commands.buckets[hash_name(name)]; cmd != NULL; cmd = cmd->next)
+	{
+		if (!strcmp(cmd->name, name))
+			return cmd;
+	}
+
+	return NULL;
+}
+
+static int dispatch(fl_context* context, const char* line)
+{
+	char buffer[FLURMP_COMMAND_LENGTH];
+	char* argv[FLURMP_COMMAND_ARGS];
+	int argc;
+	fl_command* cmd;
+
+	strncpy(buffer, line, FLURMP_COMMAND_LENGTH - 1);
+	buffer[FLURMP_COMMAND_LENGTH - 1] = '\0';
+
+	argc = fl_tokenize(buffer, argv, FLURMP_COMMAND_ARGS);
+
+	if (argc == 0)
+		return 0;
+
+	cmd = find_command(context, argv[0]);
+
+	if (cmd == NULL)
+	{
+		printf("unknown command: %s\n", argv[0]);
+		return 0;
+	}
+
+	cmd->run(context, argc, argv);
+
+	return 1;
+}
+
+static void add_history(fl_context* context, const char* line)
+{
+	fl_command_registry* reg = &context->commands;
+	const char* last = fl_get_history(context, 0);
+	char* slot;
+
+	if (last != NULL && !strcmp(last, line))
+		return;
+
+	slot = reg->history[reg->history_count % FLURMP_HISTORY_LIMIT];
+	strncpy(slot, line, FLURMP_COMMAND_LENGTH - 1);
+	slot[FLURMP_COMMAND_LENGTH - 1] = '\0';
+
+	reg->history_count++;
+}
+
+static int parse_count(const char* arg, int* value)
+{
+	char* end;
+	long n = strtol(arg, &end, 10);
+
+	if (*arg == '\0' || *end != '\0' || n < 0 || n > 1000000)
+		return 0;
+
+	*value = (int)n;
+	return 1;
+}
+
+static void help_command(fl_context* context, int argc, char** argv)
+{
+	fl_print_commands(context, argc > 1 ? argv[1] : "");
+}
+
+static void quit_command(fl_context* context, int argc, char** argv)
+{
+	context->done = 1;
+}
+
+static void info_command(fl_context* context, int argc, char** argv)
+{
+	printf("Flurmp\nVersion: 1.0.0\nAuthor: John Powell\n");
+}
+
+static void latency_command(fl_context* context, int argc, char** argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "reset"))
+		fl_latency_reset(context);
+	else
+		fl_latency_report(context);
+}
+
+static void lowlatency_command(fl_context* context, int argc, char** argv)
+{
+	/* Measurements from the previous mode are discarded
+	   so the histogram only describes the current mode. */
+	context->low_latency = !context->low_latency;
+	fl_latency_reset(context);
+	printf("low latency mode %s\n", context->low_latency ? "on" : "off");
+}
+
+static void profile_command(fl_context* context, int argc, char** argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "reset"))
+	{
+		fl_profile_reset(context);
+		return;
+	}
+
+	context->profiler.enabled = !context->profiler.enabled;
+	printf("profiler %s\n", context->profiler.enabled ? "on" : "off");
+}
+
+static void stats_command(fl_context* context, int argc, char** argv)
+{
+	int i;
+
+	printf("tick rate: %d\n", context->fps);
+	printf("entities: %d\n", context->entity_count);
+
+	for (i = 0; i < FLURMP_ENTITY_TYPE_COUNT; i++)
+		printf("  type %d: %d\n", i, context->entity_groups[i].count);
+
+	printf("animators: %d\n", context->animators.count);
+	printf("latency p50/p99: %u/%u ms\n",
+		fl_latency_percentile(context, 50), fl_latency_percentile(context, 99));
+
+	fl_profile_report(context);
+}
+
+static void tickrate_command(fl_context* context, int argc, char** argv)
+{
+	int rate;
+
+	if (argc < 2)
+	{
+		printf("tick rate: %d\n", context->fps);
+		return;
+	}
+
+	if (!parse_count(argv[1], &rate) || rate < 1 || rate > 1000)
+	{
+		printf("usage: tickrate <1-1000>\n");
+		return;
+	}
+
+	context->fps = rate;
+}
+
+static void spawn_command(fl_context* context, int argc, char** argv)
+{
+	int i;
+	int count;
+	fl_entity* (*create) (int, int) = fl_create_block_200_50;
+
+	if (argc < 2 || !parse_count(argv[1], &count))
+	{
+		printf("usage: spawn <count> [block|spike|sign]\n");
+		return;
+	}
+
+	if (argc > 2)
+	{
+		if (!strcmp(argv[2], "spike"))
+			create = fl_create_spike;
+		else if (!strcmp(argv[2], "sign"))
+			create = fl_create_sign;
+		else if (strcmp(argv[2], "block"))
+		{
+			printf("unknown entity: %s\n", argv[2]);
+			return;
+		}
+	}
+
+	/* Lay the entities out in a grid below the scene
+	   so that they do not trap the player. */
+	for (i = 0; i < count; i++)
+	{
+		fl_entity* en = create((i % SPAWN_COLUMNS) * SPAWN_SPACING_X,
+			SPAWN_TOP + (i / SPAWN_COLUMNS) * SPAWN_SPACING_Y);
+
+		if (en == NULL)
+			break;
+
+		fl_add_entity(context, en);
+
+		if (context->error)
+			break;
+	}
+
+	printf("spawned %d entities\n", i);
+}
+
+static void reset_command(fl_context* context, int argc, char** argv)
+{
+	fl_entity* pco = fl_get_entity(context, context->pco);
+
+	if (pco == NULL)
+		return;
+
+	pco->x = 260;
+	pco->y = 260;
+	context->cam_x = 0;
+	context->cam_y = 0;
+}
+
+static void exec_command(fl_context* context, int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: exec <path>\n");
+		return;
+	}
+
+	if (!fl_execute_script(context, argv[1]))
+		printf("could not run %s\n", argv[1]);
+}
+
+
+static void memory_command(fl_context* context, int argc, char** argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "leaks"))
+	{
+		/* Everything still allocated, which is only a leak
+		   once the context has been destroyed. */
+		if (fl_memory_report_leaks() == 0)
+			printf("no live blocks\n");
+	}
+	else
+		fl_memory_report();
+}
+
+static void panel_command(fl_context* context, int argc, char** argv)
+{
+	if (context->data_panel == NULL)
+		return;
+
+	if (argc < 2)
+		fl_set_data_panel_page(context->data_panel, (context->data_panel->page + 1) % FLURMP_PANEL_PAGE_COUNT);
+	else if (!strcmp(argv[1], "player"))
+		fl_set_data_panel_page(context->data_panel, FLURMP_PANEL_PAGE_PLAYER);
+	else if (!strcmp(argv[1], "memory"))
+		fl_set_data_panel_page(context->data_panel, FLURMP_PANEL_PAGE_MEMORY);
+	else
+		printf("usage: panel [player|memory]\n");
+}
+
+static void volume_command(fl_context* context, int argc, char** argv)
+{
+	int volume;
+
+	if (context->audio == NULL)
+	{
+		printf("no audio device\n");
+		return;
+	}
+
+	if (argc < 2)
+	{
+		printf("volume: %d (%d commands dropped)\n",
+			(int)(fl_get_master_volume(context->audio) * 100.0f + 0.5f), context->audio->dropped);
+		return;
+	}
+
+	if (!parse_count(argv[1], &volume) || volume > 100)
+	{
+		printf("usage: volume <0-100>\n");
+		return;
+	}
+
+	fl_set_master_volume(context->audio, volume / 100.0f);
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                    command.h implementation                    */
+/* -------------------------------------------------------------- */
+
+int fl_create_commands(fl_context* context)
+{
+	fl_command_registry* reg = &context->commands;
+
+	reg->buckets = fl_alloc(fl_command*, FLURMP_COMMAND_BUCKETS);
+
+	if (reg->buckets == NULL)
+		return 0;
+
+	fl_null(reg->buckets, FLURMP_COMMAND_BUCKETS);
+
+	reg->count = 0;
+	reg->history_count = 0;
+
+	return fl_register_command(context, "help", "lists commands", help_command)
+		&& fl_register_command(context, "quit", "closes the application", quit_command)
+		&& fl_register_command(context, "info", "prints application information", info_command)
+		&& fl_register_command(context, "latency", "prints input latency, or discards it with reset", latency_command)
+		&& fl_register_command(context, "lowlatency", "toggles sleeping before input is polled", lowlatency_command)
+		&& fl_register_command(context, "profile", "toggles the frame profiler, or discards timings with reset", profile_command)
+		&& fl_register_command(context, "stats", "prints entity, latency and profiler statistics", stats_command)
+		&& fl_register_command(context, "tickrate", "prints or sets the target frames per second", tickrate_command)
+		&& fl_register_command(context, "spawn", "adds entities below the scene for stress tests", spawn_command)
+		&& fl_register_command(context, "reset", "moves the player back to the start", reset_command)
+		&& fl_register_command(context, "exec", "runs each line of a file as a command", exec_command)
+		&& fl_register_command(context, "memory", "prints memory use by tag, or every live block with leaks", memory_command)
+		&& fl_register_command(context, "panel", "cycles or selects the data panel page", panel_command)
+		&& fl_register_command(context, "volume", "prints or sets the master volume", volume_command);
+}
+
+void fl_destroy_commands(fl_context* context)
+{
+	fl_command_registry* reg = &context->commands;
+	fl_command* cmd;
+	fl_command* next;
+	int i;
+
+	if (reg->buckets == NULL)
+		return;
+
+	for (i = 0; i < FLURMP_COMMAND_BUCKETS; i++)
+	{
+		for (cmd = reg->buckets[i]; cmd != NULL; cmd = next)
+		{
+			next = cmd->next;
+			fl_free(cmd);
+		}
+	}
+
+	fl_free(reg->buckets);
+	reg->buckets = NULL;
+	reg->count = 0;
+}
+
+int fl_register_command(fl_context* context,
+	const char* name,
+	const char* help,
+	void(*run) (fl_context*, int, char**))
+{
+	fl_command* cmd;
+	unsigned int slot;
+
+	if (context == NULL || context->commands.buckets == NULL || name == NULL || run == NULL)
+		return 0;
+
+	/* Replace an existing command of the same name. */
+	cmd = find_command(context, name);
+
+	if (cmd != NULL)
+	{
+		cmd->help = help;
+		cmd->run = run;
+		return 1;
+	}
+
+	cmd = fl_alloc(fl_command, 1);
+
+	if (cmd == NULL)
+		return 0;
+
+	slot = hash_name(name);
+
+	cmd->name = name;
+	cmd->help = help;
+	cmd->run = run;
+	cmd->next = context->commands.buckets[slot];
+
+	context->commands.buckets[slot] = cmd;
+	context->commands.count++;
+
+	return 1;
+}
+
+int fl_tokenize(char* line, char** argv, int max)
+{
+	int argc = 0;
+	char* read = line;
+	char* write;
+
+	while (argc < max)
+	{
+		/* Skip the whitespace between arguments. */
+		while (*read && isspace((unsigned char)*read))
+			read++;
+
+		if (*read == '\0')
+			break;
+
+		/* Arguments are compacted in place as quotes are removed. */
+		argv[argc++] = write = read;
+
+		while (*read && !isspace((unsigned char)*read))
+		{
+			if (*read == '"')
+			{
+				read++;
+
+				while (*read && *read != '"')
+					*write++ = *read++;
+
+				if (*read == '"')
+					read++;
+			}
+			else
+				*write++ = *read++;
+		}
+
+		if (*read)
+			read++;
+
+		*write = '\0';
+	}
+
+	return argc;
+}
+
+int fl_execute_command(fl_context* context, const char* line)
+{
+	if (context == NULL || line == NULL)
+		return 0;
+
+	/* Skip blank lines. */
+	while (*line && isspace((unsigned char)*line))
+		line++;
+
+	if (*line == '\0')
+		return 0;
+
+	add_history(context, line);
+
+	return dispatch(context, line);
+}
+
+int fl_execute_script(fl_context* context, const char* path)
+{
+	FILE* file;
+	char line[FLURMP_COMMAND_LENGTH];
+
+	if (context == NULL || path == NULL || script_depth_ >= SCRIPT_DEPTH_LIMIT)
+		return 0;
+
+	file = fopen(path, "r");
+
+	if (file == NULL)
+		return 0;
+
+	script_depth_++;
+
+	while (!context->done && fgets(line, FLURMP_COMMAND_LENGTH, file) != NULL)
+	{
+		char* start = line;
+
+		line[strcspn(line, "\r\n")] = '\0';
+
+		while (*start && isspace((unsigned char)*start))
+			start++;
+
+		if (*start == '\0' || *start == '#')
+			continue;
+
+		dispatch(context, start);
+	}
+
+	script_depth_--;
+
+	fclose(file);
+
+	return 1;
+}
+
+int fl_complete_command(fl_context* context, const char* prefix, char* out, int size)
+{
+	fl_command* cmd;
+	size_t len = strlen(prefix);
+	int matches = 0;
+	int i, j;
+
+	if (context->commands.buckets == NULL || size <= 0)
+		return 0;
+
+	for (i = 0; i < FLURMP_COMMAND_BUCKETS; i++)
+	{
+		for (cmd = context->commands.buckets[i]; cmd != NULL; cmd = cmd->next)
+		{
+			if (strncmp(cmd->name, prefix, len))
+				continue;
+
+			if (matches++ == 0)
+			{
+				/* The first match is the longest possible completion. */
+				strncpy(out, cmd->name, size - 1);
+				out[size - 1] = '\0';
+				continue;
+			}
+
+			/* Shorten the completion to the prefix shared with this match. */
+			for (j = 0; out[j] && out[j] == cmd->name[j]; j++);
+			out[j] = '\0';
+		}
+	}
+
+	return matches;
+}
+
+void fl_print_commands(fl_context* context, const char* prefix)
+{
+	fl_command* cmd;
+	size_t len = strlen(prefix);
+	int i;
+
+	if (context->commands.buckets == NULL)
+		return;
+
+	for (i = 0; i < FLURMP_COMMAND_BUCKETS; i++)
+	{
+		for (cmd = context->commands.buckets[i]; cmd != NULL; cmd = cmd->next)
+		{
+			if (!strncmp(cmd->name, prefix, len))
+				printf("  %-12s %s\n", cmd->name, cmd->help != NULL ? cmd->help : "");
+		}
+	}
+}
+
+const char* fl_get_history(fl_context* context, int age)
+{
+	fl_command_registry* reg = &context->commands;
+	int available = reg->history_count < FLURMP_HISTORY_LIMIT ? reg->history_count : FLURMP_HISTORY_LIMIT;
+
+	if (age < 0 || age >= available)
+		return NULL;
+
+	return reg->history[(reg->history_count - 1 - age) % FLURMP_HISTORY_LIMIT];
+}
@@ -1,4 +1,5 @@
 #include "core/console.h"
+#include "core/command.h"
 #include "core/input.h"
 #include "core/text.h"
 
@@ -23,8 +24,9 @@ static void render(fl_context* context, fl_console* console);
 
 /**
  * The input handler function for a console.
- * A console allows for text input via a keyboard, so any keys required
- * to send the desired input must be handled.
+ * Printable characters are taken from the text input received during
+ * the current frame. Editing keys such as backspace and return are
+ * handled as key presses.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -33,14 +35,13 @@ static void render(fl_context* context, fl_console* console);
 static void handle_input(fl_context* context, fl_input_handler* self);
 
 /**
- * Writes a character to a console's buffer.
+ * Writes a byte of UTF-8 encoded text to a console's buffer.
  *
  * Params:
  *   fl_console - a console
- *   char - a character
- *   unsigned char - modifier flags
+ *   char - a byte of UTF-8 encoded text
  */
-static void console_putc(fl_console* console, char c, unsigned char mod);
+static void console_putc(fl_console* console, char c);
 
 /**
  * Clears the contents of the current console buffer by setting all
@@ -63,18 +64,36 @@ static void clear_buffer(fl_console* console);
 static void submit_buffer(fl_context* context, fl_console* console);
 
 /**
- * Gets a character based on the scancode from a keypress.
- * If a combination of keys is pressed, such as Shift+A, then
- * the appropriate flags should be passed in.
+ * Replaces the contents of a console's buffer.
  *
  * Params:
- *   int - a scancode
- *   unsigned char - modifier flags indicating key combinations
+ *   fl_console - a console
+ *   const char* - the new contents of the buffer
+ */
+static void set_buffer(fl_console* console, const char* text);
+
+/**
+ * Completes the command name in a console's buffer.
+ * A unique match is completed in full and followed by a space.
+ * When several commands match, the buffer is extended to their
+ * common prefix and the candidates are printed to stdout.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_console - a console
+ */
+static void complete_buffer(fl_context* context, fl_console* console);
+
+/**
+ * Replaces the contents of a console's buffer with an
+ * entry from the command history.
  *
- * Return:
- *   char - a character
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_console - a console
+ *   int - 1 to step to an older entry, -1 to step to a newer entry
  */
-static char fl_sc_to_char(int sc, unsigned char mod);
+static void browse_history(fl_context* context, fl_console* console, int step);
 
 
 
@@ -84,12 +103,12 @@ static char fl_sc_to_char(int sc, unsigned char mod);
 
 static void render(fl_context* context, fl_console* self)
 {
-	int i;         /* index variable     */
-	int cx;        /* cursor x position  */
-	int cy;        /* cursor y position  */
-	fl_rect frame; /* dialog frame       */
-	fl_rect src;   /* render source      */
-	fl_rect dest;  /* render destination */
+	unsigned int c;   /* current code point */
+	const char* text; /* decode position    */
+	int cx;           /* cursor x position  */
+	int cy;           /* cursor y position  */
+	fl_rect frame;    /* dialog frame       */
+	fl_rect dest;     /* render destination */
 
 	fl_set_rect(&frame, self->x, self->y, self->w, self->h);
 
@@ -99,27 +118,25 @@ static void render(fl_context* context, fl_console* self)
 	fl_set_draw_color(context, 250, 250, 250, 255);
 	fl_draw_rect(context, &frame);
 
-	dest.x = 0;
-	dest.y = 0;
-	src.x = 0;
-	src.y = 0;
+	text = self->buffer;
+	cx = cy = 0;
 
-	for (i = cx = cy = 0; i < BUFFER_LIMIT; i++)
+	while ((c = fl_utf8_decode(&text)) != 0)
 	{
-		if (self->buffer[i] >= 0x20 && self->buffer[i] <= 0x7E)
+		if (c >= 0x20 && c != 0x7F)
 		{
 			/* Get the appropriate glyph from the font atlas. */
-			fl_image* g = fl_char_to_glyph(self->font, self->buffer[i]);
+			fl_glyph* g = fl_get_glyph(context, self->font, c);
+
+			if (g == NULL)
+				continue;
 
 			dest.x = self->x + cx + 4;
 			dest.y = self->y + cy * 22 + 4;
-			dest.w = g->w;
-			dest.h = g->h;
-
-			src.w = g->w;
-			src.h = g->h;
+			dest.w = g->src.w;
+			dest.h = g->src.h;
 
-			fl_draw(context, g->texture, &src, &dest, 0);
+			fl_draw(context, g->texture, &g->src, &dest, 0);
 
 			if (cx >= LINE_WIDTH)
 			{
@@ -131,9 +148,9 @@ static void render(fl_context* context, fl_console* self)
 					cy++;
 			}
 			else
-				cx += g->w;
+				cx += g->src.w;
 		}
-		else if (self->buffer[i] == 0x0A)
+		else if (c == 0x0A)
 		{
 			/* If we encounter a newline,
 			   increment the cursor's y position. */
@@ -147,58 +164,70 @@ static void render(fl_context* context, fl_console* self)
 static void handle_input(fl_context* context, fl_input_handler* self)
 {
 	int i;
-	for (i = 0; i < FLURMP_SC_LIMIT; i++)
+
+	/* If escape is pressed, close the console. */
+	if (fl_consume_key(context, FLURMP_SC_ESCAPE))
 	{
-		unsigned char mod = 0x00;
+		/* Relenquish input control */
+		fl_pop_input_handler(context);
 
-		/* Handle key combinations like shift and ctrl. */
-		if (fl_peek_key(context, FLURMP_SC_LSHIFT) || fl_peek_key(context, FLURMP_SC_RSHIFT))
-			mod |= FLURMP_CONSOLE_MOD_SHIFT;
+		fl_destroy_console(context->console);
+		context->console = NULL;
 
-		if (fl_peek_key(context, FLURMP_SC_LCTRL) || fl_peek_key(context, FLURMP_SC_RCTRL))
-			mod |= FLURMP_CONSOLE_MOD_CTRL;
+		return;
+	}
 
-		if (fl_consume_key(context, i))
+	/* Ctrl+C clears the current buffer. */
+	if (fl_peek_key(context, FLURMP_SC_LCTRL) || fl_peek_key(context, FLURMP_SC_RCTRL))
+	{
+		if (fl_consume_key(context, FLURMP_SC_C))
 		{
-			/* Get the character that corresponds
-			   to the current scancode. */
-			char c = fl_sc_to_char(i, mod);
+			clear_buffer(context->console);
+			return;
+		}
+	}
 
-			/* If escape is rpessed, close the console. */
-			if (i == FLURMP_SC_ESCAPE)
-			{
-				/* Relenquish input control */
-				fl_pop_input_handler(context);
+	/* Append the UTF-8 text typed during this frame. */
+	for (i = 0; i < context->input.text_count; i++)
+		console_putc(context->console, context->input.text[i]);
 
-				fl_destroy_console(context->console);
-				context->console = NULL;
+	if (fl_consume_key(context, FLURMP_SC_BACKSPACE))
+		console_putc(context->console, (char)0x08);
 
-				return;
-			}
+	/* Tab completes command names. */
+	if (fl_consume_key(context, FLURMP_SC_TAB))
+		complete_buffer(context, context->console);
 
-			/* If return is pressed, submit the current buffer,
-			   otherwise append to the current buffer. */
-			if (c == 0x0A)
-				submit_buffer(context, context->console);
-			else
-				console_putc(context->console, c, mod);
-		}
-	}
+	/* Up and down step through previously submitted commands. */
+	if (fl_consume_key(context, FLURMP_SC_UP))
+		browse_history(context, context->console, 1);
+
+	if (fl_consume_key(context, FLURMP_SC_DOWN))
+		browse_history(context, context->console, -1);
+
+	/* If return is pressed, submit the current buffer. */
+	if (fl_consume_key(context, FLURMP_SC_RETURN) || fl_consume_key(context, FLURMP_SC_RETURN2))
+		submit_buffer(context, context->console);
 }
 
-static void console_putc(fl_console* console, char c, unsigned char mod)
+static void console_putc(fl_console* console, char c)
 {
-	if (console->buffer_count >= BUFFER_LIMIT || c == '\0')
+	if (c == '\0')
 		return;
 
 	/* Handle backspaces. */
 	if (c == 0x08)
 	{
-		/* If there is at least one character in the buffer,
-		   set the current character to '\0' and decrement
-		   the character count. */
-		if (console->buffer_count > 0)
-			console->buffer[console->buffer_count-- - 1] = '\0';
+		/* Remove the last character from the buffer, including
+		   every byte of it if it was encoded as several bytes. */
+		while (console->buffer_count > 0)
+		{
+			char last = console->buffer[--console->buffer_count];
+			console->buffer[console->buffer_count] = '\0';
+
+			if (((unsigned char)last & 0xC0) != 0x80)
+				break;
+		}
 
 		return;
 	}
@@ -218,110 +247,87 @@ static void console_putc(fl_console* console, char c, unsigned char mod)
 		return;
 	}
 
-	/* Skip unprintable characters. */
-	if (c < 0x20)
+	/* Skip control characters. Bytes above 0x7F belong to
+	   UTF-8 sequences and are kept, and the last element of
+	   the buffer is reserved for the terminator. */
+	if ((unsigned char)c < 0x20 || c == 0x7F || console->buffer_count >= BUFFER_LIMIT - 1)
 		return;
 
-	/* handle Ctrl combos */
-	if (mod & FLURMP_CONSOLE_MOD_CTRL)
-	{
-		if ((c == 'c' || c == 'C') && mod == FLURMP_CONSOLE_MOD_CTRL)
-		{
-			clear_buffer(console);
-			return;
-		}
-	}
-
 	console->buffer[console->buffer_count++] = c;
 }
 
 static void submit_buffer(fl_context* context, fl_console* console)
 {
-	const char* buf = console->buffer;
+	/* Commands are registered in command.c;
+	   type "help" in the console to list them. */
+	fl_execute_command(context, console->buffer);
 
-	/* Command List
-	   1. quit - flags the context as done.
-	   2. info - prints information about the application to stdout.
-	*/
+	console->history_pos = 0;
 
-	if (!strcmp("quit", buf))
-		context->done = 1;
-
-	if (!strcmp("info", buf))
-		printf("Flurmp\nVersion: 1.0.0\nAuthor: John Powell\n");
+	/* Running a command may have closed the console. */
+	if (context->console == console)
+		clear_buffer(console);
+}
 
+static void set_buffer(fl_console* console, const char* text)
+{
 	clear_buffer(console);
+
+	while (*text)
+		console_putc(console, *text++);
 }
 
-static void clear_buffer(fl_console* console)
+static void complete_buffer(fl_context* context, fl_console* console)
 {
-	fl_zero(console->buffer, BUFFER_LIMIT);
+	char completion[BUFFER_LIMIT];
+	int matches;
 
-	console->cursor_x = 0;
-	console->cursor_y = 0;
-	console->buffer_count = 0;
+	/* Only the command name is completed, not its arguments. */
+	if (strchr(console->buffer, ' ') != NULL)
+		return;
+
+	matches = fl_complete_command(context, console->buffer, completion, BUFFER_LIMIT - 1);
+
+	if (matches == 0)
+		return;
+
+	if (matches == 1)
+		strcat(completion, " ");
+	else
+		fl_print_commands(context, console->buffer);
+
+	set_buffer(console, completion);
 }
 
-static char fl_sc_to_char(int sc, unsigned char mod)
+static void browse_history(fl_context* context, fl_console* console, int step)
 {
-	switch (sc)
+	const char* entry;
+	int pos = console->history_pos + step;
+
+	/* Position 0 is the empty line below the most recent entry. */
+	if (pos <= 0)
 	{
-	case FLURMP_SC_A: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'A'; else return 'a';
-	case FLURMP_SC_B: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'B'; else return 'b';
-	case FLURMP_SC_C: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'C'; else return 'c';
-	case FLURMP_SC_D: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'D'; else return 'd';
-	case FLURMP_SC_E: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'E'; else return 'e';
-	case FLURMP_SC_F: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'F'; else return 'f';
-	case FLURMP_SC_G: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'G'; else return 'g';
-	case FLURMP_SC_H: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'H'; else return 'h';
-	case FLURMP_SC_I: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'I'; else return 'i';
-	case FLURMP_SC_J: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'J'; else return 'j';
-	case FLURMP_SC_K: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'K'; else return 'k';
-	case FLURMP_SC_L: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'L'; else return 'l';
-	case FLURMP_SC_M: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'M'; else return 'm';
-	case FLURMP_SC_N: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'N'; else return 'n';
-	case FLURMP_SC_O: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'O'; else return 'o';
-	case FLURMP_SC_P: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'P'; else return 'p';
-	case FLURMP_SC_Q: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'Q'; else return 'q';
-	case FLURMP_SC_R: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'R'; else return 'r';
-	case FLURMP_SC_S: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'S'; else return 's';
-	case FLURMP_SC_T: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'T'; else return 't';
-	case FLURMP_SC_U: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'U'; else return 'u';
-	case FLURMP_SC_V: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'V'; else return 'v';
-	case FLURMP_SC_W: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'W'; else return 'w';
-	case FLURMP_SC_X: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'X'; else return 'x';
-	case FLURMP_SC_Y: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'Y'; else return 'y';
-	case FLURMP_SC_Z: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return 'Z'; else return 'z';
-	case FLURMP_SC_0: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return ')'; else return '0';
-	case FLURMP_SC_1: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '!'; else return '1';
-	case FLURMP_SC_2: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '@'; else return '2';
-	case FLURMP_SC_3: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '#'; else return '3';
-	case FLURMP_SC_4: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '$'; else return '4';
-	case FLURMP_SC_5: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '%'; else return '5';
-	case FLURMP_SC_6: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '^'; else return '6';
-	case FLURMP_SC_7: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '&'; else return '7';
-	case FLURMP_SC_8: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '*'; else return '8';
-	case FLURMP_SC_9: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '('; else return '9';
-
-	case FLURMP_SC_COMMA:        if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '<'; else return ',';
-	case FLURMP_SC_PERIOD:       if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '>'; else return '.';
-	case FLURMP_SC_LEFTBRACKET:  if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '{'; else return '[';
-	case FLURMP_SC_RIGHTBRACKET: if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '}'; else return ']';
-	case FLURMP_SC_SEMICOLON:    if (mod & FLURMP_CONSOLE_MOD_SHIFT) return ':'; else return ';';
-	case FLURMP_SC_APOSTRAPHE:   if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '"'; else return '\'';
-	case FLURMP_SC_SLASH:        if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '?'; else return '/';
-	case FLURMP_SC_BACKSLASH:    if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '|'; else return '\\';
-	case FLURMP_SC_MINUS:        if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '_'; else return '-';
-	case FLURMP_SC_EQUALS:       if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '+'; else return '=';
-	case FLURMP_SC_BACKTICK:     if (mod & FLURMP_CONSOLE_MOD_SHIFT) return '~'; else return '`';
-
-	case FLURMP_SC_SPACE:     return ' ';
-	case FLURMP_SC_BACKSPACE: return (char)0x08;
-	case FLURMP_SC_RETURN:    return (char)0x0A;
-	case FLURMP_SC_RETURN2:   return (char)0x0A;
-
-	default: return '\0';
+		console->history_pos = 0;
+		clear_buffer(console);
+		return;
 	}
+
+	entry = fl_get_history(context, pos - 1);
+
+	if (entry == NULL)
+		return;
+
+	console->history_pos = pos;
+	set_buffer(console, entry);
+}
+
+static void clear_buffer(fl_console* console)
+{
+	fl_zero(console->buffer, BUFFER_LIMIT);
+
+	console->cursor_x = 0;
+	console->cursor_y = 0;
+	console->buffer_count = 0;
 }
 
 
@@ -347,6 +353,7 @@ fl_console* fl_create_console(fl_context* context)
 	con->buffer_count = 0;
 	con->cursor_x = 0;
 	con->cursor_y = 0;
+	con->history_pos = 0;
 	con->font = context->fonts[FLURMP_FONT_COUSINE]->impl.font;
 	con->render = render;
 
@@ -373,6 +380,9 @@ fl_console* fl_create_console(fl_context* context)
 	/* Set all characters in the buffer to '\0' */
 	fl_zero(con->buffer, BUFFER_LIMIT);
 
+	/* Receive text input while the console is open. */
+	fl_start_text_input();
+
 	return con;
 }
 
@@ -389,5 +399,7 @@ void fl_destroy_console(fl_console* console)
 
 	fl_free(console);
 
+	fl_stop_text_input();
+
 	return;
 }
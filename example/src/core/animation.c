@@ -1,7 +1,13 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_ENTITY
+
 #include "core/animation.h"
 
+/* initial number of animators in a context */
+#define INITIAL_ANIMATOR_CAPACITY 8
+
 fl_animation* fl_create_animation(int f)
 {
+	int i;
 	fl_animation* a = fl_alloc(fl_animation, 1);
 
 	if (a == NULL)
@@ -15,7 +21,23 @@ fl_animation* fl_create_animation(int f)
 		return NULL;
 	}
 
+	int* durations = fl_alloc(int, f);
+
+	if (durations == NULL)
+	{
+		fl_free(frames);
+		fl_free(a);
+		return NULL;
+	}
+
+	for (i = 0; i < f; i++)
+	{
+		fl_set_rect(&(frames[i]), 0, 0, 0, 0);
+		durations[i] = 1;
+	}
+
 	a->frames = frames;
+	a->durations = durations;
 	a->frame_count = f;
 
 	return a;
@@ -29,5 +51,129 @@ void fl_destroy_animation(fl_animation* a)
 	if (a->frames != NULL)
 		fl_free(a->frames);
 
+	if (a->durations != NULL)
+		fl_free(a->durations);
+
 	fl_free(a);
 }
+
+void fl_set_animation_frame(fl_animation* a, int i, int x, int y, int w, int h, int duration)
+{
+	if (a == NULL || i < 0 || i >= a->frame_count)
+		return;
+
+	fl_set_rect(&(a->frames[i]), x, y, w, h);
+
+	/* Every frame must be shown for at least one update. */
+	a->durations[i] = duration > 0 ? duration : 1;
+}
+
+int fl_add_animator(fl_context* context, fl_entity* entity, fl_animation* animation)
+{
+	fl_animator_list* list = &(context->animators);
+	fl_animator* an;
+
+	if (entity == NULL || animation == NULL)
+		return 0;
+
+	/* Double the animator storage when it is full. */
+	if (list->count >= list->capacity)
+	{
+		int i;
+		int capacity = list->capacity ? list->capacity * 2 : INITIAL_ANIMATOR_CAPACITY;
+		fl_animator* items = fl_alloc(fl_animator, capacity);
+
+		if (items == NULL)
+			return 0;
+
+		for (i = 0; i < list->count; i++)
+			items[i] = list->items[i];
+
+		if (list->items != NULL)
+			fl_free(list->items);
+
+		list->items = items;
+		list->capacity = capacity;
+	}
+
+	entity->animator = list->count;
+
+	an = &(list->items[list->count++]);
+	an->entity = entity;
+	an->animation = animation;
+	an->frame = 0;
+	an->timer = animation->durations[0];
+
+	entity->frame = &(animation->frames[0]);
+
+	return 1;
+}
+
+void fl_remove_animator(fl_context* context, fl_entity* entity)
+{
+	fl_animator_list* list = &(context->animators);
+	int i = entity->animator;
+
+	if (i < 0 || i >= list->count)
+		return;
+
+	/* Move the last animator into the gap. */
+	list->items[i] = list->items[--list->count];
+	list->items[i].entity->animator = i;
+
+	entity->animator = -1;
+}
+
+void fl_play_animation(fl_context* context, fl_entity* entity, fl_animation* animation)
+{
+	fl_animator* an;
+
+	if (entity->animator < 0 || entity->animator >= context->animators.count)
+		return;
+
+	an = &(context->animators.items[entity->animator]);
+
+	if (an->animation == animation)
+		return;
+
+	an->animation = animation;
+	an->frame = 0;
+	an->timer = animation->durations[0];
+
+	entity->frame = &(animation->frames[0]);
+}
+
+void fl_update_animations(fl_context* context)
+{
+	int i;
+	fl_animator* an = context->animators.items;
+	int count = context->animators.count;
+
+	for (i = 0; i < count; i++, an++)
+	{
+		/* Most updates only count down the current frame. */
+		if (--an->timer > 0)
+			continue;
+
+		if (++an->frame >= an->animation->frame_count)
+			an->frame = 0;
+
+		an->timer = an->animation->durations[an->frame];
+		an->entity->frame = &(an->animation->frames[an->frame]);
+	}
+}
+
+void fl_clear_animators(fl_context* context)
+{
+	context->animators.count = 0;
+}
+
+void fl_destroy_animators(fl_context* context)
+{
+	if (context->animators.items != NULL)
+		fl_free(context->animators.items);
+
+	context->animators.items = NULL;
+	context->animators.count = 0;
+	context->animators.capacity = 0;
+}
@@ -0,0 +1,450 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_AUDIO
+
+#include "core/audio.h"
+
+static const char* sound_paths[FLURMP_SOUND_COUNT] = FLURMP_SOUND_PATHS;
+
+
+
+/* -------------------------------------------------------------- */
+/*                    internal audio functions                    */
+/* -------------------------------------------------------------- */
+
+/**
+ * Limits a volume to the range 0 to 1.
+ *
+ * Params:
+ *   float - a volume
+ *
+ * Returns:
+ *   float - the volume within range
+ */
+static float clamp_volume(float volume);
+
+/**
+ * Queues a command for the audio thread. (game thread)
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ *   int - the type of command (e.g. FLURMP_AUDIO_PLAY)
+ *   int - the id of a voice
+ *   int - a sound
+ *   float - a volume
+ *
+ * Returns:
+ *   int - 1 if the command was queued, or 0 if the queue is full
+ */
+static int queue_command(fl_audio* audio, int type, int voice, int sound, float volume);
+
+/**
+ * Finds the voice with an id. (audio thread)
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ *   int - the id of a voice
+ *
+ * Returns:
+ *   fl_voice - the voice, or NULL if it has finished
+ */
+static fl_voice* find_voice(fl_audio* audio, int id);
+
+/**
+ * Finds a free voice, or else the voice closest to finishing. (audio thread)
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ *
+ * Returns:
+ *   fl_voice - a voice
+ */
+static fl_voice* claim_voice(fl_audio* audio);
+
+/**
+ * Applies the commands queued since the last buffer. (audio thread)
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ */
+static void apply_commands(fl_audio* audio);
+
+/**
+ * Adds samples, scaled by a volume, to the mix.
+ *
+ * Params:
+ *   float* - the mix
+ *   const short* - the samples
+ *   int - the number of samples
+ *   float - the volume
+ */
+static void mix_samples(float* mix, const short* samples, int count, float volume);
+
+/**
+ * Scales the mix by a volume and writes it out as 16-bit samples.
+ *
+ * Params:
+ *   short* - the output buffer
+ *   const float* - the mix
+ *   int - the number of samples
+ *   float - the volume
+ */
+static void write_samples(short* out, const float* mix, int count, float volume);
+
+/**
+ * Mixes every voice into part of an output buffer. (audio thread)
+ *
+ * Params:
+ *   fl_audio - an audio structure
+ *   short* - the output buffer
+ *   int - the number of samples, up to FLURMP_AUDIO_FRAMES * 2
+ */
+static void mix_voices(fl_audio* audio, short* out, int count);
+
+/**
+ * The audio device callback. (audio thread)
+ *
+ * Params:
+ *   void* - an audio structure
+ *   unsigned char* - the buffer to fill
+ *   int - the size of the buffer in bytes
+ */
+static void fill_buffer(void* data, unsigned char* buffer, int size);
+
+
+
+/* -------------------------------------------------------------- */
+/*             internal audio functions (implementation)          */
+/* -------------------------------------------------------------- */
+
+static float clamp_volume(float volume)
+{
+	if (volume < 0.0f)
+		return 0.0f;
+
+	if (volume > 1.0f)
+		return 1.0f;
+
+	return volume;
+}
+
+static int queue_command(fl_audio* audio, int type, int voice, int sound, float volume)
+{
+	int tail = fl_atomic_get(&audio->tail);
+	int next = (tail + 1) & (FLURMP_AUDIO_QUEUE - 1);
+	fl_audio_command* cmd;
+
+	/* Drop the command rather than wait for the audio thread. */
+	if (next == fl_atomic_get(&audio->head))
+	{
+		audio->dropped++;
+		return 0;
+	}
+
+	cmd = &audio->queue[tail];
+	cmd->type = type;
+	cmd->voice = voice;
+	cmd->sound = sound;
+	cmd->volume = clamp_volume(volume);
+
+	/* The command is only handed over once it has been written. */
+	fl_atomic_set(&audio->tail, next);
+
+	return 1;
+}
+
+static fl_voice* find_voice(fl_audio* audio, int id)
+{
+	int i;
+
+	for (i = 0; i < FLURMP_AUDIO_VOICES; i++)
+	{
+		if (audio->voices[i].sound != NULL && audio->voices[i].id == id)
+			return &audio->voices[i];
+	}
+
+	return NULL;
+}
+
+static fl_voice* claim_voice(fl_audio* audio)
+{
+	int i;
+	int left;
+	fl_voice* v;
+	fl_voice* best = &audio->voices[0];
+	int best_left = -1;
+
+	for (i = 0; i < FLURMP_AUDIO_VOICES; i++)
+	{
+		v = &audio->voices[i];
+
+		if (v->sound == NULL)
+			return v;
+
+		left = v->sound->frames * 2 - v->position;
+
+		if (best_left < 0 || left < best_left)
+		{
+			best = v;
+			best_left = left;
+		}
+	}
+
+	return best;
+}
+
+static void apply_commands(fl_audio* audio)
+{
+	int head = fl_atomic_get(&audio->head);
+	int tail = fl_atomic_get(&audio->tail);
+	fl_audio_command* cmd;
+	fl_voice* v;
+
+	while (head != tail)
+	{
+		cmd = &audio->queue[head];
+
+		switch (cmd->type)
+		{
+		case FLURMP_AUDIO_PLAY:
+			v = claim_voice(audio);
+			v->sound = &audio->sounds[cmd->sound];
+			v->id = cmd->voice;
+			v->position = 0;
+			v->volume = cmd->volume;
+			break;
+
+		case FLURMP_AUDIO_STOP:
+			v = find_voice(audio, cmd->voice);
+
+			if (v != NULL)
+				v->sound = NULL;
+			break;
+
+		case FLURMP_AUDIO_VOLUME:
+			v = find_voice(audio, cmd->voice);
+
+			if (v != NULL)
+				v->volume = cmd->volume;
+			break;
+
+		case FLURMP_AUDIO_MASTER:
+			audio->master = cmd->volume;
+			break;
+		}
+
+		head = (head + 1) & (FLURMP_AUDIO_QUEUE - 1);
+	}
+
+	/* Hand the slots back to the game thread. */
+	fl_atomic_set(&audio->head, head);
+}
+
+static void mix_samples(float* mix, const short* samples, int count, float volume)
+{
+	int i;
+
+	/* The loop is kept this plain so that the compiler vectorizes it. */
+	for (i = 0; i < count; i++)
+		mix[i] += (float)samples[i] * volume;
+}
+
+static void write_samples(short* out, const float* mix, int count, float volume)
+{
+	int i;
+	float s;
+
+	/* Sounds that add up past full scale are clipped. */
+	for (i = 0; i < count; i++)
+	{
+		s = mix[i] * volume;
+		s = s > 32767.0f ? 32767.0f : s;
+		s = s < -32768.0f ? -32768.0f : s;
+		out[i] = (short)s;
+	}
+}
+
+static void mix_voices(fl_audio* audio, short* out, int count)
+{
+	int i;
+	int n;
+	fl_voice* v;
+
+	for (i = 0; i < count; i++)
+		audio->mix[i] = 0.0f;
+
+	for (i = 0; i < FLURMP_AUDIO_VOICES; i++)
+	{
+		v = &audio->voices[i];
+
+		if (v->sound == NULL)
+			continue;
+
+		n = v->sound->frames * 2 - v->position;
+
+		if (n > count)
+			n = count;
+
+		mix_samples(audio->mix, v->sound->samples + v->position, n, v->volume);
+		v->position += n;
+
+		/* Free the voice once the sound has finished. */
+		if (v->position >= v->sound->frames * 2)
+			v->sound = NULL;
+	}
+
+	write_samples(out, audio->mix, count, audio->master);
+}
+
+static void fill_buffer(void* data, unsigned char* buffer, int size)
+{
+	fl_audio* audio = (fl_audio*)data;
+	short* out = (short*)buffer;
+	int left = size / (int)sizeof(short);
+	int count;
+	unsigned long long start = fl_get_performance_counter();
+	unsigned long long ticks;
+
+	apply_commands(audio);
+
+	/* The device may ask for more than the mix holds. */
+	while (left > 0)
+	{
+		count = left < FLURMP_AUDIO_FRAMES * 2 ? left : FLURMP_AUDIO_FRAMES * 2;
+		mix_voices(audio, out, count);
+		out += count;
+		left -= count;
+	}
+
+	ticks = fl_get_performance_counter() - start;
+
+	audio->callbacks++;
+	audio->mix_ticks += ticks;
+
+	if (ticks > audio->max_mix_ticks)
+		audio->max_mix_ticks = ticks;
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                     audio.h implementation                     */
+/* -------------------------------------------------------------- */
+
+fl_audio* fl_create_audio()
+{
+	int i;
+	fl_audio* audio = fl_alloc(fl_audio, 1);
+
+	if (audio == NULL)
+		return NULL;
+
+	audio->sounds = fl_alloc(fl_sound, FLURMP_SOUND_COUNT);
+
+	if (audio->sounds == NULL)
+	{
+		fl_free(audio);
+		return NULL;
+	}
+
+	audio->device = 0;
+	audio->sound_count = FLURMP_SOUND_COUNT;
+	fl_atomic_set(&audio->head, 0);
+	fl_atomic_set(&audio->tail, 0);
+	audio->next_voice = 0;
+	audio->volume = 1.0f;
+	audio->dropped = 0;
+	audio->master = 1.0f;
+	audio->callbacks = 0;
+	audio->mix_ticks = 0;
+	audio->max_mix_ticks = 0;
+
+	for (i = 0; i < FLURMP_AUDIO_VOICES; i++)
+		audio->voices[i].sound = NULL;
+
+	/* A sound that can't be loaded plays as silence. */
+	for (i = 0; i < FLURMP_SOUND_COUNT; i++)
+	{
+		audio->sounds[i].frames = 0;
+		audio->sounds[i].samples = fl_load_wav(sound_paths[i], FLURMP_AUDIO_RATE, &audio->sounds[i].frames);
+	}
+
+	return audio;
+}
+
+int fl_start_audio(fl_audio* audio)
+{
+	if (audio == NULL)
+		return 0;
+
+	if (audio->device == 0)
+		audio->device = fl_open_audio(FLURMP_AUDIO_RATE, FLURMP_AUDIO_FRAMES, fill_buffer, audio);
+
+	return audio->device != 0;
+}
+
+void fl_stop_audio(fl_audio* audio)
+{
+	if (audio == NULL || audio->device == 0)
+		return;
+
+	fl_close_audio(audio->device);
+	audio->device = 0;
+}
+
+int fl_play_sound(fl_audio* audio, int sound, float volume)
+{
+	int voice;
+
+	if (audio == NULL || sound < 0 || sound >= audio->sound_count
+		|| audio->sounds[sound].samples == NULL)
+		return 0;
+
+	/* Ids count up from 1, and 0 is never an id. */
+	voice = audio->next_voice % 0x7fffffff + 1;
+
+	if (!queue_command(audio, FLURMP_AUDIO_PLAY, voice, sound, volume))
+		return 0;
+
+	audio->next_voice = voice;
+
+	return voice;
+}
+
+void fl_stop_sound(fl_audio* audio, int voice)
+{
+	if (audio != NULL && voice != 0)
+		queue_command(audio, FLURMP_AUDIO_STOP, voice, 0, 0.0f);
+}
+
+void fl_set_sound_volume(fl_audio* audio, int voice, float volume)
+{
+	if (audio != NULL && voice != 0)
+		queue_command(audio, FLURMP_AUDIO_VOLUME, voice, 0, volume);
+}
+
+void fl_set_master_volume(fl_audio* audio, float volume)
+{
+	if (audio != NULL && queue_command(audio, FLURMP_AUDIO_MASTER, 0, 0, volume))
+		audio->volume = clamp_volume(volume);
+}
+
+float fl_get_master_volume(fl_audio* audio)
+{
+	return audio != NULL ? audio->volume : 0.0f;
+}
+
+void fl_destroy_audio(fl_audio* audio)
+{
+	int i;
+
+	if (audio == NULL)
+		return;
+
+	/* The audio thread must be done with the sounds first. */
+	fl_stop_audio(audio);
+
+	for (i = 0; i < audio->sound_count; i++)
+		fl_free(audio->sounds[i].samples);
+
+	fl_free(audio->sounds);
+	fl_free(audio);
+}
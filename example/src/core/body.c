@@ -0,0 +1,351 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_ENTITY
+
+#include "core/body.h"
+
+/* initial number of bodies in a context */
+#define INITIAL_BODY_CAPACITY 16
+
+
+
+/* -------------------------------------------------------------- */
+/*                     internal body functions                    */
+/* -------------------------------------------------------------- */
+
+/**
+ * Moves the bodies of a list into storage with room for more.
+ *
+ * Params:
+ *   fl_body_list - a body list
+ *   int - the number of bodies to make room for
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int grow_bodies(fl_body_list* list, int capacity);
+
+/**
+ * Frees the storage of a body list.
+ *
+ * Params:
+ *   fl_body_list - a body list
+ */
+static void free_bodies(fl_body_list* list);
+
+/**
+ * Takes up the position and velocity of a body's entity along an axis
+ * where they no longer match the whole pixels of the body's own.
+ *
+ * Params:
+ *   fl_body_list - a body list
+ *   int - the index of a body
+ *   int - an axis
+ */
+static void load_body(fl_body_list* list, int i, int axis);
+
+/**
+ * Applies gravity to a y velocity.
+ *
+ * Params:
+ *   int - a y velocity
+ *   int - the gravity
+ *   int - the velocity past which gravity stops adding
+ *
+ * Returns:
+ *   int - the new velocity
+ */
+static int fall(int y_v, int gravity, int max_fall);
+
+/**
+ * Applies friction to an x velocity, which slows down to 0
+ * but never turns around.
+ *
+ * Params:
+ *   int - an x velocity
+ *   int - the friction
+ *
+ * Returns:
+ *   int - the new velocity
+ */
+static int slow(int x_v, int friction);
+
+/**
+ * Moves every body along the x axis, then applies friction.
+ *
+ * Params:
+ *   fl_body_list - a body list
+ */
+static void move_x(fl_body_list* list);
+
+/**
+ * Applies gravity to every body, then moves it along the y axis.
+ *
+ * Params:
+ *   fl_body_list - a body list
+ */
+static void move_y(fl_body_list* list);
+
+
+
+/* -------------------------------------------------------------- */
+/*              internal body functions (implementation)          */
+/* -------------------------------------------------------------- */
+
+static int grow_bodies(fl_body_list* list, int capacity)
+{
+	fl_body_list grown = *list;
+
+	grown.entities = fl_alloc(fl_entity*, capacity);
+	grown.x = fl_alloc(int, capacity);
+	grown.y = fl_alloc(int, capacity);
+	grown.x_v = fl_alloc(int, capacity);
+	grown.y_v = fl_alloc(int, capacity);
+	grown.gravity = fl_alloc(int, capacity);
+	grown.max_fall = fl_alloc(int, capacity);
+	grown.friction = fl_alloc(int, capacity);
+	grown.capacity = capacity;
+
+	if (grown.entities == NULL || grown.x == NULL || grown.y == NULL
+		|| grown.x_v == NULL || grown.y_v == NULL || grown.gravity == NULL
+		|| grown.max_fall == NULL || grown.friction == NULL)
+	{
+		free_bodies(&grown);
+		return 0;
+	}
+
+	if (list->count > 0)
+	{
+		memcpy(grown.entities, list->entities, sizeof(fl_entity*) * list->count);
+		memcpy(grown.x, list->x, sizeof(int) * list->count);
+		memcpy(grown.y, list->y, sizeof(int) * list->count);
+		memcpy(grown.x_v, list->x_v, sizeof(int) * list->count);
+		memcpy(grown.y_v, list->y_v, sizeof(int) * list->count);
+		memcpy(grown.gravity, list->gravity, sizeof(int) * list->count);
+		memcpy(grown.max_fall, list->max_fall, sizeof(int) * list->count);
+		memcpy(grown.friction, list->friction, sizeof(int) * list->count);
+	}
+
+	free_bodies(list);
+	*list = grown;
+
+	return 1;
+}
+
+static void free_bodies(fl_body_list* list)
+{
+	fl_free(list->entities);
+	fl_free(list->x);
+	fl_free(list->y);
+	fl_free(list->x_v);
+	fl_free(list->y_v);
+	fl_free(list->gravity);
+	fl_free(list->max_fall);
+	fl_free(list->friction);
+}
+
+static void load_body(fl_body_list* list, int i, int axis)
+{
+	fl_entity* en = list->entities[i];
+
+	if (axis == FLURMP_AXIS_X)
+	{
+		if (list->x[i] >> FLURMP_BODY_SHIFT != en->x)
+			list->x[i] = en->x * FLURMP_BODY_ONE;
+
+		if (list->x_v[i] >> FLURMP_BODY_SHIFT != en->x_v)
+			list->x_v[i] = en->x_v * FLURMP_BODY_ONE;
+	}
+	else
+	{
+		if (list->y[i] >> FLURMP_BODY_SHIFT != en->y)
+			list->y[i] = en->y * FLURMP_BODY_ONE;
+
+		if (list->y_v[i] >> FLURMP_BODY_SHIFT != en->y_v)
+			list->y_v[i] = en->y_v * FLURMP_BODY_ONE;
+	}
+}
+
+static int fall(int y_v, int gravity, int max_fall)
+{
+	/* A body already moving faster, as when it is knocked
+	   back, keeps its velocity. */
+	if (y_v >= max_fall)
+		return y_v;
+
+	return y_v + gravity < max_fall ? y_v + gravity : max_fall;
+}
+
+static int slow(int x_v, int friction)
+{
+	if (x_v > 0)
+		return x_v > friction ? x_v - friction : 0;
+
+	return x_v < -friction ? x_v + friction : 0;
+}
+
+static void move_x(fl_body_list* list)
+{
+	int i;
+	int count = list->count;
+	int* x = list->x;
+	int* x_v = list->x_v;
+	int* friction = list->friction;
+
+	/* Every body is treated the same, with nothing to branch on
+	   but selects, so the compiler vectorizes the loop. */
+	for (i = 0; i < count; i++)
+	{
+		x[i] += x_v[i];
+		x_v[i] = slow(x_v[i], friction[i]);
+	}
+}
+
+static void move_y(fl_body_list* list)
+{
+	int i;
+	int count = list->count;
+	int* y = list->y;
+	int* y_v = list->y_v;
+	int* gravity = list->gravity;
+	int* max_fall = list->max_fall;
+
+	for (i = 0; i < count; i++)
+	{
+		y_v[i] = fall(y_v[i], gravity[i], max_fall[i]);
+		y[i] += y_v[i];
+	}
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                      body.h implementation                     */
+/* -------------------------------------------------------------- */
+
+int fl_add_body(fl_context* context, fl_entity* entity)
+{
+	fl_body_list* list = &(context->bodies);
+	const fl_body_type* bt = context->entity_types[entity->type].body;
+	int i;
+
+	if (bt == NULL)
+		return 1;
+
+	/* Double the body storage when it is full. */
+	if (list->count >= list->capacity
+		&& !grow_bodies(list, list->capacity ? list->capacity * 2 : INITIAL_BODY_CAPACITY))
+		return 0;
+
+	i = list->count++;
+
+	list->entities[i] = entity;
+	list->x[i] = entity->x * FLURMP_BODY_ONE;
+	list->y[i] = entity->y * FLURMP_BODY_ONE;
+	list->x_v[i] = entity->x_v * FLURMP_BODY_ONE;
+	list->y_v[i] = entity->y_v * FLURMP_BODY_ONE;
+	list->gravity[i] = bt->gravity;
+	list->max_fall[i] = bt->max_fall;
+	list->friction[i] = bt->friction;
+
+	entity->body = i;
+
+	return 1;
+}
+
+void fl_remove_body(fl_context* context, fl_entity* entity)
+{
+	fl_body_list* list = &(context->bodies);
+	int i = entity->body;
+	int last;
+
+	if (i < 0 || i >= list->count)
+		return;
+
+	/* Move the last body into the gap. */
+	last = --list->count;
+
+	list->entities[i] = list->entities[last];
+	list->x[i] = list->x[last];
+	list->y[i] = list->y[last];
+	list->x_v[i] = list->x_v[last];
+	list->y_v[i] = list->y_v[last];
+	list->gravity[i] = list->gravity[last];
+	list->max_fall[i] = list->max_fall[last];
+	list->friction[i] = list->friction[last];
+
+	list->entities[i]->body = i;
+
+	entity->body = -1;
+}
+
+int fl_get_body_step(fl_context* context, fl_entity* entity, int axis)
+{
+	fl_body_list* list = &(context->bodies);
+	int i = entity->body;
+	int y_v;
+
+	if (i < 0 || i >= list->count)
+		return 0;
+
+	load_body(list, i, axis);
+
+	if (axis == FLURMP_AXIS_X)
+		return ((list->x[i] + list->x_v[i]) >> FLURMP_BODY_SHIFT) - (list->x[i] >> FLURMP_BODY_SHIFT);
+
+	y_v = fall(list->y_v[i], list->gravity[i], list->max_fall[i]);
+
+	return ((list->y[i] + y_v) >> FLURMP_BODY_SHIFT) - (list->y[i] >> FLURMP_BODY_SHIFT);
+}
+
+void fl_move_bodies(fl_context* context, int axis)
+{
+	int i;
+	fl_body_list* list = &(context->bodies);
+	fl_entity* en;
+
+	/* Take up whatever the updates and collisions changed. */
+	for (i = 0; i < list->count; i++)
+		load_body(list, i, axis);
+
+	if (axis == FLURMP_AXIS_X)
+		move_x(list);
+	else
+		move_y(list);
+
+	/* Hand the whole pixels back to the entities. */
+	for (i = 0; i < list->count; i++)
+	{
+		en = list->entities[i];
+
+		if (axis == FLURMP_AXIS_X)
+		{
+			en->x = list->x[i] >> FLURMP_BODY_SHIFT;
+			en->x_v = list->x_v[i] >> FLURMP_BODY_SHIFT;
+		}
+		else
+		{
+			en->y = list->y[i] >> FLURMP_BODY_SHIFT;
+			en->y_v = list->y_v[i] >> FLURMP_BODY_SHIFT;
+		}
+	}
+}
+
+void fl_clear_bodies(fl_context* context)
+{
+	context->bodies.count = 0;
+}
+
+void fl_destroy_bodies(fl_context* context)
+{
+	free_bodies(&(context->bodies));
+
+	context->bodies.entities = NULL;
+	context->bodies.x = NULL;
+	context->bodies.y = NULL;
+	context->bodies.x_v = NULL;
+	context->bodies.y_v = NULL;
+	context->bodies.gravity = NULL;
+	context->bodies.max_fall = NULL;
+	context->bodies.friction = NULL;
+	context->bodies.count = 0;
+	context->bodies.capacity = 0;
+}
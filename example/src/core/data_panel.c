@@ -1,5 +1,7 @@
 #include "core/data_panel.h"
 #include "core/text.h"
+#include "core/latency.h"
+#include "core/memory.h"
 #include "entity/entity.h"
 
 #define ROW_COUNT 8
@@ -21,6 +23,25 @@
  */
 static void update(fl_context*, fl_data_panel*);
 
+/**
+ * Writes the state of the primary control object
+ * and the input latency to a data panel's buffer.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_data_panel - a data panel
+ */
+static void write_player_page(fl_context*, fl_data_panel*);
+
+/**
+ * Writes the allocations made during the previous frame and the
+ * live and peak memory of each memory tag to a data panel's buffer.
+ *
+ * Params:
+ *   fl_data_panel - a data panel
+ */
+static void write_memory_page(fl_data_panel*);
+
 /**
  * Renders a data panel to the screen.
  *
@@ -73,24 +94,54 @@ static void update(fl_context* context, fl_data_panel* panel)
 {
 	clear_buffer(panel);
 
-	data_panel_printf(panel, "x: %d\n", context->pco->x);
-	data_panel_printf(panel, "y: %d\n", context->pco->y);
-	data_panel_printf(panel, "x_v: %d\n", context->pco->x_v);
-	data_panel_printf(panel, "y_v: %d\n", context->pco->y_v);
-	data_panel_printf(panel, "life: %d\n", context->pco->life);
+	if (panel->page == FLURMP_PANEL_PAGE_MEMORY)
+		write_memory_page(panel);
+	else if (fl_get_entity(context, context->pco) != NULL)
+		write_player_page(context, panel);
+}
+
+static void write_player_page(fl_context* context, fl_data_panel* panel)
+{
+	fl_entity* pco = fl_get_entity(context, context->pco);
+
+	data_panel_printf(panel, "x: %d\n", pco->x);
+	data_panel_printf(panel, "y: %d\n", pco->y);
+	data_panel_printf(panel, "x_v: %d\n", pco->x_v);
+	data_panel_printf(panel, "y_v: %d\n", pco->y_v);
+	data_panel_printf(panel, "life: %d\n", pco->life);
 	data_panel_printf(panel, "scene: %d\n", context->scene);
+	data_panel_printf(panel, "latency p50/p99: %u/%u ms\n",
+		fl_latency_percentile(context, 50), fl_latency_percentile(context, 99));
 	/* data_panel_printf(panel, "cam x: %d\n", context->cam_x); */
 	/* data_panel_printf(panel, "cam y: %d\n", context->cam_y); */
 }
 
+static void write_memory_page(fl_data_panel* panel)
+{
+	int i;
+	fl_memory_stats stats;
+
+	data_panel_printf(panel, "allocs/frame: %d\n", fl_memory_frame_allocations());
+
+	/* live and peak kilobytes, then allocations last frame */
+	for (i = 0; i < FLURMP_MEMORY_TAG_COUNT; i++)
+	{
+		fl_get_memory_stats(i, &stats);
+		data_panel_printf(panel, "%.5s %luK/%luK %d\n", fl_memory_tag_name(i),
+			(unsigned long)(stats.live_bytes + 1023) / 1024,
+			(unsigned long)(stats.peak_bytes + 1023) / 1024,
+			stats.frame_allocations);
+	}
+}
+
 static void render(fl_context* context, fl_data_panel* self)
 {
-	int i;         /* index variable     */
-	int cx;        /* cursor x position  */
-	int cy;        /* cursor y position  */
-	fl_rect frame; /* dialog frame       */
-	fl_rect src;   /* render source      */
-	fl_rect dest;  /* render destination */
+	unsigned int c;   /* current code point */
+	const char* text; /* decode position    */
+	int cx;           /* cursor x position  */
+	int cy;           /* cursor y position  */
+	fl_rect frame;    /* dialog frame       */
+	fl_rect dest;     /* render destination */
 
 	fl_set_rect(&frame, self->x, self->y, self->w, self->h);
 
@@ -100,27 +151,25 @@ static void render(fl_context* context, fl_data_panel* self)
 	fl_set_draw_color(context, 250, 250, 250, 255);
 	fl_draw_rect(context, &frame);
 
-	dest.x = 0;
-	dest.y = 0;
-	src.x = 0;
-	src.y = 0;
+	text = self->buffer;
+	cx = cy = 0;
 
-	for (i = cx = cy = 0; i < BUFFER_LIMIT; i++)
+	while ((c = fl_utf8_decode(&text)) != 0)
 	{
-		if (self->buffer[i] >= 0x20 && self->buffer[i] <= 0x7E)
+		if (c >= 0x20 && c != 0x7F)
 		{
 			/* Get the appropriate glyph from the font atlas. */
-			fl_image* g = fl_char_to_glyph(self->font, self->buffer[i]);
+			fl_glyph* g = fl_get_glyph(context, self->font, c);
+
+			if (g == NULL)
+				continue;
 
 			dest.x = self->x + cx + 10;
 			dest.y = self->y + cy * 22 + 10;
-			dest.w = g->w;
-			dest.h = g->h;
-
-			src.w = g->w;
-			src.h = g->h;
+			dest.w = g->src.w;
+			dest.h = g->src.h;
 
-			fl_draw(context, g->texture, &src, &dest, 0);
+			fl_draw(context, g->texture, &g->src, &dest, 0);
 
 			if (cx >= LINE_WIDTH)
 			{
@@ -132,9 +181,9 @@ static void render(fl_context* context, fl_data_panel* self)
 					cy++;
 			}
 			else
-				cx += g->w;
+				cx += g->src.w;
 		}
-		else if (self->buffer[i] == 0x0A)
+		else if (c == 0x0A)
 		{
 			/* If we encounter a newline,
 			   increment the cursor's y position. */
@@ -212,6 +261,7 @@ fl_data_panel* fl_create_data_panel(int x, int y, int w, int h, fl_font* font)
 	panel->update = update;
 	panel->render = render;
 	panel->buffer_count = 0;
+	panel->page = FLURMP_PANEL_PAGE_PLAYER;
 
 	panel->buffer = fl_alloc(char, BUFFER_LIMIT);
 
@@ -234,3 +284,11 @@ void fl_destroy_data_panel(fl_data_panel* panel)
 
 	fl_free(panel);
 }
+
+void fl_set_data_panel_page(fl_data_panel* panel, int page)
+{
+	if (panel == NULL || page < 0 || page >= FLURMP_PANEL_PAGE_COUNT)
+		return;
+
+	panel->page = page;
+}
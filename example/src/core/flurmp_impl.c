@@ -8,6 +8,16 @@
 #include "core/data_panel.h"
 #include "core/schedule.h"
 #include "core/animation.h"
+#include "core/body.h"
+#include "core/latency.h"
+#include "core/layer.h"
+#include "core/profiler.h"
+#include "core/memory.h"
+#include "core/command.h"
+#include "core/stream.h"
+#include "core/startup.h"
+#include "core/audio.h"
+#include "core/particle.h"
 
 #include "scene/scene.h"
 
@@ -29,19 +39,12 @@
 	hostile
 	start screen
 	end screen
-	audio
 
   modifications:
 	multiple types of projectiles
 	multiple textures per image file
 */
 
-/* Counters to keep track of how many times malloc and free
-   have been called. These do NOT take into account the calls
-   to malloc and free made by libraries. */
-static int allocations_ = 0;
-static int frees_ = 0;
-
 /**
  * Determines if an entity is within the screen boundaries.
  * If an entity is considered to be off screen, there's no
@@ -76,18 +79,39 @@ static void root_input_handler(fl_context* context, fl_input_handler* self);
 static void render_camera_boundaries(fl_context* context);
 
 /**
- * Locates the next available projectile in a context.
- * For a projectile to be considered usable, it must have
- * its alive flag toggled off.
+ * Locates a free projectile slot in a context.
+ * A slot is free if its handle no longer refers to an entity.
  *
  * Params:
  *   fl_context - a Flurmp context
  *
  * Returns:
- *   fl_entity - a reference to the next available projectile
- *               or NULL if no projectile is found.
+ *   int - the index of a free slot, or -1 if every projectile
+ *         is in flight
  */
-static fl_entity* find_projectile(fl_context* context);
+static int find_projectile(fl_context* context);
+
+/**
+ * Render queue callbacks for the user interface.
+ * Each one renders the structure passed in as the target.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   void* - a menu, console, data panel, or dialog cast as void
+ */
+static void render_menu(fl_context* context, void* target);
+static void render_console(fl_context* context, void* target);
+static void render_data_panel(fl_context* context, void* target);
+static void render_dialog(fl_context* context, void* target);
+
+/**
+ * Updates the dialog or the world, whichever is active.
+ * This is the part of fl_update that is timed by the profiler.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+static void update_world(fl_context* context);
 
 
 
@@ -98,6 +122,7 @@ const char* fl_get_error()
 
 fl_context* fl_create_context()
 {
+	int i;
 	fl_context* context;
 
 	/* entity types */
@@ -118,24 +143,66 @@ fl_context* fl_create_context()
 	/* Populate the context with default values. */
 	context->window = NULL;
 	context->renderer = NULL;
+	context->input.actions = NULL;
 	context->entity_types = NULL;
 	context->fonts = NULL;
 	context->images = NULL;
 	context->entities = NULL;
-	context->projectiles = NULL;
+	context->entity_groups = NULL;
+	context->world = NULL;
+	context->entity_table.slots = NULL;
+	context->entity_table.generations = NULL;
+	context->entity_table.free_slots = NULL;
+	context->entity_table.free_count = 0;
+	context->entity_table.count = 0;
+	context->entity_table.capacity = 0;
+	context->despawned = 0;
+	context->entity_commands.items = NULL;
+	context->entity_commands.count = 0;
+	context->entity_commands.capacity = 0;
 	context->schedules = NULL;
-	context->input_handler = NULL;
+	context->animators.items = NULL;
+	context->animators.count = 0;
+	context->animators.capacity = 0;
+	context->bodies.entities = NULL;
+	context->bodies.x = NULL;
+	context->bodies.y = NULL;
+	context->bodies.x_v = NULL;
+	context->bodies.y_v = NULL;
+	context->bodies.gravity = NULL;
+	context->bodies.max_fall = NULL;
+	context->bodies.friction = NULL;
+	context->bodies.count = 0;
+	context->bodies.capacity = 0;
+	context->particles.pools = NULL;
+	context->particles.pool_count = 0;
+	context->particles.emitters = NULL;
+	context->particles.emitter_count = 0;
+	context->particles.emitter_capacity = 0;
+	context->input_handlers.items = NULL;
+	context->input_handlers.top = -1;
+	context->input_handlers.capacity = 0;
 	context->console = NULL;
-	context->pco = NULL;
+	context->pco = FLURMP_NULL_HANDLE;
 	context->active_dialog = NULL;
-	context->active_menu = NULL;
+	context->menu_stack.items = NULL;
+	context->menu_stack.top = -1;
+	context->menu_stack.capacity = 0;
 	context->data_panel = NULL;
+	context->audio = NULL;
+	context->menus = NULL;
+	context->dialog_cache = NULL;
+	context->commands.buckets = NULL;
+	context->commands.count = 0;
+	context->commands.history_count = 0;
+	context->profiler.enabled = 0;
 	context->cam_x = 0;
 	context->cam_y = 0;
 	context->state = 0;
 	context->entity_count = 0;
 	context->fps = 60;
 	context->ticks = 0;
+	context->low_latency = 0;
 	context->done = 0;
 	context->error = 0;
 	context->paused = 0;
@@ -145,45 +212,41 @@ fl_context* fl_create_context()
 	context->transition.to_scene = 0;
 	context->transition.from_scene = 0;
 
-	/* Create the application window. */
-	context->window = fl_create_window("Flurmp",
-		100, 100, FLURMP_WINDOW_WIDTH, FLURMP_WINDOW_HEIGHT);
+	for (i = 0; i < FLURMP_PROJECTILE_LIMIT; i++)
+		context->projectiles[i] = FLURMP_NULL_HANDLE;
 
-	/* Verify window creation. */
-	if (context->window == NULL)
-	{
-		context->error = FLURMP_ERR_WINDOW;
-		return context;
-	}
+	fl_latency_reset(context);
+	fl_profile_reset(context);
+	fl_init_layers(context);
 
-	/* Create the renderer. */
-	context->renderer = fl_create_renderer(context->window);
+	/* Start with no keys actuated. */
+	for (i = 0; i < FLURMP_KEY_WORDS; i++)
+		context->input.held[i] = 0;
 
-	/* Verify renderer creation. */
-	if (context->renderer == NULL)
-	{
-		context->error = FLURMP_ERR_RENDERER;
-		return context;
-	}
+	fl_reset_input(context);
 
-	/* Get a reference to an array of key states. */
-	context->input.keystates = fl_get_key_states();
+	/* Allocate memory for the action map. */
+	context->input.actions = fl_alloc(int, FLURMP_ACTION_COUNT);
 
-	/* Allocate memory for the input flag array. */
-	context->input.flags = fl_alloc(int, FLURMP_INPUT_FLAG_COUNT);
-
-	/* Verify input flag memory allocation. */
-	if (context->input.flags == NULL)
+	/* Verify action map memory allocation. */
+	if (context->input.actions == NULL)
 	{
-		context->error = FLURMP_ERR_INPUT_FLAGS;
+		context->error = FLURMP_ERR_INPUT_ACTIONS;
 		return context;
 	}
 
-	/* Set all of the input flags to 0. */
-	fl_zero(context->input.flags, FLURMP_INPUT_FLAG_COUNT);
+	/* Map the actions to their default keys. */
+	fl_bind_action(context, FLURMP_ACTION_LEFT, FLURMP_SC_A);
+	fl_bind_action(context, FLURMP_ACTION_RIGHT, FLURMP_SC_D);
+	fl_bind_action(context, FLURMP_ACTION_UP, FLURMP_SC_W);
+	fl_bind_action(context, FLURMP_ACTION_DOWN, FLURMP_SC_S);
+	fl_bind_action(context, FLURMP_ACTION_JUMP, FLURMP_SC_SPACE);
+	fl_bind_action(context, FLURMP_ACTION_PRIMARY, FLURMP_SC_J);
+	fl_bind_action(context, FLURMP_ACTION_SECONDARY, FLURMP_SC_K);
+	fl_bind_action(context, FLURMP_ACTION_PAUSE, FLURMP_SC_ESCAPE);
 
 	/* Allocate memory for the entity type registry. */
-	context->entity_types = fl_alloc(fl_entity_type, FLURMP_ENTITY_TYPE_COUNT);
+	context->entity_types = fl_alloc_tagged(fl_entity_type, FLURMP_ENTITY_TYPE_COUNT, FLURMP_MEMORY_TAG_ENTITY);
 
 	/* Verify entity type registry memory allocation. */
 	if (context->entity_types == NULL)
@@ -208,9 +271,27 @@ fl_context* fl_create_context()
 	context->entity_types[FLURMP_ENTITY_DOOR] = door_type;
 	context->entity_types[FLURMP_ENTITY_PELLET] = pellet_type;
 
+	/* Allocate memory for the entity groups. */
+	context->entity_groups = fl_alloc_tagged(fl_entity_group, FLURMP_ENTITY_TYPE_COUNT, FLURMP_MEMORY_TAG_ENTITY);
+
+	/* Verify entity group memory allocation. */
+	if (context->entity_groups == NULL)
+	{
+		context->error = FLURMP_ERR_ENTITY_GROUPS;
+		return context;
+	}
+
+	/* Start with an empty group for each entity type. */
+	for (i = 0; i < FLURMP_ENTITY_TYPE_COUNT; i++)
+	{
+		context->entity_groups[i].type = i;
+		context->entity_groups[i].entities = NULL;
+		context->entity_groups[i].count = 0;
+		context->entity_groups[i].capacity = 0;
+	}
 
 	/* Create a font registry */
-	context->fonts = fl_alloc(fl_resource*, FLURMP_FONT_COUNT);
+	context->fonts = fl_alloc_tagged(fl_resource*, FLURMP_FONT_COUNT, FLURMP_MEMORY_TAG_RESOURCE);
 
 	/* Verify font registry creation. */
 	if (context->fonts == NULL)
@@ -219,30 +300,23 @@ fl_context* fl_create_context()
 		return context;
 	}
 
-	/* font colors */
-	fl_color menu_fc;
-	fl_color menu_bc;
-	fl_color console_fc;
-	fl_color console_bc;
+	/* The fonts are loaded at startup, see startup.c. */
+	fl_null(context->fonts, FLURMP_FONT_COUNT);
 
-	/* Populate the font colors with RGBA values. */
-	fl_set_color(&menu_fc, 250, 250, 250, 255);
-	fl_set_color(&menu_bc, 0, 0, 0, 255);
-	fl_set_color(&console_fc, 250, 250, 250, 255);
-	fl_set_color(&console_bc, 0, 0, 0, 0);
+	/* Create the menu cache. Menus are built the first time they are opened. */
+	context->menus = fl_alloc_tagged(fl_menu*, FLURMP_MENU_COUNT, FLURMP_MEMORY_TAG_MENU);
 
-	/* Load fonts into the font registry. */
-	context->fonts[FLURMP_FONT_VERA] = fl_load_font("resources/fonts/VeraMono.ttf", 16, menu_fc, menu_bc, 1);
-	context->fonts[FLURMP_FONT_COUSINE] = fl_load_font("resources/fonts/Cousine.ttf", 16, console_fc, console_bc, 0);
-	context->fonts[FLURMP_FONT_KARMILLA_BOLD] = fl_load_font("resources/fonts/Karmilla-Bold.ttf", 16, console_fc, console_bc, 0);
+	/* Verify menu cache creation. */
+	if (context->menus == NULL)
+	{
+		context->error = FLURMP_ERR_MENUS;
+		return context;
+	}
 
-	/* Create font atlases. */
-	fl_create_font_atlas(context, context->fonts[FLURMP_FONT_VERA]);
-	fl_create_font_atlas(context, context->fonts[FLURMP_FONT_COUSINE]);
-	fl_create_font_atlas(context, context->fonts[FLURMP_FONT_KARMILLA_BOLD]);
+	fl_null(context->menus, FLURMP_MENU_COUNT);
 
 	/* Allocate memory for an image registry. */
-	context->images = fl_alloc(fl_resource*, FLURMP_IMAGE_COUNT);
+	context->images = fl_alloc_tagged(fl_resource*, FLURMP_IMAGE_COUNT, FLURMP_MEMORY_TAG_RESOURCE);
 
 	/* Verify image registry allocation. */
 	if (context->images == NULL)
@@ -251,34 +325,46 @@ fl_context* fl_create_context()
 		return context;
 	}
 
-	/* Set all images to NULL. */
+	/* Set all images to NULL. They are loaded at startup. */
 	fl_null(context->images, FLURMP_IMAGE_COUNT);
 
-	/* Load common images. */
-	context->images[FLURMP_IMAGE_PLAYER] = fl_load_image(context, "resources/images/person.bmp");
+	/* Register the root input handler. */
+	fl_input_handler* root = fl_create_input_handler(root_input_handler);
 
-	context->entity_types[FLURMP_ENTITY_PLAYER].texture = context->images[FLURMP_IMAGE_PLAYER];
+	if (root == NULL)
+	{
+		context->error = FLURMP_ERR_INPUT_HANDLER;
+		return context;
+	}
 
-	/* Register the root input handler. */
-	context->input_handler = fl_create_input_handler(root_input_handler);
+	fl_push_input_handler(context, root);
 
-	if (context->input_handler == NULL)
+	if (fl_get_input_handler(context) != root)
 	{
+		fl_destroy_input_handler(root);
 		context->error = FLURMP_ERR_INPUT_HANDLER;
 		return context;
 	}
 
-	/* Create a data panel. */
-	context->data_panel = fl_create_data_panel(420, 20, 200, 150, context->fonts[FLURMP_FONT_COUSINE]->impl.font);
+	/* Create the particle pools. */
+	if (!fl_create_particles(context))
+	{
+		context->error = FLURMP_ERR_PARTICLES;
+		return context;
+	}
 
-	if (context->data_panel == NULL)
+	/* Register the console commands. */
+	if (!fl_create_commands(context))
 	{
-		context->error = 0x09;
+		context->error = FLURMP_ERR_COMMANDS;
 		return context;
 	}
 
-	/* Load a test scene. */
-	fl_load_scene(context, FLURMP_SCENE_TEST_1);
+	/* Create the window and renderer, load the fonts and images,
+	   create the data panel and load a test scene. Loading is spread
+	   over worker threads while the window is created. Sounds are
+	   loaded at the same time. */
+	fl_run_startup(context);
 
 	return context;
 }
@@ -287,34 +373,24 @@ void fl_destroy_context(fl_context* context)
 {
 	int i, j;
 
-	fl_entity* en;
-	fl_entity* next;
+	/* Stop the audio thread and free the sounds. */
+	fl_destroy_audio(context->audio);
 
-	/* Destroy the entities. */
-	en = context->entities;
-	while (en != NULL)
-	{
-		next = en->next;
-		fl_free(en);
-		en = next;
-	}
+	/* Destroy the entities and their handles, and the streamed world. */
+	fl_destroy_entities(context);
+	fl_destroy_world(context->world);
 
-	/* Removed all input handler except the root input handler.
-	   They should be destroyed when the structures
-	   that contain them are destroyed. */
-	if (context->input_handler != NULL)
-	{
-		while (context->input_handler->child != NULL)
-			fl_pop_input_handler(context);
+	/* Destroy the root input handler and the input handler stack.
+	   The other input handlers should be destroyed when the
+	   structures that contain them are destroyed. */
+	fl_destroy_input_handlers(context);
 
-		/* Destroy the root input handler. */
-		fl_destroy_input_handler(context->input_handler);
-	}
-
-	/* Destroy the dev console. */
+	/* Destroy the dev console and its commands. */
 	if (context->console != NULL)
 		fl_destroy_console(context->console);
 
+	fl_destroy_commands(context);
+
 	/* Destroy the entity type registry. */
 	if (context->entity_types != NULL)
 	{
@@ -333,14 +409,40 @@ void fl_destroy_context(fl_context* context)
 		fl_free(context->entity_types);
 	}
 
+	/* Destroy the entity groups. */
+	if (context->entity_groups != NULL)
+	{
+		for (i = 0; i < FLURMP_ENTITY_TYPE_COUNT; i++)
+		{
+			if (context->entity_groups[i].entities != NULL)
+				fl_free(context->entity_groups[i].entities);
+		}
 
-	/* Destroy the active menu. */
-	if (context->active_menu != NULL)
-		fl_destroy_menu(context->active_menu);
+		fl_free(context->entity_groups);
+	}
 
-	/* Destroy the active dialog. */
-	if (context->active_dialog != NULL)
-		fl_destroy_dialog(context->active_dialog);
+
+	/* Free the menu stack. Every menu comes from the menu cache,
+	   so the menus themselves are destroyed with the cache. */
+	if (context->menu_stack.items != NULL)
+		fl_free(context->menu_stack.items);
+
+	/* Destroy the menu cache. */
+	if (context->menus != NULL)
+	{
+		for (i = 0; i < FLURMP_MENU_COUNT; i++)
+		{
+			if (context->menus[i] != NULL)
+				fl_destroy_menu(context->menus[i]);
+		}
+
+		fl_free(context->menus);
+	}
+
+	/* Destroy the dialog. The active dialog, if any, is the cached one. */
+	context->active_dialog = NULL;
+	if (context->dialog_cache != NULL)
+		fl_destroy_dialog(context->dialog_cache);
 
 	/* Destroy the font registry. */
 	if (context->fonts != NULL)
@@ -384,9 +486,21 @@ void fl_destroy_context(fl_context* context)
 		}
 	}
 
-	/* Destroy the input flags. */
-	if (context->input.flags != NULL)
-		fl_free(context->input.flags);
+	/* Destroy the action map. */
+	if (context->input.actions != NULL)
+		fl_free(context->input.actions);
+
+	/* Destroy the layer caches and the render queue. */
+	fl_destroy_layers(context);
+
+	/* Destroy the animators. */
+	fl_destroy_animators(context);
+
+	/* Destroy the bodies. */
+	fl_destroy_bodies(context);
+
+	/* Destroy the particles and their emitters. */
+	fl_destroy_particles(context);
 
 	/* Destroy the renderer. */
 	if (context->renderer != NULL)
@@ -398,8 +512,8 @@ void fl_destroy_context(fl_context* context)
 
 	fl_free(context);
 
-	printf("allocations: %d\n", allocations_);
-	printf("frees: %d\n", frees_);
+	/* Everything allocated for the context should be gone by now. */
+	fl_memory_report_leaks();
 }
 
 int fl_is_done(fl_context* context)
@@ -411,18 +525,18 @@ int fl_is_done(fl_context* context)
 
 void fl_add_entity(fl_context* context, fl_entity* entity)
 {
-	if (context->entity_count == 0)
+	if (!fl_assign_handle(context, entity))
 	{
-		context->entities = entity;
-		context->entities->tail = entity;
+		context->error = FLURMP_ERR_ENTITIES;
+		return;
 	}
-	else
+
+	if (!fl_link_entity(context, entity))
 	{
-		context->entities->tail->next = entity;
-		context->entities->tail = entity;
+		fl_release_handle(context, entity);
+		context->error = FLURMP_ERR_ENTITY_GROUPS;
+		return;
 	}
-
-	context->entity_count++;
 }
 
 int fl_detect_collision(fl_context* context, fl_entity* a, fl_entity* b)
@@ -476,28 +590,50 @@ void fl_handle_input(fl_context* context)
 }
 
 /**
- * A helper function to update entity state and handle collision.
- * Since the updates and collision detection are performed once
- * for each axis of movement, this function is called twice.
+ * A helper function to update entity state, move the bodies and
+ * handle collision. Since the updates, movement and collision
+ * detection are performed once for each axis of movement, this
+ * function is called twice.
  * If this function was only called once, then the code could
  * be placed in the fl_update function.
  */
 static void update_and_collide(fl_context* context, int axis)
 {
-	/* Get a pointer to the linked list of entities. */
-	fl_entity* en = context->entities;
+	int i, j;
+	fl_entity* en;
 	fl_entity* next;
 
-	/* Update all entities.  */
-	while (en != NULL)
+	/* Update all entities one type at a time. */
+	for (i = 0; i < FLURMP_ENTITY_TYPE_COUNT; i++)
 	{
-		if (en->flags & FLURMP_ALIVE_FLAG)
-			context->entity_types[en->type].update(context, en, axis);
+		fl_entity_type* et = &(context->entity_types[i]);
+		fl_entity_group* group = &(context->entity_groups[i]);
 
-		en = en->next;
+		if (group->count == 0)
+			continue;
+
+		/* Prefer the batch callback if the entity type has one,
+		   otherwise fall back to updating each entity. */
+		if (et->update_all != NULL)
+		{
+			et->update_all(context, group->entities, group->count, axis);
+		}
+		else if (et->update != NULL)
+		{
+			for (j = 0; j < group->count; j++)
+			{
+				en = group->entities[j];
+
+				if (en->flags & FLURMP_ALIVE_FLAG)
+					et->update(context, en, axis);
+			}
+		}
 	}
 
-	/* Put the entity pointer back to the beginning of the list. */
+	/* Move every entity with a body in a single pass. */
+	fl_move_bodies(context, axis);
+
+	/* Get a pointer to the linked list of entities. */
 	en = context->entities;
 
 	/* Detect and handle collisions between entities. */
@@ -508,6 +644,14 @@ static void update_and_collide(fl_context* context, int axis)
 		/* Only check for collisions if the entity is alive. */
 		while (next != NULL && en->flags & FLURMP_ALIVE_FLAG)
 		{
+			/* Despawned entities wait for compaction, but are
+			   no longer part of the world. */
+			if (!(next->flags & FLURMP_ALIVE_FLAG))
+			{
+				next = next->next;
+				continue;
+			}
+
 			/* Determine if two entities have collided. */
 			int collided = fl_detect_collision(context, en, next);
 
@@ -532,6 +676,20 @@ void fl_update(fl_context* context)
 	if (context->data_panel != NULL)
 		context->data_panel->update(context, context->data_panel);
 
+	fl_profile_begin(context);
+	update_world(context);
+
+	/* Apply the structural changes requested during the update,
+	   bring the world up to date with the camera, then free
+	   whatever was despawned in a single pass. */
+	fl_apply_entity_commands(context);
+	fl_stream_world(context);
+	fl_compact_entities(context);
+	fl_profile_end(context, FLURMP_PROFILE_UPDATE);
+}
+
+static void update_world(fl_context* context)
+{
 	/* If a dialog is active, then that's the only
 	   thing that needs to be updated. */
 	if (context->active_dialog != NULL)
@@ -549,6 +707,12 @@ void fl_update(fl_context* context)
 	update_and_collide(context, FLURMP_AXIS_X);
 	update_and_collide(context, FLURMP_AXIS_Y);
 
+	/* Advance every animation in a single pass. */
+	fl_update_animations(context);
+
+	/* Move the particles, which never collide. */
+	fl_update_particles(context);
+
 	/* Call the schedules' action functions. */
 	if (context->schedules != NULL)
 	{
@@ -557,7 +721,19 @@ void fl_update(fl_context* context)
 
 		while (w != NULL)
 		{
-			w->action(context, w, w->target);
+			fl_entity* target = fl_get_entity(context, w->target);
+
+			/* A schedule whose target is gone gets one last call
+			   to clean up after itself. */
+			if (target == NULL)
+			{
+				w->action(context, w, NULL);
+				w->done = 1;
+			}
+			else
+			{
+				w->action(context, w, target);
+			}
 
 			next = w->next;
 
@@ -585,46 +761,85 @@ void fl_update(fl_context* context)
 
 void fl_render(fl_context* context)
 {
+	int i;
+	int queued = 1;
+
+	/* Time everything up to presentation, which may wait for vsync. */
+	fl_profile_begin(context);
+
 	/* Set the background color. */
 	fl_set_draw_color(context, 145, 219, 255, 255);
 
 	/* Remove the previous screen contents. */
 	fl_render_clear(context);
 
-	fl_entity* en = context->entities;
-
-	/* Render each entity by calling their render functions
-	   from the entity type registry. */
-	while (en != NULL)
+	/* Nothing in the world changes while the application is paused
+	   or a dialog is open, so draw the world from a snapshot. */
+	if (context->paused || context->active_dialog != NULL)
 	{
-		if (en->flags & FLURMP_ALIVE_FLAG)
-			context->entity_types[en->type].render(context, en);
+		if (!fl_draw_snapshot(context))
+			queued = fl_queue_entities(context) && fl_queue_particles(context);
+	}
+	else
+	{
+		fl_invalidate_snapshot(context);
 
-		en = en->next;
+		/* Queue the entities on the layers given by their entity types,
+		   and the particles on the layers given by their kinds. */
+		queued = fl_queue_entities(context) && fl_queue_particles(context);
 	}
 
-	/* Render the active menu. */
-	if (context->active_menu != NULL)
-		context->active_menu->render(context, context->active_menu);
+	/* Queue the user interface from bottom to top. */
+	for (i = 0; i <= context->menu_stack.top; i++)
+		queued = queued && fl_queue_render(context, FLURMP_LAYER_UI, 0, render_menu, context->menu_stack.items[i]);
 
-	/* Render the dev console. */
 	if (context->console != NULL)
-		context->console->render(context, context->console);
+		queued = queued && fl_queue_render(context, FLURMP_LAYER_UI, 1, render_console, context->console);
 
-	/* Render the data panel */
 	if (context->data_panel != NULL)
-		context->data_panel->render(context, context->data_panel);
+		queued = queued && fl_queue_render(context, FLURMP_LAYER_UI, 2, render_data_panel, context->data_panel);
 
-	/* Render the dialog. */
 	if (context->active_dialog != NULL)
-		context->active_dialog->render(context, context->active_dialog);
+		queued = queued && fl_queue_render(context, FLURMP_LAYER_UI, 3, render_dialog, context->active_dialog);
+
+	if (!queued)
+		context->error = FLURMP_ERR_RENDER_QUEUE;
+
+	/* Draw everything in layer and z order. */
+	fl_flush_render_queue(context);
 
 	/* render_camera_boundaries(context); */
 
+	fl_profile_end(context, FLURMP_PROFILE_RENDER);
+
 	/* Put everything on the screen. */
 	fl_render_show(context);
 }
 
+static void render_menu(fl_context* context, void* target)
+{
+	fl_menu* menu = (fl_menu*)target;
+	menu->render(context, menu);
+}
+
+static void render_console(fl_context* context, void* target)
+{
+	fl_console* console = (fl_console*)target;
+	console->render(context, console);
+}
+
+static void render_data_panel(fl_context* context, void* target)
+{
+	fl_data_panel* panel = (fl_data_panel*)target;
+	panel->render(context, panel);
+}
+
+static void render_dialog(fl_context* context, void* target)
+{
+	fl_dialog* dialog = (fl_dialog*)target;
+	dialog->render(context, dialog);
+}
+
 static void render_camera_boundaries(fl_context* context)
 {
 	fl_set_draw_color(context, 255, 255, 0, 255);
@@ -684,11 +899,14 @@ static int is_on_screen(fl_context* context, fl_entity* entity)
 
 static void root_input_handler(fl_context* context, fl_input_handler* self)
 {
-	if (fl_consume_key(context, FLURMP_SC_ESCAPE))
+	fl_entity* pco;
+	int p;
+
+	if (fl_consume_action(context, FLURMP_ACTION_PAUSE))
 	{
 		context->paused = 1;
 
-		fl_menu* pause_menu = fl_create_pause_menu(context);
+		fl_menu* pause_menu = fl_open_menu(context, FLURMP_MENU_PAUSE, fl_create_pause_menu);
 
 		fl_push_menu(context, pause_menu);
 
@@ -696,104 +914,89 @@ static void root_input_handler(fl_context* context, fl_input_handler* self)
 		fl_push_input_handler(context, pause_menu->input_handler);
 	}
 
+	/* Everything else controls the primary control object. */
+	pco = fl_get_entity(context, context->pco);
 
+	if (pco == NULL)
+		return;
 
 	/* Walk to the left */
-	if (fl_peek_input(context, FLURMP_INPUT_TYPE_KEYBOARD, FLURMP_SC_A))
+	if (fl_peek_action(context, FLURMP_ACTION_LEFT))
 	{
-		if (!(context->pco->flags & FLURMP_MIRROR_FLAG))
-			context->pco->flags |= FLURMP_MIRROR_FLAG;
+		if (!(pco->flags & FLURMP_MIRROR_FLAG))
+			pco->flags |= FLURMP_MIRROR_FLAG;
 
 
-		if (context->pco->x_v > -2)
-			context->pco->x_v -= 2;
+		if (pco->x_v > -2)
+			pco->x_v -= 2;
 	}
 
 	/* Walk to the right */
-	if (fl_peek_input(context, FLURMP_INPUT_TYPE_KEYBOARD, FLURMP_SC_D))
+	if (fl_peek_action(context, FLURMP_ACTION_RIGHT))
 	{
-		if ((context->pco->flags & FLURMP_MIRROR_FLAG))
-			context->pco->flags &= ~(FLURMP_MIRROR_FLAG);
+		if ((pco->flags & FLURMP_MIRROR_FLAG))
+			pco->flags &= ~(FLURMP_MIRROR_FLAG);
 
-		if (context->pco->x_v < 2)
-			context->pco->x_v += 2;
+		if (pco->x_v < 2)
+			pco->x_v += 2;
 	}
 
 	/* Jumping */
-	if (fl_consume_key(context, FLURMP_SC_SPACE))
+	if (fl_consume_action(context, FLURMP_ACTION_JUMP))
 	{
-		if (!(context->pco->flags & FLURMP_AIR_FLAG))
+		if (!(pco->flags & FLURMP_AIR_FLAG))
 		{
-			context->pco->y_v -= 12;
-			context->pco->flags |= FLURMP_AIR_FLAG;
+			pco->y_v -= 12;
+			pco->flags |= FLURMP_AIR_FLAG;
 		}
 	}
 
 	/* Reset the interaction flag. */
-	if (context->pco->flags & FLURMP_INTERACT_FLAG)
-		context->pco->flags &= ~(FLURMP_INTERACT_FLAG);
+	if (pco->flags & FLURMP_INTERACT_FLAG)
+		pco->flags &= ~(FLURMP_INTERACT_FLAG);
 
-	if (fl_consume_key(context, FLURMP_SC_J))
+	if (fl_consume_action(context, FLURMP_ACTION_PRIMARY))
 	{
-		if (!(context->pco->flags & FLURMP_INTERACT_FLAG))
+		if (!(pco->flags & FLURMP_INTERACT_FLAG))
 		{
-			context->pco->flags |= FLURMP_INTERACT_FLAG;
+			pco->flags |= FLURMP_INTERACT_FLAG;
 		}
 	}
 
-	if (fl_consume_key(context, FLURMP_SC_K))
+	if (fl_consume_action(context, FLURMP_ACTION_SECONDARY))
 	{
-		fl_entity* p = find_projectile(context);
-		if (p != NULL)
-			fl_schedule_pellet(context, p);
-	}
+		p = find_projectile(context);
 
-	/* Temporary code to reset player position.
-	   This should probable be performed via a command
-	   issued to the dev console. */
-	if (fl_peek_input(context, FLURMP_INPUT_TYPE_KEYBOARD, FLURMP_SC_C))
-	{
-		context->pco->x = 260;
-		context->pco->y = 260;
-		context->cam_x = 0;
-		context->cam_y = 0;
+		if (p >= 0)
+		{
+			fl_entity* pellet = fl_create_pellet(pco->x, pco->y);
+
+			if (pellet != NULL)
+			{
+				fl_add_entity(context, pellet);
+				context->projectiles[p] = pellet->handle;
+				fl_schedule_pellet(context, pellet);
+				fl_play_sound(context->audio, FLURMP_SOUND_PELLET, 0.8f);
+				fl_add_emitter(context, FLURMP_PARTICLE_TRAIL, pellet->handle, 0.5f, -1);
+			}
+		}
 	}
 
 	if (fl_consume_key(context, FLURMP_SC_T))
 	{
-		fl_schedule_walk(context, context->pco);
+		fl_schedule_walk(context, pco);
 	}
 }
 
-static fl_entity* find_projectile(fl_context* context)
-{
-	if (context == NULL || context->projectiles == NULL)
-		return NULL;
-
-	fl_entity* next = context->projectiles;
-
-	while (next != NULL && (next->flags & FLURMP_ALIVE_FLAG))
-		next = next->next;
-
-	return next;
-}
-
-
-
-void* fl_allocate_(size_t s)
+static int find_projectile(fl_context* context)
 {
-	void* p = malloc(s);
+	int i;
 
-	if (p != NULL)
+	for (i = 0; i < FLURMP_PROJECTILE_LIMIT; i++)
 	{
-		allocations_++;
+		if (fl_get_entity(context, context->projectiles[i]) == NULL)
+			return i;
 	}
 
-	return p;
-}
-
-void fl_free_(void* m)
-{
-	free(m);
-	frees_++;
+	return -1;
 }
@@ -1,339 +1,974 @@
-/**
- * Implementation of the Flurmp SDL wrapper.
- * Contains implementation of functions for creating rendering contexts,
- * loading images and fonts, and rendering data to the screen.
- *
- * This file also contains the implementation of the following functions
- * from the flurmp.h header file:
- *   fl_sleep
- *   fl_handle_events
- *   fl_begin_frame
- *   fl_end_frame
- *   fl_initialize
- *   fl_terminate
- */
-#include "core/flurmp_impl.h"
-#include "core/flurmp_sdl.h"
-
-
-
-/* -------------------------------------------------------------- */
-/*                        Core Functions                          */
-/* -------------------------------------------------------------- */
-
-fl_window* fl_create_window(const char* title, int x, int y, int w, int h)
-{
-	return SDL_CreateWindow(title, x, y, w, h, SDL_WINDOW_SHOWN);
-}
-
-void fl_destroy_window(fl_window* window)
-{
-	SDL_DestroyWindow(window);
-}
-
-fl_renderer* fl_create_renderer(fl_window* window)
-{
-	fl_renderer* ren = SDL_CreateRenderer(window, -1,
-		SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-
-	if (ren == NULL)
-		return NULL;
-
-	SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-
-	return ren;
-}
-
-void fl_destroy_renderer(fl_renderer* renderer)
-{
-	SDL_DestroyRenderer(renderer);
-}
-
-const unsigned char* fl_get_key_states()
-{
-	return SDL_GetKeyboardState(NULL);
-}
-
-
-
-/* -------------------------------------------------------------- */
-/*                        Image Functions                         */
-/* -------------------------------------------------------------- */
-
-int fl_load_bmp(fl_context* context, const char* path, fl_image* img)
-{
-	SDL_Surface* surface;
-	fl_texture* texture;
-
-	/* Load a bmp file. */
-	surface = SDL_LoadBMP(path);
-
-	/* Verify that the bmp file loaded. */
-	if (surface == NULL)
-		return 0;
-
-	/* Ignore the color with an RGB value of 255, 0, 255. */
-	SDL_SetColorKey(surface, 1, SDL_MapRGB(surface->format, 255, 0, 255));
-
-	/* Convert the SDL surface into a texture. */
-	texture = SDL_CreateTextureFromSurface(context->renderer, surface);
-
-	/* Verify texture creation. */
-	if (texture == NULL)
-	{
-		SDL_FreeSurface(surface);
-		return 0;
-	}
-
-	/* Populate the image structure. */
-	img->w = surface->w;
-	img->h = surface->h;
-	img->texture = texture;
-
-	/* Dispose of the surface. */
-	SDL_FreeSurface(surface);
-
-	return 1;
-}
-
-void fl_destroy_image(fl_image* image)
-{
-	if (image == NULL)
-		return;
-
-	if (image->texture != NULL)
-		SDL_DestroyTexture(image->texture);
-
-	fl_free(image);
-}
-
-
-
-/* -------------------------------------------------------------- */
-/*                        Text Functions                          */
-/* -------------------------------------------------------------- */
-
-fl_ttf* fl_load_ttf(const char* path, int p)
-{
-	return TTF_OpenFont(path, p);
-}
-
-void fl_close_ttf(fl_ttf* font)
-{
-	if (font == NULL)
-		return;
-
-	TTF_CloseFont(font);
-}
-
-fl_image* fl_create_glyph_image(fl_context* context, fl_resource* res, char c)
-{
-	fl_ttf* font;
-	fl_color fc;
-	fl_color bc;
-	SDL_Surface* surface;
-	fl_texture* texture;
-	fl_image* image;
-
-	/* Extract the font data from the resource. */
-	font = res->impl.font->impl;
-	fc = res->impl.font->forecolor;
-	bc = res->impl.font->backcolor;
-
-	/* Create an SDL surface representing the character. */
-	if (res->impl.font->background)
-		surface = TTF_RenderGlyph_Shaded(font, (Uint16)c, fc, bc);
-	else
-		surface = TTF_RenderGlyph_Blended(font, (Uint16)c, fc);
-
-	/* Verify surface creation. */
-	if (surface == NULL)
-		return NULL;
-
-	/* Convert the SDL surface into a texture. */
-	texture = SDL_CreateTextureFromSurface(context->renderer, surface);
-
-	/* Verify texture creation. */
-	if (texture == NULL)
-	{
-		SDL_FreeSurface(surface);
-		return NULL;
-	}
-
-	/* Allocate memory for an image structure. */
-	image = fl_alloc(fl_image, 1);
-
-	/* Verify image memory allocation. */
-	if (image == NULL)
-	{
-		SDL_FreeSurface(surface);
-		SDL_DestroyTexture(texture);
-		return NULL;
-	}
-
-	/* Populate the image structure. */
-	image->w = surface->w;
-	image->h = surface->h;
-	image->texture = texture;
-
-	/* Dispose of the surface. */
-	SDL_FreeSurface(surface);
-
-	return image;
-}
-
-fl_image* fl_create_text_image(fl_context* context, fl_resource* res, const char* str)
-{
-	fl_ttf* font;
-	fl_color fc;
-	fl_color bc;
-	SDL_Surface* surface;
-	fl_texture* texture;
-	fl_image* image;
-
-	/* Extract the font data from the resource. */
-	font = res->impl.font->impl;
-	fc = res->impl.font->forecolor;
-	bc = res->impl.font->backcolor;
-
-	/* Create an SDL surface representing the character. */
-	if (res->impl.font->background)
-		surface = TTF_RenderText_Shaded(font, str, fc, bc);
-	else
-		surface = TTF_RenderText_Blended(font, str, fc);
-
-	/* Verify surface creation. */
-	if (surface == NULL)
-		return NULL;
-
-	/* Convert the SDL surface into a texture. */
-	texture = SDL_CreateTextureFromSurface(context->renderer, surface);
-
-	/* Verify texture creation. */
-	if (texture == NULL)
-	{
-		SDL_FreeSurface(surface);
-		return NULL;
-	}
-
-	/* Allocate memory for an image structure. */
-	image = fl_alloc(fl_image, 1);
-
-	/* Verify image memory allocation. */
-	if (image == NULL)
-	{
-		SDL_FreeSurface(surface);
-		SDL_DestroyTexture(texture);
-		return NULL;
-	}
-
-	/* Populate the image structure. */
-	image->w = surface->w;
-	image->h = surface->h;
-	image->texture = texture;
-
-	/* Dispose of the surface. */
-	SDL_FreeSurface(surface);
-
-	return image;
-}
-
-
-/* -------------------------------------------------------------- */
-/*                      Rendering Functions                       */
-/* -------------------------------------------------------------- */
-
-void fl_set_draw_color(fl_context* context, int r, int g, int b, int a)
-{
-	SDL_SetRenderDrawColor(context->renderer, r, g, b, a);
-}
-
-void fl_draw_rect(fl_context* context, fl_rect* r)
-{
-	SDL_RenderDrawRect(context->renderer, r);
-}
-
-void fl_draw_solid_rect(fl_context* context, fl_rect* r)
-{
-	SDL_RenderFillRect(context->renderer, r);
-}
-
-void fl_draw_line(fl_context* context, int x1, int y1, int x2, int y2)
-{
-	SDL_RenderDrawLine(context->renderer, x1, y1, x2, y2);
-}
-
-void fl_draw(fl_context* context, fl_texture* tex, fl_rect* src, fl_rect* dest, int flip)
-{
-	if (flip)
-	{
-		SDL_RenderCopyEx(context->renderer, tex, src, dest, 0, NULL, SDL_FLIP_HORIZONTAL);
-	}
-	else
-	{
-		SDL_RenderCopyEx(context->renderer, tex, src, dest, 0, NULL, SDL_FLIP_NONE);
-	}
-}
-
-void fl_render_clear(fl_context* context)
-{
-	SDL_RenderClear(context->renderer);
-}
-
-void fl_render_show(fl_context* context)
-{
-	SDL_RenderPresent(context->renderer);
-}
-
-
-
-/* -------------------------------------------------------------- */
-/*                    flurmp.h implementation                     */
-/* -------------------------------------------------------------- */
-
-void fl_sleep(int ms)
-{
-	SDL_Delay(ms);
-}
-
-void fl_handle_events(fl_context* context)
-{
-	while (SDL_PollEvent(&(context->event)))
-	{
-		/* This happens when the user closes the window. */
-		if (context->event.type == FLURMP_QUIT)
-			context->done = 1;
-	}
-}
-
-void fl_begin_frame(fl_context* context)
-{
-	context->ticks = SDL_GetTicks();
-}
-
-void fl_end_frame(fl_context* context)
-{
-	if (1000U / context->fps > SDL_GetTicks() - context->ticks)
-	{
-		SDL_Delay(1000U / context->fps - (SDL_GetTicks() - context->ticks));
-	}
-}
-
-int fl_initialize()
-{
-	if (SDL_Init(SDL_INIT_VIDEO)) return 0;
-
-	if (TTF_Init())
-	{
-		SDL_Quit();
-		return 0;
-	}
-
-	return 1;
-}
-
-void fl_terminate()
-{
-	TTF_Quit();
-	SDL_Quit();
-}
+/**
+ * Implementation of the Flurmp SDL wrapper.
+ * Contains implementation of functions for creating rendering contexts,
+ * loading images and fonts, rendering data to the screen and running
+ * work on other threads.
+ *
+ * This file also contains the implementation of the following functions
+ * from the flurmp.h header file:
+ *   fl_sleep
+ *   fl_handle_events
+ *   fl_begin_frame
+ *   fl_end_frame
+ *   fl_initialize
+ *   fl_terminate
+ */
+#include "core/flurmp_impl.h"
+#include "core/flurmp_sdl.h"
+#include "core/image_format.h"
+#include "core/input.h"
+#include "core/latency.h"
+#include "core/layer.h"
+#include "core/memory.h"
+#include "core/pack.h"
+#include "core/qoi.h"
+#include "core/text.h"
+
+/* Opening and closing fonts share the FreeType library, so they are
+   kept to one thread at a time. Rendering only touches the font. */
+static SDL_mutex* ttf_lock_ = NULL;
+
+/**
+ * Opens an asset for reading. The asset is read from the open pack
+ * without being copied if the pack has it, and from a file otherwise.
+ *
+ * Params:
+ *   const char* - the path to the asset
+ *
+ * Returns:
+ *   SDL_RWops* - a stream to read the asset from, or NULL on failure
+ */
+static SDL_RWops* open_asset(const char* path);
+
+/**
+ * Creates a texture from premultiplied RGBA8888 pixels
+ * and fills in an image structure with it.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   const void* - the pixels
+ *   int - the width
+ *   int - the height
+ *   fl_image - a reference to an image structure
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int create_image(fl_context* context, const void* pixels, int w, int h, fl_image* img);
+
+/**
+ * Determines if a path ends with an extension.
+ *
+ * Params:
+ *   const char* - a path
+ *   const char* - an extension, including the dot
+ *
+ * Returns:
+ *   int - 1 if the path has the extension, otherwise 0
+ */
+static int has_extension(const char* path, const char* extension);
+
+/**
+ * Determines if the header of a baked image is valid.
+ *
+ * Params:
+ *   const fl_baked_header* - the header
+ *   size_t - the size of the whole image, header included
+ *
+ * Returns:
+ *   int - 1 if the header is valid and the pixels fit in the image, otherwise 0
+ */
+static int is_valid_baked(const fl_baked_header* header, size_t size);
+
+/**
+ * Reads a baked image into a surface. The pixels of a packed image
+ * are used where they are mapped rather than copied.
+ *
+ * Params:
+ *   const char* - the path to the baked image
+ *
+ * Returns:
+ *   SDL_Surface* - the premultiplied RGBA8888 pixels, or NULL on failure
+ */
+static SDL_Surface* decode_baked(const char* path);
+
+/**
+ * Decodes a QOI image into a surface.
+ *
+ * Params:
+ *   const char* - the path to the QOI image
+ *
+ * Returns:
+ *   SDL_Surface* - the premultiplied RGBA8888 pixels, or NULL on failure
+ */
+static SDL_Surface* decode_qoi(const char* path);
+
+/**
+ * Loads a bmp into a surface, making the color 255, 0, 255
+ * transparent and premultiplying the rest.
+ *
+ * Params:
+ *   const char* - the path to the bmp file
+ *
+ * Returns:
+ *   SDL_Surface* - the premultiplied RGBA8888 pixels, or NULL on failure
+ */
+static SDL_Surface* decode_bmp(const char* path);
+
+
+
+/* -------------------------------------------------------------- */
+/*                        Core Functions                          */
+/* -------------------------------------------------------------- */
+
+fl_window* fl_create_window(const char* title, int x, int y, int w, int h)
+{
+	return SDL_CreateWindow(title, x, y, w, h, SDL_WINDOW_SHOWN);
+}
+
+void fl_destroy_window(fl_window* window)
+{
+	SDL_DestroyWindow(window);
+}
+
+fl_renderer* fl_create_renderer(fl_window* window)
+{
+	fl_renderer* ren = SDL_CreateRenderer(window, -1,
+		SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
+
+	if (ren == NULL)
+		return NULL;
+
+	SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+
+	return ren;
+}
+
+void fl_destroy_renderer(fl_renderer* renderer)
+{
+	SDL_DestroyRenderer(renderer);
+}
+
+void fl_get_max_texture_size(fl_context* context, int* w, int* h)
+{
+	SDL_RendererInfo info;
+
+	/* Assume a conservative limit if the renderer does not say. */
+	if (SDL_GetRendererInfo(context->renderer, &info) || info.max_texture_width <= 0)
+	{
+		*w = 2048;
+		*h = 2048;
+		return;
+	}
+
+	*w = info.max_texture_width;
+	*h = info.max_texture_height;
+}
+
+void fl_start_text_input()
+{
+	SDL_StartTextInput();
+}
+
+void fl_stop_text_input()
+{
+	SDL_StopTextInput();
+}
+
+unsigned long long fl_get_performance_counter()
+{
+	return SDL_GetPerformanceCounter();
+}
+
+unsigned long long fl_get_performance_frequency()
+{
+	return SDL_GetPerformanceFrequency();
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                        Asset Functions                         */
+/* -------------------------------------------------------------- */
+
+const unsigned char* fl_read_asset(const char* path, size_t* size)
+{
+	SDL_RWops* file;
+	Sint64 length;
+	unsigned char* data;
+	const void* packed = fl_find_asset(path, size);
+
+	if (packed != NULL)
+		return packed;
+
+	file = SDL_RWFromFile(path, "rb");
+
+	if (file == NULL)
+		return NULL;
+
+	length = SDL_RWsize(file);
+	data = length > 0 ? fl_alloc(unsigned char, (size_t)length) : NULL;
+
+	if (data == NULL || SDL_RWread(file, data, 1, (size_t)length) != (size_t)length)
+	{
+		fl_free(data);
+		SDL_RWclose(file);
+		return NULL;
+	}
+
+	SDL_RWclose(file);
+	*size = (size_t)length;
+
+	return data;
+}
+
+void fl_release_asset(const unsigned char* data)
+{
+	/* Assets in the pack were never copied. */
+	if (data != NULL && !fl_is_packed(data))
+		fl_free((void*)data);
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                        Thread Functions                        */
+/* -------------------------------------------------------------- */
+
+fl_thread* fl_create_thread(int (*function)(void*), const char* name, void* data)
+{
+	return SDL_CreateThread(function, name, data);
+}
+
+void fl_wait_thread(fl_thread* thread)
+{
+	if (thread == NULL)
+		return;
+
+	SDL_WaitThread(thread, NULL);
+}
+
+fl_mutex* fl_create_mutex()
+{
+	return SDL_CreateMutex();
+}
+
+void fl_destroy_mutex(fl_mutex* mutex)
+{
+	if (mutex == NULL)
+		return;
+
+	SDL_DestroyMutex(mutex);
+}
+
+void fl_lock_mutex(fl_mutex* mutex)
+{
+	SDL_LockMutex(mutex);
+}
+
+void fl_unlock_mutex(fl_mutex* mutex)
+{
+	SDL_UnlockMutex(mutex);
+}
+
+fl_cond* fl_create_cond()
+{
+	return SDL_CreateCond();
+}
+
+void fl_destroy_cond(fl_cond* cond)
+{
+	if (cond == NULL)
+		return;
+
+	SDL_DestroyCond(cond);
+}
+
+void fl_wait_cond(fl_cond* cond, fl_mutex* mutex)
+{
+	SDL_CondWait(cond, mutex);
+}
+
+void fl_broadcast_cond(fl_cond* cond)
+{
+	SDL_CondBroadcast(cond);
+}
+
+void fl_lock_spin(fl_spinlock* lock)
+{
+	SDL_AtomicLock(lock);
+}
+
+void fl_unlock_spin(fl_spinlock* lock)
+{
+	SDL_AtomicUnlock(lock);
+}
+
+int fl_atomic_get(fl_atomic* value)
+{
+	return SDL_AtomicGet(value);
+}
+
+void fl_atomic_set(fl_atomic* value, int v)
+{
+	SDL_AtomicSet(value, v);
+}
+
+int fl_get_cpu_count()
+{
+	return SDL_GetCPUCount();
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                        Audio Functions                         */
+/* -------------------------------------------------------------- */
+
+fl_audio_device fl_open_audio(int rate, int frames, void(*callback) (void*, unsigned char*, int), void* data)
+{
+	SDL_AudioSpec spec;
+	SDL_AudioDeviceID device;
+
+	memset(&spec, 0, sizeof(spec));
+	spec.freq = rate;
+	spec.format = AUDIO_S16SYS;
+	spec.channels = 2;
+	spec.samples = (Uint16)frames;
+	spec.callback = callback;
+	spec.userdata = data;
+
+	/* Allowing no changes makes SDL convert to the hardware's format,
+	   so the callback always gets the format it asked for. */
+	device = SDL_OpenAudioDevice(NULL, 0, &spec, NULL, 0);
+
+	if (device != 0)
+		SDL_PauseAudioDevice(device, 0);
+
+	return device;
+}
+
+void fl_close_audio(fl_audio_device device)
+{
+	SDL_CloseAudioDevice(device);
+}
+
+short* fl_load_wav(const char* path, int rate, int* frames)
+{
+	SDL_AudioSpec spec;
+	SDL_AudioCVT cvt;
+	Uint8* wav;
+	Uint32 length;
+	short* samples = NULL;
+
+	if (SDL_LoadWAV_RW(open_asset(path), 1, &spec, &wav, &length) == NULL)
+		return NULL;
+
+	/* The conversion is done in place, in a buffer big enough
+	   for the converted samples. */
+	if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, AUDIO_S16SYS, 2, rate) >= 0)
+	{
+		cvt.len = (int)length;
+		cvt.buf = fl_alloc(Uint8, (size_t)length * cvt.len_mult);
+
+		if (cvt.buf != NULL)
+		{
+			memcpy(cvt.buf, wav, length);
+
+			if (SDL_ConvertAudio(&cvt) == 0)
+			{
+				samples = (short*)cvt.buf;
+				*frames = cvt.len_cvt / (int)(2 * sizeof(short));
+			}
+			else
+				fl_free(cvt.buf);
+		}
+	}
+
+	SDL_FreeWAV(wav);
+
+	return samples;
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                        Image Functions                         */
+/* -------------------------------------------------------------- */
+
+int fl_load_bmp(fl_context* context, const char* path, fl_image* img)
+{
+	SDL_Surface* surface;
+	fl_texture* texture;
+
+	/* Load a bmp file. */
+	surface = SDL_LoadBMP_RW(open_asset(path), 1);
+
+	/* Verify that the bmp file loaded. */
+	if (surface == NULL)
+		return 0;
+
+	/* Ignore the color with an RGB value of 255, 0, 255. */
+	SDL_SetColorKey(surface, 1, SDL_MapRGB(surface->format, 255, 0, 255));
+
+	/* Convert the SDL surface into a texture. */
+	texture = SDL_CreateTextureFromSurface(context->renderer, surface);
+
+	/* Verify texture creation. */
+	if (texture == NULL)
+	{
+		SDL_FreeSurface(surface);
+		return 0;
+	}
+
+	/* Populate the image structure. */
+	img->w = surface->w;
+	img->h = surface->h;
+	img->texture = texture;
+
+	/* Dispose of the surface. */
+	SDL_FreeSurface(surface);
+
+	return 1;
+}
+
+int fl_load_baked_image(fl_context* context, const char* path, fl_image* img)
+{
+	SDL_Surface* surface = decode_baked(path);
+	int ok = surface != NULL && fl_upload_image(context, surface, img);
+
+	SDL_FreeSurface(surface);
+
+	return ok;
+}
+
+int fl_load_qoi(fl_context* context, const char* path, fl_image* img)
+{
+	SDL_Surface* surface = decode_qoi(path);
+	int ok = surface != NULL && fl_upload_image(context, surface, img);
+
+	SDL_FreeSurface(surface);
+
+	return ok;
+}
+
+fl_surface* fl_decode_image(const char* path)
+{
+	if (has_extension(path, FLURMP_BAKED_EXTENSION))
+		return decode_baked(path);
+
+	if (has_extension(path, FLURMP_QOI_EXTENSION))
+		return decode_qoi(path);
+
+	return decode_bmp(path);
+}
+
+int fl_upload_image(fl_context* context, fl_surface* surface, fl_image* img)
+{
+	if (surface == NULL)
+		return 0;
+
+	/* Decoded surfaces are packed, so their pitch is
+	   the width of a row of pixels. */
+	return create_image(context, surface->pixels, surface->w, surface->h, img);
+}
+
+void fl_destroy_image(fl_image* image)
+{
+	if (image == NULL)
+		return;
+
+	if (image->texture != NULL)
+		SDL_DestroyTexture(image->texture);
+
+	fl_free(image);
+}
+
+fl_texture* fl_create_target_texture(fl_context* context, int w, int h)
+{
+	fl_texture* texture = SDL_CreateTexture(context->renderer,
+		SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+
+	if (texture == NULL)
+		return NULL;
+
+	/* Allow whatever is behind the texture to show through
+	   its transparent areas. */
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	return texture;
+}
+
+void fl_destroy_texture(fl_texture* texture)
+{
+	if (texture == NULL)
+		return;
+
+	SDL_DestroyTexture(texture);
+}
+
+fl_texture* fl_create_atlas_texture(fl_context* context, int w, int h)
+{
+	fl_texture* texture = SDL_CreateTexture(context->renderer,
+		SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, w, h);
+
+	if (texture == NULL)
+		return NULL;
+
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	return texture;
+}
+
+int fl_update_texture(fl_texture* texture, fl_rect* area, fl_surface* surface)
+{
+	if (texture == NULL || surface == NULL)
+		return 0;
+
+	return SDL_UpdateTexture(texture, area, surface->pixels, surface->pitch) == 0;
+}
+
+void fl_destroy_surface(fl_surface* surface)
+{
+	if (surface == NULL)
+		return;
+
+	SDL_FreeSurface(surface);
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                        Text Functions                          */
+/* -------------------------------------------------------------- */
+
+fl_ttf* fl_load_ttf(const char* path, int p)
+{
+	TTF_Font* font;
+
+	/* A font reads from its stream for as long as it is open,
+	   which is fine for the pack since it stays mapped until
+	   fl_terminate. */
+	SDL_LockMutex(ttf_lock_);
+	font = TTF_OpenFontRW(open_asset(path), 1, p);
+	SDL_UnlockMutex(ttf_lock_);
+
+	return font;
+}
+
+void fl_close_ttf(fl_ttf* font)
+{
+	if (font == NULL)
+		return;
+
+	SDL_LockMutex(ttf_lock_);
+	TTF_CloseFont(font);
+	SDL_UnlockMutex(ttf_lock_);
+}
+
+fl_surface* fl_create_glyph_surface(fl_font* font, unsigned int code, int* w, int* h)
+{
+	char str[5];
+	SDL_Surface* surface;
+	SDL_Surface* converted;
+
+	/* Render the code point as a one character UTF-8 string,
+	   which reaches beyond the basic multilingual plane. */
+	str[fl_utf8_encode(code, str)] = '\0';
+
+	/* Create an SDL surface representing the character. */
+	if (font->background)
+		surface = TTF_RenderUTF8_Shaded(font->impl, str, font->forecolor, font->backcolor);
+	else
+		surface = TTF_RenderUTF8_Blended(font->impl, str, font->forecolor);
+
+	/* Verify surface creation. */
+	if (surface == NULL)
+		return NULL;
+
+	/* Convert the surface to the format of the atlas textures
+	   so that it can be uploaded directly. */
+	converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA8888, 0);
+	SDL_FreeSurface(surface);
+
+	if (converted == NULL)
+		return NULL;
+
+	*w = converted->w;
+	*h = converted->h;
+
+	return converted;
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                      Rendering Functions                       */
+/* -------------------------------------------------------------- */
+
+void fl_set_draw_color(fl_context* context, int r, int g, int b, int a)
+{
+	SDL_SetRenderDrawColor(context->renderer, r, g, b, a);
+}
+
+void fl_draw_rect(fl_context* context, fl_rect* r)
+{
+	SDL_RenderDrawRect(context->renderer, r);
+}
+
+void fl_draw_solid_rect(fl_context* context, fl_rect* r)
+{
+	SDL_RenderFillRect(context->renderer, r);
+}
+
+void fl_draw_line(fl_context* context, int x1, int y1, int x2, int y2)
+{
+	SDL_RenderDrawLine(context->renderer, x1, y1, x2, y2);
+}
+
+void fl_draw_geometry(fl_context* context, fl_texture* tex, const fl_vertex* vertices, int vertex_count, const int* indices, int index_count)
+{
+	SDL_RenderGeometry(context->renderer, tex, vertices, vertex_count, indices, index_count);
+}
+
+void fl_draw(fl_context* context, fl_texture* tex, fl_rect* src, fl_rect* dest, int flip)
+{
+	if (flip)
+	{
+		SDL_RenderCopyEx(context->renderer, tex, src, dest, 0, NULL, SDL_FLIP_HORIZONTAL);
+	}
+	else
+	{
+		SDL_RenderCopyEx(context->renderer, tex, src, dest, 0, NULL, SDL_FLIP_NONE);
+	}
+}
+
+int fl_set_render_target(fl_context* context, fl_texture* texture)
+{
+	return SDL_SetRenderTarget(context->renderer, texture) == 0;
+}
+
+fl_texture* fl_get_render_target(fl_context* context)
+{
+	return SDL_GetRenderTarget(context->renderer);
+}
+
+void fl_render_clear(fl_context* context)
+{
+	SDL_RenderClear(context->renderer);
+}
+
+void fl_render_show(fl_context* context)
+{
+	SDL_RenderPresent(context->renderer);
+
+	/* The frame containing the response to any pending
+	   input is now on its way to the screen. */
+	fl_latency_present(context, SDL_GetTicks());
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                    flurmp.h implementation                     */
+/* -------------------------------------------------------------- */
+
+void fl_sleep(int ms)
+{
+	SDL_Delay(ms);
+}
+
+void fl_handle_events(fl_context* context)
+{
+	/* Forget the key presses and text from the previous frame. */
+	fl_reset_input(context);
+
+	while (SDL_PollEvent(&(context->event)))
+	{
+		switch (context->event.type)
+		{
+		/* This happens when the user closes the window. */
+		case FLURMP_QUIT:
+			context->done = 1;
+			break;
+
+		/* Ignore key repeats so that holding a key
+		   only counts as a single press. */
+		case FLURMP_KEYDOWN:
+			if (!context->event.key.repeat)
+			{
+				fl_input_key_down(context, context->event.key.keysym.scancode);
+				fl_latency_input(context, context->event.key.timestamp);
+			}
+			break;
+
+		case FLURMP_KEYUP:
+			fl_input_key_up(context, context->event.key.keysym.scancode);
+			break;
+
+		case FLURMP_TEXTINPUT:
+			fl_input_text(context, context->event.text.text);
+			break;
+
+		/* The contents of render target textures have been lost,
+		   so any cached layers must be redrawn. */
+		case FLURMP_RENDER_TARGETS_RESET:
+			fl_invalidate_layers(context);
+			fl_invalidate_snapshot(context);
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+void fl_begin_frame(fl_context* context)
+{
+	/* In low latency mode, the remainder of the previous frame is
+	   spent waiting here so that input is polled as late as possible. */
+	if (context->low_latency)
+	{
+		if (1000U / context->fps > SDL_GetTicks() - context->ticks)
+		{
+			SDL_Delay(1000U / context->fps - (SDL_GetTicks() - context->ticks));
+		}
+	}
+
+	context->ticks = SDL_GetTicks();
+
+	/* Start counting the allocations made during this frame. */
+	fl_memory_frame();
+}
+
+void fl_end_frame(fl_context* context)
+{
+	if (context->low_latency)
+		return;
+
+	if (1000U / context->fps > SDL_GetTicks() - context->ticks)
+	{
+		SDL_Delay(1000U / context->fps - (SDL_GetTicks() - context->ticks));
+	}
+}
+
+int fl_initialize()
+{
+	if (SDL_Init(SDL_INIT_VIDEO)) return 0;
+
+	/* Without audio, contexts carry on silently. */
+	SDL_InitSubSystem(SDL_INIT_AUDIO);
+
+	if (TTF_Init())
+	{
+		SDL_Quit();
+		return 0;
+	}
+
+	ttf_lock_ = SDL_CreateMutex();
+
+	if (ttf_lock_ == NULL)
+	{
+		TTF_Quit();
+		SDL_Quit();
+		return 0;
+	}
+
+	/* Use the asset pack if there is one, and loose files otherwise. */
+	fl_open_pack(FLURMP_PACK_PATH);
+
+	return 1;
+}
+
+void fl_terminate()
+{
+	fl_close_pack();
+	TTF_Quit();
+
+	SDL_DestroyMutex(ttf_lock_);
+	ttf_lock_ = NULL;
+
+	SDL_Quit();
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                      Internal Functions                        */
+/* -------------------------------------------------------------- */
+
+static SDL_RWops* open_asset(const char* path)
+{
+	size_t size;
+	const void* data = fl_find_asset(path, &size);
+
+	if (data != NULL)
+		return SDL_RWFromConstMem(data, (int)size);
+
+	return SDL_RWFromFile(path, "rb");
+}
+
+static int create_image(fl_context* context, const void* pixels, int w, int h, fl_image* img)
+{
+	fl_texture* texture = SDL_CreateTexture(context->renderer,
+		SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, w, h);
+
+	if (texture == NULL)
+		return 0;
+
+	if (SDL_UpdateTexture(texture, NULL, pixels, w * 4))
+	{
+		SDL_DestroyTexture(texture);
+		return 0;
+	}
+
+	/* Renderers that don't support custom blend modes fall back to
+	   ordinary blending. That is exact for color keyed images, whose
+	   pixels are either opaque or transparent black. */
+	if (SDL_SetTextureBlendMode(texture, SDL_ComposeCustomBlendMode(
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD)))
+	{
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	}
+
+	img->w = w;
+	img->h = h;
+	img->texture = texture;
+
+	return 1;
+}
+
+static int has_extension(const char* path, const char* extension)
+{
+	size_t length = strlen(path);
+	size_t n = strlen(extension);
+
+	return length >= n && !strcmp(path + length - n, extension);
+}
+
+static int is_valid_baked(const fl_baked_header* header, size_t size)
+{
+	return !memcmp(header->magic, FLURMP_BAKED_MAGIC, 4)
+		&& header->version == FLURMP_BAKED_VERSION
+		&& header->w > 0 && header->w <= FLURMP_IMAGE_SIZE_LIMIT
+		&& header->h > 0 && header->h <= FLURMP_IMAGE_SIZE_LIMIT
+		&& size >= sizeof(*header)
+		&& (size - sizeof(*header)) / 4 / header->w >= header->h;
+}
+
+static SDL_Surface* decode_baked(const char* path)
+{
+	size_t size;
+	Sint64 length;
+	fl_baked_header header;
+	SDL_Surface* surface = NULL;
+	SDL_RWops* file;
+	const unsigned char* packed = fl_find_asset(path, &size);
+
+	/* Packed pixels are used where they are mapped. */
+	if (packed != NULL)
+	{
+		if (size < sizeof(header))
+			return NULL;
+
+		memcpy(&header, packed, sizeof(header));
+
+		if (!is_valid_baked(&header, size))
+			return NULL;
+
+		return SDL_CreateRGBSurfaceWithFormatFrom((void*)(packed + sizeof(header)),
+			(int)header.w, (int)header.h, 32, (int)header.w * 4, SDL_PIXELFORMAT_RGBA8888);
+	}
+
+	file = SDL_RWFromFile(path, "rb");
+
+	if (file == NULL)
+		return NULL;
+
+	length = SDL_RWsize(file);
+
+	/* Read the pixels straight into the surface. */
+	if (length > 0 && SDL_RWread(file, &header, sizeof(header), 1) == 1
+		&& is_valid_baked(&header, (size_t)length))
+	{
+		surface = SDL_CreateRGBSurfaceWithFormat(0, (int)header.w, (int)header.h, 32, SDL_PIXELFORMAT_RGBA8888);
+
+		if (surface != NULL && SDL_RWread(file, surface->pixels, (size_t)header.w * 4, header.h) != header.h)
+		{
+			SDL_FreeSurface(surface);
+			surface = NULL;
+		}
+	}
+
+	SDL_RWclose(file);
+
+	return surface;
+}
+
+static SDL_Surface* decode_qoi(const char* path)
+{
+	size_t size;
+	int w;
+	int h;
+	SDL_Surface* surface = NULL;
+	const unsigned char* data = fl_read_asset(path, &size);
+
+	if (data == NULL)
+		return NULL;
+
+	if (fl_qoi_size(data, size, &w, &h))
+		surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA8888);
+
+	if (surface != NULL && !fl_decode_qoi(data, size, surface->pixels))
+	{
+		SDL_FreeSurface(surface);
+		surface = NULL;
+	}
+
+	fl_release_asset(data);
+
+	return surface;
+}
+
+static SDL_Surface* decode_bmp(const char* path)
+{
+	int x;
+	int y;
+	SDL_Surface* bmp = SDL_LoadBMP_RW(open_asset(path), 1);
+	SDL_Surface* surface;
+
+	if (bmp == NULL)
+		return NULL;
+
+	surface = SDL_ConvertSurfaceFormat(bmp, SDL_PIXELFORMAT_RGBA8888, 0);
+	SDL_FreeSurface(bmp);
+
+	if (surface == NULL)
+		return NULL;
+
+	for (y = 0; y < surface->h; y++)
+	{
+		Uint32* row = (Uint32*)((Uint8*)surface->pixels + y * surface->pitch);
+
+		for (x = 0; x < surface->w; x++)
+		{
+			Uint32 p = row[x];
+			Uint32 a = p & 0xff;
+
+			/* The color key becomes transparent black, as it does
+			   in baked images. */
+			if ((p >> 8) == 0xff00ff)
+				row[x] = 0;
+			else if (a != 0xff)
+			{
+				row[x] = ((((p >> 24) * a + 127) / 255) << 24)
+					| (((((p >> 16) & 0xff) * a + 127) / 255) << 16)
+					| (((((p >> 8) & 0xff) * a + 127) / 255) << 8)
+					| a;
+			}
+		}
+	}
+
+	return surface;
+}
@@ -1,97 +1,82 @@
 #include "core/input.h"
 
-int fl_code_to_flag(int type, int code)
+/* Bit set helpers. Each key occupies one bit in an array of words. */
+#define KEY_WORD(code) ((code) / FLURMP_KEY_WORD_BITS)
+#define KEY_BIT(code) (1U << ((code) % FLURMP_KEY_WORD_BITS))
+
+/* initial number of slots in the input handler stack */
+#define INITIAL_STACK_CAPACITY 8
+
+/**
+ * Determines whether a scancode can be stored in the key bit sets.
+ *
+ * Params:
+ *   int - a scancode
+ *
+ * Returns:
+ *   int - 1 if the scancode is valid, otherwise 0
+ */
+static int is_valid_code(int code)
 {
-	if (type == FLURMP_INPUT_TYPE_KEYBOARD)
+	return code >= 0 && code < FLURMP_SC_LIMIT;
+}
+
+void fl_reset_input(fl_context* context)
+{
+	int i;
+
+	for (i = 0; i < FLURMP_KEY_WORDS; i++)
 	{
-		switch (code)
-		{
-		case FLURMP_SC_A: return FLURMP_INPUT_A;
-		case FLURMP_SC_B: return FLURMP_INPUT_B;
-		case FLURMP_SC_C: return FLURMP_INPUT_C;
-		case FLURMP_SC_D: return FLURMP_INPUT_D;
-		case FLURMP_SC_E: return FLURMP_INPUT_E;
-		case FLURMP_SC_F: return FLURMP_INPUT_F;
-		case FLURMP_SC_G: return FLURMP_INPUT_G;
-		case FLURMP_SC_H: return FLURMP_INPUT_H;
-		case FLURMP_SC_I: return FLURMP_INPUT_I;
-		case FLURMP_SC_J: return FLURMP_INPUT_J;
-		case FLURMP_SC_K: return FLURMP_INPUT_K;
-		case FLURMP_SC_L: return FLURMP_INPUT_L;
-		case FLURMP_SC_M: return FLURMP_INPUT_M;
-		case FLURMP_SC_N: return FLURMP_INPUT_N;
-		case FLURMP_SC_O: return FLURMP_INPUT_O;
-		case FLURMP_SC_P: return FLURMP_INPUT_P;
-		case FLURMP_SC_Q: return FLURMP_INPUT_Q;
-		case FLURMP_SC_R: return FLURMP_INPUT_R;
-		case FLURMP_SC_S: return FLURMP_INPUT_S;
-		case FLURMP_SC_T: return FLURMP_INPUT_T;
-		case FLURMP_SC_U: return FLURMP_INPUT_U;
-		case FLURMP_SC_V: return FLURMP_INPUT_V;
-		case FLURMP_SC_W: return FLURMP_INPUT_W;
-		case FLURMP_SC_X: return FLURMP_INPUT_X;
-		case FLURMP_SC_Y: return FLURMP_INPUT_Y;
-		case FLURMP_SC_Z: return FLURMP_INPUT_Z;
-		case FLURMP_SC_0: return FLURMP_INPUT_0;
-		case FLURMP_SC_1: return FLURMP_INPUT_1;
-		case FLURMP_SC_2: return FLURMP_INPUT_2;
-		case FLURMP_SC_3: return FLURMP_INPUT_3;
-		case FLURMP_SC_4: return FLURMP_INPUT_4;
-		case FLURMP_SC_5: return FLURMP_INPUT_5;
-		case FLURMP_SC_6: return FLURMP_INPUT_6;
-		case FLURMP_SC_7: return FLURMP_INPUT_7;
-		case FLURMP_SC_8: return FLURMP_INPUT_8;
-		case FLURMP_SC_9: return FLURMP_INPUT_9;
-		case FLURMP_SC_ESCAPE: return FLURMP_INPUT_ESCAPE;
-		case FLURMP_SC_COMMA: return FLURMP_INPUT_COMMA;
-		case FLURMP_SC_PERIOD: return FLURMP_INPUT_PERIOD;
-		case FLURMP_SC_SPACE: return FLURMP_INPUT_SPACE;
-		case FLURMP_SC_LSHIFT:
-		case FLURMP_SC_RSHIFT:
-			return FLURMP_INPUT_SHIFT;
-		case FLURMP_SC_LCTRL:
-		case FLURMP_SC_RCTRL:
-			return FLURMP_INPUT_CTRL;
-		case FLURMP_SC_BACKSPACE: return FLURMP_INPUT_BACKSPACE;
-		case FLURMP_SC_RETURN: return FLURMP_INPUT_RETURN;
-		case FLURMP_SC_RETURN2: return FLURMP_INPUT_RETURN2;
-		case FLURMP_SC_LEFTBRACKET: return FLURMP_INPUT_LEFTBRACKET;
-		case FLURMP_SC_RIGHTBRACKET: return FLURMP_INPUT_RIGHTBRACKET;
-		case FLURMP_SC_SEMICOLON: return FLURMP_INPUT_SEMICOLON;
-		case FLURMP_SC_APOSTRAPHE: return FLURMP_INPUT_APOSTRAPHE;
-		case FLURMP_SC_SLASH: return FLURMP_INPUT_SLASH;
-		case FLURMP_SC_BACKSLASH: return FLURMP_INPUT_BACKSLASH;
-		case FLURMP_SC_MINUS: return FLURMP_INPUT_MINUS;
-		case FLURMP_SC_EQUALS: return FLURMP_INPUT_EQUALS;
-		case FLURMP_SC_BACKTICK: return FLURMP_INPUT_BACKTICK;
-
-		default:
-			return FLURMP_INPUT_UNKNOWN;
-		}
+		context->input.pressed[i] = 0;
+		context->input.released[i] = 0;
 	}
 
-	return FLURMP_INPUT_UNKNOWN;
+	context->input.text[0] = '\0';
+	context->input.text_count = 0;
+}
+
+void fl_input_key_down(fl_context* context, int code)
+{
+	if (!is_valid_code(code))
+		return;
+
+	context->input.held[KEY_WORD(code)] |= KEY_BIT(code);
+	context->input.pressed[KEY_WORD(code)] |= KEY_BIT(code);
+}
+
+void fl_input_key_up(fl_context* context, int code)
+{
+	if (!is_valid_code(code))
+		return;
+
+	context->input.held[KEY_WORD(code)] &= ~KEY_BIT(code);
+	context->input.released[KEY_WORD(code)] |= KEY_BIT(code);
+}
+
+void fl_input_text(fl_context* context, const char* text)
+{
+	if (text == NULL)
+		return;
+
+	/* Leave room for the terminating '\0'. */
+	while (*text != '\0' && context->input.text_count < FLURMP_TEXT_INPUT_LIMIT - 1)
+		context->input.text[context->input.text_count++] = *text++;
+
+	context->input.text[context->input.text_count] = '\0';
 }
 
 int fl_consume_input(fl_context* context, int type, int code)
 {
-	if (type == FLURMP_INPUT_TYPE_KEYBOARD)
+	if (type == FLURMP_INPUT_TYPE_KEYBOARD && is_valid_code(code))
 	{
-		int flag = fl_code_to_flag(type, code);
-
-		if (context->input.keystates[code])
+		if (context->input.pressed[KEY_WORD(code)] & KEY_BIT(code))
 		{
-			if (!context->input.flags[flag])
-			{
-				context->input.flags[flag] = 1;
+			/* Clear the pressed bit so that the key press
+			   only triggers one action. */
+			context->input.pressed[KEY_WORD(code)] &= ~KEY_BIT(code);
 
-				return 1;
-			}
-
-			return 0;
+			return 1;
 		}
-		else if (context->input.flags[flag])
-			context->input.flags[flag] = 0;
 
 		return 0;
 	}
@@ -101,9 +86,9 @@ int fl_consume_input(fl_context* context, int type, int code)
 
 int fl_peek_input(fl_context* context, int type, int code)
 {
-	if (type == FLURMP_INPUT_TYPE_KEYBOARD)
+	if (type == FLURMP_INPUT_TYPE_KEYBOARD && is_valid_code(code))
 	{
-		if (context->input.keystates[code])
+		if (context->input.held[KEY_WORD(code)] & KEY_BIT(code))
 			return 1;
 
 		return 0;
@@ -122,6 +107,38 @@ int fl_peek_key(fl_context* context, int code)
 	return fl_peek_input(context, FLURMP_INPUT_TYPE_KEYBOARD, code);
 }
 
+int fl_key_released(fl_context* context, int code)
+{
+	if (!is_valid_code(code))
+		return 0;
+
+	return (context->input.released[KEY_WORD(code)] & KEY_BIT(code)) ? 1 : 0;
+}
+
+void fl_bind_action(fl_context* context, int action, int code)
+{
+	if (action < 0 || action >= FLURMP_ACTION_COUNT || !is_valid_code(code))
+		return;
+
+	context->input.actions[action] = code;
+}
+
+int fl_consume_action(fl_context* context, int action)
+{
+	if (action < 0 || action >= FLURMP_ACTION_COUNT)
+		return 0;
+
+	return fl_consume_key(context, context->input.actions[action]);
+}
+
+int fl_peek_action(fl_context* context, int action)
+{
+	if (action < 0 || action >= FLURMP_ACTION_COUNT)
+		return 0;
+
+	return fl_peek_key(context, context->input.actions[action]);
+}
+
 fl_input_handler* fl_create_input_handler(void(*handler) (fl_context*, fl_input_handler*))
 {
 	fl_input_handler* input;
@@ -132,8 +149,7 @@ fl_input_handler* fl_create_input_handler(void(*handler) (fl_context*, fl_input_
 		return NULL;
 
 	input->handle_input = handler;
-	input->parent = NULL;
-	input->child = NULL;
+	input->depth = -1;
 
 	return input;
 }
@@ -143,25 +159,15 @@ void fl_destroy_input_handler(fl_input_handler* input)
 	if (input == NULL)
 		return;
 
-	/* Destroy the child input handlers. */
-	if (input->child != NULL)
-		fl_destroy_input_handler(input->child);
-
 	fl_free(input);
 }
 
 fl_input_handler* fl_get_input_handler(fl_context* context)
 {
-	if (context == NULL || context->input_handler == NULL)
+	if (context == NULL || context->input_handlers.top < 0)
 		return NULL;
 
-	fl_input_handler* input = context->input_handler;
-
-	/* Traverse the input handler list until we find one with no child. */
-	while (input->child != NULL)
-		input = input->child;
-
-	return input;
+	return context->input_handlers.items[context->input_handlers.top];
 }
 
 void fl_push_input_handler(fl_context* context, fl_input_handler* input)
@@ -169,49 +175,69 @@ void fl_push_input_handler(fl_context* context, fl_input_handler* input)
 	if (context == NULL || input == NULL)
 		return;
 
-	if (context->input_handler == NULL)
-	{
-		context->input_handler = input;
-	}
-	else
+	fl_input_stack* stack = &context->input_handlers;
+
+	/* Double the stack storage when it is full. */
+	if (stack->top + 1 >= stack->capacity)
 	{
-		fl_input_handler* ih = context->input_handler;
+		int i;
+		int capacity = stack->capacity ? stack->capacity * 2 : INITIAL_STACK_CAPACITY;
+		fl_input_handler** items = fl_alloc(fl_input_handler*, capacity);
 
-		/* Traverse the input handler list until we find
-		   an input handler with no child. */
-		while (ih->child != NULL)
-			ih = ih->child;
+		if (items == NULL)
+		{
+			context->error = FLURMP_ERR_INPUT_HANDLER;
+			return;
+		}
+
+		for (i = 0; i <= stack->top; i++)
+			items[i] = stack->items[i];
 
-		/* Link the new input handler to the current,
-		   active input handler. */
-		ih->child = input;
-		input->parent = ih;
+		if (stack->items != NULL)
+			fl_free(stack->items);
+
+		stack->items = items;
+		stack->capacity = capacity;
 	}
+
+	stack->items[++stack->top] = input;
+	input->depth = stack->top;
 }
 
 void fl_pop_input_handler(fl_context* context)
 {
-	if (context == NULL || context->input_handler == NULL)
+	if (context == NULL || context->input_handlers.top < 0)
 		return;
 
-	fl_input_handler* ih = context->input_handler;
+	fl_input_stack* stack = &context->input_handlers;
 
-	/* Traverse the input handler list until we find
-	   an input handler with no child. */
-	while (ih->child != NULL)
-		ih = ih->child;
+	stack->items[stack->top--]->depth = -1;
+}
 
-	/* If the current input handler has no parent,
-	   clear the input handler pointer. */
-	if (ih->parent == NULL)
-	{
-		context->input_handler = NULL;
+void fl_propagate_input(fl_context* context, fl_input_handler* self)
+{
+	if (context == NULL || self == NULL || self->depth <= 0)
 		return;
-	}
-		
-	/* Clear the parent and child pointers to prevent the
-	   destruction of other input handlers when this
-	   input handler is destroyed elsewhere. */
-	ih->parent->child = NULL;
-	ih->parent = NULL;
+
+	fl_input_handler* below = context->input_handlers.items[self->depth - 1];
+
+	if (below->handle_input != NULL)
+		below->handle_input(context, below);
+}
+
+void fl_destroy_input_handlers(fl_context* context)
+{
+	fl_input_stack* stack = &context->input_handlers;
+
+	/* Only the root input handler belongs to the stack. The others
+	   are destroyed with the structures that contain them. */
+	if (stack->top >= 0)
+		fl_destroy_input_handler(stack->items[0]);
+
+	if (stack->items != NULL)
+		fl_free(stack->items);
+
+	stack->items = NULL;
+	stack->top = -1;
+	stack->capacity = 0;
 }
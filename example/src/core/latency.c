@@ -0,0 +1,123 @@
+#include "core/latency.h"
+
+
+
+/* -------------------------------------------------------------- */
+/*                     latency.h implementation                   */
+/* -------------------------------------------------------------- */
+
+void fl_latency_input(fl_context* context, unsigned int timestamp)
+{
+	if (context->latency.pending)
+		return;
+
+	context->latency.pending = 1;
+	context->latency.stamp = timestamp;
+}
+
+void fl_latency_present(fl_context* context, unsigned int now)
+{
+	fl_latency* latency = &context->latency;
+	unsigned int ms;
+	int bucket;
+
+	if (!latency->pending)
+		return;
+
+	latency->pending = 0;
+
+	/* Timestamps come from the same clock as now, but guard
+	   against events stamped after the call to SDL_GetTicks. */
+	ms = now > latency->stamp ? now - latency->stamp : 0;
+
+	/* Latencies beyond the last bucket are counted in the last bucket. */
+	bucket = ms / FLURMP_LATENCY_BUCKET_MS;
+	if (bucket >= FLURMP_LATENCY_BUCKETS)
+		bucket = FLURMP_LATENCY_BUCKETS - 1;
+
+	latency->histogram[bucket]++;
+	latency->samples++;
+	latency->total += ms;
+
+	if (ms > latency->max)
+		latency->max = ms;
+}
+
+unsigned int fl_latency_percentile(fl_context* context, int p)
+{
+	fl_latency* latency = &context->latency;
+	unsigned long target;
+	unsigned long seen;
+	int i;
+
+	if (latency->samples == 0)
+		return 0;
+
+	/* The number of samples at or below the percentile, rounded up. */
+	target = ((unsigned long)latency->samples * p + 99) / 100;
+	if (target == 0)
+		target = 1;
+
+	seen = 0;
+	for (i = 0; i < FLURMP_LATENCY_BUCKETS; i++)
+	{
+		seen += latency->histogram[i];
+
+		if (seen >= target)
+			break;
+	}
+
+	/* The last bucket is unbounded, so report the maximum instead. */
+	if (i >= FLURMP_LATENCY_BUCKETS - 1)
+		return latency->max;
+
+	return (i + 1) * FLURMP_LATENCY_BUCKET_MS;
+}
+
+void fl_latency_report(fl_context* context)
+{
+	fl_latency* latency = &context->latency;
+	int i;
+
+	printf("input to present latency (%s mode)\n",
+		context->low_latency ? "low latency" : "normal");
+
+	if (latency->samples == 0)
+	{
+		printf("  no samples\n");
+		return;
+	}
+
+	printf("  samples: %u avg: %lu ms max: %u ms\n",
+		latency->samples, latency->total / latency->samples, latency->max);
+	printf("  p50: %u ms p90: %u ms p99: %u ms\n",
+		fl_latency_percentile(context, 50),
+		fl_latency_percentile(context, 90),
+		fl_latency_percentile(context, 99));
+
+	for (i = 0; i < FLURMP_LATENCY_BUCKETS; i++)
+	{
+		if (latency->histogram[i] == 0)
+			continue;
+
+		if (i == FLURMP_LATENCY_BUCKETS - 1)
+			printf("  %3d+    ms: %u\n", i * FLURMP_LATENCY_BUCKET_MS, latency->histogram[i]);
+		else
+			printf("  %3d-%-3d ms: %u\n", i * FLURMP_LATENCY_BUCKET_MS,
+				(i + 1) * FLURMP_LATENCY_BUCKET_MS - 1, latency->histogram[i]);
+	}
+}
+
+void fl_latency_reset(fl_context* context)
+{
+	int i;
+
+	for (i = 0; i < FLURMP_LATENCY_BUCKETS; i++)
+		context->latency.histogram[i] = 0;
+
+	context->latency.pending = 0;
+	context->latency.stamp = 0;
+	context->latency.samples = 0;
+	context->latency.total = 0;
+	context->latency.max = 0;
+}
@@ -0,0 +1,462 @@
+#include "core/layer.h"
+#include "core/particle.h"
+#include "entity/entity.h"
+
+/* initial number of items in the render queue */
+#define INITIAL_QUEUE_CAPACITY 16
+
+
+
+/* -------------------------------------------------------------- */
+/*                    internal layer functions                    */
+/* -------------------------------------------------------------- */
+
+/**
+ * Orders render items by layer, then z, then queue order.
+ *
+ * Params:
+ *   const void* - a render item
+ *   const void* - another render item
+ *
+ * Returns:
+ *   int - a negative value if the first item is drawn first,
+ *         otherwise a positive value
+ */
+static int compare_items(const void* a, const void* b);
+
+/**
+ * Renders an entity group.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   void* - an entity group cast as void
+ */
+static void render_group(fl_context* context, void* target);
+
+/**
+ * Calculates the area in world coordinates covered by
+ * the entities assigned to a layer.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - a layer
+ *   fl_rect - a reference to a rect to receive the bounds
+ *
+ * Returns:
+ *   int - 1 if the layer contains any entities, otherwise 0
+ */
+static int layer_bounds(fl_context* context, int layer, fl_rect* bounds);
+
+/**
+ * Redraws the cached texture of a static layer.
+ * If the layer cannot be cached, its cache is released and the layer
+ * is drawn directly each frame instead.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - a layer
+ *   fl_render_item* - the queued items belonging to the layer
+ *   int - the number of items
+ */
+static void rebuild_cache(fl_context* context, int layer, fl_render_item* items, int count);
+
+/**
+ * Renders the world into the snapshot texture.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int capture_snapshot(fl_context* context);
+
+/**
+ * Draws a sequence of render items.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_render_item* - the render items
+ *   int - the number of items
+ */
+static void draw_items(fl_context* context, fl_render_item* items, int count);
+
+
+
+/* -------------------------------------------------------------- */
+/*             internal layer functions (implementation)          */
+/* -------------------------------------------------------------- */
+
+static int compare_items(const void* a, const void* b)
+{
+	const fl_render_item* x = (const fl_render_item*)a;
+	const fl_render_item* y = (const fl_render_item*)b;
+
+	if (x->layer != y->layer)
+		return x->layer < y->layer ? -1 : 1;
+
+	if (x->z != y->z)
+		return x->z < y->z ? -1 : 1;
+
+	/* Fall back to queue order so that the sort is stable. */
+	return x->seq < y->seq ? -1 : 1;
+}
+
+static void render_group(fl_context* context, void* target)
+{
+	int i;
+	fl_entity_group* group = (fl_entity_group*)target;
+	fl_entity_type* et = &(context->entity_types[group->type]);
+
+	/* Prefer the batch callback if the entity type has one,
+	   otherwise fall back to rendering each entity. */
+	if (et->render_all != NULL)
+	{
+		et->render_all(context, group->entities, group->count);
+	}
+	else if (et->render != NULL)
+	{
+		for (i = 0; i < group->count; i++)
+		{
+			fl_entity* en = group->entities[i];
+
+			if (en->flags & FLURMP_ALIVE_FLAG)
+				et->render(context, en);
+		}
+	}
+}
+
+static int layer_bounds(fl_context* context, int layer, fl_rect* bounds)
+{
+	int i, j;
+	int found = 0;
+	int left = 0, top = 0, right = 0, bottom = 0;
+
+	for (i = 0; i < FLURMP_ENTITY_TYPE_COUNT; i++)
+	{
+		fl_entity_type* et = &(context->entity_types[i]);
+		fl_entity_group* group = &(context->entity_groups[i]);
+
+		if (et->layer != layer)
+			continue;
+
+		for (j = 0; j < group->count; j++)
+		{
+			fl_entity* en = group->entities[j];
+
+			if (!found || en->x < left)
+				left = en->x;
+			if (!found || en->y < top)
+				top = en->y;
+			if (!found || en->x + et->w > right)
+				right = en->x + et->w;
+			if (!found || en->y + et->h > bottom)
+				bottom = en->y + et->h;
+
+			found = 1;
+		}
+	}
+
+	fl_set_rect(bounds, left, top, right - left, bottom - top);
+
+	return found && bounds->w > 0 && bounds->h > 0;
+}
+
+static void rebuild_cache(fl_context* context, int layer, fl_render_item* items, int count)
+{
+	fl_render_layer* rl = &(context->layers[layer]);
+	fl_texture* target;
+	fl_rect bounds;
+	int max_w;
+	int max_h;
+	int cam_x;
+	int cam_y;
+
+	rl->dirty = 0;
+
+	/* Release the cache if the layer is empty, or too large
+	   to fit in a single texture. */
+	fl_get_max_texture_size(context, &max_w, &max_h);
+
+	if (!layer_bounds(context, layer, &bounds) || bounds.w > max_w || bounds.h > max_h)
+	{
+		fl_destroy_texture(rl->cache);
+		rl->cache = NULL;
+		return;
+	}
+
+	/* Keep the existing texture if its size has not changed. */
+	if (rl->cache != NULL && (rl->bounds.w != bounds.w || rl->bounds.h != bounds.h))
+	{
+		fl_destroy_texture(rl->cache);
+		rl->cache = NULL;
+	}
+
+	if (rl->cache == NULL)
+		rl->cache = fl_create_target_texture(context, bounds.w, bounds.h);
+
+	rl->bounds = bounds;
+
+	/* The cache may be rebuilt while capturing a snapshot,
+	   so remember where to direct rendering afterward. */
+	target = fl_get_render_target(context);
+
+	if (rl->cache == NULL || !fl_set_render_target(context, rl->cache))
+	{
+		fl_destroy_texture(rl->cache);
+		rl->cache = NULL;
+		return;
+	}
+
+	/* Start from a transparent texture. */
+	fl_set_draw_color(context, 0, 0, 0, 0);
+	fl_render_clear(context);
+
+	/* Render callbacks draw relative to the camera, so move the
+	   camera to the corner of the cache while drawing into it. */
+	cam_x = context->cam_x;
+	cam_y = context->cam_y;
+	context->cam_x = bounds.x;
+	context->cam_y = bounds.y;
+
+	draw_items(context, items, count);
+
+	context->cam_x = cam_x;
+	context->cam_y = cam_y;
+
+	fl_set_render_target(context, target);
+}
+
+static int capture_snapshot(fl_context* context)
+{
+	fl_world_snapshot* snap = &(context->snapshot);
+
+	if (snap->texture == NULL)
+		snap->texture = fl_create_target_texture(context, FLURMP_WINDOW_WIDTH, FLURMP_WINDOW_HEIGHT);
+
+	if (snap->texture == NULL || !fl_set_render_target(context, snap->texture))
+		return 0;
+
+	/* The snapshot replaces the whole screen, background included. */
+	fl_set_draw_color(context, 145, 219, 255, 255);
+	fl_render_clear(context);
+
+	/* Only the world has been queued at this point,
+	   so flushing the queue draws nothing else. */
+	if (!fl_queue_entities(context) || !fl_queue_particles(context))
+	{
+		context->render_queue.count = 0;
+		fl_set_render_target(context, NULL);
+		return 0;
+	}
+
+	fl_flush_render_queue(context);
+	fl_set_render_target(context, NULL);
+
+	snap->valid = 1;
+	snap->cam_x = context->cam_x;
+	snap->cam_y = context->cam_y;
+
+	return 1;
+}
+
+static void draw_items(fl_context* context, fl_render_item* items, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		items[i].render(context, items[i].target);
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                      layer.h implementation                    */
+/* -------------------------------------------------------------- */
+
+void fl_init_layers(fl_context* context)
+{
+	int i;
+
+	for (i = 0; i < FLURMP_LAYER_COUNT; i++)
+	{
+		context->layers[i].is_static = 0;
+		context->layers[i].dirty = 1;
+		context->layers[i].cache = NULL;
+		fl_set_rect(&(context->layers[i].bounds), 0, 0, 0, 0);
+	}
+
+	/* Scenery does not move, so it only needs to be drawn once. */
+	context->layers[FLURMP_LAYER_SCENERY].is_static = 1;
+
+	context->render_queue.items = NULL;
+	context->render_queue.count = 0;
+	context->render_queue.capacity = 0;
+
+	context->snapshot.texture = NULL;
+	context->snapshot.valid = 0;
+	context->snapshot.cam_x = 0;
+	context->snapshot.cam_y = 0;
+}
+
+void fl_destroy_layers(fl_context* context)
+{
+	int i;
+
+	for (i = 0; i < FLURMP_LAYER_COUNT; i++)
+	{
+		fl_destroy_texture(context->layers[i].cache);
+		context->layers[i].cache = NULL;
+	}
+
+	fl_destroy_texture(context->snapshot.texture);
+	context->snapshot.texture = NULL;
+	context->snapshot.valid = 0;
+
+	if (context->render_queue.items != NULL)
+		fl_free(context->render_queue.items);
+
+	context->render_queue.items = NULL;
+	context->render_queue.count = 0;
+	context->render_queue.capacity = 0;
+}
+
+void fl_invalidate_layer(fl_context* context, int layer)
+{
+	if (layer < 0 || layer >= FLURMP_LAYER_COUNT)
+		return;
+
+	context->layers[layer].dirty = 1;
+}
+
+void fl_invalidate_layers(fl_context* context)
+{
+	int i;
+
+	for (i = 0; i < FLURMP_LAYER_COUNT; i++)
+		context->layers[i].dirty = 1;
+}
+
+void fl_invalidate_snapshot(fl_context* context)
+{
+	context->snapshot.valid = 0;
+}
+
+int fl_draw_snapshot(fl_context* context)
+{
+	fl_world_snapshot* snap = &(context->snapshot);
+
+	if (!snap->valid || snap->cam_x != context->cam_x || snap->cam_y != context->cam_y)
+	{
+		if (!capture_snapshot(context))
+			return 0;
+	}
+
+	fl_draw(context, snap->texture, NULL, NULL, 0);
+
+	return 1;
+}
+
+int fl_queue_render(fl_context* context, int layer, int z,
+	void(*render)(fl_context*, void*), void* target)
+{
+	fl_render_queue* queue = &(context->render_queue);
+	fl_render_item* item;
+
+	if (render == NULL || layer < 0 || layer >= FLURMP_LAYER_COUNT)
+		return 0;
+
+	/* Double the queue storage when it is full. */
+	if (queue->count >= queue->capacity)
+	{
+		int i;
+		int capacity = queue->capacity ? queue->capacity * 2 : INITIAL_QUEUE_CAPACITY;
+		fl_render_item* items = fl_alloc(fl_render_item, capacity);
+
+		if (items == NULL)
+			return 0;
+
+		for (i = 0; i < queue->count; i++)
+			items[i] = queue->items[i];
+
+		if (queue->items != NULL)
+			fl_free(queue->items);
+
+		queue->items = items;
+		queue->capacity = capacity;
+	}
+
+	item = &(queue->items[queue->count]);
+	item->layer = layer;
+	item->z = z;
+	item->seq = queue->count;
+	item->render = render;
+	item->target = target;
+
+	queue->count++;
+
+	return 1;
+}
+
+int fl_queue_entities(fl_context* context)
+{
+	int i;
+
+	for (i = 0; i < FLURMP_ENTITY_TYPE_COUNT; i++)
+	{
+		fl_entity_type* et = &(context->entity_types[i]);
+		fl_entity_group* group = &(context->entity_groups[i]);
+
+		if (group->count == 0 || (et->render_all == NULL && et->render == NULL))
+			continue;
+
+		if (!fl_queue_render(context, et->layer, et->z, render_group, group))
+			return 0;
+	}
+
+	return 1;
+}
+
+void fl_flush_render_queue(fl_context* context)
+{
+	fl_render_queue* queue = &(context->render_queue);
+	int i, j;
+
+	qsort(queue->items, queue->count, sizeof(fl_render_item), compare_items);
+
+	for (i = 0; i < queue->count; i = j)
+	{
+		int layer = queue->items[i].layer;
+		fl_render_layer* rl = &(context->layers[layer]);
+
+		/* Find the end of the current layer. */
+		for (j = i; j < queue->count && queue->items[j].layer == layer; j++);
+
+		if (!rl->is_static)
+		{
+			draw_items(context, queue->items + i, j - i);
+			continue;
+		}
+
+		if (rl->dirty)
+			rebuild_cache(context, layer, queue->items + i, j - i);
+
+		/* Composite the cache at the camera offset, or draw the
+		   layer directly if it could not be cached. */
+		if (rl->cache != NULL)
+		{
+			fl_rect dest;
+
+			fl_set_rect(&dest, rl->bounds.x - context->cam_x, rl->bounds.y - context->cam_y,
+				rl->bounds.w, rl->bounds.h);
+
+			fl_draw(context, rl->cache, NULL, &dest, 0);
+		}
+		else
+		{
+			draw_items(context, queue->items + i, j - i);
+		}
+	}
+
+	queue->count = 0;
+}
@@ -0,0 +1,314 @@
+#include "core/memory.h"
+
+/* maximum number of call sites listed in a leak report */
+#define LEAK_SITE_LIMIT 32
+
+/**
+ * The header placed in front of each tracked block.
+ * The union with long double keeps the memory that follows
+ * the header aligned as strictly as memory returned by malloc.
+ */
+typedef union block_header {
+	struct {
+		union block_header* prev;
+		union block_header* next;
+		const char* file;
+		size_t size;
+		int line;
+		int tag;
+	} info;
+	long double align;
+}block_header;
+
+/**
+ * A call site in a leak report.
+ */
+typedef struct leak_site {
+	const char* file;
+	int line;
+	int tag;
+	int blocks;
+	size_t bytes;
+}leak_site;
+
+/* names of the memory tags, indexed by tag */
+static const char* tag_names[FLURMP_MEMORY_TAG_COUNT] = {
+	"general",
+	"entity",
+	"schedule",
+	"menu",
+	"dialog",
+	"text",
+	"resource",
+	"audio",
+	"particle"
+};
+
+/* Blocks that have not been freed, most recent first. */
+static block_header* live_ = NULL;
+
+static fl_memory_stats stats_[FLURMP_MEMORY_TAG_COUNT];
+
+/* allocations per tag since the start of the current frame */
+static int frame_counts_[FLURMP_MEMORY_TAG_COUNT];
+
+/* guards the live list and the counts, which worker threads
+   update as well as the main thread */
+static fl_spinlock lock_ = 0;
+
+
+
+/* -------------------------------------------------------------- */
+/*                     internal memory functions                  */
+/* -------------------------------------------------------------- */
+
+/**
+ * Clamps a memory tag to the range of valid tags.
+ *
+ * Params:
+ *   int - a memory tag
+ *
+ * Returns:
+ *   int - the tag, or FLURMP_MEMORY_TAG_GENERAL if it is invalid
+ */
+static int valid_tag(int tag);
+
+/**
+ * Finds the entry for a call site in a leak report, adding it if
+ * there is room.
+ *
+ * Params:
+ *   leak_site* - the call sites found so far
+ *   int* - the number of call sites found so far
+ *   block_header - a leaked block
+ *
+ * Returns:
+ *   leak_site - the entry for the block's call site,
+ *               or NULL if the report is full
+ */
+static leak_site* find_site(leak_site* sites, int* count, block_header* block);
+
+
+
+/* -------------------------------------------------------------- */
+/*            internal memory functions (implementation)          */
+/* -------------------------------------------------------------- */
+
+static int valid_tag(int tag)
+{
+	return tag >= 0 && tag < FLURMP_MEMORY_TAG_COUNT ? tag : FLURMP_MEMORY_TAG_GENERAL;
+}
+
+static leak_site* find_site(leak_site* sites, int* count, block_header* block)
+{
+	int i;
+
+	for (i = 0; i < *count; i++)
+	{
+		if (sites[i].line == block->info.line && !strcmp(sites[i].file, block->info.file))
+			return &sites[i];
+	}
+
+	if (*count >= LEAK_SITE_LIMIT)
+		return NULL;
+
+	sites[*count].file = block->info.file;
+	sites[*count].line = block->info.line;
+	sites[*count].tag = block->info.tag;
+	sites[*count].blocks = 0;
+	sites[*count].bytes = 0;
+
+	return &sites[(*count)++];
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                     memory.h implementation                    */
+/* -------------------------------------------------------------- */
+
+const char* fl_memory_tag_name(int tag)
+{
+	return tag_names[valid_tag(tag)];
+}
+
+void fl_get_memory_stats(int tag, fl_memory_stats* stats)
+{
+	fl_lock_spin(&lock_);
+	*stats = stats_[valid_tag(tag)];
+	fl_unlock_spin(&lock_);
+}
+
+int fl_memory_frame_allocations()
+{
+	int i;
+	int total = 0;
+
+	fl_lock_spin(&lock_);
+
+	for (i = 0; i < FLURMP_MEMORY_TAG_COUNT; i++)
+		total += stats_[i].frame_allocations;
+
+	fl_unlock_spin(&lock_);
+
+	return total;
+}
+
+void fl_memory_frame()
+{
+	int i;
+
+	fl_lock_spin(&lock_);
+
+	for (i = 0; i < FLURMP_MEMORY_TAG_COUNT; i++)
+	{
+		stats_[i].frame_allocations = frame_counts_[i];
+		frame_counts_[i] = 0;
+	}
+
+	fl_unlock_spin(&lock_);
+}
+
+void fl_memory_report()
+{
+	int i;
+	fl_memory_stats stats[FLURMP_MEMORY_TAG_COUNT];
+
+	/* Print a copy rather than holding the lock while printing. */
+	fl_lock_spin(&lock_);
+	memcpy(stats, stats_, sizeof(stats));
+	fl_unlock_spin(&lock_);
+
+	printf("%-9s %10s %10s %7s %9s %6s\n", "tag", "live", "peak", "blocks", "allocs", "frame");
+
+	for (i = 0; i < FLURMP_MEMORY_TAG_COUNT; i++)
+	{
+		printf("%-9s %10lu %10lu %7d %9d %6d\n", tag_names[i],
+			(unsigned long)stats[i].live_bytes, (unsigned long)stats[i].peak_bytes,
+			stats[i].live_blocks, stats[i].allocations, stats[i].frame_allocations);
+	}
+}
+
+int fl_memory_report_leaks()
+{
+	leak_site sites[LEAK_SITE_LIMIT];
+	int site_count = 0;
+	int leaks = 0;
+	size_t bytes = 0;
+	block_header* block;
+	int i;
+
+	/* Leaks are reported once nothing else is running,
+	   but the list is still only walked under the lock. */
+	fl_lock_spin(&lock_);
+
+	for (block = live_; block != NULL; block = block->info.next)
+	{
+		leak_site* site = find_site(sites, &site_count, block);
+
+		if (site != NULL)
+		{
+			site->blocks++;
+			site->bytes += block->info.size;
+		}
+
+		leaks++;
+		bytes += block->info.size;
+	}
+
+	fl_unlock_spin(&lock_);
+
+	if (leaks == 0)
+		return 0;
+
+	printf("leaked %d blocks (%lu bytes):\n", leaks, (unsigned long)bytes);
+
+	for (i = 0; i < site_count; i++)
+	{
+		printf("  %s:%d (%s) %d blocks, %lu bytes\n", sites[i].file, sites[i].line,
+			tag_names[sites[i].tag], sites[i].blocks, (unsigned long)sites[i].bytes);
+	}
+
+	if (site_count == LEAK_SITE_LIMIT)
+		printf("  ... further call sites omitted\n");
+
+	return leaks;
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                   flurmp_impl.h implementation                 */
+/* -------------------------------------------------------------- */
+
+void* fl_allocate_(size_t s, int tag, const char* file, int line)
+{
+	block_header* block = malloc(sizeof(block_header) + s);
+	fl_memory_stats* stats;
+
+	if (block == NULL)
+		return NULL;
+
+	tag = valid_tag(tag);
+
+	block->info.file = file;
+	block->info.line = line;
+	block->info.size = s;
+	block->info.tag = tag;
+
+	fl_lock_spin(&lock_);
+
+	/* Push the block onto the live list. */
+	block->info.prev = NULL;
+	block->info.next = live_;
+
+	if (live_ != NULL)
+		live_->info.prev = block;
+
+	live_ = block;
+
+	stats = &stats_[tag];
+	stats->allocations++;
+	stats->live_blocks++;
+	stats->live_bytes += s;
+
+	if (stats->live_bytes > stats->peak_bytes)
+		stats->peak_bytes = stats->live_bytes;
+
+	frame_counts_[tag]++;
+
+	fl_unlock_spin(&lock_);
+
+	return block + 1;
+}
+
+void fl_free_(void* m)
+{
+	block_header* block;
+	fl_memory_stats* stats;
+
+	if (m == NULL)
+		return;
+
+	block = (block_header*)m - 1;
+
+	fl_lock_spin(&lock_);
+
+	/* Unlink the block from the live list. */
+	if (block->info.prev != NULL)
+		block->info.prev->info.next = block->info.next;
+	else
+		live_ = block->info.next;
+
+	if (block->info.next != NULL)
+		block->info.next->info.prev = block->info.prev;
+
+	stats = &stats_[block->info.tag];
+	stats->frees++;
+	stats->live_blocks--;
+	stats->live_bytes -= block->info.size;
+
+	fl_unlock_spin(&lock_);
+
+	free(block);
+}
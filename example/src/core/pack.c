@@ -0,0 +1,160 @@
+#include "core/pack.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* The mapping of the open pack, or NULL if no pack is open. */
+static const unsigned char* map_ = NULL;
+static size_t map_size_ = 0;
+
+/* The index of the open pack, sorted by name. */
+static const fl_pack_entry* entries_ = NULL;
+static int entry_count_ = 0;
+
+
+
+/* -------------------------------------------------------------- */
+/*                      internal pack functions                   */
+/* -------------------------------------------------------------- */
+
+/**
+ * Determines if a mapped file is a valid pack whose index and
+ * assets lie within the file.
+ *
+ * Params:
+ *   const unsigned char* - the contents of the file
+ *   size_t - the size of the file
+ *
+ * Returns:
+ *   int - 1 if the pack is valid, or 0 if it is not
+ */
+static int is_valid_pack(const unsigned char* data, size_t size);
+
+
+
+/* -------------------------------------------------------------- */
+/*             internal pack functions (implementation)           */
+/* -------------------------------------------------------------- */
+
+static int is_valid_pack(const unsigned char* data, size_t size)
+{
+	uint32_t i;
+	const fl_pack_header* header = (const fl_pack_header*)data;
+	const fl_pack_entry* entries = (const fl_pack_entry*)(header + 1);
+
+	if (size < sizeof(fl_pack_header) || memcmp(header->magic, FLURMP_PACK_MAGIC, 4))
+		return 0;
+
+	if (header->version != FLURMP_PACK_VERSION)
+		return 0;
+
+	if (header->count > (size - sizeof(fl_pack_header)) / sizeof(fl_pack_entry))
+		return 0;
+
+	for (i = 0; i < header->count; i++)
+	{
+		/* Names must be terminated for lookups to stay in bounds. */
+		if (entries[i].name[FLURMP_PACK_NAME_LENGTH - 1] != '\0')
+			return 0;
+
+		if (entries[i].offset > size || entries[i].size > size - entries[i].offset)
+			return 0;
+	}
+
+	return 1;
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                      pack.h implementation                     */
+/* -------------------------------------------------------------- */
+
+int fl_open_pack(const char* path)
+{
+	int fd;
+	struct stat st;
+	void* data;
+
+	fl_close_pack();
+
+	fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+		return 0;
+
+	if (fstat(fd, &st) || st.st_size <= 0)
+	{
+		close(fd);
+		return 0;
+	}
+
+	/* Pages are only read from disk when an asset in them is used. */
+	data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return 0;
+
+	if (!is_valid_pack(data, (size_t)st.st_size))
+	{
+		munmap(data, (size_t)st.st_size);
+		return 0;
+	}
+
+	map_ = data;
+	map_size_ = (size_t)st.st_size;
+	entry_count_ = (int)((const fl_pack_header*)map_)->count;
+	entries_ = (const fl_pack_entry*)(map_ + sizeof(fl_pack_header));
+
+	return 1;
+}
+
+void fl_close_pack()
+{
+	if (map_ != NULL)
+		munmap((void*)map_, map_size_);
+
+	map_ = NULL;
+	map_size_ = 0;
+	entries_ = NULL;
+	entry_count_ = 0;
+}
+
+const void* fl_find_asset(const char* name, size_t* size)
+{
+	int low = 0;
+	int high = entry_count_ - 1;
+
+	if (map_ == NULL || name == NULL)
+		return NULL;
+
+	/* The index is sorted, so search it in place. */
+	while (low <= high)
+	{
+		int mid = low + (high - low) / 2;
+		int cmp = strncmp(name, entries_[mid].name, FLURMP_PACK_NAME_LENGTH);
+
+		if (cmp == 0)
+		{
+			*size = entries_[mid].size;
+			return map_ + entries_[mid].offset;
+		}
+
+		if (cmp < 0)
+			high = mid - 1;
+		else
+			low = mid + 1;
+	}
+
+	return NULL;
+}
+
+int fl_is_packed(const void* data)
+{
+	const unsigned char* p = data;
+
+	return map_ != NULL && p >= map_ && p < map_ + map_size_;
+}
@@ -0,0 +1,536 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_PARTICLE
+
+#include "core/particle.h"
+#include "core/image.h"
+#include "core/layer.h"
+
+#include "entity/entity.h"
+
+/* room for particles in a pool when it is first used */
+#define INITIAL_PARTICLE_CAPACITY 256
+
+/* room for emitters when the first is added */
+#define INITIAL_EMITTER_CAPACITY 8
+
+/**
+ * What the particles of a kind look like and how they move.
+ * Velocities are in pixels per frame.
+ */
+typedef struct particle_kind {
+	int image;      /* an image registry index, or -1 for plain squares */
+	fl_rect src;    /* the part of the image drawn */
+	int size;       /* width and height in pixels */
+	fl_color color; /* multiplies the image, or fills the square */
+	float x_v;
+	float y_v;
+	float spread;   /* how far each velocity may stray either way */
+	float gravity;
+	int lifetime;   /* frames; particles fade out over their lives */
+	int layer;
+	int z;
+}particle_kind;
+
+/* indexed by kind */
+static const particle_kind kinds[FLURMP_PARTICLE_KIND_COUNT] = {
+	{ FLURMP_IMAGE_PELLET, { 0, 0, 20, 20 }, 6, { 255, 220, 120, 255 }, 0.0f, -2.0f, 3.0f, 0.25f, 30, FLURMP_LAYER_ENTITIES, 4 },
+	{ -1, { 0, 0, 0, 0 }, 4, { 220, 40, 40, 255 }, 0.0f, -3.0f, 2.5f, 0.3f, 40, FLURMP_LAYER_ENTITIES, 4 },
+	{ -1, { 0, 0, 0, 0 }, 3, { 255, 255, 255, 160 }, 0.0f, 0.0f, 0.4f, 0.0f, 15, FLURMP_LAYER_ENTITIES, 0 }
+};
+
+
+
+/* -------------------------------------------------------------- */
+/*                  internal particle functions                   */
+/* -------------------------------------------------------------- */
+
+/**
+ * Generates a pseudo-random number from 0 to 32767.
+ *
+ * Params:
+ *   unsigned int* - the state of the generator
+ *
+ * Returns:
+ *   unsigned int - the next number
+ */
+static unsigned int next_random(unsigned int* state);
+
+/**
+ * Gets a random velocity around a mean velocity.
+ *
+ * Params:
+ *   unsigned int* - the state of the generator
+ *   float - the mean velocity
+ *   float - how far the velocity may stray either way
+ *
+ * Returns:
+ *   float - a velocity
+ */
+static float random_velocity(unsigned int* state, float mean, float spread);
+
+/**
+ * Makes room for more particles in a pool.
+ *
+ * Params:
+ *   fl_particle_pool - a particle pool
+ *   int - the number of particles to make room for
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int grow_pool(fl_particle_pool* pool, int capacity);
+
+/**
+ * Frees the arrays of a pool.
+ *
+ * Params:
+ *   fl_particle_pool - a particle pool
+ */
+static void free_pool(fl_particle_pool* pool);
+
+/**
+ * Moves every particle in a pool and ages it by a frame.
+ *
+ * Params:
+ *   fl_particle_pool - a particle pool
+ *   float - the gravity of the kind
+ */
+static void integrate(fl_particle_pool* pool, float gravity);
+
+/**
+ * Removes the particles whose lives are over. The last particle
+ * takes the place of each one removed.
+ *
+ * Params:
+ *   fl_particle_pool - a particle pool
+ */
+static void remove_dead(fl_particle_pool* pool);
+
+/**
+ * Emits particles from the emitters, and removes the emitters
+ * that have finished or whose entities are gone.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+static void run_emitters(fl_context* context);
+
+/**
+ * Draws every particle in a pool as one batch of quads.
+ * This is a render queue callback.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   void* - a particle pool
+ */
+static void render_pool(fl_context* context, void* target);
+
+
+
+/* -------------------------------------------------------------- */
+/*           internal particle functions (implementation)         */
+/* -------------------------------------------------------------- */
+
+static unsigned int next_random(unsigned int* state)
+{
+	*state = *state * 1103515245u + 12345u;
+
+	return (*state >> 16) & 0x7FFF;
+}
+
+static float random_velocity(unsigned int* state, float mean, float spread)
+{
+	return mean + spread * ((float)next_random(state) / 16383.5f - 1.0f);
+}
+
+static int grow_pool(fl_particle_pool* pool, int capacity)
+{
+	int i;
+	fl_particle_pool grown = *pool;
+
+	grown.x = fl_alloc(float, capacity);
+	grown.y = fl_alloc(float, capacity);
+	grown.x_v = fl_alloc(float, capacity);
+	grown.y_v = fl_alloc(float, capacity);
+	grown.life = fl_alloc(float, capacity);
+	grown.vertices = fl_alloc(fl_vertex, capacity * 4);
+	grown.indices = fl_alloc(int, capacity * 6);
+	grown.capacity = capacity;
+
+	if (grown.x == NULL || grown.y == NULL || grown.x_v == NULL || grown.y_v == NULL
+		|| grown.life == NULL || grown.vertices == NULL || grown.indices == NULL)
+	{
+		free_pool(&grown);
+		return 0;
+	}
+
+	if (pool->count > 0)
+	{
+		memcpy(grown.x, pool->x, sizeof(float) * pool->count);
+		memcpy(grown.y, pool->y, sizeof(float) * pool->count);
+		memcpy(grown.x_v, pool->x_v, sizeof(float) * pool->count);
+		memcpy(grown.y_v, pool->y_v, sizeof(float) * pool->count);
+		memcpy(grown.life, pool->life, sizeof(float) * pool->count);
+	}
+
+	/* Two triangles per quad: top left, top right, bottom right
+	   and top left, bottom right, bottom left. */
+	for (i = 0; i < capacity; i++)
+	{
+		grown.indices[i * 6] = i * 4;
+		grown.indices[i * 6 + 1] = i * 4 + 1;
+		grown.indices[i * 6 + 2] = i * 4 + 2;
+		grown.indices[i * 6 + 3] = i * 4;
+		grown.indices[i * 6 + 4] = i * 4 + 2;
+		grown.indices[i * 6 + 5] = i * 4 + 3;
+	}
+
+	free_pool(pool);
+	*pool = grown;
+
+	return 1;
+}
+
+static void free_pool(fl_particle_pool* pool)
+{
+	fl_free(pool->x);
+	fl_free(pool->y);
+	fl_free(pool->x_v);
+	fl_free(pool->y_v);
+	fl_free(pool->life);
+	fl_free(pool->vertices);
+	fl_free(pool->indices);
+}
+
+static void integrate(fl_particle_pool* pool, float gravity)
+{
+	int i;
+	int count = pool->count;
+	float* x = pool->x;
+	float* y = pool->y;
+	float* x_v = pool->x_v;
+	float* y_v = pool->y_v;
+	float* life = pool->life;
+
+	/* Every particle is treated the same, with nothing to branch on,
+	   so the compiler vectorizes the loop. */
+	for (i = 0; i < count; i++)
+	{
+		y_v[i] += gravity;
+		x[i] += x_v[i];
+		y[i] += y_v[i];
+		life[i] -= 1.0f;
+	}
+}
+
+static void remove_dead(fl_particle_pool* pool)
+{
+	int i = 0;
+	int last;
+
+	while (i < pool->count)
+	{
+		if (pool->life[i] > 0.0f)
+		{
+			i++;
+			continue;
+		}
+
+		last = --pool->count;
+		pool->x[i] = pool->x[last];
+		pool->y[i] = pool->y[last];
+		pool->x_v[i] = pool->x_v[last];
+		pool->y_v[i] = pool->y_v[last];
+		pool->life[i] = pool->life[last];
+	}
+}
+
+static void run_emitters(fl_context* context)
+{
+	int i = 0;
+	int count;
+	fl_particle_system* ps = &(context->particles);
+	fl_particle_emitter* em;
+	fl_entity* target;
+
+	while (i < ps->emitter_count)
+	{
+		em = &ps->emitters[i];
+		target = fl_get_entity(context, em->target);
+
+		/* The last emitter takes the place of one that is done. */
+		if (target == NULL || em->frames == 0)
+		{
+			*em = ps->emitters[--ps->emitter_count];
+			continue;
+		}
+
+		em->pending += em->rate;
+		count = (int)em->pending;
+		em->pending -= (float)count;
+
+		if (count > 0)
+		{
+			fl_emit_particles(context, em->kind,
+				target->x + context->entity_types[target->type].w / 2,
+				target->y + context->entity_types[target->type].h / 2, count);
+		}
+
+		if (em->frames > 0)
+			em->frames--;
+
+		i++;
+	}
+}
+
+static void render_pool(fl_context* context, void* target)
+{
+	int i;
+	fl_particle_pool* pool = (fl_particle_pool*)target;
+	const particle_kind* k = &kinds[pool->kind];
+	fl_vertex* v = pool->vertices;
+	fl_texture* tex = NULL;
+	fl_image* img;
+	float half = k->size / 2.0f;
+	float size = (float)k->size;
+	float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+	fl_color color = k->color;
+
+	/* Without its image, a kind is drawn as plain squares. */
+	if (k->image >= 0 && context->images[k->image] != NULL)
+	{
+		img = context->images[k->image]->impl.image;
+		tex = img->texture;
+		u0 = (float)k->src.x / img->w;
+		v0 = (float)k->src.y / img->h;
+		u1 = (float)(k->src.x + k->src.w) / img->w;
+		v1 = (float)(k->src.y + k->src.h) / img->h;
+	}
+
+	for (i = 0; i < pool->count; i++, v += 4)
+	{
+		/* Particles fade out over their lives. */
+		color.a = (unsigned char)(k->color.a * pool->life[i] / k->lifetime);
+
+		v[0].position.x = pool->x[i] - context->cam_x - half;
+		v[0].position.y = pool->y[i] - context->cam_y - half;
+		v[1].position.x = v[0].position.x + size;
+		v[1].position.y = v[0].position.y;
+		v[2].position.x = v[1].position.x;
+		v[2].position.y = v[0].position.y + size;
+		v[3].position.x = v[0].position.x;
+		v[3].position.y = v[2].position.y;
+
+		v[0].tex_coord.x = u0;
+		v[0].tex_coord.y = v0;
+		v[1].tex_coord.x = u1;
+		v[1].tex_coord.y = v0;
+		v[2].tex_coord.x = u1;
+		v[2].tex_coord.y = v1;
+		v[3].tex_coord.x = u0;
+		v[3].tex_coord.y = v1;
+
+		v[0].color = color;
+		v[1].color = color;
+		v[2].color = color;
+		v[3].color = color;
+	}
+
+	fl_draw_geometry(context, tex, pool->vertices, pool->count * 4, pool->indices, pool->count * 6);
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                    particle.h implementation                   */
+/* -------------------------------------------------------------- */
+
+int fl_create_particles(fl_context* context)
+{
+	int i;
+	fl_particle_system* ps = &(context->particles);
+
+	ps->pools = fl_alloc(fl_particle_pool, FLURMP_PARTICLE_KIND_COUNT);
+	ps->pool_count = 0;
+	ps->emitters = NULL;
+	ps->emitter_count = 0;
+	ps->emitter_capacity = 0;
+	ps->seed = 1;
+
+	if (ps->pools == NULL)
+		return 0;
+
+	/* The arrays of a pool are allocated when it is first used. */
+	for (i = 0; i < FLURMP_PARTICLE_KIND_COUNT; i++)
+	{
+		ps->pools[i].kind = i;
+		ps->pools[i].x = NULL;
+		ps->pools[i].y = NULL;
+		ps->pools[i].x_v = NULL;
+		ps->pools[i].y_v = NULL;
+		ps->pools[i].life = NULL;
+		ps->pools[i].vertices = NULL;
+		ps->pools[i].indices = NULL;
+		ps->pools[i].count = 0;
+		ps->pools[i].capacity = 0;
+	}
+
+	ps->pool_count = FLURMP_PARTICLE_KIND_COUNT;
+
+	return 1;
+}
+
+void fl_destroy_particles(fl_context* context)
+{
+	int i;
+	fl_particle_system* ps = &(context->particles);
+
+	for (i = 0; i < ps->pool_count; i++)
+		free_pool(&ps->pools[i]);
+
+	fl_free(ps->pools);
+	fl_free(ps->emitters);
+
+	ps->pools = NULL;
+	ps->pool_count = 0;
+	ps->emitters = NULL;
+	ps->emitter_count = 0;
+	ps->emitter_capacity = 0;
+}
+
+void fl_clear_particles(fl_context* context)
+{
+	int i;
+	fl_particle_system* ps = &(context->particles);
+
+	for (i = 0; i < ps->pool_count; i++)
+		ps->pools[i].count = 0;
+
+	ps->emitter_count = 0;
+}
+
+int fl_emit_particles(fl_context* context, int kind, int x, int y, int count)
+{
+	int i;
+	int n;
+	int capacity;
+	fl_particle_system* ps = &(context->particles);
+	fl_particle_pool* pool;
+	const particle_kind* k;
+
+	if (kind < 0 || kind >= ps->pool_count || count <= 0)
+		return 0;
+
+	pool = &ps->pools[kind];
+	k = &kinds[kind];
+
+	if (count > FLURMP_PARTICLE_LIMIT - pool->count)
+		count = FLURMP_PARTICLE_LIMIT - pool->count;
+
+	/* Make room for the particles. */
+	if (pool->count + count > pool->capacity)
+	{
+		capacity = pool->capacity > 0 ? pool->capacity : INITIAL_PARTICLE_CAPACITY;
+
+		while (capacity < pool->count + count)
+			capacity *= 2;
+
+		if (capacity > FLURMP_PARTICLE_LIMIT)
+			capacity = FLURMP_PARTICLE_LIMIT;
+
+		if (!grow_pool(pool, capacity))
+			return 0;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		n = pool->count++;
+		pool->x[n] = (float)x;
+		pool->y[n] = (float)y;
+		pool->x_v[n] = random_velocity(&ps->seed, k->x_v, k->spread);
+		pool->y_v[n] = random_velocity(&ps->seed, k->y_v, k->spread);
+		pool->life[n] = (float)k->lifetime;
+	}
+
+	return count;
+}
+
+int fl_add_emitter(fl_context* context, int kind, fl_handle target, float rate, int frames)
+{
+	int i;
+	fl_particle_system* ps = &(context->particles);
+	fl_particle_emitter* em;
+
+	if (kind < 0 || kind >= ps->pool_count)
+		return 0;
+
+	/* Make room for one more emitter. */
+	if (ps->emitter_count >= ps->emitter_capacity)
+	{
+		int capacity = ps->emitter_capacity > 0 ? ps->emitter_capacity * 2 : INITIAL_EMITTER_CAPACITY;
+		fl_particle_emitter* emitters = fl_alloc(fl_particle_emitter, capacity);
+
+		if (emitters == NULL)
+			return 0;
+
+		for (i = 0; i < ps->emitter_count; i++)
+			emitters[i] = ps->emitters[i];
+
+		fl_free(ps->emitters);
+		ps->emitters = emitters;
+		ps->emitter_capacity = capacity;
+	}
+
+	em = &ps->emitters[ps->emitter_count++];
+	em->kind = kind;
+	em->target = target;
+	em->rate = rate;
+	em->pending = 0.0f;
+	em->frames = frames;
+
+	return 1;
+}
+
+void fl_update_particles(fl_context* context)
+{
+	int i;
+	fl_particle_system* ps = &(context->particles);
+
+	run_emitters(context);
+
+	for (i = 0; i < ps->pool_count; i++)
+	{
+		if (ps->pools[i].count == 0)
+			continue;
+
+		integrate(&ps->pools[i], kinds[i].gravity);
+		remove_dead(&ps->pools[i]);
+	}
+}
+
+int fl_queue_particles(fl_context* context)
+{
+	int i;
+	fl_particle_system* ps = &(context->particles);
+
+	for (i = 0; i < ps->pool_count; i++)
+	{
+		if (ps->pools[i].count == 0)
+			continue;
+
+		if (!fl_queue_render(context, kinds[i].layer, kinds[i].z, render_pool, &ps->pools[i]))
+			return 0;
+	}
+
+	return 1;
+}
+
+int fl_get_particle_count(fl_context* context)
+{
+	int i;
+	int count = 0;
+
+	for (i = 0; i < context->particles.pool_count; i++)
+		count += context->particles.pools[i].count;
+
+	return count;
+}
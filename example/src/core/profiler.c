@@ -0,0 +1,113 @@
+#include "core/profiler.h"
+
+/* names of the profiled sections, indexed by section */
+static const char* section_names[FLURMP_PROFILE_SECTIONS] = {
+	"update",
+	"render"
+};
+
+
+
+/* -------------------------------------------------------------- */
+/*                    internal profiler functions                 */
+/* -------------------------------------------------------------- */
+
+/**
+ * Converts performance counter ticks to microseconds.
+ *
+ * Params:
+ *   unsigned long long - a number of ticks
+ *
+ * Returns:
+ *   unsigned int - the number of microseconds
+ */
+static unsigned int to_microseconds(unsigned long long ticks);
+
+
+
+/* -------------------------------------------------------------- */
+/*          internal profiler functions (implementation)          */
+/* -------------------------------------------------------------- */
+
+static unsigned int to_microseconds(unsigned long long ticks)
+{
+	return (unsigned int)(ticks * 1000000ULL / fl_get_performance_frequency());
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                    profiler.h implementation                   */
+/* -------------------------------------------------------------- */
+
+void fl_profile_begin(fl_context* context)
+{
+	if (!context->profiler.enabled)
+		return;
+
+	context->profiler.start = fl_get_performance_counter();
+}
+
+void fl_profile_end(fl_context* context, int section)
+{
+	fl_profiler* profiler = &context->profiler;
+	unsigned long long elapsed;
+
+	if (!profiler->enabled || section < 0 || section >= FLURMP_PROFILE_SECTIONS)
+		return;
+
+	elapsed = fl_get_performance_counter() - profiler->start;
+
+	profiler->total[section] += elapsed;
+	profiler->samples[section]++;
+
+	if (elapsed > profiler->peak[section])
+		profiler->peak[section] = elapsed;
+}
+
+unsigned int fl_profile_average(fl_context* context, int section)
+{
+	fl_profiler* profiler = &context->profiler;
+
+	if (section < 0 || section >= FLURMP_PROFILE_SECTIONS || profiler->samples[section] == 0)
+		return 0;
+
+	return to_microseconds(profiler->total[section] / profiler->samples[section]);
+}
+
+unsigned int fl_profile_peak(fl_context* context, int section)
+{
+	if (section < 0 || section >= FLURMP_PROFILE_SECTIONS)
+		return 0;
+
+	return to_microseconds(context->profiler.peak[section]);
+}
+
+void fl_profile_report(fl_context* context)
+{
+	int i;
+
+	printf("frame profile (%s)\n", context->profiler.enabled ? "running" : "stopped");
+
+	for (i = 0; i < FLURMP_PROFILE_SECTIONS; i++)
+	{
+		printf("  %-8s samples: %lu avg: %u us peak: %u us\n", section_names[i],
+			context->profiler.samples[i],
+			fl_profile_average(context, i),
+			fl_profile_peak(context, i));
+	}
+}
+
+void fl_profile_reset(fl_context* context)
+{
+	int i;
+
+	for (i = 0; i < FLURMP_PROFILE_SECTIONS; i++)
+	{
+		context->profiler.total[i] = 0;
+		context->profiler.peak[i] = 0;
+		context->profiler.samples[i] = 0;
+	}
+
+	context->profiler.start = 0;
+}
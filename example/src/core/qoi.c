@@ -0,0 +1,319 @@
+#include "core/qoi.h"
+#include "core/image_format.h"
+
+#include <string.h>
+
+#define QOI_HEADER_SIZE 14
+#define QOI_END_SIZE    8
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xc0
+#define QOI_OP_RGB   0xfe
+#define QOI_OP_RGBA  0xff
+#define QOI_OP_MASK  0xc0
+
+/* longest run a single op can hold */
+#define QOI_RUN_LIMIT 62
+
+#define QOI_HASH(p) (((p).r * 3 + (p).g * 5 + (p).b * 7 + (p).a * 11) & 63)
+
+/**
+ * A pixel as QOI sees it, with straight alpha.
+ */
+typedef struct qoi_pixel {
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char a;
+}qoi_pixel;
+
+
+
+/* -------------------------------------------------------------- */
+/*                      internal qoi functions                    */
+/* -------------------------------------------------------------- */
+
+/**
+ * Packs a pixel into an RGBA8888 value with its color premultiplied.
+ *
+ * Params:
+ *   qoi_pixel - a pixel
+ *
+ * Returns:
+ *   uint32_t - the premultiplied pixel
+ */
+static uint32_t premultiply(qoi_pixel p);
+
+/**
+ * Reads a big endian 32-bit number.
+ */
+static uint32_t read_32(const unsigned char* data);
+
+/**
+ * Writes a big endian 32-bit number.
+ */
+static void write_32(unsigned char* out, uint32_t value);
+
+
+
+/* -------------------------------------------------------------- */
+/*              internal qoi functions (implementation)           */
+/* -------------------------------------------------------------- */
+
+static uint32_t premultiply(qoi_pixel p)
+{
+	uint32_t r = p.r;
+	uint32_t g = p.g;
+	uint32_t b = p.b;
+	uint32_t t;
+
+	/* Sprites are mostly opaque or fully transparent. */
+	if (p.a == 255)
+		return (r << 24) | (g << 16) | (b << 8) | 255;
+
+	if (p.a == 0)
+		return 0;
+
+	/* Divide by 255 with rounding, without dividing. */
+	t = r * p.a + 128; r = (t + (t >> 8)) >> 8;
+	t = g * p.a + 128; g = (t + (t >> 8)) >> 8;
+	t = b * p.a + 128; b = (t + (t >> 8)) >> 8;
+
+	return (r << 24) | (g << 16) | (b << 8) | p.a;
+}
+
+static uint32_t read_32(const unsigned char* data)
+{
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16)
+		| ((uint32_t)data[2] << 8) | data[3];
+}
+
+static void write_32(unsigned char* out, uint32_t value)
+{
+	out[0] = (unsigned char)(value >> 24);
+	out[1] = (unsigned char)(value >> 16);
+	out[2] = (unsigned char)(value >> 8);
+	out[3] = (unsigned char)value;
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                      qoi.h implementation                      */
+/* -------------------------------------------------------------- */
+
+int fl_qoi_size(const unsigned char* data, size_t size, int* w, int* h)
+{
+	uint32_t width;
+	uint32_t height;
+
+	if (size < QOI_HEADER_SIZE + QOI_END_SIZE || memcmp(data, "qoif", 4))
+		return 0;
+
+	width = read_32(data + 4);
+	height = read_32(data + 8);
+
+	if (width == 0 || height == 0)
+		return 0;
+
+	if (width > FLURMP_IMAGE_SIZE_LIMIT || height > FLURMP_IMAGE_SIZE_LIMIT)
+		return 0;
+
+	*w = (int)width;
+	*h = (int)height;
+
+	return 1;
+}
+
+int fl_decode_qoi(const unsigned char* data, size_t size, uint32_t* pixels)
+{
+	int w;
+	int h;
+	size_t i;
+	size_t count;
+	size_t p = QOI_HEADER_SIZE;
+	size_t end;
+	qoi_pixel index[64];
+	qoi_pixel px = { 0, 0, 0, 255 };
+	uint32_t value = 255;
+
+	if (!fl_qoi_size(data, size, &w, &h))
+		return 0;
+
+	memset(index, 0, sizeof(index));
+	count = (size_t)w * (size_t)h;
+	end = size - QOI_END_SIZE;
+
+	for (i = 0; i < count;)
+	{
+		unsigned char op;
+
+		if (p >= end)
+			return 0;
+
+		op = data[p++];
+
+		if (op == QOI_OP_RGB || op == QOI_OP_RGBA)
+		{
+			if (end - p < (size_t)(op == QOI_OP_RGB ? 3 : 4))
+				return 0;
+
+			px.r = data[p++];
+			px.g = data[p++];
+			px.b = data[p++];
+
+			if (op == QOI_OP_RGBA)
+				px.a = data[p++];
+		}
+		else if ((op & QOI_OP_MASK) == QOI_OP_INDEX)
+		{
+			px = index[op];
+		}
+		else if ((op & QOI_OP_MASK) == QOI_OP_DIFF)
+		{
+			px.r = (unsigned char)(px.r + ((op >> 4) & 3) - 2);
+			px.g = (unsigned char)(px.g + ((op >> 2) & 3) - 2);
+			px.b = (unsigned char)(px.b + (op & 3) - 2);
+		}
+		else if ((op & QOI_OP_MASK) == QOI_OP_LUMA)
+		{
+			int dg;
+			unsigned char next;
+
+			if (p >= end)
+				return 0;
+
+			next = data[p++];
+			dg = (op & 0x3f) - 32;
+
+			px.r = (unsigned char)(px.r + dg - 8 + ((next >> 4) & 0x0f));
+			px.g = (unsigned char)(px.g + dg);
+			px.b = (unsigned char)(px.b + dg - 8 + (next & 0x0f));
+		}
+		else
+		{
+			/* A run repeats the previous pixel, which is already
+			   premultiplied, so runs cost nothing but the stores. */
+			size_t run = (size_t)(op & 0x3f) + 1;
+
+			if (run > count - i)
+				return 0;
+
+			while (run--)
+				pixels[i++] = value;
+
+			continue;
+		}
+
+		index[QOI_HASH(px)] = px;
+		value = premultiply(px);
+		pixels[i++] = value;
+	}
+
+	return 1;
+}
+
+size_t fl_encode_qoi(const uint32_t* pixels, int w, int h, unsigned char* out)
+{
+	size_t i;
+	size_t count = (size_t)w * (size_t)h;
+	size_t p = 0;
+	int run = 0;
+	qoi_pixel index[64];
+	qoi_pixel prev = { 0, 0, 0, 255 };
+
+	memset(index, 0, sizeof(index));
+
+	memcpy(out, "qoif", 4);
+	write_32(out + 4, (uint32_t)w);
+	write_32(out + 8, (uint32_t)h);
+	out[12] = 4; /* RGBA */
+	out[13] = 0; /* sRGB with linear alpha */
+	p = QOI_HEADER_SIZE;
+
+	for (i = 0; i < count; i++)
+	{
+		qoi_pixel px;
+		int hash;
+
+		px.r = (unsigned char)(pixels[i] >> 24);
+		px.g = (unsigned char)(pixels[i] >> 16);
+		px.b = (unsigned char)(pixels[i] >> 8);
+		px.a = (unsigned char)pixels[i];
+
+		if (!memcmp(&px, &prev, sizeof(px)))
+		{
+			run++;
+
+			if (run == QOI_RUN_LIMIT || i == count - 1)
+			{
+				out[p++] = (unsigned char)(QOI_OP_RUN | (run - 1));
+				run = 0;
+			}
+
+			continue;
+		}
+
+		if (run > 0)
+		{
+			out[p++] = (unsigned char)(QOI_OP_RUN | (run - 1));
+			run = 0;
+		}
+
+		hash = QOI_HASH(px);
+
+		if (!memcmp(&index[hash], &px, sizeof(px)))
+		{
+			out[p++] = (unsigned char)(QOI_OP_INDEX | hash);
+		}
+		else
+		{
+			index[hash] = px;
+
+			if (px.a == prev.a)
+			{
+				signed char dr = (signed char)(px.r - prev.r);
+				signed char dg = (signed char)(px.g - prev.g);
+				signed char db = (signed char)(px.b - prev.b);
+				signed char dr_dg = (signed char)(dr - dg);
+				signed char db_dg = (signed char)(db - dg);
+
+				if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+				{
+					out[p++] = (unsigned char)(QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+				}
+				else if (dr_dg >= -8 && dr_dg <= 7 && dg >= -32 && dg <= 31 && db_dg >= -8 && db_dg <= 7)
+				{
+					out[p++] = (unsigned char)(QOI_OP_LUMA | (dg + 32));
+					out[p++] = (unsigned char)(((dr_dg + 8) << 4) | (db_dg + 8));
+				}
+				else
+				{
+					out[p++] = QOI_OP_RGB;
+					out[p++] = px.r;
+					out[p++] = px.g;
+					out[p++] = px.b;
+				}
+			}
+			else
+			{
+				out[p++] = QOI_OP_RGBA;
+				out[p++] = px.r;
+				out[p++] = px.g;
+				out[p++] = px.b;
+				out[p++] = px.a;
+			}
+		}
+
+		prev = px;
+	}
+
+	/* end marker */
+	memset(out + p, 0, QOI_END_SIZE - 1);
+	p += QOI_END_SIZE - 1;
+	out[p++] = 1;
+
+	return p;
+}
@@ -1,17 +1,111 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_RESOURCE
+
 #include "core/resource.h"
+#include "core/font_format.h"
+#include "core/image_format.h"
 #include "core/text.h"
 
+/* longest path that a baked image or font is looked for under */
+#define BAKED_PATH_LENGTH 256
+
+/* whether fonts are loaded from their bakes when there are any */
+static int baked_fonts_ = 1;
+
+
+
+/* -------------------------------------------------------------- */
+/*                    internal resource functions                 */
+/* -------------------------------------------------------------- */
+
+/**
+ * Replaces the extension of a path.
+ *
+ * Params:
+ *   char* - receives the new path; BAKED_PATH_LENGTH bytes long
+ *   const char* - a path
+ *   const char* - the new extension, including the dot
+ *
+ * Returns:
+ *   int - 1 on success, or 0 if the new path is too long
+ */
+static int replace_extension(char* out, const char* path, const char* extension);
+
+
+
+
+/* -------------------------------------------------------------- */
+/*            internal resource functions (implementation)        */
+/* -------------------------------------------------------------- */
+
+static int replace_extension(char* out, const char* path, const char* extension)
+{
+	const char* dot = strrchr(path, '.');
+	size_t length;
+
+	/* Only a dot in the file name starts an extension. */
+	if (dot == NULL || strchr(dot, '/') != NULL)
+		length = strlen(path);
+	else
+		length = (size_t)(dot - path);
+
+	if (length + strlen(extension) >= BAKED_PATH_LENGTH)
+		return 0;
+
+	memcpy(out, path, length);
+	strcpy(out + length, extension);
+
+	return 1;
+}
+
+
+
+
+/* -------------------------------------------------------------- */
+/*                    resource.h implementation                   */
+/* -------------------------------------------------------------- */
+
 fl_resource* fl_load_image(fl_context* context, const char* path)
+{
+	fl_surface* pixels = fl_prepare_image(path);
+	fl_resource* resource = fl_finish_image(context, pixels);
+
+	fl_destroy_surface(pixels);
+
+	return resource;
+}
+
+fl_surface* fl_prepare_image(const char* path)
+{
+	char baked[BAKED_PATH_LENGTH];
+	fl_surface* pixels;
+
+	/* Baked images skip the conversion and color keying
+	   that loading a bmp does, so try them first. */
+	if (replace_extension(baked, path, FLURMP_BAKED_EXTENSION)
+		&& (pixels = fl_decode_image(baked)) != NULL)
+		return pixels;
+
+	if (replace_extension(baked, path, FLURMP_QOI_EXTENSION)
+		&& (pixels = fl_decode_image(baked)) != NULL)
+		return pixels;
+
+	return fl_decode_image(path);
+}
+
+fl_resource* fl_finish_image(fl_context* context, fl_surface* pixels)
 {
 	fl_resource* resource;
 	fl_image* image;
 
+	if (pixels == NULL)
+		return NULL;
+
 	image = fl_alloc(fl_image, 1);
 
 	if (image == NULL)
 		return NULL;
 
-	if (!fl_load_bmp(context, path, image))
+	if (!fl_upload_image(context, pixels, image))
 	{
 		fl_free(image);
 		return NULL;
@@ -31,43 +125,96 @@ fl_resource* fl_load_image(fl_context* context, const char* path)
 	return resource;
 }
 
-fl_resource* fl_load_font(const char* path, int p, fl_color fc, fl_color bc, int background)
+fl_resource* fl_load_font(fl_context* context, const char* path, int p, fl_color fc, fl_color bc, int background)
+{
+	fl_surface* atlas;
+	fl_resource* resource = fl_prepare_font(path, p, fc, bc, background, &atlas);
+	int ok;
+
+	if (resource == NULL)
+		return NULL;
+
+	ok = fl_finish_font(context, resource, atlas);
+	fl_destroy_surface(atlas);
+
+	if (!ok)
+	{
+		fl_destroy_resource(resource);
+		return NULL;
+	}
+
+	return resource;
+}
+
+fl_resource* fl_prepare_font(const char* path, int p, fl_color fc, fl_color bc, int background, fl_surface** atlas)
 {
 	if (path == NULL)
 		return NULL;
 
 	fl_resource* resource;
 	fl_font* font;
-	fl_ttf* impl;
+	char suffix[32];
+	char metrics[BAKED_PATH_LENGTH];
+	char pixels[BAKED_PATH_LENGTH];
+	int baked;
+
+	*atlas = NULL;
 
 	resource = fl_alloc(fl_resource, 1);
 
 	if (resource == NULL)
 		return NULL;
 
-	impl = fl_load_ttf(path, p);
+	font = fl_alloc(fl_font, 1);
 
-	if (impl == NULL)
+	if (font == NULL)
 	{
 		fl_free(resource);
 		return NULL;
 	}
 
-	font = fl_alloc(fl_font, 1);
+	font->impl = NULL;
+	font->path = fl_alloc(char, strlen(path) + 1);
+	font->size = p;
+	font->buckets = NULL;
+	font->page_count = 0;
+	font->baked = NULL;
+	font->baked_glyphs = NULL;
+	font->baked_count = 0;
+	font->clock = 0;
+	font->forecolor = fc;
+	font->backcolor = bc;
+	font->background = background;
 
-	if (font == NULL)
+	if (font->path == NULL)
 	{
+		fl_free(font);
 		fl_free(resource);
-		fl_close_ttf(impl);
 		return NULL;
 	}
 
-	font->impl = impl;
-	font->count = 0;
-	font->glyphs = NULL;
-	font->forecolor = fc;
-	font->backcolor = bc;
-	font->background = background;
+	strcpy(font->path, path);
+
+	/* A bake is named after the TTF and the size, and spares
+	   opening the TTF until a glyph that wasn't baked is drawn. */
+	snprintf(suffix, sizeof(suffix), "-%d%s", p, FLURMP_BAKED_FONT_EXTENSION);
+	baked = baked_fonts_ && replace_extension(metrics, path, suffix);
+
+	snprintf(suffix, sizeof(suffix), "-%d%s", p, FLURMP_BAKED_EXTENSION);
+	baked = baked && replace_extension(pixels, path, suffix);
+
+	baked = baked && fl_read_baked_glyphs(font, metrics, pixels, atlas);
+
+	if (!baked)
+		font->impl = fl_load_ttf(path, p);
+
+	if (!baked && font->impl == NULL)
+	{
+		fl_free(font->path);
+		fl_free(font);
+		fl_free(resource);
+		return NULL;
+	}
 
 	resource->impl.font = font;
 	resource->type = FLURMP_FONT_RESOURCE;
@@ -75,6 +222,24 @@ fl_resource* fl_load_font(const char* path, int p, fl_color fc, fl_color bc, int
 	return resource;
 }
 
+int fl_finish_font(fl_context* context, fl_resource* resource, fl_surface* atlas)
+{
+	fl_font* font = resource->impl.font;
+
+	if (atlas == NULL || fl_upload_baked_glyphs(context, font, atlas))
+		return 1;
+
+	/* Without its baked glyphs, the font is drawn from the TTF. */
+	font->impl = fl_load_ttf(font->path, font->size);
+
+	return font->impl != NULL;
+}
+
+void fl_use_baked_fonts(int enabled)
+{
+	baked_fonts_ = enabled;
+}
+
 void fl_destroy_resource(fl_resource* resource)
 {
 	if (resource == NULL)
@@ -89,14 +254,10 @@ void fl_destroy_resource(fl_resource* resource)
 			if (resource->impl.font->impl != NULL)
 				fl_close_ttf(resource->impl.font->impl);
 
-			if (resource->impl.font->glyphs != NULL)
-			{
-				int i;
-				for (i = 0; i < resource->impl.font->count; i++)
-					fl_destroy_image(resource->impl.font->glyphs[i]);
+			fl_destroy_glyph_cache(resource->impl.font);
 
-				fl_free(resource->impl.font->glyphs);
-			}
+			if (resource->impl.font->path != NULL)
+				fl_free(resource->impl.font->path);
 
 			fl_free(resource->impl.font);
 		}
@@ -11,6 +11,11 @@
 #include "core/resource.h"
 #include "core/image.h"
 #include "core/schedule.h"
+#include "core/layer.h"
+#include "core/animation.h"
+#include "core/body.h"
+#include "core/stream.h"
+#include "core/particle.h"
 
 #include "menu/menu.h"
 
@@ -22,6 +27,14 @@
 #include "entity/door.h"
 #include "entity/pellet.h"
 
+/* size of the cells in the grid layout, which fit the largest entity */
+#define GRID_CELL_W 210
+#define GRID_CELL_H 60
+
+/* entities per cluster and cluster radius in the clustered layout */
+#define CLUSTER_SIZE 64
+#define CLUSTER_RADIUS 120
+
  /**
   * Determines if an image resource is used often.
   * Some images may be used in multiple scenes.
@@ -57,6 +70,62 @@ static void load_test_1(fl_context* context);
  */
 static void load_test_2(fl_context* context);
 
+/**
+ * Loads the images used by the entities in the scenes
+ * and assigns them to their entity types.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ */
+static void load_entity_images(fl_context* context);
+
+/**
+ * Advances a pseudo-random number generator.
+ * A linear congruential generator is used so that a seed
+ * produces the same sequence on every platform.
+ *
+ * Params:
+ *   unsigned int* - the state of the generator
+ *
+ * Returns:
+ *   unsigned int - a pseudo-random number from 0 to 32767
+ */
+static unsigned int next_random(unsigned int* state);
+
+/**
+ * Chooses the position of an entity in a stress scene.
+ *
+ * Params:
+ *   fl_stress_config - the configuration of the scene
+ *   int - the index of the entity among all entities in the scene
+ *   unsigned int* - the state of the random number generator
+ *   int* - receives the x position
+ *   int* - receives the y position
+ */
+static void stress_position(const fl_stress_config* config, int n, unsigned int* state, int* x, int* y);
+
+/**
+ * Creates entities of one kind for a stress scene
+ * and adds them to a context.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_stress_config - the configuration of the scene
+ *   fl_entity* (*create) (int, int) - the entity constructor
+ *   int - the number of entities to create
+ *   int* - the index of the next entity in the scene, which is advanced
+ *   unsigned int* - the state of the random number generator
+ *
+ * Returns:
+ *   fl_entity - the first entity created, or NULL if none were created
+ */
+static fl_entity* add_stress_entities(fl_context* context,
+	const fl_stress_config* config,
+	fl_entity* (*create) (int, int),
+	int count,
+	int* n,
+	unsigned int* state);
+
 
 
 
@@ -70,29 +139,141 @@ void fl_load_scene(fl_context* context, int id)
 	case FLURMP_SCENE_TEST_2:
 		load_test_2(context);
 		break;
+	case FLURMP_SCENE_STRESS:
+	{
+		fl_stress_config config;
+		fl_default_stress_config(&config);
+		fl_load_stress_scene(context, &config);
+		break;
+	}
+	case FLURMP_SCENE_STREAM:
+	{
+		fl_world_config config;
+		fl_default_world_config(&config);
+		fl_load_stream_scene(context, &config);
+		break;
+	}
 
 	default:
 		break;
 	}
 }
 
-void fl_clear_scene(fl_context* context)
+void fl_default_stress_config(fl_stress_config* config)
+{
+	config->blocks = 2000;
+	config->spikes = 1000;
+	config->doors = 500;
+	config->pellets = 100;
+	config->players = 1;
+	config->layout = FLURMP_LAYOUT_UNIFORM;
+	config->w = 40000;
+	config->h = 4000;
+	config->seed = 1;
+}
+
+void fl_load_stress_scene(fl_context* context, const fl_stress_config* config)
 {
 	int i;
-	fl_entity* current;
-	fl_entity* next;
+	int n = 0;
+	unsigned int state = config->seed;
+	fl_entity* player;
 
-	/* Remove all entities. */
-	current = context->entities;
-	while (current != NULL)
+	/* Set the camera position. */
+	context->cam_x = 0;
+	context->cam_y = 0;
+
+	load_entity_images(context);
+
+	add_stress_entities(context, config, fl_create_block_200_50, config->blocks, &n, &state);
+	add_stress_entities(context, config, fl_create_spike, config->spikes, &n, &state);
+	add_stress_entities(context, config, fl_create_door, config->doors, &n, &state);
+	player = add_stress_entities(context, config, fl_create_player, config->players, &n, &state);
+	add_stress_entities(context, config, fl_create_pellet, config->pellets, &n, &state);
+
+	/* Animate the players. */
+	for (i = 0; player != NULL && i < context->entity_groups[FLURMP_ENTITY_PLAYER].count; i++)
 	{
-		next = current->next;
-		fl_free(current);
-		current = next;
+		if (!fl_load_player_animations(context, context->entity_groups[FLURMP_ENTITY_PLAYER].entities[i]))
+		{
+			context->error = FLURMP_ERR_ANIMATORS;
+			break;
+		}
 	}
-	context->entity_count = 0;
-	context->entities = NULL;
-	context->pco = NULL;
+
+	/* Set the primary control object. */
+	if (player != NULL)
+		context->pco = player->handle;
+
+	/* Set the scene field. */
+	context->scene = FLURMP_SCENE_STRESS;
+}
+
+void fl_load_stream_scene(fl_context* context, const fl_world_config* config)
+{
+	int x, y;
+	fl_entity* player;
+	fl_entity* platform;
+
+	load_entity_images(context);
+
+	context->world = fl_create_world(config);
+
+	if (context->world == NULL)
+	{
+		context->error = FLURMP_ERR_WORLD;
+		return;
+	}
+
+	/* Start at the center of the world. */
+	x = config->columns * config->chunk_w / 2;
+	y = config->rows * config->chunk_h / 2;
+
+	player = fl_create_player(x, y);
+	platform = fl_create_block_200_50(x - 80, y + 100);
+
+	fl_add_entity(context, player);
+	fl_add_entity(context, platform);
+
+	if (context->error)
+		return;
+
+	if (!fl_load_player_animations(context, player))
+		context->error = FLURMP_ERR_ANIMATORS;
+
+	/* Set the primary control object. */
+	context->pco = player->handle;
+
+	/* Put the player where the test scenes do on the screen,
+	   and bring in the chunks around it right away. */
+	context->cam_x = x - 300;
+	context->cam_y = y - 200;
+	fl_stream_world(context);
+
+	/* Set the scene field. */
+	context->scene = FLURMP_SCENE_STREAM;
+}
+
+void fl_clear_scene(fl_context* context)
+{
+	int i;
+
+	/* Destroy the streamed world. Its entities are removed below. */
+	fl_destroy_world(context->world);
+	context->world = NULL;
+
+	/* Remove all entities. Every handle to them stops resolving. */
+	fl_clear_entities(context);
+
+	/* The animators and bodies belong to the entities that were just
+	   destroyed, and the particles to the old scene. */
+	fl_clear_animators(context);
+	fl_clear_bodies(context);
+	fl_clear_particles(context);
+
+	/* The cached scenery and snapshot belong to the old scene. */
+	fl_invalidate_layers(context);
+	fl_invalidate_snapshot(context);
 
 	/* Clear the texture pointers from entity types. */
 	for (i = 0; i < FLURMP_ENTITY_TYPE_COUNT; i++)
@@ -124,6 +305,9 @@ void fl_clear_scene(fl_context* context)
 		while (w != NULL)
 		{
 			next = w->next;
+
+			/* The targets are gone, so let each action clean up. */
+			w->action(context, w, NULL);
 			fl_destroy_schedule(w);
 			w = next;
 		}
@@ -171,20 +355,7 @@ static void load_test_1(fl_context* context)
 	context->cam_x = 0;
 	context->cam_y = 0;
 
-	/* Load the image resources. */
-	/* TODO: add resource loading check */
-	context->images[FLURMP_IMAGE_SIGN] = fl_load_image(context, "resources/images/sign.bmp");
-	context->images[FLURMP_IMAGE_BLOCK_200_50] = fl_load_image(context, "resources/images/block_200_50.bmp");
-	context->images[FLURMP_IMAGE_SPIKE] = fl_load_image(context, "resources/images/spike.bmp");
-	context->images[FLURMP_IMAGE_DOOR] = fl_load_image(context, "resources/images/door.bmp");
-	context->images[FLURMP_IMAGE_PELLET] = fl_load_image(context, "resources/images/pellet.bmp");
-
-	/* Assign the image resources */
-	context->entity_types[FLURMP_ENTITY_SIGN].texture = context->images[FLURMP_IMAGE_SIGN];
-	context->entity_types[FLURMP_ENTITY_BLOCK_200_50].texture = context->images[FLURMP_IMAGE_BLOCK_200_50];
-	context->entity_types[FLURMP_ENTITY_SPIKE].texture = context->images[FLURMP_IMAGE_SPIKE];
-	context->entity_types[FLURMP_ENTITY_DOOR].texture = context->images[FLURMP_IMAGE_DOOR];
-	context->entity_types[FLURMP_ENTITY_PELLET].texture = context->images[FLURMP_IMAGE_PELLET];
+	load_entity_images(context);
 
 	/* Create a player entity. */
 	fl_entity* player = fl_create_player(300, 200);
@@ -199,8 +370,6 @@ static void load_test_1(fl_context* context)
 	fl_entity* spike = fl_create_spike(160, 330);
 	fl_entity* door = fl_create_door(520, 210);
 
-	fl_entity* pellet = fl_create_pellet(player->x, player->y);
-
 	/* Add the entities to the context. */
 	fl_add_entity(context, sign);
 	fl_add_entity(context, door);
@@ -209,17 +378,14 @@ static void load_test_1(fl_context* context)
 	fl_add_entity(context, block_2);
 	fl_add_entity(context, block_3);
 	fl_add_entity(context, spike);
-	fl_add_entity(context, pellet);
 
 
-	/* Create the schedule for the player. */
-	fl_load_player_schedules(context, player);
+	/* Animate the player. */
+	if (!fl_load_player_animations(context, player))
+		context->error = FLURMP_ERR_ANIMATORS;
 
 	/* Set the primary control object. */
-	context->pco = player;
-
-	/* Set the start point of the projectile list */
-	context->projectiles = pellet;
+	context->pco = player->handle;
 
 	/* Set the scene field. */
 	context->scene = FLURMP_SCENE_TEST_1;
@@ -231,20 +397,7 @@ static void load_test_2(fl_context* context)
 	context->cam_x = 0;
 	context->cam_y = 0;
 
-	/* Load the image resources. */
-	/* TODO: add resource loading check */
-	context->images[FLURMP_IMAGE_SIGN] = fl_load_image(context, "resources/images/sign.bmp");
-	context->images[FLURMP_IMAGE_BLOCK_200_50] = fl_load_image(context, "resources/images/block_200_50.bmp");
-	context->images[FLURMP_IMAGE_SPIKE] = fl_load_image(context, "resources/images/spike.bmp");
-	context->images[FLURMP_IMAGE_DOOR] = fl_load_image(context, "resources/images/door.bmp");
-	context->images[FLURMP_IMAGE_PELLET] = fl_load_image(context, "resources/images/pellet.bmp");
-
-	/* Assign the image resources */
-	context->entity_types[FLURMP_ENTITY_SIGN].texture = context->images[FLURMP_IMAGE_SIGN];
-	context->entity_types[FLURMP_ENTITY_BLOCK_200_50].texture = context->images[FLURMP_IMAGE_BLOCK_200_50];
-	context->entity_types[FLURMP_ENTITY_SPIKE].texture = context->images[FLURMP_IMAGE_SPIKE];
-	context->entity_types[FLURMP_ENTITY_DOOR].texture = context->images[FLURMP_IMAGE_DOOR];
-	context->entity_types[FLURMP_ENTITY_PELLET].texture = context->images[FLURMP_IMAGE_PELLET];
+	load_entity_images(context);
 
 	/* Create a player entity. */
 	fl_entity* player = fl_create_player(320, 200);
@@ -257,26 +410,112 @@ static void load_test_2(fl_context* context)
 	/*fl_entity* spike = fl_create_spike(160, 330);
 	fl_entity* door = fl_create_door(520, 210);*/
 
-	fl_entity* pellet = fl_create_pellet(player->x, player->y);
-
 	/* Add the entities to the context. */
 	fl_add_entity(context, door);
 	fl_add_entity(context, player);
 	fl_add_entity(context, block_1);
 	fl_add_entity(context, block_2);
 	fl_add_entity(context, block_3);
-	fl_add_entity(context, pellet);
 
 
-	/* Create the schedule for the player. */
-	fl_load_player_schedules(context, player);
+	/* Animate the player. */
+	if (!fl_load_player_animations(context, player))
+		context->error = FLURMP_ERR_ANIMATORS;
 
 	/* Set the primary control object. */
-	context->pco = player;
-
-	/* Set the start point of the projectile list */
-	context->projectiles = pellet;
+	context->pco = player->handle;
 
 	/* Set the scene field. */
 	context->scene = FLURMP_SCENE_TEST_2;
 }
+
+static void load_entity_images(fl_context* context)
+{
+	static const char* paths[FLURMP_IMAGE_COUNT] = FLURMP_IMAGE_PATHS;
+	int i;
+
+	/* Load the image resources. Images that are still loaded,
+	   such as those loaded at startup, are kept. */
+	/* TODO: add resource loading check */
+	for (i = 0; i < FLURMP_IMAGE_COUNT; i++)
+	{
+		if (context->images[i] == NULL && !is_common_image(i))
+			context->images[i] = fl_load_image(context, paths[i]);
+	}
+
+	/* Assign the image resources */
+	context->entity_types[FLURMP_ENTITY_SIGN].texture = context->images[FLURMP_IMAGE_SIGN];
+	context->entity_types[FLURMP_ENTITY_BLOCK_200_50].texture = context->images[FLURMP_IMAGE_BLOCK_200_50];
+	context->entity_types[FLURMP_ENTITY_SPIKE].texture = context->images[FLURMP_IMAGE_SPIKE];
+	context->entity_types[FLURMP_ENTITY_DOOR].texture = context->images[FLURMP_IMAGE_DOOR];
+	context->entity_types[FLURMP_ENTITY_PELLET].texture = context->images[FLURMP_IMAGE_PELLET];
+}
+
+static unsigned int next_random(unsigned int* state)
+{
+	*state = *state * 1103515245u + 12345u;
+
+	return (*state >> 16) & 0x7FFF;
+}
+
+static void stress_position(const fl_stress_config* config, int n, unsigned int* state, int* x, int* y)
+{
+	int columns;
+	unsigned int cluster;
+
+	switch (config->layout)
+	{
+	case FLURMP_LAYOUT_GRID:
+		columns = config->w / GRID_CELL_W > 0 ? config->w / GRID_CELL_W : 1;
+		*x = (n % columns) * GRID_CELL_W;
+		*y = (n / columns) * GRID_CELL_H;
+		break;
+
+	case FLURMP_LAYOUT_CLUSTERED:
+		/* The center of each cluster is derived from the seed and
+		   the cluster index, so entities of different kinds that
+		   share a cluster end up overlapping. */
+		cluster = config->seed ^ ((unsigned int)(n / CLUSTER_SIZE) * 2654435761u);
+		*x = (int)((next_random(&cluster) << 15 | next_random(&cluster)) % (unsigned int)(config->w > 0 ? config->w : 1));
+		*y = (int)((next_random(&cluster) << 15 | next_random(&cluster)) % (unsigned int)(config->h > 0 ? config->h : 1));
+		*x += (int)(next_random(state) % (2 * CLUSTER_RADIUS)) - CLUSTER_RADIUS;
+		*y += (int)(next_random(state) % (2 * CLUSTER_RADIUS)) - CLUSTER_RADIUS;
+		break;
+
+	default:
+		*x = (int)((next_random(state) << 15 | next_random(state)) % (unsigned int)(config->w > 0 ? config->w : 1));
+		*y = (int)((next_random(state) << 15 | next_random(state)) % (unsigned int)(config->h > 0 ? config->h : 1));
+		break;
+	}
+}
+
+static fl_entity* add_stress_entities(fl_context* context,
+	const fl_stress_config* config,
+	fl_entity* (*create) (int, int),
+	int count,
+	int* n,
+	unsigned int* state)
+{
+	int i;
+	int x, y;
+	fl_entity* first = NULL;
+
+	for (i = 0; i < count && !context->error; i++)
+	{
+		fl_entity* en;
+
+		stress_position(config, (*n)++, state, &x, &y);
+
+		en = create(x, y);
+
+		if (en == NULL)
+			break;
+
+		fl_add_entity(context, en);
+
+		if (first == NULL)
+			first = en;
+	}
+
+	return first;
+}
@@ -1,6 +1,8 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_SCHEDULE
+
 #include "core/schedule.h"
 
-fl_schedule* fl_create_schedule(void(*action)(fl_context*, fl_schedule*, void*), int limit, void* target)
+fl_schedule* fl_create_schedule(void(*action)(fl_context*, fl_schedule*, fl_entity*), int limit, fl_handle target)
 {
 	fl_schedule* w = fl_alloc(fl_schedule, 1);
 
@@ -62,10 +64,12 @@ void fl_remove_schedule(fl_context* context, fl_schedule* schedule)
 
 	if (s->prev != NULL)
 		s->prev->next = s->next;
+	else
+		context->schedules = s->next;
 
 	if (s->next != NULL)
 		s->next->prev = s->prev;
 
-	if (s->next == NULL && s->prev == NULL)
-		context->schedules = NULL;
+	s->next = NULL;
+	s->prev = NULL;
 }
@@ -0,0 +1,444 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_RESOURCE
+
+#include "core/startup.h"
+#include "core/audio.h"
+#include "core/data_panel.h"
+#include "core/image.h"
+#include "core/resource.h"
+#include "core/task.h"
+#include "core/text.h"
+
+#include "scene/scene.h"
+
+#include "entity/entity.h"
+
+/* printable ASCII, which fonts without a bake rasterize up front */
+#define FIRST_GLYPH 0x20
+#define LAST_GLYPH  0x7E
+#define GLYPH_COUNT (LAST_GLYPH - FIRST_GLYPH + 1)
+
+/**
+ * A font that a context starts with.
+ */
+typedef struct font_spec {
+	const char* path;
+	int size;
+	fl_color forecolor;
+	fl_color backcolor;
+	int background;
+}font_spec;
+
+/**
+ * A font being loaded. The worker fills in the resource and either
+ * the atlas of its bake or the glyphs it rasterized, which the main
+ * thread then uploads.
+ */
+typedef struct font_job {
+	int id;
+	fl_resource* resource;
+	fl_surface* atlas;
+	fl_surface* glyphs[GLYPH_COUNT];
+}font_job;
+
+/**
+ * An image being loaded.
+ */
+typedef struct image_job {
+	int id;
+	const char* path;
+	fl_surface* pixels;
+}image_job;
+
+/**
+ * The fonts, indexed like the font registry. The fonts and colors
+ * baked by the bake target must match these.
+ */
+static const font_spec font_specs[FLURMP_FONT_COUNT] = {
+	{ "resources/fonts/VeraMono.ttf", 16, { 250, 250, 250, 255 }, { 0, 0, 0, 255 }, 1 },
+	{ "resources/fonts/Cousine.ttf", 16, { 250, 250, 250, 255 }, { 0, 0, 0, 0 }, 0 },
+	{ "resources/fonts/Karmilla-Bold.ttf", 16, { 250, 250, 250, 255 }, { 0, 0, 0, 0 }, 0 }
+};
+
+static const char* image_paths[FLURMP_IMAGE_COUNT] = FLURMP_IMAGE_PATHS;
+
+/* number of worker threads, or -1 for one less than the number of cores */
+static int workers_ = -1;
+
+/* where to write the timeline of startup, if anywhere */
+static const char* trace_ = NULL;
+
+
+
+/* -------------------------------------------------------------- */
+/*                   internal startup functions                   */
+/* -------------------------------------------------------------- */
+
+/**
+ * Gets the file name at the end of a path.
+ *
+ * Params:
+ *   const char* - a path
+ *
+ * Returns:
+ *   const char* - the file name
+ */
+static const char* file_name(const char* path);
+
+/**
+ * Creates the window and the renderer. (main thread)
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   void* - unused
+ */
+static void create_window(fl_context* context, void* data);
+
+/**
+ * Reads a font, and rasterizes its printable ASCII
+ * if it has no bake. (any thread)
+ *
+ * Params:
+ *   fl_context - NULL
+ *   void* - a font_job
+ */
+static void prepare_font(fl_context* context, void* data);
+
+/**
+ * Uploads a font and adds it to the font registry. (main thread)
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   void* - a font_job
+ */
+static void finish_font(fl_context* context, void* data);
+
+/**
+ * Reads and decodes an image. (any thread)
+ *
+ * Params:
+ *   fl_context - NULL
+ *   void* - an image_job
+ */
+static void prepare_image(fl_context* context, void* data);
+
+/**
+ * Uploads an image and adds it to the image registry. (main thread)
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   void* - an image_job
+ */
+static void finish_image(fl_context* context, void* data);
+
+/**
+ * Decodes the sounds. (any thread)
+ *
+ * Params:
+ *   fl_context - NULL
+ *   void* - a reference to an audio structure pointer to fill in
+ */
+static void prepare_audio(fl_context* context, void* data);
+
+/**
+ * Opens the audio device and gives the context its sounds. (main thread)
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   void* - a reference to an audio structure pointer
+ */
+static void finish_audio(fl_context* context, void* data);
+
+/**
+ * Creates the data panel. (main thread)
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   void* - unused
+ */
+static void create_data_panel(fl_context* context, void* data);
+
+/**
+ * Loads the first scene. (main thread)
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   void* - unused
+ */
+static void load_first_scene(fl_context* context, void* data);
+
+/**
+ * Adds a task that loads an asset on any thread and a task
+ * that uploads it on the main thread once the renderer exists.
+ *
+ * Params:
+ *   fl_task_graph - a task graph
+ *   const char* - the path to the asset, which names the tasks
+ *   void (*prepare) (fl_context*, void*) - the loading task
+ *   void (*finish) (fl_context*, void*) - the uploading task
+ *   void* - the job shared by the tasks
+ *   int - the index of the task that creates the renderer
+ *
+ * Returns:
+ *   int - the index of the uploading task, or -1 on failure
+ */
+static int add_asset_tasks(fl_task_graph* graph,
+	const char* path,
+	void(*prepare) (fl_context*, void*),
+	void(*finish) (fl_context*, void*),
+	void* job,
+	int window);
+
+
+
+/* -------------------------------------------------------------- */
+/*           internal startup functions (implementation)          */
+/* -------------------------------------------------------------- */
+
+static const char* file_name(const char* path)
+{
+	const char* slash = strrchr(path, '/');
+
+	return slash != NULL ? slash + 1 : path;
+}
+
+static void create_window(fl_context* context, void* data)
+{
+	/* Create the application window. */
+	context->window = fl_create_window("Flurmp",
+		100, 100, FLURMP_WINDOW_WIDTH, FLURMP_WINDOW_HEIGHT);
+
+	/* Verify window creation. */
+	if (context->window == NULL)
+	{
+		context->error = FLURMP_ERR_WINDOW;
+		return;
+	}
+
+	/* Create the renderer. */
+	context->renderer = fl_create_renderer(context->window);
+
+	/* Verify renderer creation. */
+	if (context->renderer == NULL)
+		context->error = FLURMP_ERR_RENDERER;
+}
+
+static void prepare_font(fl_context* context, void* data)
+{
+	font_job* job = (font_job*)data;
+	const font_spec* spec = &font_specs[job->id];
+	unsigned int code;
+	int w, h;
+
+	job->resource = fl_prepare_font(spec->path, spec->size,
+		spec->forecolor, spec->backcolor, spec->background, &job->atlas);
+
+	/* A bake already holds the glyphs. Without one, rasterize the
+	   characters most text is made of here rather than while
+	   drawing the first frames. */
+	if (job->resource == NULL || job->atlas != NULL)
+		return;
+
+	for (code = FIRST_GLYPH; code <= LAST_GLYPH; code++)
+		job->glyphs[code - FIRST_GLYPH] = fl_create_glyph_surface(job->resource->impl.font, code, &w, &h);
+}
+
+static void finish_font(fl_context* context, void* data)
+{
+	font_job* job = (font_job*)data;
+	int i;
+
+	if (job->resource != NULL && context->renderer != NULL
+		&& fl_finish_font(context, job->resource, job->atlas))
+	{
+		context->fonts[job->id] = job->resource;
+
+		/* A glyph that doesn't fit is rasterized again when drawn. */
+		for (i = 0; i < GLYPH_COUNT; i++)
+		{
+			if (job->glyphs[i] != NULL)
+				fl_add_glyph(context, job->resource->impl.font, FIRST_GLYPH + i, job->glyphs[i]);
+		}
+	}
+	else
+		fl_destroy_resource(job->resource);
+
+	fl_destroy_surface(job->atlas);
+
+	for (i = 0; i < GLYPH_COUNT; i++)
+		fl_destroy_surface(job->glyphs[i]);
+}
+
+static void prepare_image(fl_context* context, void* data)
+{
+	image_job* job = (image_job*)data;
+
+	job->pixels = fl_prepare_image(job->path);
+}
+
+static void finish_image(fl_context* context, void* data)
+{
+	image_job* job = (image_job*)data;
+
+	/* TODO: add resource loading check */
+	if (context->renderer != NULL)
+		context->images[job->id] = fl_finish_image(context, job->pixels);
+
+	fl_destroy_surface(job->pixels);
+}
+
+static void prepare_audio(fl_context* context, void* data)
+{
+	*(fl_audio**)data = fl_create_audio();
+}
+
+static void finish_audio(fl_context* context, void* data)
+{
+	fl_audio* audio = *(fl_audio**)data;
+
+	/* Without an audio device, the context is silent. */
+	if (fl_start_audio(audio))
+		context->audio = audio;
+	else
+		fl_destroy_audio(audio);
+}
+
+static void create_data_panel(fl_context* context, void* data)
+{
+	if (context->error)
+		return;
+
+	if (context->fonts[FLURMP_FONT_COUSINE] != NULL)
+		context->data_panel = fl_create_data_panel(420, 20, 200, 190, context->fonts[FLURMP_FONT_COUSINE]->impl.font);
+
+	if (context->data_panel == NULL)
+		context->error = 0x09;
+}
+
+static void load_first_scene(fl_context* context, void* data)
+{
+	if (context->error)
+		return;
+
+	/* The player image is common to every scene. The scene
+	   keeps the other images, which were loaded here too. */
+	context->entity_types[FLURMP_ENTITY_PLAYER].texture = context->images[FLURMP_IMAGE_PLAYER];
+
+	/* Load a test scene. */
+	fl_load_scene(context, FLURMP_SCENE_TEST_1);
+}
+
+static int add_asset_tasks(fl_task_graph* graph,
+	const char* path,
+	void(*prepare) (fl_context*, void*),
+	void(*finish) (fl_context*, void*),
+	void* job,
+	int window)
+{
+	char name[FLURMP_TASK_NAME_LENGTH];
+	int load;
+	int upload;
+
+	snprintf(name, sizeof(name), "load %s", file_name(path));
+	load = fl_add_task(graph, name, FLURMP_TASK_ANY, prepare, job);
+
+	snprintf(name, sizeof(name), "upload %s", file_name(path));
+	upload = fl_add_task(graph, name, FLURMP_TASK_MAIN, finish, job);
+
+	if (load < 0 || upload < 0 || !fl_add_dependency(graph, upload, load)
+		|| !fl_add_dependency(graph, upload, window))
+		return -1;
+
+	return upload;
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                    startup.h implementation                    */
+/* -------------------------------------------------------------- */
+
+void fl_run_startup(fl_context* context)
+{
+	int i;
+	int j;
+	int ok;
+	int window;
+	int sounds;
+	int panel;
+	int scene;
+	int uploads[FLURMP_FONT_COUNT + FLURMP_IMAGE_COUNT];
+	int workers = workers_;
+	font_job fonts[FLURMP_FONT_COUNT];
+	image_job images[FLURMP_IMAGE_COUNT];
+	fl_audio* audio = NULL;
+	fl_task_graph* graph = fl_create_task_graph();
+
+	if (graph == NULL)
+	{
+		context->error = FLURMP_ERR_STARTUP;
+		return;
+	}
+
+	/* The window comes first, since every upload needs the renderer.
+	   The workers load assets meanwhile. */
+	window = fl_add_task(graph, "window", FLURMP_TASK_MAIN, create_window, NULL);
+	ok = window >= 0;
+
+	for (i = 0; ok && i < FLURMP_FONT_COUNT; i++)
+	{
+		fonts[i].id = i;
+		fonts[i].resource = NULL;
+		fonts[i].atlas = NULL;
+
+		for (j = 0; j < GLYPH_COUNT; j++)
+			fonts[i].glyphs[j] = NULL;
+
+		uploads[i] = add_asset_tasks(graph, font_specs[i].path, prepare_font, finish_font, &fonts[i], window);
+		ok = uploads[i] >= 0;
+	}
+
+	for (i = 0; ok && i < FLURMP_IMAGE_COUNT; i++)
+	{
+		images[i].id = i;
+		images[i].path = image_paths[i];
+		images[i].pixels = NULL;
+
+		uploads[FLURMP_FONT_COUNT + i] = add_asset_tasks(graph, image_paths[i], prepare_image, finish_image, &images[i], window);
+		ok = uploads[FLURMP_FONT_COUNT + i] >= 0;
+	}
+
+	/* Sounds don't need the window, only a device of their own. */
+	sounds = ok ? fl_add_task(graph, "load sounds", FLURMP_TASK_ANY, prepare_audio, &audio) : -1;
+	ok = ok && fl_add_dependency(graph, fl_add_task(graph, "audio", FLURMP_TASK_MAIN, finish_audio, &audio), sounds);
+
+	/* The data panel draws with Cousine, and the scene
+	   may use any of the assets. */
+	panel = ok ? fl_add_task(graph, "data panel", FLURMP_TASK_MAIN, create_data_panel, NULL) : -1;
+	scene = ok ? fl_add_task(graph, "scene", FLURMP_TASK_MAIN, load_first_scene, NULL) : -1;
+	ok = ok && fl_add_dependency(graph, panel, uploads[FLURMP_FONT_COUSINE]);
+
+	for (i = 0; ok && i < FLURMP_FONT_COUNT + FLURMP_IMAGE_COUNT; i++)
+		ok = fl_add_dependency(graph, scene, uploads[i]);
+
+	if (workers < 0)
+		workers = fl_get_cpu_count() - 1;
+
+	/* The graph has no cycles, so it can only fail before
+	   any of its tasks have run. */
+	if (!ok || !fl_run_task_graph(context, graph, workers))
+		context->error = FLURMP_ERR_STARTUP;
+	else if (trace_ != NULL)
+		fl_write_task_trace(graph, trace_);
+
+	fl_destroy_task_graph(graph);
+}
+
+void fl_set_startup_workers(int workers)
+{
+	workers_ = workers;
+}
+
+void fl_set_startup_trace(const char* path)
+{
+	trace_ = path;
+}
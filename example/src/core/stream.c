@@ -0,0 +1,466 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_ENTITY
+
+#include "core/stream.h"
+
+#include "entity/entity.h"
+#include "entity/block_200_50.h"
+#include "entity/sign.h"
+#include "entity/player.h"
+#include "entity/spike.h"
+#include "entity/door.h"
+#include "entity/pellet.h"
+
+/* initial number of resident chunks */
+#define INITIAL_RESIDENT_CAPACITY 32
+
+/* entity constructors, indexed by entity type */
+static fl_entity* (*constructors[FLURMP_ENTITY_TYPE_COUNT]) (int, int) = {
+	fl_create_player,
+	fl_create_sign,
+	fl_create_block_200_50,
+	fl_create_spike,
+	fl_create_door,
+	fl_create_pellet
+};
+
+
+
+/* -------------------------------------------------------------- */
+/*                     internal stream functions                  */
+/* -------------------------------------------------------------- */
+
+/**
+ * Advances a pseudo-random number generator.
+ * This is the same generator used by the stress scene.
+ *
+ * Params:
+ *   unsigned int* - the state of the generator
+ *
+ * Returns:
+ *   unsigned int - a pseudo-random number from 0 to 32767
+ */
+static unsigned int next_random(unsigned int* state);
+
+/**
+ * Gets the distance of a chunk from another chunk, which is the
+ * larger of the horizontal and vertical distances.
+ *
+ * Params:
+ *   fl_world - a world
+ *   int - the index of a chunk
+ *   int - the column of the other chunk
+ *   int - the row of the other chunk
+ *
+ * Returns:
+ *   int - the distance in chunks
+ */
+static int chunk_distance(fl_world* world, int index, int column, int row);
+
+/**
+ * Generates the records of a chunk and adds the chunk
+ * to the resident chunks.
+ *
+ * Params:
+ *   fl_world - a world
+ *   int - the index of an unloaded chunk
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int load_chunk(fl_world* world, int index);
+
+/**
+ * Frees the records of a chunk. The chunk is not removed
+ * from the resident chunks.
+ *
+ * Params:
+ *   fl_chunk - a loaded chunk
+ */
+static void unload_chunk(fl_chunk* chunk);
+
+/**
+ * Adds the entities of a chunk to a context.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_chunk - a loaded chunk
+ */
+static void activate_chunk(fl_context* context, fl_chunk* chunk);
+
+/**
+ * Writes the entities of a chunk back to its records
+ * and despawns them.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_chunk - an active chunk
+ */
+static void deactivate_chunk(fl_context* context, fl_chunk* chunk);
+
+/**
+ * Loads the unloaded chunks at a distance from a chunk,
+ * until the load budget is spent.
+ *
+ * Params:
+ *   fl_world - a world
+ *   int - the column of the center chunk
+ *   int - the row of the center chunk
+ *   int - the distance
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int prefetch_ring(fl_world* world, int column, int row, int r);
+
+
+
+/* -------------------------------------------------------------- */
+/*            internal stream functions (implementation)          */
+/* -------------------------------------------------------------- */
+
+static unsigned int next_random(unsigned int* state)
+{
+	*state = *state * 1103515245u + 12345u;
+
+	return (*state >> 16) & 0x7FFF;
+}
+
+static int chunk_distance(fl_world* world, int index, int column, int row)
+{
+	int dx = abs(index % world->config.columns - column);
+	int dy = abs(index / world->config.columns - row);
+
+	return dx > dy ? dx : dy;
+}
+
+static int load_chunk(fl_world* world, int index)
+{
+	int i, j, k;
+	fl_world_config* config = &(world->config);
+	fl_chunk* chunk = &(world->chunks[index]);
+	int counts[FLURMP_ENTITY_TYPE_COUNT] = { 0 };
+	int count = config->blocks + config->spikes + config->doors + config->pellets;
+	int origin_x = (index % config->columns) * config->chunk_w;
+	int origin_y = (index / config->columns) * config->chunk_h;
+	unsigned int state = config->seed ^ ((unsigned int)index * 2654435761u);
+
+	/* Make room for one more resident chunk. */
+	if (world->resident_count >= world->resident_capacity)
+	{
+		int capacity = world->resident_capacity * 2;
+		int* resident = fl_alloc(int, capacity);
+
+		if (resident == NULL)
+			return 0;
+
+		for (i = 0; i < world->resident_count; i++)
+			resident[i] = world->resident[i];
+
+		fl_free(world->resident);
+		world->resident = resident;
+		world->resident_capacity = capacity;
+	}
+
+	chunk->records = fl_alloc(fl_chunk_record, count > 0 ? count : 1);
+	chunk->handles = fl_alloc(fl_handle, count > 0 ? count : 1);
+
+	if (chunk->records == NULL || chunk->handles == NULL)
+	{
+		unload_chunk(chunk);
+		return 0;
+	}
+
+	counts[FLURMP_ENTITY_BLOCK_200_50] = config->blocks;
+	counts[FLURMP_ENTITY_SPIKE] = config->spikes;
+	counts[FLURMP_ENTITY_DOOR] = config->doors;
+	counts[FLURMP_ENTITY_PELLET] = config->pellets;
+
+	/* The seed and the chunk index decide the contents, so a chunk
+	   that is loaded again looks as it did the first time. */
+	for (i = 0, k = 0; i < FLURMP_ENTITY_TYPE_COUNT; i++)
+	{
+		for (j = 0; j < counts[i]; j++, k++)
+		{
+			chunk->records[k].type = i;
+			chunk->records[k].x = origin_x + (int)((next_random(&state) << 15 | next_random(&state)) % (unsigned int)config->chunk_w);
+			chunk->records[k].y = origin_y + (int)((next_random(&state) << 15 | next_random(&state)) % (unsigned int)config->chunk_h);
+		}
+	}
+
+	chunk->count = count;
+	chunk->state = FLURMP_CHUNK_LOADED;
+
+	world->resident[world->resident_count++] = index;
+	world->loads++;
+
+	return 1;
+}
+
+static void unload_chunk(fl_chunk* chunk)
+{
+	if (chunk->records != NULL)
+		fl_free(chunk->records);
+
+	if (chunk->handles != NULL)
+		fl_free(chunk->handles);
+
+	chunk->records = NULL;
+	chunk->handles = NULL;
+	chunk->count = 0;
+	chunk->state = FLURMP_CHUNK_UNLOADED;
+}
+
+static void activate_chunk(fl_context* context, fl_chunk* chunk)
+{
+	int i;
+
+	for (i = 0; i < chunk->count; i++)
+		chunk->handles[i] = FLURMP_NULL_HANDLE;
+
+	for (i = 0; i < chunk->count && !context->error; i++)
+	{
+		fl_chunk_record* r = &(chunk->records[i]);
+		fl_entity* en = constructors[r->type](r->x, r->y);
+
+		if (en == NULL)
+		{
+			context->error = FLURMP_ERR_WORLD;
+			break;
+		}
+
+		fl_add_entity(context, en);
+
+		/* The entity wasn't added. */
+		if (context->error)
+		{
+			fl_free(en);
+			break;
+		}
+
+		chunk->handles[i] = en->handle;
+	}
+
+	chunk->state = FLURMP_CHUNK_ACTIVE;
+	context->world->active_count++;
+	context->world->activations++;
+}
+
+static void deactivate_chunk(fl_context* context, fl_chunk* chunk)
+{
+	int i;
+	int count = 0;
+
+	for (i = 0; i < chunk->count; i++)
+	{
+		fl_entity* en = fl_get_entity(context, chunk->handles[i]);
+
+		/* Entities despawned while the chunk was active stay gone. */
+		if (en == NULL)
+			continue;
+
+		chunk->records[count].type = en->type;
+		chunk->records[count].x = en->x;
+		chunk->records[count].y = en->y;
+		count++;
+
+		fl_despawn_entity(context, chunk->handles[i]);
+	}
+
+	chunk->count = count;
+	chunk->state = FLURMP_CHUNK_LOADED;
+	context->world->active_count--;
+}
+
+static int prefetch_ring(fl_world* world, int column, int row, int r)
+{
+	int x, y;
+
+	for (y = row - r; y <= row + r; y++)
+	{
+		for (x = column - r; x <= column + r; x++)
+		{
+			int index = y * world->config.columns + x;
+
+			if (world->loads >= world->config.load_budget)
+				return 1;
+
+			/* Only the edge of the square is at distance r. */
+			if (y != row - r && y != row + r && x != column - r && x != column + r)
+				continue;
+
+			if (x < 0 || y < 0 || x >= world->config.columns || y >= world->config.rows)
+				continue;
+
+			if (world->chunks[index].state == FLURMP_CHUNK_UNLOADED && !load_chunk(world, index))
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                     stream.h implementation                    */
+/* -------------------------------------------------------------- */
+
+void fl_default_world_config(fl_world_config* config)
+{
+	config->columns = 100;
+	config->rows = 100;
+	config->chunk_w = 1024;
+	config->chunk_h = 1024;
+	config->blocks = 50;
+	config->spikes = 25;
+	config->doors = 15;
+	config->pellets = 10;
+	config->active_radius = 1;
+	config->load_radius = 2;
+	config->hysteresis = 1;
+	config->load_budget = 2;
+	config->seed = 1;
+}
+
+fl_world* fl_create_world(const fl_world_config* config)
+{
+	int i;
+	int count;
+	fl_world* world;
+
+	if (config->columns <= 0 || config->rows <= 0 || config->chunk_w <= 0 || config->chunk_h <= 0)
+		return NULL;
+
+	world = fl_alloc(fl_world, 1);
+
+	if (world == NULL)
+		return NULL;
+
+	count = config->columns * config->rows;
+
+	world->config = *config;
+	world->chunks = fl_alloc(fl_chunk, count);
+	world->resident = fl_alloc(int, INITIAL_RESIDENT_CAPACITY);
+
+	if (world->chunks == NULL || world->resident == NULL)
+	{
+		fl_free(world->chunks);
+		fl_free(world->resident);
+		fl_free(world);
+		return NULL;
+	}
+
+	/* Chunks are never loaded ahead of the chunks that must be active. */
+	if (world->config.load_radius < world->config.active_radius)
+		world->config.load_radius = world->config.active_radius;
+
+	if (world->config.hysteresis < 0)
+		world->config.hysteresis = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		world->chunks[i].state = FLURMP_CHUNK_UNLOADED;
+		world->chunks[i].count = 0;
+		world->chunks[i].records = NULL;
+		world->chunks[i].handles = NULL;
+	}
+
+	world->resident_count = 0;
+	world->resident_capacity = INITIAL_RESIDENT_CAPACITY;
+	world->active_count = 0;
+	world->loads = 0;
+	world->activations = 0;
+
+	return world;
+}
+
+void fl_destroy_world(fl_world* world)
+{
+	int i;
+
+	if (world == NULL)
+		return;
+
+	for (i = 0; i < world->resident_count; i++)
+		unload_chunk(&(world->chunks[world->resident[i]]));
+
+	fl_free(world->chunks);
+	fl_free(world->resident);
+	fl_free(world);
+}
+
+void fl_stream_world(fl_context* context)
+{
+	int i, r, x, y;
+	int column, row;
+	fl_world* world = context->world;
+	fl_world_config* config;
+
+	if (world == NULL)
+		return;
+
+	config = &(world->config);
+	world->loads = 0;
+	world->activations = 0;
+
+	/* Find the chunk at the center of the screen. Dividing
+	   a negative coordinate must still round down. */
+	x = context->cam_x + FLURMP_WINDOW_WIDTH / 2;
+	y = context->cam_y + FLURMP_WINDOW_HEIGHT / 2;
+	column = x >= 0 ? x / config->chunk_w : -((-x - 1) / config->chunk_w) - 1;
+	row = y >= 0 ? y / config->chunk_h : -((-y - 1) / config->chunk_h) - 1;
+
+	/* Let go of the chunks the camera has left behind. */
+	for (i = 0; i < world->resident_count; )
+	{
+		fl_chunk* chunk = &(world->chunks[world->resident[i]]);
+		int d = chunk_distance(world, world->resident[i], column, row);
+
+		if (chunk->state == FLURMP_CHUNK_ACTIVE && d > config->active_radius + config->hysteresis)
+			deactivate_chunk(context, chunk);
+
+		if (d > config->load_radius + config->hysteresis)
+		{
+			unload_chunk(chunk);
+			world->resident[i] = world->resident[--world->resident_count];
+			continue;
+		}
+
+		i++;
+	}
+
+	/* Activate the chunks around the camera. A chunk that wasn't
+	   loaded ahead of time has to be loaded now. */
+	for (y = row - config->active_radius; y <= row + config->active_radius; y++)
+	{
+		for (x = column - config->active_radius; x <= column + config->active_radius; x++)
+		{
+			int index = y * config->columns + x;
+			fl_chunk* chunk;
+
+			if (x < 0 || y < 0 || x >= config->columns || y >= config->rows)
+				continue;
+
+			chunk = &(world->chunks[index]);
+
+			if (chunk->state == FLURMP_CHUNK_UNLOADED && !load_chunk(world, index))
+			{
+				context->error = FLURMP_ERR_WORLD;
+				return;
+			}
+
+			if (chunk->state == FLURMP_CHUNK_LOADED)
+				activate_chunk(context, chunk);
+		}
+	}
+
+	/* Load the chunks the camera is approaching, nearest first. */
+	for (r = config->active_radius + 1; r <= config->load_radius; r++)
+	{
+		if (!prefetch_ring(world, column, row, r))
+		{
+			context->error = FLURMP_ERR_WORLD;
+			return;
+		}
+	}
+}
@@ -0,0 +1,390 @@
+#include "core/task.h"
+
+/* initial room for tasks and dependencies */
+#define INITIAL_TASK_CAPACITY 16
+#define INITIAL_EDGE_CAPACITY 32
+
+
+
+/* -------------------------------------------------------------- */
+/*                     internal task functions                    */
+/* -------------------------------------------------------------- */
+
+/**
+ * Queues a task whose dependencies have all finished.
+ * The graph must be locked.
+ *
+ * Params:
+ *   fl_task_graph - a running task graph
+ *   int - the index of the task
+ */
+static void queue_task(fl_task_graph* graph, int task);
+
+/**
+ * Runs a task and records when and where it ran.
+ * The graph must not be locked.
+ *
+ * Params:
+ *   fl_task_graph - a running task graph
+ *   int - the index of the task
+ *   int - the thread running the task, 0 for the main thread
+ */
+static void run_task(fl_task_graph* graph, int task, int thread);
+
+/**
+ * Marks a task as finished and queues the tasks that were
+ * only waiting for it. The graph must be locked.
+ *
+ * Params:
+ *   fl_task_graph - a running task graph
+ *   int - the index of the task
+ */
+static void finish_task(fl_task_graph* graph, int task);
+
+/**
+ * Runs tasks that may run on any thread until the graph is done.
+ *
+ * Params:
+ *   void* - the fl_task_worker of the thread
+ *
+ * Returns:
+ *   int - always 0
+ */
+static int run_worker(void* data);
+
+/**
+ * Converts a performance counter value into microseconds
+ * since a task graph started running.
+ *
+ * Params:
+ *   fl_task_graph - a task graph
+ *   unsigned long long - a performance counter value
+ *
+ * Returns:
+ *   double - the number of microseconds
+ */
+static double trace_time(fl_task_graph* graph, unsigned long long counter);
+
+
+
+/* -------------------------------------------------------------- */
+/*             internal task functions (implementation)           */
+/* -------------------------------------------------------------- */
+
+static void queue_task(fl_task_graph* graph, int task)
+{
+	if (graph->tasks[task].where == FLURMP_TASK_MAIN)
+	{
+		graph->main_queue[graph->main_tail++] = task;
+	}
+	else
+	{
+		graph->any_queue[graph->any_tail++] = task;
+		fl_broadcast_cond(graph->wake_workers);
+	}
+}
+
+static void run_task(fl_task_graph* graph, int task, int thread)
+{
+	fl_task* t = &graph->tasks[task];
+
+	t->thread = thread;
+	t->start = fl_get_performance_counter();
+
+	/* Only tasks kept to the main thread may touch the context. */
+	t->run(t->where == FLURMP_TASK_MAIN ? graph->context : NULL, t->data);
+
+	t->end = fl_get_performance_counter();
+}
+
+static void finish_task(fl_task_graph* graph, int task)
+{
+	int i;
+
+	graph->running--;
+	graph->finished++;
+
+	for (i = 0; i < graph->edge_count; i++)
+	{
+		int dependent = graph->edges[i * 2 + 1];
+
+		if (graph->edges[i * 2] == task && --graph->tasks[dependent].pending == 0)
+			queue_task(graph, dependent);
+	}
+
+	fl_broadcast_cond(graph->wake_main);
+}
+
+static int run_worker(void* data)
+{
+	fl_task_worker* worker = (fl_task_worker*)data;
+	fl_task_graph* graph = worker->graph;
+	int task;
+
+	fl_lock_mutex(graph->lock);
+
+	while (!graph->quit)
+	{
+		if (graph->any_head == graph->any_tail)
+		{
+			fl_wait_cond(graph->wake_workers, graph->lock);
+			continue;
+		}
+
+		task = graph->any_queue[graph->any_head++];
+		graph->running++;
+
+		fl_unlock_mutex(graph->lock);
+		run_task(graph, task, worker->index);
+		fl_lock_mutex(graph->lock);
+
+		finish_task(graph, task);
+	}
+
+	fl_unlock_mutex(graph->lock);
+
+	return 0;
+}
+
+static double trace_time(fl_task_graph* graph, unsigned long long counter)
+{
+	return (double)(counter - graph->origin) * 1000000.0 / (double)fl_get_performance_frequency();
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                      task.h implementation                     */
+/* -------------------------------------------------------------- */
+
+fl_task_graph* fl_create_task_graph()
+{
+	fl_task_graph* graph = fl_alloc(fl_task_graph, 1);
+
+	if (graph == NULL)
+		return NULL;
+
+	graph->tasks = fl_alloc(fl_task, INITIAL_TASK_CAPACITY);
+	graph->edges = fl_alloc(int, INITIAL_EDGE_CAPACITY * 2);
+	graph->lock = fl_create_mutex();
+	graph->wake_workers = fl_create_cond();
+	graph->wake_main = fl_create_cond();
+
+	graph->count = 0;
+	graph->capacity = INITIAL_TASK_CAPACITY;
+	graph->edge_count = 0;
+	graph->edge_capacity = INITIAL_EDGE_CAPACITY;
+	graph->main_queue = NULL;
+	graph->any_queue = NULL;
+	graph->worker_count = 0;
+	graph->context = NULL;
+	graph->origin = 0;
+
+	if (graph->tasks == NULL || graph->edges == NULL || graph->lock == NULL
+		|| graph->wake_workers == NULL || graph->wake_main == NULL)
+	{
+		fl_destroy_task_graph(graph);
+		return NULL;
+	}
+
+	return graph;
+}
+
+int fl_add_task(fl_task_graph* graph, const char* name, int where, void(*run) (fl_context*, void*), void* data)
+{
+	int i;
+	fl_task* t;
+
+	/* Make room for one more task. */
+	if (graph->count >= graph->capacity)
+	{
+		int capacity = graph->capacity * 2;
+		fl_task* tasks = fl_alloc(fl_task, capacity);
+
+		if (tasks == NULL)
+			return -1;
+
+		for (i = 0; i < graph->count; i++)
+			tasks[i] = graph->tasks[i];
+
+		fl_free(graph->tasks);
+		graph->tasks = tasks;
+		graph->capacity = capacity;
+	}
+
+	t = &graph->tasks[graph->count];
+
+	snprintf(t->name, sizeof(t->name), "%s", name);
+	t->run = run;
+	t->data = data;
+	t->where = where;
+	t->pending = 0;
+	t->thread = 0;
+	t->start = 0;
+	t->end = 0;
+
+	return graph->count++;
+}
+
+int fl_add_dependency(fl_task_graph* graph, int task, int dependency)
+{
+	int i;
+
+	if (task < 0 || task >= graph->count || dependency < 0 || dependency >= graph->count || task == dependency)
+		return 0;
+
+	/* Make room for one more dependency. */
+	if (graph->edge_count >= graph->edge_capacity)
+	{
+		int capacity = graph->edge_capacity * 2;
+		int* edges = fl_alloc(int, capacity * 2);
+
+		if (edges == NULL)
+			return 0;
+
+		for (i = 0; i < graph->edge_count * 2; i++)
+			edges[i] = graph->edges[i];
+
+		fl_free(graph->edges);
+		graph->edges = edges;
+		graph->edge_capacity = capacity;
+	}
+
+	graph->edges[graph->edge_count * 2] = dependency;
+	graph->edges[graph->edge_count * 2 + 1] = task;
+	graph->edge_count++;
+	graph->tasks[task].pending++;
+
+	return 1;
+}
+
+int fl_run_task_graph(fl_context* context, fl_task_graph* graph, int workers)
+{
+	int i;
+	int task;
+
+	if (graph->main_queue != NULL)
+		return 0;
+
+	graph->main_queue = fl_alloc(int, graph->count > 0 ? graph->count : 1);
+	graph->any_queue = fl_alloc(int, graph->count > 0 ? graph->count : 1);
+
+	if (graph->main_queue == NULL || graph->any_queue == NULL)
+		return 0;
+
+	graph->main_head = 0;
+	graph->main_tail = 0;
+	graph->any_head = 0;
+	graph->any_tail = 0;
+	graph->running = 0;
+	graph->finished = 0;
+	graph->quit = 0;
+	graph->context = context;
+	graph->origin = fl_get_performance_counter();
+
+	for (i = 0; i < graph->count; i++)
+	{
+		if (graph->tasks[i].pending == 0)
+			queue_task(graph, i);
+	}
+
+	if (workers > FLURMP_TASK_WORKER_LIMIT)
+		workers = FLURMP_TASK_WORKER_LIMIT;
+
+	/* Carry on with however many workers could be started,
+	   since the main thread can run every task by itself. */
+	for (graph->worker_count = 0; graph->worker_count < workers; graph->worker_count++)
+	{
+		fl_task_worker* worker = &graph->workers[graph->worker_count];
+
+		worker->graph = graph;
+		worker->index = graph->worker_count + 1;
+		worker->thread = fl_create_thread(run_worker, "flurmp_task", worker);
+
+		if (worker->thread == NULL)
+			break;
+	}
+
+	fl_lock_mutex(graph->lock);
+
+	while (graph->finished < graph->count)
+	{
+		/* Tasks that need the main thread come first. Otherwise
+		   the main thread helps the workers rather than waiting. */
+		if (graph->main_head < graph->main_tail)
+			task = graph->main_queue[graph->main_head++];
+		else if (graph->any_head < graph->any_tail)
+			task = graph->any_queue[graph->any_head++];
+		else if (graph->running == 0)
+			break; /* only a cycle leaves tasks that can never start */
+		else
+		{
+			fl_wait_cond(graph->wake_main, graph->lock);
+			continue;
+		}
+
+		graph->running++;
+
+		fl_unlock_mutex(graph->lock);
+		run_task(graph, task, 0);
+		fl_lock_mutex(graph->lock);
+
+		finish_task(graph, task);
+	}
+
+	graph->quit = 1;
+	fl_broadcast_cond(graph->wake_workers);
+	fl_unlock_mutex(graph->lock);
+
+	for (i = 0; i < graph->worker_count; i++)
+		fl_wait_thread(graph->workers[i].thread);
+
+	return graph->finished == graph->count;
+}
+
+int fl_write_task_trace(fl_task_graph* graph, const char* path)
+{
+	int i;
+	FILE* out = fopen(path, "w");
+
+	if (out == NULL)
+		return 0;
+
+	fprintf(out, "{\"traceEvents\":[\n");
+	fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"main\"}}");
+
+	for (i = 1; i <= graph->worker_count; i++)
+		fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}", i, i);
+
+	/* Tasks that never ran have no place on the timeline. */
+	for (i = 0; i < graph->count; i++)
+	{
+		fl_task* t = &graph->tasks[i];
+
+		if (t->end == 0)
+			continue;
+
+		fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.1f,\"dur\":%.1f}",
+			t->name, t->where == FLURMP_TASK_MAIN ? "main" : "any", t->thread,
+			trace_time(graph, t->start), trace_time(graph, t->end) - trace_time(graph, t->start));
+	}
+
+	fprintf(out, "\n]}\n");
+
+	return fclose(out) == 0;
+}
+
+void fl_destroy_task_graph(fl_task_graph* graph)
+{
+	if (graph == NULL)
+		return;
+
+	fl_free(graph->tasks);
+	fl_free(graph->edges);
+	fl_free(graph->main_queue);
+	fl_free(graph->any_queue);
+	fl_destroy_cond(graph->wake_main);
+	fl_destroy_cond(graph->wake_workers);
+	fl_destroy_mutex(graph->lock);
+	fl_free(graph);
+}
@@ -1,104 +1,763 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_TEXT
+
 #include "core/text.h"
+#include "core/font_format.h"
+
+/* padding between glyphs on an atlas page,
+   which keeps filtering from bleeding neighbours into each other */
+#define GLYPH_PADDING 1
+
+
+
+/* -------------------------------------------------------------- */
+/*                    internal text functions                     */
+/* -------------------------------------------------------------- */
+
+/**
+ * Hashes a code point and font size into a bucket index.
+ *
+ * Params:
+ *   unsigned int - a code point
+ *   int - a font size
+ *
+ * Returns:
+ *   unsigned int - a bucket index
+ */
+static unsigned int hash_glyph(unsigned int code, int size);
+
+/**
+ * Creates the glyph lookup table of a font.
+ *
+ * Params:
+ *   fl_font - a font without a lookup table
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int create_buckets(fl_font* font);
+
+/**
+ * Opens the TTF of a font that was loaded from a bake. If the TTF
+ * cannot be opened, the font keeps to its baked glyphs from then on.
+ *
+ * Params:
+ *   fl_font - a font
+ *
+ * Returns:
+ *   int - 1 if the TTF is open, otherwise 0
+ */
+static int open_ttf(fl_font* font);
+
+/**
+ * Determines if a baked font was made for the size and colors of a font.
+ *
+ * Params:
+ *   fl_font - a font
+ *   const unsigned char* - the contents of a metrics file
+ *   size_t - the size of the metrics file
+ *
+ * Returns:
+ *   int - 1 if the metrics are valid and match the font, otherwise 0
+ */
+static int is_matching_bake(fl_font* font, const unsigned char* data, size_t size);
+
+/**
+ * Rasterizes a code point into the atlas of a font and adds it
+ * to the glyph lookup table.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_font - a font
+ *   unsigned int - a code point
+ *
+ * Returns:
+ *   fl_glyph - the new glyph, or NULL on failure
+ */
+static fl_glyph* cache_glyph(fl_context* context, fl_font* font, unsigned int code);
+
+/**
+ * Reserves an area of an atlas page on the page's current shelf,
+ * starting a new shelf if the area does not fit.
+ *
+ * Params:
+ *   fl_glyph_page* - an atlas page
+ *   int - the width of the area
+ *   int - the height of the area
+ *   fl_rect* - receives the reserved area
+ *
+ * Returns:
+ *   int - 1 if the area was reserved, 0 if the page is full
+ */
+static int pack_glyph(fl_glyph_page* page, int w, int h, fl_rect* area);
+
+/**
+ * Reserves an area for a glyph on any page of a font.
+ * A new page is added while the font is below its page limit,
+ * after which the least recently used page is recycled.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_font - a font
+ *   int - the width of the glyph
+ *   int - the height of the glyph
+ *   fl_rect* - receives the reserved area
+ *
+ * Returns:
+ *   int - the index of the page, or -1 on failure
+ */
+static int place_glyph(fl_context* context, fl_font* font, int w, int h, fl_rect* area);
+
+/**
+ * Removes every glyph on an atlas page from the lookup table
+ * and marks the page as empty. The texture is kept for reuse.
+ *
+ * Params:
+ *   fl_font - a font
+ *   int - the index of the page
+ */
+static void evict_page(fl_font* font, int page);
+
+/**
+ * Removes the baked glyphs of a font from the lookup table
+ * and frees them.
+ *
+ * Params:
+ *   fl_font - a font
+ */
+static void drop_baked_glyphs(fl_font* font);
+
+
+
+/* -------------------------------------------------------------- */
+/*             internal text functions (implementation)           */
+/* -------------------------------------------------------------- */
 
-fl_image* fl_create_glyph(fl_context* context, fl_resource* res, char c)
+static unsigned int hash_glyph(unsigned int code, int size)
 {
-	/* glyph data */
-	fl_image* image;
+	return (code * 2654435761u ^ (unsigned int)size * 40503u) & (FLURMP_GLYPH_BUCKETS - 1);
+}
+
+static int create_buckets(fl_font* font)
+{
+	int i;
 
-	/* Create an image of the character. */
-	image = fl_create_glyph_image(context, res, c);
+	font->buckets = fl_alloc(fl_glyph*, FLURMP_GLYPH_BUCKETS);
 
-	/* Verify image creation. */
-	if (image == NULL)
-		return NULL;
+	if (font->buckets == NULL)
+		return 0;
+
+	for (i = 0; i < FLURMP_GLYPH_BUCKETS; i++)
+		font->buckets[i] = NULL;
 
-	return image;
+	return 1;
 }
 
-int fl_create_font_atlas(fl_context* context, fl_resource* res)
+static int open_ttf(fl_font* font)
 {
-	if (res == NULL)
+	if (font->impl != NULL)
+		return 1;
+
+	if (font->path == NULL)
+		return 0;
+
+	font->impl = fl_load_ttf(font->path, font->size);
+
+	/* Don't try again for every glyph that is missing. */
+	if (font->impl == NULL)
 	{
-		context->error = FLURMP_ERR_FONTS;
+		fl_free(font->path);
+		font->path = NULL;
 		return 0;
 	}
 
-	int i, j; /* index variables */
+	return 1;
+}
 
-	/* We are using the character range 32 to 126 of the ASCII chart
-	   as printable characters. This is why we allocate space for
-	   95 glyphs. This range starts with the space character ' '
-	   and ends with the tilde character '~'. */
-	res->impl.font->glyphs = fl_alloc(fl_image*, 95);
+static int is_matching_bake(fl_font* font, const unsigned char* data, size_t size)
+{
+	fl_baked_font_header header;
+	fl_color fc = font->forecolor;
+	fl_color bc = font->backcolor;
 
-	/* Verify glyph memory allocation. */
-	if (res->impl.font->glyphs == NULL)
+	if (size < sizeof(header))
+		return 0;
+
+	memcpy(&header, data, sizeof(header));
+
+	if (memcmp(header.magic, FLURMP_BAKED_FONT_MAGIC, 4) || header.version != FLURMP_BAKED_FONT_VERSION)
+		return 0;
+
+	if (header.count > FLURMP_BAKED_GLYPH_LIMIT
+		|| (size - sizeof(header)) / sizeof(fl_baked_glyph) < header.count)
+		return 0;
+
+	/* The colors are part of the glyphs, so a bake
+	   in other colors can't be used. */
+	if (header.size != (uint32_t)font->size || header.background != (font->background ? 1u : 0u))
+		return 0;
+
+	if (header.forecolor[0] != fc.r || header.forecolor[1] != fc.g
+		|| header.forecolor[2] != fc.b || header.forecolor[3] != fc.a)
+		return 0;
+
+	if (font->background && (header.backcolor[0] != bc.r || header.backcolor[1] != bc.g
+		|| header.backcolor[2] != bc.b || header.backcolor[3] != bc.a))
+		return 0;
+
+	return 1;
+}
+
+static fl_glyph* cache_glyph(fl_context* context, fl_font* font, unsigned int code)
+{
+	int w, h;          /* glyph dimensions    */
+	fl_surface* surface;
+	fl_glyph* glyph;
+
+	/* Fonts loaded from a bake only open their TTF
+	   once a glyph that wasn't baked is drawn. */
+	if (!open_ttf(font))
+		return NULL;
+
+	surface = fl_create_glyph_surface(font, code, &w, &h);
+
+	if (surface == NULL)
+		return NULL;
+
+	glyph = fl_add_glyph(context, font, code, surface);
+	fl_destroy_surface(surface);
+
+	return glyph;
+}
+
+static int pack_glyph(fl_glyph_page* page, int w, int h, fl_rect* area)
+{
+	/* Start a new shelf below the current one
+	   when the glyph does not fit beside the last glyph. */
+	if (page->shelf_x + w > FLURMP_GLYPH_PAGE_SIZE)
 	{
-		context->error = FLURMP_ERR_FONTS;
+		page->shelf_y += page->shelf_h + GLYPH_PADDING;
+		page->shelf_x = 0;
+		page->shelf_h = 0;
+	}
+
+	if (w > FLURMP_GLYPH_PAGE_SIZE || page->shelf_y + h > FLURMP_GLYPH_PAGE_SIZE)
 		return 0;
+
+	fl_set_rect(area, page->shelf_x, page->shelf_y, w, h);
+
+	page->shelf_x += w + GLYPH_PADDING;
+	if (h > page->shelf_h)
+		page->shelf_h = h;
+
+	return 1;
+}
+
+static int place_glyph(fl_context* context, fl_font* font, int w, int h, fl_rect* area)
+{
+	int i;
+	int lru = 0; /* least recently used page */
+
+	/* Glyphs are only added to the newest page. Older pages stay
+	   closed even if a smaller glyph would still fit on them. */
+	if (font->page_count > 0 && pack_glyph(&font->pages[font->page_count - 1], w, h, area))
+		return font->page_count - 1;
+
+	/* Grow the atlas by another page. */
+	if (font->page_count < FLURMP_GLYPH_PAGE_LIMIT)
+	{
+		fl_glyph_page* page = &font->pages[font->page_count];
+
+		page->texture = fl_create_atlas_texture(context, FLURMP_GLYPH_PAGE_SIZE, FLURMP_GLYPH_PAGE_SIZE);
+
+		if (page->texture == NULL)
+			return -1;
+
+		page->shelf_x = 0;
+		page->shelf_y = 0;
+		page->shelf_h = 0;
+		page->used = font->clock;
+		page->glyphs = NULL;
+
+		font->page_count++;
+
+		return pack_glyph(page, w, h, area) ? font->page_count - 1 : -1;
+	}
+
+	/* Every page is in use, so recycle the one
+	   that has gone the longest without being drawn from. */
+	for (i = 1; i < font->page_count; i++)
+	{
+		if (font->pages[i].used < font->pages[lru].used)
+			lru = i;
 	}
 
-	/* Create the glyphs and add them to the atlas. */
-	for (i = 32; i < 127; i++)
+	evict_page(font, lru);
+	font->pages[lru].used = font->clock;
+
+	/* Move the recycled page to the end so that it becomes
+	   the page that new glyphs are added to. */
+	if (lru != font->page_count - 1)
 	{
-		fl_image* glyph = fl_create_glyph(context, res, (char)i);
+		fl_glyph_page last = font->pages[font->page_count - 1];
+		fl_glyph* g;
+
+		font->pages[font->page_count - 1] = font->pages[lru];
+		font->pages[lru] = last;
+
+		for (g = font->pages[lru].glyphs; g != NULL; g = g->page_next)
+			g->page = lru;
+
+		lru = font->page_count - 1;
+	}
+
+	return pack_glyph(&font->pages[lru], w, h, area) ? lru : -1;
+}
+
+static void evict_page(fl_font* font, int page)
+{
+	fl_glyph* g;
+	fl_glyph* next;
+	fl_glyph** link;
+
+	for (g = font->pages[page].glyphs; g != NULL; g = next)
+	{
+		next = g->page_next;
+
+		/* Unlink the glyph from its bucket. */
+		link = &font->buckets[hash_glyph(g->code, g->size)];
+		while (*link != g)
+			link = &(*link)->next;
+		*link = g->next;
+
+		fl_free(g);
+	}
+
+	font->pages[page].glyphs = NULL;
+	font->pages[page].shelf_x = 0;
+	font->pages[page].shelf_y = 0;
+	font->pages[page].shelf_h = 0;
+}
+
+static void drop_baked_glyphs(fl_font* font)
+{
+	int i;
+	fl_glyph** link;
 
-		if (glyph == NULL)
+	for (i = 0; font->buckets != NULL && i < FLURMP_GLYPH_BUCKETS; i++)
+	{
+		link = &font->buckets[i];
+
+		while (*link != NULL)
 		{
-			for (j = 0; j < res->impl.font->count; i++)
-				fl_destroy_image(res->impl.font->glyphs[i]);
+			if ((*link)->page < 0)
+				*link = (*link)->next;
+			else
+				link = &(*link)->next;
+		}
+	}
+
+	fl_free(font->baked_glyphs);
+	font->baked_glyphs = NULL;
+	font->baked_count = 0;
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                         text functions                         */
+/* -------------------------------------------------------------- */
+
+unsigned int fl_utf8_decode(const char** str)
+{
+	const unsigned char* s = (const unsigned char*)*str;
+	unsigned int code;
+	int len;
+	int i;
+
+	if (s[0] == 0)
+		return 0;
+
+	if (s[0] < 0x80)
+	{
+		*str += 1;
+		return s[0];
+	}
 
-			fl_free(res->impl.font->glyphs);
-			res->impl.font->glyphs = NULL;
-			res->impl.font->count = 0;
+	/* Determine the sequence length from the leading byte. */
+	if ((s[0] & 0xE0) == 0xC0)
+	{
+		code = s[0] & 0x1F;
+		len = 2;
+	}
+	else if ((s[0] & 0xF0) == 0xE0)
+	{
+		code = s[0] & 0x0F;
+		len = 3;
+	}
+	else if ((s[0] & 0xF8) == 0xF0)
+	{
+		code = s[0] & 0x07;
+		len = 4;
+	}
+	else
+	{
+		*str += 1;
+		return FLURMP_REPLACEMENT_CHARACTER;
+	}
 
-			context->error = FLURMP_ERR_FONTS;
-			return 0;
+	for (i = 1; i < len; i++)
+	{
+		/* A missing continuation byte ends the sequence early.
+		   The terminator is never a continuation byte. */
+		if ((s[i] & 0xC0) != 0x80)
+		{
+			*str += i;
+			return FLURMP_REPLACEMENT_CHARACTER;
 		}
 
-		res->impl.font->glyphs[res->impl.font->count++] = glyph;
+		code = (code << 6) | (s[i] & 0x3F);
 	}
 
-	return 1;
+	*str += len;
+
+	/* Reject overlong encodings, surrogates and
+	   values beyond the last code point. */
+	if ((len == 2 && code < 0x80) || (len == 3 && code < 0x800) ||
+		(len == 4 && code < 0x10000) || (code >= 0xD800 && code <= 0xDFFF) ||
+		code > 0x10FFFF)
+		return FLURMP_REPLACEMENT_CHARACTER;
+
+	return code;
 }
 
-fl_image* fl_char_to_glyph(fl_font* font, char c)
+int fl_utf8_encode(unsigned int code, char* out)
 {
-	if (font == NULL || font->glyphs == NULL || font->count == 0)
+	if (code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+		code = FLURMP_REPLACEMENT_CHARACTER;
+
+	if (code < 0x80)
+	{
+		out[0] = (char)code;
+		return 1;
+	}
+
+	if (code < 0x800)
+	{
+		out[0] = (char)(0xC0 | (code >> 6));
+		out[1] = (char)(0x80 | (code & 0x3F));
+		return 2;
+	}
+
+	if (code < 0x10000)
+	{
+		out[0] = (char)(0xE0 | (code >> 12));
+		out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+		out[2] = (char)(0x80 | (code & 0x3F));
+		return 3;
+	}
+
+	out[0] = (char)(0xF0 | (code >> 18));
+	out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+	out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+	out[3] = (char)(0x80 | (code & 0x3F));
+	return 4;
+}
+
+fl_glyph* fl_get_glyph(fl_context* context, fl_font* font, unsigned int code)
+{
+	fl_glyph* g;
+
+	if (context == NULL || font == NULL || code == 0)
+		return NULL;
+
+	/* The lookup table is created on first use
+	   so that fonts cost nothing until they are drawn with. */
+	if (font->buckets == NULL && !create_buckets(font))
+	{
+		context->error = FLURMP_ERR_FONTS;
 		return NULL;
+	}
 
-	int i = (int)c;
+	font->clock++;
 
-	/* If the character c is within the range of printable characters,
-	   return the glyph of that character,
-	   otherwise return a space glyph. */
-	return (i >= 32 && i <= 126) ? font->glyphs[i - 32] : font->glyphs[0];
+	for (g = font->buckets[hash_glyph(code, font->size)]; g != NULL; g = g->next)
+	{
+		if (g->code == code && g->size == font->size)
+			break;
+	}
+
+	if (g == NULL)
+		g = cache_glyph(context, font, code);
+
+	if (g != NULL && g->page >= 0)
+		font->pages[g->page].used = font->clock;
+
+	return g;
 }
 
-fl_image* fl_create_static_text(fl_context* context, fl_resource* res, const char* txt)
+fl_glyph* fl_add_glyph(fl_context* context, fl_font* font, unsigned int code, fl_surface* surface)
 {
-	/* static text data */
-	char* contents;
-	fl_image* image;
+	int page;          /* page index          */
+	unsigned int slot; /* bucket index        */
+	fl_rect area;      /* area on the page    */
+	fl_glyph* glyph;
 
-	if (txt == NULL)
+	if (font->buckets == NULL && !create_buckets(font))
 		return NULL;
 
-	/* Allocate memory for the character string contents. */
-	contents = fl_alloc(char, (strlen(txt) + 1));
+	glyph = fl_alloc(fl_glyph, 1);
 
-	/* Verify character string allocation. */
-	if (contents == NULL)
+	if (glyph == NULL)
+		return NULL;
+
+	page = place_glyph(context, font, surface->w, surface->h, &area);
+
+	if (page < 0 || !fl_update_texture(font->pages[page].texture, &area, surface))
+	{
+		fl_free(glyph);
 		return NULL;
+	}
+
+	glyph->code = code;
+	glyph->size = font->size;
+	glyph->page = page;
+	glyph->texture = font->pages[page].texture;
+	glyph->src = area;
+
+	/* Link the glyph into its bucket and its page. */
+	slot = hash_glyph(code, font->size);
+	glyph->next = font->buckets[slot];
+	font->buckets[slot] = glyph;
+	glyph->page_next = font->pages[page].glyphs;
+	font->pages[page].glyphs = glyph;
+
+	return glyph;
+}
+
+int fl_load_baked_glyphs(fl_context* context, fl_font* font, const char* metrics, const char* atlas)
+{
+	fl_surface* pixels;
+	int ok;
 
-	/* Populate the character buffer with the specified text. */
-	strcpy(contents, txt);
+	if (!fl_read_baked_glyphs(font, metrics, atlas, &pixels))
+		return 0;
+
+	ok = fl_upload_baked_glyphs(context, font, pixels);
+	fl_destroy_surface(pixels);
+
+	return ok;
+}
+
+int fl_read_baked_glyphs(fl_font* font, const char* metrics, const char* atlas, fl_surface** pixels)
+{
+	int i;
+	int ok = 1;
+	size_t size;
+	fl_baked_font_header header;
+	fl_baked_glyph entry;
+	fl_surface* surface;
+	fl_glyph* glyphs;
+	const unsigned char* data;
+
+	if (font->baked_glyphs != NULL)
+		return 0;
+
+	data = fl_read_asset(metrics, &size);
+
+	if (data == NULL)
+		return 0;
+
+	if (!is_matching_bake(font, data, size))
+	{
+		fl_release_asset(data);
+		return 0;
+	}
+
+	memcpy(&header, data, sizeof(header));
+
+	glyphs = fl_alloc(fl_glyph, header.count > 0 ? header.count : 1);
+	surface = glyphs != NULL ? fl_decode_image(atlas) : NULL;
+
+	if (surface == NULL)
+	{
+		fl_free(glyphs);
+		fl_release_asset(data);
+		return 0;
+	}
+
+	for (i = 0; ok && i < (int)header.count; i++)
+	{
+		memcpy(&entry, data + sizeof(header) + sizeof(entry) * i, sizeof(entry));
+
+		/* Every glyph must lie within the atlas. */
+		ok = entry.x + entry.w <= surface->w && entry.y + entry.h <= surface->h;
+
+		/* The texture is filled in once the atlas is uploaded. */
+		glyphs[i].code = entry.code;
+		glyphs[i].size = font->size;
+		glyphs[i].page = -1;
+		glyphs[i].texture = NULL;
+		fl_set_rect(&glyphs[i].src, entry.x, entry.y, entry.w, entry.h);
+		glyphs[i].page_next = NULL;
+	}
+
+	fl_release_asset(data);
+
+	if (!ok || (font->buckets == NULL && !create_buckets(font)))
+	{
+		fl_destroy_surface(surface);
+		fl_free(glyphs);
+		return 0;
+	}
+
+	for (i = 0; i < (int)header.count; i++)
+	{
+		unsigned int slot = hash_glyph(glyphs[i].code, font->size);
 
-	/* Create an image of the text. */
-	image = fl_create_text_image(context, res, contents);
+		glyphs[i].next = font->buckets[slot];
+		font->buckets[slot] = &glyphs[i];
+	}
+
+	font->baked_glyphs = glyphs;
+	font->baked_count = (int)header.count;
+	*pixels = surface;
+
+	return 1;
+}
+
+int fl_upload_baked_glyphs(fl_context* context, fl_font* font, fl_surface* pixels)
+{
+	int i;
+	fl_image* image = fl_alloc(fl_image, 1);
+
+	if (image == NULL || !fl_upload_image(context, pixels, image))
+	{
+		fl_free(image);
+		drop_baked_glyphs(font);
+		return 0;
+	}
+
+	for (i = 0; i < font->baked_count; i++)
+		font->baked_glyphs[i].texture = image->texture;
+
+	font->baked = image;
+
+	return 1;
+}
+
+void fl_destroy_glyph_cache(fl_font* font)
+{
+	int i;
+
+	if (font == NULL)
+		return;
+
+	for (i = 0; i < font->page_count; i++)
+	{
+		if (font->buckets != NULL)
+			evict_page(font, i);
+
+		fl_destroy_texture(font->pages[i].texture);
+		font->pages[i].texture = NULL;
+	}
+
+	font->page_count = 0;
+
+	/* Baked glyphs are only linked into the lookup table,
+	   which is freed with them. The atlas may not have
+	   been uploaded yet. */
+	if (font->baked_glyphs != NULL)
+	{
+		fl_free(font->baked_glyphs);
+		fl_destroy_image(font->baked);
+		font->baked_glyphs = NULL;
+		font->baked_count = 0;
+		font->baked = NULL;
+	}
+
+	if (font->buckets != NULL)
+	{
+		fl_free(font->buckets);
+		font->buckets = NULL;
+	}
+}
+
+fl_static_text* fl_create_static_text(fl_context* context, fl_resource* res, const char* txt)
+{
+	fl_static_text* text;
+	const char* pos;
+	unsigned int c;
+
+	if (res == NULL || txt == NULL)
+		return NULL;
+
+	text = fl_alloc(fl_static_text, 1);
+
+	if (text == NULL)
+		return NULL;
+
+	/* There is at most one glyph per byte of the string. */
+	text->glyphs = fl_alloc(fl_text_glyph, strlen(txt) + 1);
+
+	if (text->glyphs == NULL)
+	{
+		fl_free(text);
+		return NULL;
+	}
+
+	text->font = res->impl.font;
+	text->glyph_count = 0;
+	text->w = 0;
+	text->h = 0;
+
+	pos = txt;
+
+	while ((c = fl_utf8_decode(&pos)) != 0)
+	{
+		fl_glyph* g = fl_get_glyph(context, text->font, c);
+
+		if (g == NULL)
+			continue;
+
+		text->glyphs[text->glyph_count].code = c;
+		text->glyphs[text->glyph_count].x = text->w;
+		text->glyph_count++;
+
+		text->w += g->src.w;
+		if (g->src.h > text->h)
+			text->h = g->src.h;
+	}
+
+	return text;
+}
+
+void fl_draw_static_text(fl_context* context, fl_static_text* text, int x, int y)
+{
+	int i;
+	fl_rect dest;
+
+	if (text == NULL)
+		return;
+
+	for (i = 0; i < text->glyph_count; i++)
+	{
+		fl_glyph* g = fl_get_glyph(context, text->font, text->glyphs[i].code);
+
+		if (g == NULL)
+			continue;
+
+		fl_set_rect(&dest, x + text->glyphs[i].x, y, g->src.w, g->src.h);
+		fl_draw(context, g->texture, &g->src, &dest, 0);
+	}
+}
+
+void fl_destroy_static_text(fl_static_text* text)
+{
+	if (text == NULL)
+		return;
 
-	/* Dispose of the string. */
-	fl_free(contents);
+	if (text->glyphs != NULL)
+		fl_free(text->glyphs);
 
-	return image;
+	fl_free(text);
 }
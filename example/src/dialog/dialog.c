@@ -1,11 +1,17 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_DIALOG
+
 #include "core/dialog.h"
 #include "core/input.h"
 #include "core/text.h"
 
 #define ROW_COUNT 2
-#define BUFFER_LIMIT 120
+#define ROW_HEIGHT 22
 #define LINE_WIDTH 450
 
+/* characters revealed per second at a speed of 1,
+   which matches one character per frame at 60 frames per second */
+#define REVEAL_RATE 60
+
 
 
 /* -------------------------------------------------------------- */
@@ -13,7 +19,8 @@
 /* -------------------------------------------------------------- */
 
 /**
- * Appends the next set of characters to the dialog buffer.
+ * Reveals the characters of the current page that are due
+ * based on the time elapsed since the page was shown.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -23,6 +30,7 @@ static void update(fl_context* context, fl_dialog* self);
 
 /**
  * Renders a dialog to the screen.
+ * Only the revealed glyphs of the current page are drawn.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -32,14 +40,13 @@ static void render(fl_context* context, fl_dialog* self);
 
 /**
  * The input handler function for dialogs.
- * A dialog should consume two inputs: the J key, and the K key.
- * By pressing either the J or K key, the current dialog should
- * be destroyed, if applicable, and the callback should be invoked.
- * Pressing the J or K key should destroy the dialog, if applicable,
- * and invoke the callback function.
- * If the K key is pressed before the message has been completely displayed,
- * then the remaining characters of the message should be written to
- * the dialog buffer.
+ * A dialog should consume two inputs: the primary action (the J key),
+ * and the secondary action (the K key).
+ * Once the current page has been completely displayed, either action
+ * advances to the next page. Either action on the last page destroys the
+ * dialog, if applicable, and invokes the callback.
+ * If the secondary action is used before the current page has been
+ * completely displayed, the rest of the page is displayed immediately.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -48,22 +55,51 @@ static void render(fl_context* context, fl_dialog* self);
 static void handle_input(fl_context* context, fl_input_handler* self);
 
 /**
- * Appends a single character to the current active dialog buffer.
+ * Wraps a message into lines and pages of glyphs.
+ * Lines are broken between words where possible, using the
+ * width of each glyph in the dialog font.
  *
  * Params:
  *   fl_context - a Flurmp context
- *   char - a character
+ *   fl_dialog - a dialog
+ *   const char* - the UTF-8 encoded message
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int layout(fl_context* context, fl_dialog* dialog, const char* msg);
+
+/**
+ * Moves the layout to the next row, starting a new page
+ * if the current page is full.
+ *
+ * Params:
+ *   fl_dialog - a dialog
+ *   int* - the current row
+ *   int - the index of the first glyph on the new row
  */
-static void dialog_putc(fl_dialog* dialog, char c);
+static void next_row(fl_dialog* dialog, int* row, int first);
 
 /**
- * Clears the contents of the current dialog buffer by setting all
- * characters to '\0' and setting the buffer count to 0.
+ * Gets the number of glyphs on the current page of a dialog.
  *
  * Params:
  *   fl_dialog - a dialog
+ *
+ * Returns:
+ *   int - the number of glyphs
+ */
+static int page_length(fl_dialog* dialog);
+
+/**
+ * Shows the next page of a dialog, or closes the dialog if
+ * the last page is being shown.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_dialog - the active dialog
  */
-static void clear_buffer(fl_dialog* dialog);
+static void advance(fl_context* context, fl_dialog* dialog);
 
 
 
@@ -73,23 +109,30 @@ static void clear_buffer(fl_dialog* dialog);
 
 static void update(fl_context* context, fl_dialog* self)
 {
-	if (self->counter < self->len)
-	{
-		if (self->msg != NULL)
-			dialog_putc(self, self->msg[self->counter]);
+	unsigned long due;
+	int count = page_length(self);
 
-		self->counter++;
+	if (self->revealed >= count)
+		return;
+
+	if (self->speed <= 0)
+	{
+		self->revealed = count;
+		return;
 	}
+
+	due = (context->ticks - self->page_ticks) * self->speed * REVEAL_RATE / 1000;
+
+	self->revealed = due < (unsigned long)count ? (int)due : count;
 }
 
 static void render(fl_context* context, fl_dialog* self)
 {
-	int i;         /* index variable     */
-	int cx;        /* cursor x position  */
-	int cy;        /* cursor y position  */
-	fl_rect frame; /* dialog frame       */
-	fl_rect src;   /* render source      */
-	fl_rect dest;  /* render destination */
+	int i;                 /* index variable     */
+	fl_dialog_glyph* run;  /* current page       */
+	fl_rect frame;         /* dialog frame       */
+	fl_rect dest;          /* render destination */
+	fl_glyph* g;           /* current glyph      */
 
 	fl_set_rect(&frame, self->x, self->y, self->w, self->h);
 
@@ -99,47 +142,34 @@ static void render(fl_context* context, fl_dialog* self)
 	fl_set_draw_color(context, 250, 250, 250, 255);
 	fl_draw_rect(context, &frame);
 
-	dest.x = 0;
-	dest.y = 0;
-	src.x = 0;
-	src.y = 0;
+	/* The glyphs were positioned when the dialog was created,
+	   so drawing is a single pass over the revealed prefix. */
+	run = self->glyphs + self->pages[self->page];
 
-	for (i = cx = cy = 0; i < BUFFER_LIMIT; i++)
+	for (i = 0; i < self->revealed; i++)
 	{
-		if (self->buffer[i] >= 0x20 && self->buffer[i] <= 0x7E)
-		{
-			/* Get the appropriate glyph from the font atlas. */
-			fl_image* g = fl_char_to_glyph(self->font, self->buffer[i]);
+		g = fl_get_glyph(context, self->font, run[i].code);
 
-			dest.x = self->x + cx + 10;
-			dest.y = self->y + cy * 22 + 10;
-			dest.w = g->w;
-			dest.h = g->h;
+		if (g == NULL)
+			continue;
 
-			src.w = g->w;
-			src.h = g->h;
+		dest.x = self->x + run[i].x + 10;
+		dest.y = self->y + run[i].row * ROW_HEIGHT + 10;
+		dest.w = g->src.w;
+		dest.h = g->src.h;
 
-			fl_draw(context, g->texture, &src, &dest, 0);
+		fl_draw(context, g->texture, &g->src, &dest, 0);
+	}
 
-			if (cx >= LINE_WIDTH)
-			{
-				/* If the current line exceeds the
-				   line width pixel limit,
-				   increment the cursor's y position. */
-				cx = 0;
-				if (cy < ROW_COUNT - 1)
-					cy++;
-			}
-			else
-				cx += g->w;
-		}
-		else if (self->buffer[i] == 0x0A)
+	/* Indicate that there are more pages to read. */
+	if (self->revealed >= page_length(self) && self->page < self->page_count - 1)
+	{
+		g = fl_get_glyph(context, self->font, '>');
+
+		if (g != NULL)
 		{
-			/* If we encounter a newline,
-			   increment the cursor's y position. */
-			cx = 0;
-			if (cy < ROW_COUNT - 1)
-				cy++;
+			fl_set_rect(&dest, self->x + self->w - g->src.w - 10, self->y + self->h - g->src.h - 10, g->src.w, g->src.h);
+			fl_draw(context, g->texture, &g->src, &dest, 0);
 		}
 	}
 }
@@ -149,104 +179,174 @@ static void handle_input(fl_context* context, fl_input_handler* self)
 	if (context == NULL || context->active_dialog == NULL)
 		return;
 
-	if (self->child != NULL)
-	{
-		self->child->handle_input(context, self->child);
-		return;
-	}
-
 	fl_dialog* dialog = context->active_dialog;
-	void(*callback) (fl_context*) = dialog->callback;
 
-	/* Handle the J key */
-	if (fl_consume_key(context, FLURMP_SC_J))
+	/* Handle the primary action (the J key by default). */
+	if (fl_consume_action(context, FLURMP_ACTION_PRIMARY))
 	{
-		/* Do not proceed unless the current dialog message
+		/* Do not proceed unless the current page
 		   has been completely displayed. */
-		if (dialog->counter < dialog->len)
+		if (dialog->revealed < page_length(dialog))
 			return;
 
-		/* If the dialog is not marked as "hold", destroy
-		   it here, otherwise its destruction should be handled
-		   in the callback function. */
-		if (!dialog->hold)
+		advance(context, dialog);
+		return;
+	}
+
+	/* Handle the secondary action (the K key by default). */
+	if (fl_consume_action(context, FLURMP_ACTION_SECONDARY))
+	{
+		/* If the page has not yet been completely displayed,
+		   display the rest of it. */
+		if (dialog->revealed < page_length(dialog))
 		{
-			/* Clear the active dialog pointer. */
-			context->active_dialog = NULL;
+			dialog->revealed = page_length(dialog);
+			return;
+		}
 
-			/* Relenquish input control. */
-			fl_pop_input_handler(context);
+		advance(context, dialog);
+		return;
+	}
+}
 
-			/* Destroy the dialog. */
-			fl_destroy_dialog(dialog);
-		}
+static int layout(fl_context* context, fl_dialog* dialog, const char* msg)
+{
+	size_t len = strlen(msg);
+	const char* text = msg;
+	unsigned int c;
+	int j;
+	int cx = 0;         /* x position of the next glyph          */
+	int row = 0;        /* row of the next glyph within its page */
+	int line_start = 0; /* first glyph of the current line       */
+	int word_start = 0; /* first glyph of the current word       */
+
+	/* There is at most one glyph per byte, and at most one
+	   page per line plus an entry marking the end of the last page.
+	   The arrays are kept between messages and only grow. */
+	if (dialog->glyph_capacity < (int)len + 1)
+	{
+		if (dialog->glyphs != NULL)
+			fl_free(dialog->glyphs);
+
+		dialog->glyphs = fl_alloc(fl_dialog_glyph, len + 1);
+		dialog->glyph_capacity = dialog->glyphs != NULL ? (int)len + 1 : 0;
+	}
 
-		/* If a callback function is present, invoke it here. */
-		if (callback != NULL)
-			callback(context);
+	if (dialog->page_capacity < (int)len + 2)
+	{
+		if (dialog->pages != NULL)
+			fl_free(dialog->pages);
 
-		return;
+		dialog->pages = fl_alloc(int, len + 2);
+		dialog->page_capacity = dialog->pages != NULL ? (int)len + 2 : 0;
 	}
 
-	/* Handle the K key */
-	if (fl_consume_key(context, FLURMP_SC_K))
+	if (dialog->glyphs == NULL || dialog->pages == NULL)
+		return 0;
+
+	dialog->glyph_count = 0;
+	dialog->pages[0] = 0;
+	dialog->page_count = 1;
+
+	while ((c = fl_utf8_decode(&text)) != 0)
 	{
-		/* If the message has not yet been completely displayed,
-		   write the remaining characters in the message to the
-		   dialog buffer. */
-		if (dialog->counter < dialog->len && dialog->msg != NULL)
+		fl_glyph* g;
+
+		if (c == '\n')
 		{
-			size_t i;
-			for (i = dialog->counter; i < dialog->len; i++)
-				dialog_putc(dialog, dialog->msg[i]);
+			next_row(dialog, &row, dialog->glyph_count);
+			cx = 0;
+			line_start = word_start = dialog->glyph_count;
+			continue;
+		}
 
-			dialog->counter = dialog->len;
+		/* Skip spaces at the beginning of a line. */
+		if (c == ' ' && dialog->glyph_count == line_start)
+			continue;
 
-			return;
-		}
+		g = fl_get_glyph(context, dialog->font, c);
+
+		if (g == NULL)
+			continue;
 
-		/* If the dialog is not marked as "hold", destroy
-		   it here, otherwise its destruction should be handled
-		   in the callback function. */
-		if (!dialog->hold)
+		/* Wrap when the glyph would cross the right edge of the text area.
+		   Trailing spaces are allowed to hang past the edge. */
+		if (c != ' ' && cx + g->src.w > LINE_WIDTH && dialog->glyph_count > line_start)
 		{
-			/* Clear the active dialog pointer. */
-			context->active_dialog = NULL;
+			/* Move the current word to the next line, unless it
+			   fills the whole line, in which case it is split here. */
+			if (word_start == line_start)
+				word_start = dialog->glyph_count;
 
-			/* Relenquish input control. */
-			fl_pop_input_handler(context);
+			next_row(dialog, &row, word_start);
+			line_start = word_start;
+			cx = 0;
 
-			/* Destroy the dialog. */
-			fl_destroy_dialog(dialog);
+			for (j = word_start; j < dialog->glyph_count; j++)
+			{
+				dialog->glyphs[j].x = cx;
+				dialog->glyphs[j].row = row;
+				cx += dialog->glyphs[j].w;
+			}
 		}
 
-		/* If a callback function is present, invoke it here. */
-		if (callback != NULL)
-			callback(context);
+		dialog->glyphs[dialog->glyph_count].code = c;
+		dialog->glyphs[dialog->glyph_count].w = g->src.w;
+		dialog->glyphs[dialog->glyph_count].x = cx;
+		dialog->glyphs[dialog->glyph_count].row = row;
+		dialog->glyph_count++;
 
-		return;
+		cx += g->src.w;
+
+		if (c == ' ')
+			word_start = dialog->glyph_count;
 	}
+
+	/* Mark the end of the last page. */
+	dialog->pages[dialog->page_count] = dialog->glyph_count;
+
+	return 1;
 }
 
-static void dialog_putc(fl_dialog* dialog, char c)
+static void next_row(fl_dialog* dialog, int* row, int first)
 {
-	if (dialog == NULL || dialog->buffer_count >= BUFFER_LIMIT)
+	if (++(*row) < ROW_COUNT)
 		return;
 
-	/* Add the character to the buffer and increment the buffer count. */
-	dialog->buffer[dialog->buffer_count++] = c;
+	*row = 0;
+
+	/* Avoid empty pages caused by consecutive line breaks. */
+	if (first > dialog->pages[dialog->page_count - 1])
+		dialog->pages[dialog->page_count++] = first;
 }
 
-static void clear_buffer(fl_dialog* dialog)
+static int page_length(fl_dialog* dialog)
 {
-	if (dialog == NULL)
+	return dialog->pages[dialog->page + 1] - dialog->pages[dialog->page];
+}
+
+static void advance(fl_context* context, fl_dialog* dialog)
+{
+	void(*callback) (fl_context*) = dialog->callback;
+
+	/* Show the next page, if there is one. */
+	if (dialog->page < dialog->page_count - 1)
+	{
+		dialog->page++;
+		dialog->revealed = 0;
+		dialog->page_ticks = context->ticks;
 		return;
+	}
 
-	/* Set all characters in the buffer to '\0'. */
-	fl_zero(dialog->buffer, BUFFER_LIMIT);
+	/* If the dialog is not marked as "hold", close
+	   it here, otherwise it should be closed
+	   in the callback function. */
+	if (!dialog->hold)
+		fl_close_dialog(context);
 
-	/* Reset the buffer count. */
-	dialog->buffer_count = 0;
+	/* If a callback function is present, invoke it here. */
+	if (callback != NULL)
+		callback(context);
 }
 
 
@@ -278,33 +378,30 @@ fl_dialog* fl_create_dialog(fl_context* context)
 	dialog->h = 100;
 	dialog->update = update;
 	dialog->render = render;
-	dialog->buffer = NULL;
 	dialog->input_handler = NULL;
 	dialog->msg = NULL;
-	dialog->buffer_count = 0;
-	dialog->counter = 0;
-	dialog->counter = 0;
-	dialog->len = 0;
+	dialog->glyphs = NULL;
+	dialog->glyph_count = 0;
+	dialog->glyph_capacity = 0;
+	dialog->pages = NULL;
+	dialog->page_count = 0;
+	dialog->page_capacity = 0;
+	dialog->page = 0;
+	dialog->revealed = 0;
+	dialog->page_ticks = context->ticks;
 	dialog->speed = 0;
 	dialog->callback = NULL;
 	dialog->hold = 0;
 
-	/* Allocate memory for the buffer. */
-	char* buffer = fl_alloc(char, BUFFER_LIMIT);
+	dialog->input_handler = fl_create_input_handler(handle_input);
 
-	/* Verify buffer allocation. */
-	if (buffer == NULL)
+	/* Verify input handler creation. */
+	if (dialog->input_handler == NULL)
 	{
 		fl_destroy_dialog(dialog);
 		return NULL;
 	}
 
-	/* Set the characters in the buffer to '\0'. */
-	fl_zero(buffer, BUFFER_LIMIT);
-
-	dialog->buffer = buffer;
-	dialog->input_handler = fl_create_input_handler(handle_input);
-
 	return dialog;
 }
 
@@ -313,8 +410,11 @@ void fl_destroy_dialog(fl_dialog* dialog)
 	if (dialog == NULL)
 		return;
 
-	if (dialog->buffer != NULL)
-		fl_free(dialog->buffer);
+	if (dialog->glyphs != NULL)
+		fl_free(dialog->glyphs);
+
+	if (dialog->pages != NULL)
+		fl_free(dialog->pages);
 
 	if (dialog->input_handler != NULL)
 		fl_destroy_input_handler(dialog->input_handler);
@@ -327,17 +427,25 @@ void fl_dialog_write(fl_context* context, const char* msg, int speed, void(*call
 	if (context->active_dialog != NULL || msg == NULL)
 		return;
 
-	/* Determine the length of the message. */
-	size_t len = strlen(msg);
+	/* Reuse the dialog of the previous message,
+	   creating it the first time a message is written. */
+	if (context->dialog_cache == NULL)
+		context->dialog_cache = fl_create_dialog(context);
 
-	/* Create a new dialog. */
-	fl_dialog* dialog = fl_create_dialog(context);
+	fl_dialog* dialog = context->dialog_cache;
 
-	dialog->len = len;
-	dialog->counter = 0;
+	if (dialog == NULL)
+		return;
+
+	/* Lay out the whole message once, up front. */
+	if (!layout(context, dialog, msg))
+		return;
 
+	dialog->page = 0;
+	dialog->revealed = 0;
+	dialog->page_ticks = context->ticks;
 	dialog->msg = msg;
-	dialog->speed = speed; /* TODO: implement speed */
+	dialog->speed = speed;
 	dialog->callback = callback;
 	dialog->hold = hold;
 
@@ -345,3 +453,16 @@ void fl_dialog_write(fl_context* context, const char* msg, int speed, void(*call
 	context->active_dialog = dialog;
 	fl_push_input_handler(context, dialog->input_handler);
 }
+
+void fl_close_dialog(fl_context* context)
+{
+	if (context == NULL || context->active_dialog == NULL)
+		return;
+
+	/* Clear the active dialog pointer. The dialog itself
+	   stays in the cache for the next message. */
+	context->active_dialog = NULL;
+
+	/* Relenquish input control. */
+	fl_pop_input_handler(context);
+}
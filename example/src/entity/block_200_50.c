@@ -1,3 +1,5 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_ENTITY
+
 #include "entity/block_200_50.h"
 #include "entity/entity.h"
 #include "core/resource.h"
@@ -22,24 +24,15 @@
 static void collide(fl_context*, fl_entity*, fl_entity*, int, int);
 
 /**
- * Does nothing.
- * A solid block has no reason to change.
- *
- * Params:
- *   fl_context - a Flurmp context
- *   fl_entity - the 200 x 50 block entity
- *   int - an axis
- */
-static void update(fl_context*, fl_entity*, int);
-
-/**
- * Renders a 200 x 50 block entity to the screen.
+ * Renders all 200 x 50 block entities to the screen.
+ * A solid block has no reason to change, so there is no update callback.
  *
  * Params:
  *   fl_context - a Flurmp context
- *   fl_entity - the 200 x 50 block entity
+ *   fl_entity** - the 200 x 50 block entities
+ *   int - the number of entities
  */
-static void render(fl_context*, fl_entity*);
+static void render_all(fl_context*, fl_entity**, int);
 
 
 
@@ -100,34 +93,36 @@ static void collide(fl_context* context, fl_entity* self, fl_entity* other, int
 	}
 }
 
-static void update(fl_context* context, fl_entity* self, int axis)
-{
-
-}
-
-static void render(fl_context* context, fl_entity* self)
+static void render_all(fl_context* context, fl_entity** entities, int count)
 {
-	int i;
-	int self_w = context->entity_types[self->type].w;
-	int self_h = context->entity_types[self->type].h;
-	fl_texture* tex = context->entity_types[self->type].texture->impl.image->texture;
+	int i, j;
+	fl_texture* tex = context->entity_types[FLURMP_ENTITY_BLOCK_200_50].texture->impl.image->texture;
 
 	fl_rect src;
 	fl_rect dest;
 
 	fl_set_rect(&src, 0, 0, 50, 50);
 
-	dest.x = self->x - context->cam_x;
-	dest.y = self->y - context->cam_y;
 	dest.w = 50;
 	dest.h = 50;
 
-	/* This entity is 200 pixels wide, so copy a 50 pixel
-	   tile 4 times */
-	for (i = 0; i < 4; i++)
+	for (i = 0; i < count; i++)
 	{
-		fl_draw(context, tex, &src, &dest, 0);
-		dest.x += dest.w;
+		fl_entity* self = entities[i];
+
+		if (!(self->flags & FLURMP_ALIVE_FLAG))
+			continue;
+
+		dest.x = self->x - context->cam_x;
+		dest.y = self->y - context->cam_y;
+
+		/* This entity is 200 pixels wide, so copy a 50 pixel
+		   tile 4 times */
+		for (j = 0; j < 4; j++)
+		{
+			fl_draw(context, tex, &src, &dest, 0);
+			dest.x += dest.w;
+		}
 	}
 }
 
@@ -151,6 +146,8 @@ fl_entity* fl_create_block_200_50(int x, int y)
 	block->y_v = 0;
 	block->x = x;
 	block->y = y;
+	block->animator = -1;
+	block->body = -1;
 	block->life = 1;
 
 	return block;
@@ -160,12 +157,17 @@ void fl_register_block_200_50_type(fl_context* context, fl_entity_type* et)
 {
 	et->w = 200;
 	et->h = 50;
+	et->layer = FLURMP_LAYER_SCENERY;
+	et->z = 0;
 
 	et->collide = collide;
-	et->update = update;
-	et->render = render;
+	et->update = NULL;
+	et->render = NULL;
+	et->update_all = NULL;
+	et->render_all = render_all;
 
 	et->texture = NULL;
 	et->animations = NULL;
 	et->animation_count = 0;
+	et->body = NULL;
 }
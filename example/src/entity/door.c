@@ -1,7 +1,10 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_ENTITY
+
 #include "entity/door.h"
 #include "entity/entity.h"
 #include "core/resource.h"
 #include "core/dialog.h"
+#include "core/audio.h"
 #include "scene/scene.h"
 
 
@@ -28,24 +31,15 @@
 static void collide(fl_context*, fl_entity*, fl_entity*, int, int);
 
 /**
- * Does nothing.
- * A door is not affected by physics.
+ * Renders all door entities to the screen.
+ * A door is not affected by physics. Because of this, there is no update callback.
  *
  * Params:
  *   fl_context - a Flurmp context
- *   fl_entity - a door entity
- *   int - an axis
+ *   fl_entity** - the door entities
+ *   int - the number of entities
  */
-static void update(fl_context*, fl_entity*, int);
-
-/**
- * Renders a door entity to the screen.
- *
- * Params:
- *   fl_context - a Flurmp context
- *   fl_entity - the door entity
- */
-static void render(fl_context*, fl_entity*);
+static void render_all(fl_context*, fl_entity**, int);
 
 
 
@@ -60,6 +54,8 @@ static void collide(fl_context* context, fl_entity* self, fl_entity* other, int
 	{
 		other->flags &= ~(FLURMP_INTERACT_FLAG);
 
+		fl_play_sound(context->audio, FLURMP_SOUND_DOOR, 1.0f);
+
 		if (context->scene == FLURMP_SCENE_TEST_1)
 			fl_schedule_scene_transition(context, context->scene, FLURMP_SCENE_TEST_2);
 		else if (context->scene == FLURMP_SCENE_TEST_2)
@@ -67,28 +63,33 @@ static void collide(fl_context* context, fl_entity* self, fl_entity* other, int
 	}
 }
 
-static void update(fl_context* context, fl_entity* self, int axis)
+static void render_all(fl_context* context, fl_entity** entities, int count)
 {
-
-}
-
-static void render(fl_context* context, fl_entity* self)
-{
-	int self_w = context->entity_types[self->type].w;
-	int self_h = context->entity_types[self->type].h;
-	fl_texture* tex = context->entity_types[self->type].texture->impl.image->texture;
+	int i;
+	int self_w = context->entity_types[FLURMP_ENTITY_DOOR].w;
+	int self_h = context->entity_types[FLURMP_ENTITY_DOOR].h;
+	fl_texture* tex = context->entity_types[FLURMP_ENTITY_DOOR].texture->impl.image->texture;
 
 	fl_rect src;
 	fl_rect dest;
 
 	fl_set_rect(&src, 0, 0, 30, 40);
 
-	dest.x = self->x - context->cam_x;
-	dest.y = self->y - context->cam_y;
 	dest.w = self_w;
 	dest.h = self_h;
 
-	fl_draw(context, tex, &src, &dest, 0);
+	for (i = 0; i < count; i++)
+	{
+		fl_entity* self = entities[i];
+
+		if (!(self->flags & FLURMP_ALIVE_FLAG))
+			continue;
+
+		dest.x = self->x - context->cam_x;
+		dest.y = self->y - context->cam_y;
+
+		fl_draw(context, tex, &src, &dest, 0);
+	}
 }
 
 
@@ -111,6 +112,8 @@ fl_entity* fl_create_door(int x, int y)
 	door->y_v = 0;
 	door->x = x;
 	door->y = y;
+	door->animator = -1;
+	door->body = -1;
 	door->life = 1;
 
 	return door;
@@ -120,12 +123,17 @@ void fl_register_door_type(fl_context* context, fl_entity_type* et)
 {
 	et->w = 30;
 	et->h = 40;
+	et->layer = FLURMP_LAYER_SCENERY;
+	et->z = 3;
 
 	et->collide = collide;
-	et->update = update;
-	et->render = render;
+	et->update = NULL;
+	et->render = NULL;
+	et->update_all = NULL;
+	et->render_all = render_all;
 
 	et->texture = NULL;
 	et->animations = NULL;
 	et->animation_count = 0;
+	et->body = NULL;
 }
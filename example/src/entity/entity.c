@@ -0,0 +1,614 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_ENTITY
+
+#include "entity/entity.h"
+#include "core/animation.h"
+#include "core/body.h"
+#include "core/layer.h"
+
+/* initial number of slots in an entity table */
+#define INITIAL_SLOT_CAPACITY 64
+
+/* initial number of entity commands per update */
+#define INITIAL_COMMAND_CAPACITY 32
+
+
+
+/* -------------------------------------------------------------- */
+/*                     internal entity functions                  */
+/* -------------------------------------------------------------- */
+
+/**
+ * Doubles the number of slots in an entity table.
+ * The new slots are empty and go on the free list.
+ *
+ * Params:
+ *   fl_entity_table - an entity table
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int grow_table(fl_entity_table* table);
+
+/**
+ * Empties a slot of an entity table and puts it on the free list.
+ * The generation of the slot advances, so handles to the entity
+ * that was in the slot no longer resolve.
+ *
+ * Params:
+ *   fl_entity_table - an entity table
+ *   int - the index of a slot in use
+ */
+static void release_slot(fl_entity_table* table, int index);
+
+/**
+ * Determines if an entity has been despawned.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity in the entity list
+ *
+ * Returns:
+ *   int - 1 if the entity has been despawned, or 0 if it has not
+ */
+static int is_despawned(fl_context* context, fl_entity* entity);
+
+/**
+ * Appends an entity to the group of entities of the same type.
+ * The group's storage grows as needed.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int add_to_group(fl_context* context, fl_entity* entity);
+
+/**
+ * Removes an entity from the group of entities of its type,
+ * keeping the order of the rest of the group.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity
+ */
+static void remove_from_group(fl_context* context, fl_entity* entity);
+
+/**
+ * Invalidates the cached layer of an entity type if the layer is static.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - an entity type
+ */
+static void invalidate_type_layer(fl_context* context, int type);
+
+/**
+ * Appends a command to the entity commands of a context.
+ * The storage doubles when it is full.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   int - the command (e.g. FLURMP_ENTITY_COMMAND_SPAWN)
+ *   fl_handle - the entity the command applies to
+ *   fl_entity - the entity to add, for a spawn
+ *   int - the new entity type, for a type change
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int push_command(fl_context* context, int command, fl_handle target, fl_entity* entity, int type);
+
+/**
+ * Changes the type of an entity in place.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity
+ *   int - the new entity type
+ */
+static void change_type(fl_context* context, fl_entity* entity, int type);
+
+
+
+/* -------------------------------------------------------------- */
+/*            internal entity functions (implementation)          */
+/* -------------------------------------------------------------- */
+
+static int grow_table(fl_entity_table* table)
+{
+	int i;
+	int capacity = table->capacity > 0 ? table->capacity * 2 : INITIAL_SLOT_CAPACITY;
+
+	fl_entity** slots = fl_alloc(fl_entity*, capacity);
+	unsigned int* generations = fl_alloc(unsigned int, capacity);
+	int* free_slots = fl_alloc(int, capacity);
+
+	if (slots == NULL || generations == NULL || free_slots == NULL)
+	{
+		fl_free(slots);
+		fl_free(generations);
+		fl_free(free_slots);
+		return 0;
+	}
+
+	for (i = 0; i < table->capacity; i++)
+	{
+		slots[i] = table->slots[i];
+		generations[i] = table->generations[i];
+	}
+
+	for (i = 0; i < table->free_count; i++)
+		free_slots[i] = table->free_slots[i];
+
+	/* Generation 0 belongs to the null handle. Push the new slots in
+	   reverse so that the lowest index is handed out first. */
+	for (i = capacity - 1; i >= table->capacity; i--)
+	{
+		slots[i] = NULL;
+		generations[i] = 1;
+		free_slots[table->free_count++] = i;
+	}
+
+	fl_free(table->slots);
+	fl_free(table->generations);
+	fl_free(table->free_slots);
+
+	table->slots = slots;
+	table->generations = generations;
+	table->free_slots = free_slots;
+	table->capacity = capacity;
+
+	return 1;
+}
+
+static void release_slot(fl_entity_table* table, int index)
+{
+	table->slots[index] = NULL;
+
+	if (++table->generations[index] == 0)
+		table->generations[index] = 1;
+
+	table->free_slots[table->free_count++] = index;
+	table->count--;
+}
+
+static int is_despawned(fl_context* context, fl_entity* entity)
+{
+	return fl_get_entity(context, entity->handle) != entity;
+}
+
+static int add_to_group(fl_context* context, fl_entity* entity)
+{
+	if (context->entity_groups == NULL || entity == NULL)
+		return 0;
+
+	fl_entity_group* group = &(context->entity_groups[entity->type]);
+
+	/* Double the capacity of the group if it is full. */
+	if (group->count >= group->capacity)
+	{
+		int capacity = group->capacity > 0 ? group->capacity * 2 : 8;
+		fl_entity** entities = fl_alloc(fl_entity*, capacity);
+
+		if (entities == NULL)
+			return 0;
+
+		if (group->entities != NULL)
+		{
+			memcpy(entities, group->entities, sizeof(fl_entity*) * group->count);
+			fl_free(group->entities);
+		}
+
+		group->entities = entities;
+		group->capacity = capacity;
+	}
+
+	group->entities[group->count++] = entity;
+
+	return 1;
+}
+
+static void remove_from_group(fl_context* context, fl_entity* entity)
+{
+	int i;
+	fl_entity_group* group = &(context->entity_groups[entity->type]);
+
+	for (i = 0; i < group->count && group->entities[i] != entity; i++);
+
+	if (i == group->count)
+		return;
+
+	for (group->count--; i < group->count; i++)
+		group->entities[i] = group->entities[i + 1];
+}
+
+static void invalidate_type_layer(fl_context* context, int type)
+{
+	int layer = context->entity_types[type].layer;
+
+	if (context->layers[layer].is_static)
+		fl_invalidate_layer(context, layer);
+}
+
+static int push_command(fl_context* context, int command, fl_handle target, fl_entity* entity, int type)
+{
+	fl_entity_command_list* list = &(context->entity_commands);
+	fl_entity_command* c;
+
+	/* Double the command storage when it is full. */
+	if (list->count >= list->capacity)
+	{
+		int i;
+		int capacity = list->capacity ? list->capacity * 2 : INITIAL_COMMAND_CAPACITY;
+		fl_entity_command* items = fl_alloc(fl_entity_command, capacity);
+
+		if (items == NULL)
+			return 0;
+
+		for (i = 0; i < list->count; i++)
+			items[i] = list->items[i];
+
+		if (list->items != NULL)
+			fl_free(list->items);
+
+		list->items = items;
+		list->capacity = capacity;
+	}
+
+	c = &(list->items[list->count++]);
+	c->command = command;
+	c->target = target;
+	c->entity = entity;
+	c->type = type;
+
+	return 1;
+}
+
+static void change_type(fl_context* context, fl_entity* entity, int type)
+{
+	int old_type = entity->type;
+
+	if (type == old_type || type < 0 || type >= FLURMP_ENTITY_TYPE_COUNT)
+		return;
+
+	/* The animations and body of the old type don't apply to the new one. */
+	fl_remove_animator(context, entity);
+	fl_remove_body(context, entity);
+	remove_from_group(context, entity);
+
+	entity->type = type;
+
+	if (!add_to_group(context, entity) || !fl_add_body(context, entity))
+	{
+		/* The entity can't be updated without a group,
+		   nor moved without a body. */
+		entity->type = old_type;
+		fl_despawn_entity(context, entity->handle);
+		context->error = FLURMP_ERR_ENTITY_GROUPS;
+		return;
+	}
+
+	invalidate_type_layer(context, old_type);
+	invalidate_type_layer(context, type);
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                     entity.h implementation                    */
+/* -------------------------------------------------------------- */
+
+int fl_assign_handle(fl_context* context, fl_entity* entity)
+{
+	fl_entity_table* table = &(context->entity_table);
+	int index;
+
+	if (entity == NULL)
+		return 0;
+
+	if (table->free_count == 0 && !grow_table(table))
+		return 0;
+
+	index = table->free_slots[--table->free_count];
+
+	table->slots[index] = entity;
+	table->count++;
+
+	entity->handle.index = index;
+	entity->handle.generation = table->generations[index];
+
+	return 1;
+}
+
+void fl_release_handle(fl_context* context, fl_entity* entity)
+{
+	if (fl_get_entity(context, entity->handle) == entity)
+		release_slot(&(context->entity_table), entity->handle.index);
+}
+
+int fl_link_entity(fl_context* context, fl_entity* entity)
+{
+	if (!add_to_group(context, entity))
+		return 0;
+
+	if (!fl_add_body(context, entity))
+	{
+		remove_from_group(context, entity);
+		return 0;
+	}
+
+	/* A new entity changes the appearance of its layer. */
+	invalidate_type_layer(context, entity->type);
+
+	entity->next = NULL;
+
+	if (context->entity_count == 0)
+	{
+		context->entities = entity;
+		context->entities->tail = entity;
+	}
+	else
+	{
+		context->entities->tail->next = entity;
+		context->entities->tail = entity;
+	}
+
+	context->entity_count++;
+
+	return 1;
+}
+
+void fl_apply_entity_commands(fl_context* context)
+{
+	int i;
+	fl_entity_command_list* list = &(context->entity_commands);
+
+	for (i = 0; i < list->count; i++)
+	{
+		fl_entity_command* c = &(list->items[i]);
+		fl_entity* en = fl_get_entity(context, c->target);
+
+		switch (c->command)
+		{
+		case FLURMP_ENTITY_COMMAND_SPAWN:
+			/* An entity despawned before it was added is simply freed. */
+			if (en != c->entity)
+			{
+				fl_free(c->entity);
+			}
+			else if (!fl_link_entity(context, en))
+			{
+				fl_release_handle(context, en);
+				fl_free(en);
+				context->error = FLURMP_ERR_ENTITY_GROUPS;
+			}
+			break;
+
+		case FLURMP_ENTITY_COMMAND_DESPAWN:
+			if (en != NULL)
+				fl_despawn_entity(context, c->target);
+			break;
+
+		case FLURMP_ENTITY_COMMAND_RETYPE:
+			if (en != NULL)
+				change_type(context, en, c->type);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	list->count = 0;
+}
+
+void fl_compact_entities(fl_context* context)
+{
+	int i, j;
+	fl_entity* en;
+	fl_entity* next;
+	fl_entity* head = NULL;
+	fl_entity* tail = NULL;
+
+	if (context->despawned == 0)
+		return;
+
+	/* Close the gaps in the entity groups, keeping their order. */
+	for (i = 0; i < FLURMP_ENTITY_TYPE_COUNT; i++)
+	{
+		fl_entity_group* group = &(context->entity_groups[i]);
+		int count = 0;
+
+		for (j = 0; j < group->count; j++)
+		{
+			if (!is_despawned(context, group->entities[j]))
+				group->entities[count++] = group->entities[j];
+		}
+
+		group->count = count;
+	}
+
+	/* Unlink and free the despawned entities. */
+	for (en = context->entities; en != NULL; en = next)
+	{
+		next = en->next;
+
+		if (is_despawned(context, en))
+		{
+			fl_remove_animator(context, en);
+			invalidate_type_layer(context, en->type);
+
+			fl_free(en);
+			context->entity_count--;
+			continue;
+		}
+
+		en->next = NULL;
+
+		if (tail == NULL)
+			head = en;
+		else
+			tail->next = en;
+
+		tail = en;
+	}
+
+	context->entities = head;
+
+	if (head != NULL)
+		head->tail = tail;
+
+	context->despawned = 0;
+}
+
+void fl_clear_entities(fl_context* context)
+{
+	int i;
+	fl_entity_table* table = &(context->entity_table);
+	fl_entity* en;
+	fl_entity* next;
+
+	for (en = context->entities; en != NULL; en = next)
+	{
+		next = en->next;
+		fl_free(en);
+	}
+
+	/* Entities waiting to be spawned already belong to the context. */
+	for (i = 0; i < context->entity_commands.count; i++)
+	{
+		if (context->entity_commands.items[i].command == FLURMP_ENTITY_COMMAND_SPAWN)
+			fl_free(context->entity_commands.items[i].entity);
+	}
+
+	context->entity_commands.count = 0;
+	context->entities = NULL;
+	context->entity_count = 0;
+	context->despawned = 0;
+
+	/* Advance the generation of every slot in use, which also
+	   covers entities that were despawned but not yet compacted. */
+	table->free_count = 0;
+	table->count = 0;
+
+	for (i = table->capacity - 1; i >= 0; i--)
+	{
+		if (table->slots[i] != NULL)
+		{
+			table->slots[i] = NULL;
+
+			if (++table->generations[i] == 0)
+				table->generations[i] = 1;
+		}
+
+		table->free_slots[table->free_count++] = i;
+	}
+
+	/* Empty the entity groups, but keep their storage for the next scene. */
+	if (context->entity_groups != NULL)
+	{
+		for (i = 0; i < FLURMP_ENTITY_TYPE_COUNT; i++)
+			context->entity_groups[i].count = 0;
+	}
+
+	context->pco = FLURMP_NULL_HANDLE;
+
+	for (i = 0; i < FLURMP_PROJECTILE_LIMIT; i++)
+		context->projectiles[i] = FLURMP_NULL_HANDLE;
+}
+
+void fl_destroy_entities(fl_context* context)
+{
+	fl_entity_table* table = &(context->entity_table);
+
+	fl_clear_entities(context);
+
+	fl_free(table->slots);
+	fl_free(table->generations);
+	fl_free(table->free_slots);
+	fl_free(context->entity_commands.items);
+
+	table->slots = NULL;
+	table->generations = NULL;
+	table->free_slots = NULL;
+	table->free_count = 0;
+	table->capacity = 0;
+
+	context->entity_commands.items = NULL;
+	context->entity_commands.capacity = 0;
+}
+
+
+
+/* -------------------------------------------------------------- */
+/*                     flurmp.h implementation                    */
+/* -------------------------------------------------------------- */
+
+fl_entity* fl_get_entity(fl_context* context, fl_handle handle)
+{
+	fl_entity_table* table = &(context->entity_table);
+
+	if (handle.generation == 0 || handle.index < 0 || handle.index >= table->capacity)
+		return NULL;
+
+	if (table->generations[handle.index] != handle.generation)
+		return NULL;
+
+	return table->slots[handle.index];
+}
+
+void fl_despawn_entity(fl_context* context, fl_handle handle)
+{
+	fl_entity* en = fl_get_entity(context, handle);
+
+	if (en == NULL)
+		return;
+
+	release_slot(&(context->entity_table), handle.index);
+
+	/* The entity stays in the entity list until it is compacted,
+	   so keep every pass from treating it as part of the world. */
+	en->flags &= ~(FLURMP_ALIVE_FLAG);
+
+	/* Nor should it move. */
+	fl_remove_body(context, en);
+
+	context->despawned++;
+}
+
+fl_handle fl_queue_spawn(fl_context* context, fl_entity* entity)
+{
+	fl_handle handle = FLURMP_NULL_HANDLE;
+
+	if (entity == NULL || !fl_assign_handle(context, entity))
+		return handle;
+
+	if (!push_command(context, FLURMP_ENTITY_COMMAND_SPAWN, entity->handle, entity, 0))
+	{
+		fl_release_handle(context, entity);
+		return handle;
+	}
+
+	return entity->handle;
+}
+
+void fl_queue_despawn(fl_context* context, fl_handle handle)
+{
+	if (fl_get_entity(context, handle) == NULL)
+		return;
+
+	/* Despawning right away is still safe if the command can't be kept. */
+	if (!push_command(context, FLURMP_ENTITY_COMMAND_DESPAWN, handle, NULL, 0))
+		fl_despawn_entity(context, handle);
+}
+
+void fl_queue_type_change(fl_context* context, fl_handle handle, int type)
+{
+	if (fl_get_entity(context, handle) == NULL)
+		return;
+
+	if (!push_command(context, FLURMP_ENTITY_COMMAND_RETYPE, handle, NULL, type))
+		context->error = FLURMP_ERR_ENTITIES;
+}
@@ -1,9 +1,15 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_ENTITY
+
 #include "entity/pellet.h"
 #include "entity/entity.h"
 #include "core/resource.h"
 #include "core/schedule.h"
 #include "core/input.h"
 #include "core/animation.h"
+#include "core/particle.h"
+
+/* Pellets fly straight, with neither gravity nor friction. */
+static const fl_body_type pellet_body = { 0, 0, 0 };
 
 
 /* -------------------------------------------------------------- */
@@ -12,8 +18,7 @@
 
 /**
  * The collision callback for a pellet entity.
- * If a pellet collides with a solid object, the pellet should
- * vanish from the screen and become usable again.
+ * If a pellet collides with a solid object, the pellet is despawned.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -25,48 +30,15 @@
 static void collide(fl_context*, fl_entity*, fl_entity*, int, int);
 
 /**
- * Updates the state of a pellet entity.
+ * Renders all pellet entities to the screen.
  *
  * Params:
  *   fl_context - a Flurmp context
- *   fl_entity - a pellet entity
- *   int - an axis
+ *   fl_entity** - the pellet entities
+ *   int - the number of entities
  */
-static void update(fl_context*, fl_entity*, int);
+static void render_all(fl_context*, fl_entity**, int);
 
-/**
- * Renders a pellet entity to the screen.
- *
- * Params:
- *   fl_context - a Flurmp context
- *   fl_entity - a pellet entity
- */
-static void render(fl_context*, fl_entity*);
-
-
-
-
-/* -------------------------------------------------------------- */
-/*                       update functions                         */
-/* -------------------------------------------------------------- */
-
-/**
- * Handles horizontal movement events such as walking and inertia.
- *
- * Params:
- *   fl_context - a Flurmp context
- *   fl_entity - a pellet entity
- */
-static void horizontal_movement(fl_context*, fl_entity*);
-
-/**
- * Handles vertical movement events such as jumping and gravity.
- *
- * Params:
- *   fl_context - a Flurmp context
- *   fl_entity - a pellet entity
- */
-static void vertical_movement(fl_context*, fl_entity*);
 
 
 
@@ -81,9 +53,9 @@ static void vertical_movement(fl_context*, fl_entity*);
  * Params:
  *   fl_context - a Flurmp context
  *   fl_schedule - a schedule
- *   void* - a reference to a pellet entity cast as a void pointer
+ *   fl_entity - a pellet entity
  */
-static void animate(fl_context*, fl_schedule*, void*);
+static void animate(fl_context*, fl_schedule*, fl_entity*);
 
 
 
@@ -115,12 +87,14 @@ fl_entity* fl_create_pellet(int x, int y)
 	pellet->next = NULL;
 	pellet->tail = NULL;
 	pellet->type = FLURMP_ENTITY_PELLET;
-	pellet->flags = 0;
+	pellet->flags = FLURMP_ALIVE_FLAG;
 	pellet->x_v = 0;
 	pellet->y_v = 0;
 	pellet->x = x;
 	pellet->y = y;
 	pellet->frame = 0;
+	pellet->animator = -1;
+	pellet->body = -1;
 	pellet->life = 10;
 
 	return pellet;
@@ -128,7 +102,7 @@ fl_entity* fl_create_pellet(int x, int y)
 
 int fl_load_pellet_schedules(fl_context* context, fl_entity* player)
 {
-	/*fl_schedule* w = fl_create_schedule(animate, -1, pellet);
+	/*fl_schedule* w = fl_create_schedule(animate, -1, pellet->handle);
 
 	if (w == NULL)
 		return 0;
@@ -142,14 +116,19 @@ void fl_register_pellet_type(fl_context* context, fl_entity_type* et)
 {
 	et->w = 20;
 	et->h = 20;
+	et->layer = FLURMP_LAYER_ENTITIES;
+	et->z = 1;
 
 	et->collide = collide;
-	et->update = update;
-	et->render = render;
+	et->update = NULL;
+	et->render = NULL;
+	et->update_all = NULL;
+	et->render_all = render_all;
 
 	et->texture = NULL;
 	et->animations = NULL;
 	et->animation_count = 0;
+	et->body = &pellet_body;
 }
 
 
@@ -169,63 +148,48 @@ static void collide(fl_context* context, fl_entity* self, fl_entity* other, int
 		break;
 
 	default:
-		self->flags &= ~(FLURMP_ALIVE_FLAG);
+		fl_queue_despawn(context, self->handle);
+
+		/* A pellet may hit several things before it is gone,
+		   but only bursts into sparks once. */
+		if (!(self->flags & FLURMP_DAMAGE_FLAG))
+		{
+			self->flags |= FLURMP_DAMAGE_FLAG;
+			fl_emit_particles(context, FLURMP_PARTICLE_SPARK,
+				self->x + context->entity_types[self->type].w / 2,
+				self->y + context->entity_types[self->type].h / 2, 12);
+		}
 		break;
 	}
 }
 
-static void update(fl_context* context, fl_entity* self, int axis)
-{
-	if (axis == FLURMP_AXIS_X)
-	{
-		horizontal_movement(context, self);
-	}
-
-	if (axis == FLURMP_AXIS_Y)
-	{
-		vertical_movement(context, self);
-	}
-}
-
-static void render(fl_context* context, fl_entity* self)
+static void render_all(fl_context* context, fl_entity** entities, int count)
 {
-	int self_w = context->entity_types[self->type].w;
-	int self_h = context->entity_types[self->type].h;
-	fl_texture* tex = context->entity_types[self->type].texture->impl.image->texture;
+	int i;
+	int self_w = context->entity_types[FLURMP_ENTITY_PELLET].w;
+	int self_h = context->entity_types[FLURMP_ENTITY_PELLET].h;
+	fl_texture* tex = context->entity_types[FLURMP_ENTITY_PELLET].texture->impl.image->texture;
 
 	fl_rect src;
 	fl_rect dest;
 
 	fl_set_rect(&src, 0, 0, self_w, self_h);
 
-	dest.x = self->x - context->cam_x;
-	dest.y = self->y - context->cam_y;
 	dest.w = self_w;
 	dest.h = self_h;
 
-	fl_draw(context, tex, &src, &dest, 0);
-}
-
-
-
-/* -------------------------------------------------------------- */
-/*                update functions (implementation)               */
-/* -------------------------------------------------------------- */
-
-static void horizontal_movement(fl_context* context, fl_entity* self)
-{
-	int self_w = context->entity_types[self->type].w;
-	int self_h = context->entity_types[self->type].h;
+	for (i = 0; i < count; i++)
+	{
+		fl_entity* self = entities[i];
 
-	self->x += self->x_v;
-}
+		if (!(self->flags & FLURMP_ALIVE_FLAG))
+			continue;
 
-static void vertical_movement(fl_context* context, fl_entity* self)
-{
-	int self_w = context->entity_types[self->type].w;
-	int self_h = context->entity_types[self->type].h;
+		dest.x = self->x - context->cam_x;
+		dest.y = self->y - context->cam_y;
 
-	self->y += self->y_v;
+		fl_draw(context, tex, &src, &dest, 0);
+	}
 }
 
 
@@ -259,24 +223,29 @@ static void render_hitbox(fl_context* context, fl_entity* self)
 /*               schedule functions (implementation)              */
 /* -------------------------------------------------------------- */
 
-static void animate(fl_context* context, fl_schedule* w, void* self)
+static void animate(fl_context* context, fl_schedule* w, fl_entity* self)
 {
 
 }
 
 /**
  * Launches a pellet.
- * The pellet will move forward for 80 iterations or until
- * it collides with a solid object.
+ * The pellet will move forward until the schedule reaches its limit
+ * or the pellet collides with a solid object, and is then despawned.
  */
-static void launch(fl_context* context, fl_schedule* w, void* self)
+static void launch(fl_context* context, fl_schedule* w, fl_entity* en)
 {
-	fl_entity* en = (fl_entity*)self;
+	/* The pellet has already been despawned. */
+	if (en == NULL)
+	{
+		w->done = 1;
+		return;
+	}
 
-	if (w->counter >= w->limit || !(en->flags & FLURMP_ALIVE_FLAG))
+	if (w->counter >= w->limit)
 	{
 		w->done = 1;
-		en->flags &= ~(FLURMP_ALIVE_FLAG);
+		fl_despawn_entity(context, en->handle);
 	}
 
 	w->counter++;
@@ -284,18 +253,24 @@ static void launch(fl_context* context, fl_schedule* w, void* self)
 
 int fl_schedule_pellet(fl_context* context, fl_entity* pellet)
 {
+	fl_entity* pco = fl_get_entity(context, context->pco);
+
+	if (pco == NULL)
+		return 0;
+
 	pellet->flags |= FLURMP_ALIVE_FLAG;
-	pellet->x = context->pco->x + 20;
-	pellet->y = context->pco->y + 10;
+	pellet->flags &= ~(FLURMP_DAMAGE_FLAG);
+	pellet->x = pco->x + 20;
+	pellet->y = pco->y + 10;
 	pellet->x_v = 0;
 	pellet->y_v = 0;
 
-	if (context->pco->flags & FLURMP_MIRROR_FLAG)
+	if (pco->flags & FLURMP_MIRROR_FLAG)
 		pellet->x_v = -4;
 	else
 		pellet->x_v = 4;
 
-	fl_schedule* w = fl_create_schedule(launch, 50, pellet);
+	fl_schedule* w = fl_create_schedule(launch, 50, pellet->handle);
 
 	if (w == NULL)
 		return 0;
@@ -1,9 +1,25 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_ENTITY
+
 #include "entity/player.h"
 #include "entity/entity.h"
 #include "core/resource.h"
 #include "core/schedule.h"
 #include "core/input.h"
 #include "core/animation.h"
+#include "core/body.h"
+
+/* indices of the player animations */
+#define ANIMATION_STAND 0
+#define ANIMATION_WALK  1
+#define ANIMATION_JUMP  2
+
+/* The player falls under gravity up to a top speed,
+   and slows to a stop when not walking. */
+static const fl_body_type player_body = {
+	1 * FLURMP_BODY_ONE,
+	4 * FLURMP_BODY_ONE,
+	1 * FLURMP_BODY_ONE
+};
 
 
 /* -------------------------------------------------------------- */
@@ -27,10 +43,12 @@ static void collide(fl_context*, fl_entity*, fl_entity*, int, int);
 /**
  * Performs the following operations:
  * horizontal camera adjustment (x axis)
- * horizontal movement          (x axis)
- * vertical movement            (y axis)
- * entity interaction           (either axis)
- * animation                    (either axis)
+ * horizontal camera following  (x axis)
+ * vertical camera adjustment   (y axis)
+ * vertical camera following    (y axis)
+ * animation                    (x axis)
+ *
+ * The player's body does the moving, right after the update.
  *
  * Params:
  *   fl_context - a Flurmp context
@@ -66,13 +84,14 @@ static void render(fl_context*, fl_entity*);
 static void adjust_camera_horizontal(fl_context*, fl_entity*);
 
 /**
- * Handles horizontal movement events such as walking and inertia.
+ * Moves the camera along with the player when the player's body is
+ * about to carry it past the left or right boundary.
  *
  * Params:
  *   fl_context - a Flurmp context
  *   fl_entity - the player entity
  */
-static void horizontal_movement(fl_context*, fl_entity*);
+static void follow_horizontal(fl_context*, fl_entity*);
 
 /**
  * Updates the camera position to keep the player near the center of the
@@ -85,30 +104,32 @@ static void horizontal_movement(fl_context*, fl_entity*);
 static void adjust_camera_vertical(fl_context*, fl_entity*);
 
 /**
- * Handles vertical movement events such as jumping and gravity.
+ * Puts the player in the air until a collision says otherwise, and
+ * moves the camera along with the player when the player's body is
+ * about to carry it past the upper or lower boundary.
  *
  * Params:
  *   fl_context - a Flurmp context
  *   fl_entity - the player entity
  */
-static void vertical_movement(fl_context*, fl_entity*);
+static void follow_vertical(fl_context*, fl_entity*);
 
 
 
 /* -------------------------------------------------------------- */
-/*                      schedule functions                        */
+/*                     animation functions                        */
 /* -------------------------------------------------------------- */
 
 /**
- * Determines which section of the player texture to use when
- * rendering a player entity.
+ * Chooses the animation that matches the current state of a player
+ * entity. The animation itself is advanced with all other animations
+ * in fl_update.
  *
  * Params:
  *   fl_context - a Flurmp context
- *   fl_schedule - a schedule
- *   void* - a reference to a player entity cast as a void pointer
+ *   fl_entity - the player entity
  */
-static void animate(fl_context*, fl_schedule*, void*);
+static void select_animation(fl_context*, fl_entity*);
 
 
 
@@ -146,34 +167,42 @@ fl_entity* fl_create_player(int x, int y)
 	player->x = x;
 	player->y = y;
 	player->frame = 0;
+	player->animator = -1;
+	player->body = -1;
 	player->life = 10;
 
 	return player;
 }
 
-int fl_load_player_schedules(fl_context* context, fl_entity* player)
+int fl_load_player_animations(fl_context* context, fl_entity* player)
 {
-	fl_schedule* w = fl_create_schedule(animate, -1, player);
+	fl_entity_type* et = &(context->entity_types[player->type]);
 
-	if (w == NULL)
+	if (et->animations == NULL)
 		return 0;
 
-	fl_add_schedule(context, w);
-	
-	return 1;
+	return fl_add_animator(context, player, et->animations[ANIMATION_STAND]);
 }
 
 void fl_register_player_type(fl_context* context, fl_entity_type* et)
 {
 	et->w = 30;
 	et->h = 40;
+	et->layer = FLURMP_LAYER_ENTITIES;
+	et->z = 0;
 
 	et->collide = collide;
 	et->update = update;
 	et->render = render;
+	et->update_all = NULL;
+	et->render_all = NULL;
 
 	et->texture = NULL;
 
+	et->animations = NULL;
+	et->animation_count = 0;
+	et->body = &player_body;
+
 	fl_animation** animations = fl_alloc(fl_animation*, 3);
 
 	if (animations == NULL)
@@ -186,9 +215,10 @@ void fl_register_player_type(fl_context* context, fl_entity_type* et)
 		fl_free(animations);
 		return;
 	}
-	fl_set_rect(&(stand->frames[0]), 0, 0, 50, 50);
+	fl_set_animation_frame(stand, 0, 0, 0, 50, 50, 1);
 
-	/* Create the walking animation. */
+	/* Create the walking animation.
+	   Each step is shown for 4 updates. */
 	fl_animation* walk = fl_create_animation(3);
 	if (walk == NULL)
 	{
@@ -196,24 +226,24 @@ void fl_register_player_type(fl_context* context, fl_entity_type* et)
 		fl_free(animations);
 		return;
 	}
-	fl_set_rect(&(walk->frames[0]), 0, 0, 50, 50);
-	fl_set_rect(&(walk->frames[1]), 50, 0, 50, 50);
-	fl_set_rect(&(walk->frames[2]), 100, 0, 50, 50);
+	fl_set_animation_frame(walk, 0, 0, 0, 50, 50, 4);
+	fl_set_animation_frame(walk, 1, 50, 0, 50, 50, 4);
+	fl_set_animation_frame(walk, 2, 100, 0, 50, 50, 4);
 
 	/* Create the jumping animation. */
 	fl_animation* jump = fl_create_animation(1);
 	if (jump == NULL)
 	{
 		fl_destroy_animation(stand);
-		fl_destroy_animation(jump);
+		fl_destroy_animation(walk);
 		fl_free(animations);
 		return;
 	}
-	fl_set_rect(&(jump->frames[0]), 50, 0, 50, 50);
+	fl_set_animation_frame(jump, 0, 50, 0, 50, 50, 1);
 
-	animations[0] = stand;
-	animations[1] = walk;
-	animations[2] = jump;
+	animations[ANIMATION_STAND] = stand;
+	animations[ANIMATION_WALK] = walk;
+	animations[ANIMATION_JUMP] = jump;
 
 	et->animations = animations;
 	et->animation_count = 3;
@@ -234,11 +264,15 @@ static void update(fl_context* context, fl_entity* self, int axis)
 {
 	if (axis == FLURMP_AXIS_X)
 	{
+		/* Choose an animation based on the state
+		   left by the previous update. */
+		select_animation(context, self);
+
 		/* horizontal camera adjustment */
 		adjust_camera_horizontal(context, self);
 
-		/* horizontal movement */
-		horizontal_movement(context, self);
+		/* horizontal camera following */
+		follow_horizontal(context, self);
 	}
 
 	if (axis == FLURMP_AXIS_Y)
@@ -246,8 +280,8 @@ static void update(fl_context* context, fl_entity* self, int axis)
 		/* vertical camera adjustment */
 		adjust_camera_vertical(context, self);
 
-		/* vertical movement */
-		vertical_movement(context, self);
+		/* vertical camera following */
+		follow_vertical(context, self);
 	}
 }
 
@@ -337,31 +371,23 @@ static void adjust_camera_horizontal(fl_context* context, fl_entity* self)
 	}
 }
 
-static void horizontal_movement(fl_context* context, fl_entity* self)
+static void follow_horizontal(fl_context* context, fl_entity* self)
 {
 	int self_w = context->entity_types[self->type].w;
-	int self_h = context->entity_types[self->type].h;
+	int step = fl_get_body_step(context, self, FLURMP_AXIS_X);
 
 	/* inertia */
 	/* if the player's x velocity is not 0, then the
 	   camera x axis adjustment doesn't occur. */
-	self->x += self->x_v;
-
-	if (self->x_v < 0 && self->x - context->cam_x <= FLURMP_LEFT_BOUNDARY)
+	if (step < 0 && self->x + step - context->cam_x <= FLURMP_LEFT_BOUNDARY)
 	{
-		context->cam_x += self->x_v;
+		context->cam_x += step;
 	}
 
-	if (self->x_v > 0 && self->x + self_w - context->cam_x >= FLURMP_RIGHT_BOUNDARY)
+	if (step > 0 && self->x + step + self_w - context->cam_x >= FLURMP_RIGHT_BOUNDARY)
 	{
-		context->cam_x += self->x_v;
+		context->cam_x += step;
 	}
-
-	if (self->x_v > 0)
-		self->x_v--;
-
-	if (self->x_v < 0)
-		self->x_v++;
 }
 
 static void adjust_camera_vertical(fl_context* context, fl_entity* self)
@@ -392,27 +418,25 @@ static void adjust_camera_vertical(fl_context* context, fl_entity* self)
 	}
 }
 
-static void vertical_movement(fl_context* context, fl_entity* self)
+static void follow_vertical(fl_context* context, fl_entity* self)
 {
-	int self_w = context->entity_types[self->type].w;
 	int self_h = context->entity_types[self->type].h;
+	int step;
 
 	/* Reset the air flag. */
 	self->flags |= FLURMP_AIR_FLAG;
 
-	/* gravity (y axis) */
-	if (self->y_v < 4) self->y_v += 1;
-
-	self->y += self->y_v;
+	/* The step includes this update's gravity. */
+	step = fl_get_body_step(context, self, FLURMP_AXIS_Y);
 
-	if (self->y_v < 0 && self->y - context->cam_y <= FLURMP_UPPER_BOUNDARY)
+	if (step < 0 && self->y + step - context->cam_y <= FLURMP_UPPER_BOUNDARY)
 	{
-		context->cam_y += self->y_v;
+		context->cam_y += step;
 	}
 
-	if (self->y_v > 0 && self->y + self_h - context->cam_y >= FLURMP_LOWER_BOUNDARY)
+	if (step > 0 && self->y + step + self_h - context->cam_y >= FLURMP_LOWER_BOUNDARY)
 	{
-		context->cam_y += self->y_v;
+		context->cam_y += step;
 	}
 }
 
@@ -440,57 +464,50 @@ static void render_hitbox(fl_context* context, fl_entity* self)
 
 
 /* -------------------------------------------------------------- */
-/*               schedule functions (implementation)              */
+/*              animation functions (implementation)              */
 /* -------------------------------------------------------------- */
 
-static void animate(fl_context* context, fl_schedule* w, void* self)
+static void select_animation(fl_context* context, fl_entity* self)
 {
-	fl_entity* en = (fl_entity*)self;
-	fl_animation* a;
-
-	if (en->flags & FLURMP_AIR_FLAG)
-	{
-		/* in the air */
-		a = context->entity_types[en->type].animations[2];
-
-		if (w->counter > 0)
-			w->counter = 0;
-
-		en->frame = &(a->frames[w->counter]);
-	}
-	else if (en->x_v != 0)
-	{
-		/* walking */
-		a = context->entity_types[en->type].animations[1];
-
-		if (w->counter / 4 >= a->frame_count)
-			w->counter = 0;
+	fl_animation** animations = context->entity_types[self->type].animations;
 
-		en->frame = &(a->frames[w->counter / 4]);
-
-		w->counter++;
-	}
+	if (self->flags & FLURMP_AIR_FLAG)
+		fl_play_animation(context, self, animations[ANIMATION_JUMP]);
+	else if (self->x_v != 0)
+		fl_play_animation(context, self, animations[ANIMATION_WALK]);
 	else
-	{
-		/* standing */
-		a = context->entity_types[en->type].animations[0];
+		fl_play_animation(context, self, animations[ANIMATION_STAND]);
+}
 
-		if (w->counter > 0)
-			w->counter = 0;
 
-		en->frame = &(a->frames[w->counter]);
-	}
-}
+
+/* -------------------------------------------------------------- */
+/*               schedule functions (implementation)              */
+/* -------------------------------------------------------------- */
 
 /**
  * A scheduled action for walking to the right and jumping once.
  * For the first 80 iterations, the target will move to the right.
  *
  * On the 60th iteration, the target will jump.
+ *
+ * If the target is gone, the input handler pushed with the
+ * schedule is removed, unless that has already happened.
  */
-static void walk_to_the_right_and_jump(fl_context* context, fl_schedule* w, void* self)
+static void walk_to_the_right_and_jump(fl_context* context, fl_schedule* w, fl_entity* en)
 {
-	fl_entity* en = (fl_entity*)self;
+	if (en == NULL)
+	{
+		if (w->counter <= w->limit)
+		{
+			fl_input_handler* ih = fl_get_input_handler(context);
+			fl_pop_input_handler(context);
+			fl_destroy_input_handler(ih);
+		}
+
+		w->done = 1;
+		return;
+	}
 
 	if (w->counter < 80)
 	{
@@ -518,7 +535,7 @@ static void walk_to_the_right_and_jump(fl_context* context, fl_schedule* w, void
 
 int fl_schedule_walk(fl_context* context, fl_entity* player)
 {
-	fl_schedule* w = fl_create_schedule(walk_to_the_right_and_jump, 120, player);
+	fl_schedule* w = fl_create_schedule(walk_to_the_right_and_jump, 120, player->handle);
 
 	if (w == NULL)
 		return 0;
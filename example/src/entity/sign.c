@@ -1,3 +1,5 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_ENTITY
+
 #include "entity/sign.h"
 #include "entity/entity.h"
 #include "core/resource.h"
@@ -36,24 +38,15 @@ static const char* statements[2] = {
 static void collide(fl_context*, fl_entity*, fl_entity*, int, int);
 
 /**
- * Does nothing.
- * A sign is not affected by physics.
+ * Renders all sign entities to the screen.
+ * A sign is not affected by physics. Because of this, there is no update callback.
  *
  * Params:
  *   fl_context - a Flurmp context
- *   fl_entity - a sign entity
- *   int - an axis
+ *   fl_entity** - the sign entities
+ *   int - the number of entities
  */
-static void update(fl_context*, fl_entity*, int);
-
-/**
- * Renders a sign entity to the screen.
- *
- * Params:
- *   fl_context - a Flurmp context
- *   fl_entity - the sign entity
- */
-static void render(fl_context*, fl_entity*);
+static void render_all(fl_context*, fl_entity**, int);
 
 /**
  * The first dialog callback.
@@ -80,28 +73,33 @@ static void collide(fl_context* context, fl_entity* self, fl_entity* other, int
 	}
 }
 
-static void update(fl_context* context, fl_entity* self, int axis)
+static void render_all(fl_context* context, fl_entity** entities, int count)
 {
-
-}
-
-static void render(fl_context* context, fl_entity* self)
-{
-	int self_w = context->entity_types[self->type].w;
-	int self_h = context->entity_types[self->type].h;
-	fl_texture* tex = context->entity_types[self->type].texture->impl.image->texture;
+	int i;
+	int self_w = context->entity_types[FLURMP_ENTITY_SIGN].w;
+	int self_h = context->entity_types[FLURMP_ENTITY_SIGN].h;
+	fl_texture* tex = context->entity_types[FLURMP_ENTITY_SIGN].texture->impl.image->texture;
 
 	fl_rect src;
 	fl_rect dest;
 
 	fl_set_rect(&src, 0, 0, 50, 50);
 
-	dest.x = self->x - context->cam_x;
-	dest.y = self->y - context->cam_y;
 	dest.w = self_w;
 	dest.h = self_h;
 
-	fl_draw(context, tex, &src, &dest, 0);
+	for (i = 0; i < count; i++)
+	{
+		fl_entity* self = entities[i];
+
+		if (!(self->flags & FLURMP_ALIVE_FLAG))
+			continue;
+
+		dest.x = self->x - context->cam_x;
+		dest.y = self->y - context->cam_y;
+
+		fl_draw(context, tex, &src, &dest, 0);
+	}
 }
 
 static void first_cb(fl_context* context)
@@ -129,6 +127,8 @@ fl_entity* fl_create_sign(int x, int y)
 	sign->y_v = 0;
 	sign->x = x;
 	sign->y = y;
+	sign->animator = -1;
+	sign->body = -1;
 	sign->life = 1;
 
 	return sign;
@@ -138,12 +138,17 @@ void fl_register_sign_type(fl_context* context, fl_entity_type* et)
 {
 	et->w = 30;
 	et->h = 40;
+	et->layer = FLURMP_LAYER_SCENERY;
+	et->z = 2;
 
 	et->collide = collide;
-	et->update = update;
-	et->render = render;
+	et->update = NULL;
+	et->render = NULL;
+	et->update_all = NULL;
+	et->render_all = render_all;
 
 	et->texture = NULL;
 	et->animations = NULL;
 	et->animation_count = 0;
+	et->body = NULL;
 }
@@ -1,9 +1,13 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_ENTITY
+
 #include "entity/spike.h"
 #include "entity/entity.h"
 #include "core/resource.h"
 #include "core/input.h"
 #include "menu/pause_menu.h"
 #include "core/schedule.h"
+#include "core/audio.h"
+#include "core/particle.h"
 
 
 /* -------------------------------------------------------------- */
@@ -25,24 +29,15 @@
 static void collide(fl_context*, fl_entity*, fl_entity*, int, int);
 
 /**
- * Does nothing.
- * A spike has no reason to change.
+ * Renders all spike entities to the screen.
+ * A spike has no reason to change. Because of this, there is no update callback.
  *
  * Params:
  *   fl_context - a Flurmp context
- *   fl_entity - the spike entity
- *   int - an axis
+ *   fl_entity** - the spike entities
+ *   int - the number of entities
  */
-static void update(fl_context*, fl_entity*, int);
-
-/**
- * Renders a spike entity to the screen.
- *
- * Params:
- *   fl_context - a Flurmp context
- *   fl_entity - the spike entity
- */
-static void render(fl_context*, fl_entity*);
+static void render_all(fl_context*, fl_entity**, int);
 
 /**
  * Applies a knockback effect to an entity.
@@ -117,32 +112,39 @@ static void collide(fl_context* context, fl_entity* self, fl_entity* other, int
 	if (!(other->flags & FLURMP_DAMAGE_FLAG))
 	{
 		other->life--;
+		fl_play_sound(context->audio, FLURMP_SOUND_SPIKE, 1.0f);
+		fl_emit_particles(context, FLURMP_PARTICLE_HIT, other->x + other_w / 2, other->y + other_h / 2, 24);
 		apply_knockback(context, other, collided);
 	}
 }
 
-static void update(fl_context* context, fl_entity* self, int axis)
+static void render_all(fl_context* context, fl_entity** entities, int count)
 {
-
-}
-
-static void render(fl_context* context, fl_entity* self)
-{
-	int self_w = context->entity_types[self->type].w;
-	int self_h = context->entity_types[self->type].h;
-	fl_texture* tex = context->entity_types[self->type].texture->impl.image->texture;
+	int i;
+	int self_w = context->entity_types[FLURMP_ENTITY_SPIKE].w;
+	int self_h = context->entity_types[FLURMP_ENTITY_SPIKE].h;
+	fl_texture* tex = context->entity_types[FLURMP_ENTITY_SPIKE].texture->impl.image->texture;
 
 	fl_rect src;
 	fl_rect dest;
 
 	fl_set_rect(&src, 0, 0, self_w, self_h);
 
-	dest.x = self->x - context->cam_x;
-	dest.y = self->y - context->cam_y;
 	dest.w = self_w;
 	dest.h = self_h;
 
-	fl_draw(context, tex, &src, &dest, 0);
+	for (i = 0; i < count; i++)
+	{
+		fl_entity* self = entities[i];
+
+		if (!(self->flags & FLURMP_ALIVE_FLAG))
+			continue;
+
+		dest.x = self->x - context->cam_x;
+		dest.y = self->y - context->cam_y;
+
+		fl_draw(context, tex, &src, &dest, 0);
+	}
 }
 
 
@@ -165,6 +167,8 @@ fl_entity* fl_create_spike(int x, int y)
 	spike->y_v = 0;
 	spike->x = x;
 	spike->y = y;
+	spike->animator = -1;
+	spike->body = -1;
 	spike->life = 1;
 
 	return spike;
@@ -174,14 +178,19 @@ void fl_register_spike_type(fl_context* context, fl_entity_type* et)
 {
 	et->w = 20;
 	et->h = 20;
+	et->layer = FLURMP_LAYER_SCENERY;
+	et->z = 1;
 
 	et->collide = collide;
-	et->update = update;
-	et->render = render;
+	et->update = NULL;
+	et->render = NULL;
+	et->update_all = NULL;
+	et->render_all = render_all;
 
 	et->texture = NULL;
 	et->animations = NULL;
 	et->animation_count = 0;
+	et->body = NULL;
 }
 
 /**
@@ -193,10 +202,23 @@ void fl_register_spike_type(fl_context* context, fl_entity_type* et)
  *
  * Approximately halfway through the duration of the action,
  * input control should be returned to the user.
+ * If the affected entity is gone before then, input control
+ * is returned immediately.
  */
-static void knockback(fl_context* context, fl_schedule* w, void* self)
+static void knockback(fl_context* context, fl_schedule* w, fl_entity* en)
 {
-	fl_entity* en = (fl_entity*)self;
+	if (en == NULL)
+	{
+		if (w->counter <= 20)
+		{
+			fl_input_handler* ih = fl_get_input_handler(context);
+			fl_pop_input_handler(context);
+			fl_destroy_input_handler(ih);
+		}
+
+		w->done = 1;
+		return;
+	}
 
 	if (w->counter < w->limit)
 	{
@@ -230,11 +252,11 @@ static void knockback(fl_context* context, fl_schedule* w, void* self)
  */
 static void knockback_input_handler(fl_context* context, fl_input_handler* self)
 {
-	if (fl_consume_key(context, FLURMP_SC_ESCAPE))
+	if (fl_consume_action(context, FLURMP_ACTION_PAUSE))
 	{
 		context->paused = 1;
 
-		fl_menu* pause_menu = fl_create_pause_menu(context);
+		fl_menu* pause_menu = fl_open_menu(context, FLURMP_MENU_PAUSE, fl_create_pause_menu);
 
 		fl_push_menu(context, pause_menu);
 
@@ -260,7 +282,7 @@ static int apply_knockback(fl_context* context, fl_entity* other, int dir)
 		other->y_v = -6;
 	}
 
-	fl_schedule* w = fl_create_schedule(knockback, 70, other);
+	fl_schedule* w = fl_create_schedule(knockback, 70, other->handle);
 
 	if (w == NULL)
 		return 0;
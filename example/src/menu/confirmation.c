@@ -1,5 +1,8 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_MENU
+
 #include "menu/confirmation.h"
 #include "core/input.h"
+#include "core/text.h"
 
 /* amount of menu items */
 #define ITEM_COUNT 2
@@ -102,25 +105,25 @@ static void handle_input(fl_context* context, fl_input_handler* self)
 {
 	fl_menu* menu = fl_get_active_menu(context);
 
-	if (fl_consume_key(context, FLURMP_SC_W))
+	if (fl_consume_action(context, FLURMP_ACTION_UP))
 	{
 		cursor_up(context, menu);
 		return;
 	}
 
-	if (fl_consume_key(context, FLURMP_SC_S))
+	if (fl_consume_action(context, FLURMP_ACTION_DOWN))
 	{
 		cursor_down(context, menu);
 		return;
 	}
 
-	if (fl_consume_key(context, FLURMP_SC_J))
+	if (fl_consume_action(context, FLURMP_ACTION_PRIMARY))
 	{
 		cursor_select(context, menu);
 		return;
 	}
 
-	if (fl_consume_key(context, FLURMP_SC_K))
+	if (fl_consume_action(context, FLURMP_ACTION_SECONDARY))
 	{
 		cursor_cancel(context, menu);
 		return;
@@ -146,15 +149,12 @@ static void render(fl_context* context, fl_menu* menu)
 	{
 		for (i = 0; i < menu->item_count; i++)
 		{
-			r.x = menu->items[i]->x;
-			r.y = menu->items[i]->y;
-			r.w = menu->items[i]->image->w;
-			r.h = menu->items[i]->image->h;
-			fl_draw(context, menu->items[i]->image->texture, NULL, &r, 0);
+			fl_draw_static_text(context, menu->items[i]->text, menu->items[i]->x, menu->items[i]->y);
 		}
 	}
 
-	if (menu->child == NULL)
+	/* Menus below the active menu are drawn without a cursor. */
+	if (menu == fl_get_active_menu(context))
 	{
 		menu->get_cursor_coords(menu, &r.x, &r.y);
 		r.w = 10;
@@ -162,10 +162,6 @@ static void render(fl_context* context, fl_menu* menu)
 
 		fl_draw_solid_rect(context, &r);
 	}
-	else
-	{
-		menu->child->render(context, menu->child);
-	}
 }
 
 
@@ -219,7 +215,7 @@ static void yes_action(fl_context* context, fl_menu* menu)
 	/* Remove the current active menu */
 	active = fl_pop_menu(context);
 
-	fl_destroy_menu(active);
+	fl_close_menu(context, active);
 
 	if (callback != NULL)
 	{
@@ -243,7 +239,7 @@ static void no_action(fl_context* context, fl_menu* menu)
 	/* Remove the current active menu */
 	active = fl_pop_menu(context);
 
-	fl_destroy_menu(active);
+	fl_close_menu(context, active);
 
 	if (callback != NULL)
 	{
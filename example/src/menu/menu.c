@@ -1,7 +1,12 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_MENU
+
 #include "menu/menu.h"
 #include "core/text.h"
 #include "core/input.h"
 
+/* initial number of slots in the menu stack */
+#define INITIAL_STACK_CAPACITY 8
+
 fl_menu_item* fl_create_menu_item(fl_context* context,
 	int x,
 	int y,
@@ -9,7 +14,7 @@ fl_menu_item* fl_create_menu_item(fl_context* context,
 	void(*action) (fl_context*, fl_menu*))
 {
 	fl_menu_item* item;
-	fl_image* image;
+	fl_static_text* label;
 
 	/* Allocate memory for a menu item. */
 	item = fl_alloc(fl_menu_item, 1);
@@ -22,17 +27,18 @@ fl_menu_item* fl_create_menu_item(fl_context* context,
 	item->y = y;
 	item->action = action;
 
-	/* Create an image to render for the menu item. */
-	image = fl_create_static_text(context, context->fonts[FLURMP_FONT_VERA], text);
+	/* Lay out the label of the menu item. Its glyphs are drawn
+	   from the shared font atlas, so no texture is created here. */
+	label = fl_create_static_text(context, context->fonts[FLURMP_FONT_VERA], text);
 
-	/* Verify image creation. */
-	if (image == NULL)
+	/* Verify label creation. */
+	if (label == NULL)
 	{
 		fl_free(item);
 		return NULL;
 	}
 
-	item->image = image;
+	item->text = label;
 
 	return item;
 }
@@ -42,8 +48,8 @@ void fl_destroy_menu_item(fl_menu_item* item)
 	if (item == NULL)
 		return;
 
-	if (item->image != NULL)
-		fl_destroy_image(item->image);
+	if (item->text != NULL)
+		fl_destroy_static_text(item->text);
 
 	fl_free(item);
 }
@@ -55,8 +61,7 @@ fl_menu* fl_create_menu(int x, int y, int w, int h)
 	if (menu == NULL)
 		return NULL;
 
-	menu->child = NULL;
-	menu->parent = NULL;
+	menu->id = -1;
 	menu->x = x;
 	menu->y = y;
 	menu->w = w;
@@ -93,74 +98,93 @@ void fl_destroy_menu(fl_menu* menu)
 	if (menu->input_handler != NULL)
 		fl_destroy_input_handler(menu->input_handler);
 
-	/* Destroy the child menus. */
-	if (menu->child != NULL)
-		fl_destroy_menu(menu->child);
-
 	/* Destroy the menu. */
 	fl_free(menu);
 }
 
-fl_menu* fl_get_active_menu(fl_context* context)
+fl_menu* fl_open_menu(fl_context* context, int id, fl_menu*(*create) (fl_context*))
 {
-	if (context == NULL || context->active_menu == NULL)
+	if (context == NULL || context->menus == NULL || id < 0 || id >= FLURMP_MENU_COUNT)
 		return NULL;
 
-	fl_menu* menu = context->active_menu;
+	fl_menu* menu = context->menus[id];
+
+	/* Build the menu the first time it is opened. */
+	if (menu == NULL)
+	{
+		menu = create(context);
+
+		if (menu == NULL)
+			return NULL;
+
+		menu->id = id;
+		context->menus[id] = menu;
+	}
 
-	/* Traverse the menu list until we find one with no child. */
-	while (menu->child != NULL)
-		menu = menu->child;
+	/* Reset the state left over from the last time the menu was open. */
+	menu->pos = 0;
+	menu->callback = NULL;
 
 	return menu;
 }
 
-void fl_push_menu(fl_context* context, fl_menu* menu)
+void fl_close_menu(fl_context* context, fl_menu* menu)
 {
 	if (context == NULL || menu == NULL)
 		return;
 
-	if (context->active_menu == NULL)
-	{
-		context->active_menu = menu;
-	}
-	else
-	{
-		fl_menu* active = context->active_menu;
-
-		/* Traverse the menu list until we find one with no child. */
-		while (active->child != NULL)
-			active = active->child;
+	/* Keep cached menus for the next time they are opened. */
+	if (menu->id >= 0 && context->menus != NULL && context->menus[menu->id] == menu)
+		return;
 
-		/* Link the new menu to the current active menu. */
-		active->child = menu;
-		menu->parent = active;
-	}
+	fl_destroy_menu(menu);
 }
 
-fl_menu* fl_pop_menu(fl_context* context)
+fl_menu* fl_get_active_menu(fl_context* context)
 {
-	if (context == NULL || context->active_menu == NULL)
+	if (context == NULL || context->menu_stack.top < 0)
 		return NULL;
 
-	fl_menu* menu = context->active_menu;
+	return context->menu_stack.items[context->menu_stack.top];
+}
+
+void fl_push_menu(fl_context* context, fl_menu* menu)
+{
+	if (context == NULL || menu == NULL)
+		return;
 
-	/* Traverse the menu list until we find one with no child. */
-	while (menu->child != NULL)
-		menu = menu->child;
+	fl_menu_stack* stack = &context->menu_stack;
 
-	/* If the active menu has no parent, clear the active menu pointer. */
-	if (menu->parent == NULL)
+	/* Double the stack storage when it is full. */
+	if (stack->top + 1 >= stack->capacity)
 	{
-		context->active_menu = NULL;
-		return menu;
+		int i;
+		int capacity = stack->capacity ? stack->capacity * 2 : INITIAL_STACK_CAPACITY;
+		fl_menu** items = fl_alloc(fl_menu*, capacity);
+
+		if (items == NULL)
+		{
+			context->error = FLURMP_ERR_MENUS;
+			return;
+		}
+
+		for (i = 0; i <= stack->top; i++)
+			items[i] = stack->items[i];
+
+		if (stack->items != NULL)
+			fl_free(stack->items);
+
+		stack->items = items;
+		stack->capacity = capacity;
 	}
 
-	/* Clear the parent and child pointers to prevent the
-	   destruction of other menus when this menu is
-	   destroyed elsewhere. */
-	menu->parent->child = NULL;
-	menu->parent = NULL;
+	stack->items[++stack->top] = menu;
+}
 
-	return menu;
+fl_menu* fl_pop_menu(fl_context* context)
+{
+	if (context == NULL || context->menu_stack.top < 0)
+		return NULL;
+
+	return context->menu_stack.items[context->menu_stack.top--];
 }
@@ -1,3 +1,5 @@
+#define FLURMP_MEMORY_TAG FLURMP_MEMORY_TAG_MENU
+
 #include "menu/pause_menu.h"
 #include "menu/pause_submenu.h"
 #include "menu/confirmation.h"
@@ -226,12 +228,6 @@ static void confirm_cb(fl_context*);
 
 static void get_cursor_coords(fl_menu* menu, int* x, int* y)
 {
-	if (menu->child != NULL)
-	{
-		menu->get_cursor_coords(menu->child, x, y);
-		return;
-	}
-
 	/* Determine the cursor's x position. */
 	if (menu->pos < 4)
 		* x = 60;
@@ -249,43 +245,43 @@ static void handle_input(fl_context* context, fl_input_handler* self)
 {
 	fl_menu* menu = fl_get_active_menu(context);
 
-	if (fl_consume_key(context, FLURMP_SC_W))
+	if (fl_consume_action(context, FLURMP_ACTION_UP))
 	{
 		cursor_up(context, menu);
 		return;
 	}
 
-	if (fl_consume_key(context, FLURMP_SC_A))
+	if (fl_consume_action(context, FLURMP_ACTION_LEFT))
 	{
 		cursor_left(context, menu);
 		return;
 	}
 
-	if (fl_consume_key(context, FLURMP_SC_S))
+	if (fl_consume_action(context, FLURMP_ACTION_DOWN))
 	{
 		cursor_down(context, menu);
 		return;
 	}
 
-	if (fl_consume_key(context, FLURMP_SC_D))
+	if (fl_consume_action(context, FLURMP_ACTION_RIGHT))
 	{
 		cursor_right(context, menu);
 		return;
 	}
 
-	if (fl_consume_key(context, FLURMP_SC_J))
+	if (fl_consume_action(context, FLURMP_ACTION_PRIMARY))
 	{
 		cursor_select(context, menu);
 		return;
 	}
 
-	if (fl_consume_key(context, FLURMP_SC_K))
+	if (fl_consume_action(context, FLURMP_ACTION_SECONDARY))
 	{
 		cursor_cancel(context, menu);
 		return;
 	}
 
-	if (fl_consume_key(context, FLURMP_SC_ESCAPE))
+	if (fl_consume_action(context, FLURMP_ACTION_PAUSE))
 	{
 		menu->pos = 0;
 		context->paused = 0;
@@ -296,7 +292,7 @@ static void handle_input(fl_context* context, fl_input_handler* self)
 		/* Remove the current active menu */
 		fl_menu* active = fl_pop_menu(context);
 
-		fl_destroy_menu(active);
+		fl_close_menu(context, active);
 	}
 }
 
@@ -319,15 +315,12 @@ static void render(fl_context* context, fl_menu* menu)
 	{
 		for (i = 0; i < menu->item_count; i++)
 		{
-			r.x = menu->items[i]->x;
-			r.y = menu->items[i]->y;
-			r.w = menu->items[i]->image->w;
-			r.h = menu->items[i]->image->h;
-			fl_draw(context, menu->items[i]->image->texture, NULL, &r, 0);
+			fl_draw_static_text(context, menu->items[i]->text, menu->items[i]->x, menu->items[i]->y);
 		}
 	}
 
-	if (menu->child == NULL)
+	/* Menus below the active menu are drawn without a cursor. */
+	if (menu == fl_get_active_menu(context))
 	{
 		menu->get_cursor_coords(menu, &r.x, &r.y);
 		r.w = 10;
@@ -335,10 +328,6 @@ static void render(fl_context* context, fl_menu* menu)
 
 		fl_draw_solid_rect(context, &r);
 	}
-	else
-	{
-		menu->child->render(context, menu->child);
-	}
 }
 
 
@@ -386,7 +375,7 @@ static void cursor_cancel(fl_context* context, fl_menu* menu)
 
 	fl_menu* active = fl_pop_menu(context);
 
-	fl_destroy_menu(active);
+	fl_close_menu(context, active);
 }
 
 
@@ -402,7 +391,7 @@ static void info_action(fl_context* context, fl_menu* menu)
 
 static void submenu_action(fl_context* context, fl_menu* menu)
 {
-	fl_menu* submenu = fl_create_pause_submenu(context);
+	fl_menu* submenu = fl_open_menu(context, FLURMP_MENU_PAUSE_SUBMENU, fl_create_pause_submenu);
 
 	fl_push_menu(context, submenu);
 	fl_push_input_handler(context, submenu->input_handler);
@@ -428,7 +417,7 @@ static void confirmation_action(fl_context* context, fl_menu* menu)
 
 static void confirm_menu(fl_context* context)
 {
-	fl_menu* confirm = fl_create_confirmation_menu(context);
+	fl_menu* confirm = fl_open_menu(context, FLURMP_MENU_CONFIRMATION, fl_create_confirmation_menu);
 
 	confirm->callback = confirm_cb;
 
@@ -454,21 +443,9 @@ static void info_cb_2(fl_context* context)
 
 static void confirm_cb(fl_context* context)
 {
-	/* Handle dialog destruction here, since the active
+	/* Close the dialog here, since the active
 	   dialog was marked as hold. */
-	if (context->active_dialog != NULL)
-	{
-		fl_dialog* dialog = context->active_dialog;
-
-		/* Clear the active dialog pointer. */
-		context->active_dialog = NULL;
-
-		/* Relenquish input control. */
-		fl_pop_input_handler(context);
-
-		/* Destroy the dialog. */
-		fl_destroy_dialog(dialog);
-	}
+	fl_close_dialog(context);
 
 	switch (context->ret_val)
 	{
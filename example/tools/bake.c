@@ -0,0 +1,255 @@
+/**
+ * Image bake tool.
+ *
+ * Converts BMP images into the format the engine uploads its textures
+ * in, so that loading them needs no conversion. The color key
+ * (255, 0, 255) becomes transparent and colors are premultiplied by
+ * their alpha. Each image is written next to the original with the
+ * .flimg extension, or with -qoi, as a QOI image with the .qoi
+ * extension:
+ *
+ *   flurmp_bake [-qoi] resources/images/person.bmp ...
+ *
+ * The engine loads a baked image in place of the BMP it was made from,
+ * so images must be baked again after the BMPs are edited.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+
+#include "core/image_format.h"
+#include "core/qoi.h"
+
+/**
+ * Writes a path with its extension replaced.
+ *
+ * Params:
+ *   char* - receives the new path
+ *   size_t - the size of the buffer for the new path
+ *   const char* - a path
+ *   const char* - the new extension, including the dot
+ *
+ * Returns:
+ *   int - 1 on success, or 0 if the new path is too long
+ */
+static int replace_extension(char* out, size_t n, const char* path, const char* extension)
+{
+	const char* dot = strrchr(path, '.');
+	size_t length = dot != NULL && strchr(dot, '/') == NULL ? (size_t)(dot - path) : strlen(path);
+
+	if (length + strlen(extension) >= n)
+		return 0;
+
+	memcpy(out, path, length);
+	strcpy(out + length, extension);
+
+	return 1;
+}
+
+/**
+ * Loads a BMP as RGBA8888 pixels with the color key made transparent.
+ *
+ * Params:
+ *   const char* - the path to the BMP
+ *   int* - receives the width
+ *   int* - receives the height
+ *
+ * Returns:
+ *   uint32_t* - the pixels with straight alpha, or NULL on failure
+ */
+static uint32_t* load_pixels(const char* path, int* w, int* h)
+{
+	int x;
+	int y;
+	uint32_t* pixels;
+	SDL_Surface* bmp = SDL_LoadBMP(path);
+	SDL_Surface* surface;
+
+	if (bmp == NULL)
+		return NULL;
+
+	surface = SDL_ConvertSurfaceFormat(bmp, SDL_PIXELFORMAT_RGBA8888, 0);
+	SDL_FreeSurface(bmp);
+
+	if (surface == NULL)
+		return NULL;
+
+	pixels = malloc(sizeof(uint32_t) * surface->w * surface->h);
+
+	if (pixels == NULL)
+	{
+		SDL_FreeSurface(surface);
+		return NULL;
+	}
+
+	for (y = 0; y < surface->h; y++)
+	{
+		const uint32_t* row = (const uint32_t*)((const unsigned char*)surface->pixels + y * surface->pitch);
+
+		for (x = 0; x < surface->w; x++)
+		{
+			uint32_t p = row[x];
+
+			/* The engine loads BMPs with this color keyed out. */
+			if ((p >> 8) == 0xff00ff)
+				p = 0;
+
+			pixels[y * surface->w + x] = p;
+		}
+	}
+
+	*w = surface->w;
+	*h = surface->h;
+	SDL_FreeSurface(surface);
+
+	return pixels;
+}
+
+/**
+ * Premultiplies RGBA8888 pixels by their alpha.
+ *
+ * Params:
+ *   uint32_t* - the pixels
+ *   size_t - the number of pixels
+ */
+static void premultiply(uint32_t* pixels, size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		uint32_t p = pixels[i];
+		uint32_t a = p & 0xff;
+		uint32_t r = ((p >> 24) * a + 127) / 255;
+		uint32_t g = (((p >> 16) & 0xff) * a + 127) / 255;
+		uint32_t b = (((p >> 8) & 0xff) * a + 127) / 255;
+
+		pixels[i] = (r << 24) | (g << 16) | (b << 8) | a;
+	}
+}
+
+/**
+ * Writes pixels as a baked image.
+ *
+ * Params:
+ *   const char* - the path to write to
+ *   uint32_t* - the pixels with straight alpha, which are premultiplied
+ *   int - the width
+ *   int - the height
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int write_baked(const char* path, uint32_t* pixels, int w, int h)
+{
+	fl_baked_header header;
+	FILE* out = fopen(path, "wb");
+
+	if (out == NULL)
+		return 0;
+
+	memcpy(header.magic, FLURMP_BAKED_MAGIC, 4);
+	header.version = FLURMP_BAKED_VERSION;
+	header.w = (uint32_t)w;
+	header.h = (uint32_t)h;
+
+	premultiply(pixels, (size_t)w * h);
+
+	fwrite(&header, sizeof(header), 1, out);
+	fwrite(pixels, sizeof(uint32_t), (size_t)w * h, out);
+
+	return fclose(out) == 0;
+}
+
+/**
+ * Writes pixels as a QOI image.
+ *
+ * Params:
+ *   const char* - the path to write to
+ *   const uint32_t* - the pixels with straight alpha
+ *   int - the width
+ *   int - the height
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int write_qoi(const char* path, const uint32_t* pixels, int w, int h)
+{
+	size_t size;
+	FILE* out;
+	unsigned char* data = malloc(FLURMP_QOI_MAX_SIZE(w, h));
+
+	if (data == NULL)
+		return 0;
+
+	size = fl_encode_qoi(pixels, w, h, data);
+	out = fopen(path, "wb");
+
+	if (out == NULL)
+	{
+		free(data);
+		return 0;
+	}
+
+	fwrite(data, 1, size, out);
+	free(data);
+
+	return fclose(out) == 0;
+}
+
+int main(int argc, char** argv)
+{
+	int i;
+	int qoi = 0;
+	int first = 1;
+
+	if (argc > 1 && !strcmp(argv[1], "-qoi"))
+	{
+		qoi = 1;
+		first = 2;
+	}
+
+	if (first >= argc)
+	{
+		fprintf(stderr, "usage: %s [-qoi] <image.bmp>...\n", argv[0]);
+		return 1;
+	}
+
+	for (i = first; i < argc; i++)
+	{
+		int w;
+		int h;
+		int ok;
+		char path[1024];
+		uint32_t* pixels;
+
+		if (!replace_extension(path, sizeof(path), argv[i], qoi ? FLURMP_QOI_EXTENSION : FLURMP_BAKED_EXTENSION))
+		{
+			fprintf(stderr, "path too long: %s\n", argv[i]);
+			return 1;
+		}
+
+		pixels = load_pixels(argv[i], &w, &h);
+
+		if (pixels == NULL)
+		{
+			fprintf(stderr, "cannot load %s: %s\n", argv[i], SDL_GetError());
+			return 1;
+		}
+
+		ok = qoi ? write_qoi(path, pixels, w, h) : write_baked(path, pixels, w, h);
+		free(pixels);
+
+		if (!ok)
+		{
+			fprintf(stderr, "cannot write %s\n", path);
+			return 1;
+		}
+
+		printf("%s -> %s\n", argv[i], path);
+	}
+
+	return 0;
+}
@@ -0,0 +1,388 @@
+/**
+ * Font bake tool.
+ *
+ * Renders the glyphs of a font at one size and in one set of colors
+ * into an atlas, so that the engine can load them without opening the
+ * TTF or rasterizing anything. Glyphs are rendered exactly as the
+ * engine renders them from the TTF. The atlas and the metrics are
+ * written next to the TTF, named after it and the size:
+ *
+ *   flurmp_bake_font resources/fonts/VeraMono.ttf 16 fafafaff 000000ff
+ *
+ * writes resources/fonts/VeraMono-16.flimg and VeraMono-16.flfont.
+ * Colors are given as RRGGBBAA. Glyphs are rendered on the background
+ * color if one is given, and blended otherwise. By default the
+ * printable ASCII characters are baked; -chars selects another range
+ * of code points.
+ *
+ * The engine only uses a bake made for the size and colors it asks
+ * for, so a font must be baked again when they change.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_ttf.h>
+
+#include "core/font_format.h"
+#include "core/image_format.h"
+
+/* width of the atlas; glyphs are packed on shelves down its height */
+#define ATLAS_WIDTH 256
+
+/* padding between glyphs, as in the atlas pages of the engine */
+#define GLYPH_PADDING 1
+
+#define DEFAULT_FIRST 0x20
+#define DEFAULT_LAST  0x7E
+
+/**
+ * A rendered glyph and its place in the atlas.
+ */
+typedef struct glyph {
+	unsigned int code;
+	SDL_Surface* surface;
+	int x;
+	int y;
+}glyph;
+
+/**
+ * Parses an RRGGBBAA color.
+ *
+ * Params:
+ *   const char* - the color
+ *   SDL_Color* - receives the color
+ *
+ * Returns:
+ *   int - 1 on success, or 0 if the color is malformed
+ */
+static int parse_color(const char* str, SDL_Color* color)
+{
+	unsigned long value;
+	char* end;
+
+	if (strlen(str) != 8)
+		return 0;
+
+	value = strtoul(str, &end, 16);
+
+	if (*end != '\0')
+		return 0;
+
+	color->r = (Uint8)(value >> 24);
+	color->g = (Uint8)(value >> 16);
+	color->b = (Uint8)(value >> 8);
+	color->a = (Uint8)value;
+
+	return 1;
+}
+
+/**
+ * Encodes a code point as a null terminated UTF-8 string.
+ *
+ * Params:
+ *   unsigned int - a code point
+ *   char* - a buffer with room for at least five bytes
+ */
+static void encode_utf8(unsigned int code, char* out)
+{
+	if (code < 0x80)
+	{
+		*out++ = (char)code;
+	}
+	else if (code < 0x800)
+	{
+		*out++ = (char)(0xC0 | (code >> 6));
+		*out++ = (char)(0x80 | (code & 0x3F));
+	}
+	else if (code < 0x10000)
+	{
+		*out++ = (char)(0xE0 | (code >> 12));
+		*out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (code & 0x3F));
+	}
+	else
+	{
+		*out++ = (char)(0xF0 | (code >> 18));
+		*out++ = (char)(0x80 | ((code >> 12) & 0x3F));
+		*out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (code & 0x3F));
+	}
+
+	*out = '\0';
+}
+
+/**
+ * Writes the atlas as a baked image, premultiplying it by its alpha.
+ *
+ * Params:
+ *   const char* - the path to write to
+ *   glyph* - the placed glyphs
+ *   int - the number of glyphs
+ *   int - the height of the atlas
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int write_atlas(const char* path, glyph* glyphs, int count, int h)
+{
+	int i;
+	int x;
+	int y;
+	fl_baked_header header;
+	FILE* out;
+	uint32_t* pixels = calloc((size_t)ATLAS_WIDTH * h, sizeof(uint32_t));
+
+	if (pixels == NULL)
+		return 0;
+
+	for (i = 0; i < count; i++)
+	{
+		SDL_Surface* s = glyphs[i].surface;
+
+		for (y = 0; y < s->h; y++)
+		{
+			const uint32_t* row = (const uint32_t*)((const unsigned char*)s->pixels + y * s->pitch);
+
+			for (x = 0; x < s->w; x++)
+			{
+				uint32_t p = row[x];
+				uint32_t a = p & 0xff;
+				uint32_t r = ((p >> 24) * a + 127) / 255;
+				uint32_t g = (((p >> 16) & 0xff) * a + 127) / 255;
+				uint32_t b = (((p >> 8) & 0xff) * a + 127) / 255;
+
+				pixels[(glyphs[i].y + y) * ATLAS_WIDTH + glyphs[i].x + x] = (r << 24) | (g << 16) | (b << 8) | a;
+			}
+		}
+	}
+
+	out = fopen(path, "wb");
+
+	if (out == NULL)
+	{
+		free(pixels);
+		return 0;
+	}
+
+	memcpy(header.magic, FLURMP_BAKED_MAGIC, 4);
+	header.version = FLURMP_BAKED_VERSION;
+	header.w = ATLAS_WIDTH;
+	header.h = (uint32_t)h;
+
+	fwrite(&header, sizeof(header), 1, out);
+	fwrite(pixels, sizeof(uint32_t), (size_t)ATLAS_WIDTH * h, out);
+	free(pixels);
+
+	return fclose(out) == 0;
+}
+
+/**
+ * Writes the metrics of the baked glyphs.
+ *
+ * Params:
+ *   const char* - the path to write to
+ *   fl_baked_font_header* - the header, which receives the glyph count
+ *   glyph* - the placed glyphs, sorted by code point
+ *   int - the number of glyphs
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int write_metrics(const char* path, fl_baked_font_header* header, glyph* glyphs, int count)
+{
+	int i;
+	FILE* out = fopen(path, "wb");
+
+	if (out == NULL)
+		return 0;
+
+	header->count = (uint32_t)count;
+	fwrite(header, sizeof(*header), 1, out);
+
+	for (i = 0; i < count; i++)
+	{
+		fl_baked_glyph entry;
+
+		entry.code = glyphs[i].code;
+		entry.x = (uint16_t)glyphs[i].x;
+		entry.y = (uint16_t)glyphs[i].y;
+		entry.w = (uint16_t)glyphs[i].surface->w;
+		entry.h = (uint16_t)glyphs[i].surface->h;
+
+		fwrite(&entry, sizeof(entry), 1, out);
+	}
+
+	return fclose(out) == 0;
+}
+
+int main(int argc, char** argv)
+{
+	int i;
+	int arg = 1;
+	int size;
+	int count = 0;
+	int shelf_x = 0;
+	int shelf_y = 0;
+	int shelf_h = 0;
+	unsigned int code;
+	unsigned int first = DEFAULT_FIRST;
+	unsigned int last = DEFAULT_LAST;
+	char base[1024];
+	char path[1100];
+	const char* dot;
+	SDL_Color fc;
+	SDL_Color bc = { 0, 0, 0, 0 };
+	int background;
+	TTF_Font* font;
+	glyph* glyphs;
+	fl_baked_font_header header;
+	int ok;
+
+	if (argc > 2 && !strcmp(argv[1], "-chars"))
+	{
+		if (sscanf(argv[2], "%x-%x", &first, &last) != 2 || first == 0 || last < first || last > 0x10FFFF)
+		{
+			fprintf(stderr, "-chars takes a range of hexadecimal code points, such as 20-7E\n");
+			return 1;
+		}
+
+		arg = 3;
+	}
+
+	if (argc - arg < 3 || argc - arg > 4 || (size = atoi(argv[arg + 1])) <= 0
+		|| !parse_color(argv[arg + 2], &fc)
+		|| (argc - arg == 4 && !parse_color(argv[arg + 3], &bc)))
+	{
+		fprintf(stderr, "usage: %s [-chars FIRST-LAST] <font.ttf> <size> <RRGGBBAA> [<RRGGBBAA>]\n", argv[0]);
+		return 1;
+	}
+
+	background = argc - arg == 4;
+
+	if (last - first + 1 > FLURMP_BAKED_GLYPH_LIMIT)
+	{
+		fprintf(stderr, "too many code points to bake\n");
+		return 1;
+	}
+
+	/* The outputs are named after the TTF and the size. */
+	dot = strrchr(argv[arg], '.');
+
+	if (dot == NULL || strchr(dot, '/') != NULL)
+		dot = argv[arg] + strlen(argv[arg]);
+
+	if ((size_t)(dot - argv[arg]) + 16 >= sizeof(base))
+	{
+		fprintf(stderr, "path too long: %s\n", argv[arg]);
+		return 1;
+	}
+
+	snprintf(base, sizeof(base), "%.*s-%d", (int)(dot - argv[arg]), argv[arg], size);
+
+	if (TTF_Init())
+	{
+		fprintf(stderr, "cannot initialize SDL_ttf: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	font = TTF_OpenFont(argv[arg], size);
+	glyphs = malloc(sizeof(glyph) * (last - first + 1));
+
+	if (font == NULL || glyphs == NULL)
+	{
+		fprintf(stderr, "cannot open %s: %s\n", argv[arg], SDL_GetError());
+		return 1;
+	}
+
+	for (code = first; code <= last; code++)
+	{
+		char str[5];
+		SDL_Surface* surface;
+
+		encode_utf8(code, str);
+
+		/* Render the glyph as fl_create_glyph_surface does. */
+		if (background)
+			surface = TTF_RenderUTF8_Shaded(font, str, fc, bc);
+		else
+			surface = TTF_RenderUTF8_Blended(font, str, fc);
+
+		if (surface == NULL)
+		{
+			fprintf(stderr, "skipping U+%04X: %s\n", code, SDL_GetError());
+			continue;
+		}
+
+		glyphs[count].code = code;
+		glyphs[count].surface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA8888, 0);
+		SDL_FreeSurface(surface);
+
+		if (glyphs[count].surface == NULL || glyphs[count].surface->w > ATLAS_WIDTH)
+		{
+			fprintf(stderr, "cannot bake U+%04X\n", code);
+			return 1;
+		}
+
+		/* Pack the glyphs on shelves, like the atlas pages of the engine. */
+		if (shelf_x + glyphs[count].surface->w > ATLAS_WIDTH)
+		{
+			shelf_y += shelf_h + GLYPH_PADDING;
+			shelf_x = 0;
+			shelf_h = 0;
+		}
+
+		glyphs[count].x = shelf_x;
+		glyphs[count].y = shelf_y;
+
+		shelf_x += glyphs[count].surface->w + GLYPH_PADDING;
+		if (glyphs[count].surface->h > shelf_h)
+			shelf_h = glyphs[count].surface->h;
+
+		count++;
+	}
+
+	if (count == 0 || shelf_y + shelf_h > FLURMP_IMAGE_SIZE_LIMIT)
+	{
+		fprintf(stderr, "nothing to bake, or too much for one atlas\n");
+		return 1;
+	}
+
+	memcpy(header.magic, FLURMP_BAKED_FONT_MAGIC, 4);
+	header.version = FLURMP_BAKED_FONT_VERSION;
+	header.size = (uint32_t)size;
+	header.forecolor[0] = fc.r;
+	header.forecolor[1] = fc.g;
+	header.forecolor[2] = fc.b;
+	header.forecolor[3] = fc.a;
+	header.backcolor[0] = bc.r;
+	header.backcolor[1] = bc.g;
+	header.backcolor[2] = bc.b;
+	header.backcolor[3] = bc.a;
+	header.background = (uint32_t)background;
+	header.reserved = 0;
+
+	snprintf(path, sizeof(path), "%s%s", base, FLURMP_BAKED_EXTENSION);
+	ok = write_atlas(path, glyphs, count, shelf_y + shelf_h);
+
+	if (ok)
+	{
+		snprintf(path, sizeof(path), "%s%s", base, FLURMP_BAKED_FONT_EXTENSION);
+		ok = write_metrics(path, &header, glyphs, count);
+	}
+
+	if (!ok)
+		fprintf(stderr, "cannot write %s\n", path);
+	else
+		printf("%s -> %s (%d glyphs, %dx%d atlas)\n", argv[arg], base, count, ATLAS_WIDTH, shelf_y + shelf_h);
+
+	for (i = 0; i < count; i++)
+		SDL_FreeSurface(glyphs[i].surface);
+
+	free(glyphs);
+	TTF_CloseFont(font);
+	TTF_Quit();
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+/**
+ * Asset pack tool.
+ *
+ * Builds an asset pack from every file found under a set of
+ * directories. Run it from the example directory so that the names
+ * in the pack match the paths the engine loads:
+ *
+ *   flurmp_pack resources.pack resources
+ *
+ * Hidden files are skipped. The tool doesn't depend on SDL, so it can
+ * be built and run before the dependencies are installed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "core/pack_format.h"
+
+/**
+ * A file to be put in the pack.
+ */
+typedef struct asset {
+	char name[FLURMP_PACK_NAME_LENGTH];
+	uint32_t offset;
+	uint32_t size;
+}asset;
+
+/**
+ * The files found so far.
+ */
+typedef struct asset_list {
+	asset* items;
+	int count;
+	int capacity;
+}asset_list;
+
+/**
+ * Adds a file to a list of assets, growing the list as needed.
+ *
+ * Params:
+ *   asset_list - a list of assets
+ *   const char* - the path to the file
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int add_asset(asset_list* list, const char* path)
+{
+	if (strlen(path) >= FLURMP_PACK_NAME_LENGTH)
+	{
+		fprintf(stderr, "name too long for a pack: %s\n", path);
+		return 0;
+	}
+
+	if (list->count >= list->capacity)
+	{
+		int capacity = list->capacity ? list->capacity * 2 : 32;
+		asset* items = realloc(list->items, sizeof(asset) * capacity);
+
+		if (items == NULL)
+			return 0;
+
+		list->items = items;
+		list->capacity = capacity;
+	}
+
+	memset(&(list->items[list->count]), 0, sizeof(asset));
+	strcpy(list->items[list->count].name, path);
+	list->count++;
+
+	return 1;
+}
+
+/**
+ * Adds every file under a directory to a list of assets.
+ *
+ * Params:
+ *   asset_list - a list of assets
+ *   const char* - the path to the directory
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int add_directory(asset_list* list, const char* dir)
+{
+	DIR* d = opendir(dir);
+	struct dirent* e;
+	int ok = 1;
+
+	if (d == NULL)
+	{
+		fprintf(stderr, "cannot open %s\n", dir);
+		return 0;
+	}
+
+	while (ok && (e = readdir(d)) != NULL)
+	{
+		char path[1024];
+		struct stat st;
+
+		if (e->d_name[0] == '.')
+			continue;
+
+		snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+
+		if (stat(path, &st))
+			continue;
+
+		if (S_ISDIR(st.st_mode))
+			ok = add_directory(list, path);
+		else if (S_ISREG(st.st_mode))
+			ok = add_asset(list, path);
+	}
+
+	closedir(d);
+
+	return ok;
+}
+
+static int compare_assets(const void* a, const void* b)
+{
+	return strcmp(((const asset*)a)->name, ((const asset*)b)->name);
+}
+
+/**
+ * Writes zeros until a file position is a multiple of the pack alignment.
+ *
+ * Params:
+ *   FILE* - the pack being written
+ *   long - the current position
+ *
+ * Returns:
+ *   long - the aligned position
+ */
+static long pad(FILE* out, long pos)
+{
+	while (pos % FLURMP_PACK_ALIGNMENT)
+	{
+		fputc(0, out);
+		pos++;
+	}
+
+	return pos;
+}
+
+/**
+ * Copies a file to the end of the pack.
+ *
+ * Params:
+ *   FILE* - the pack being written
+ *   asset - the file, which receives its size
+ *
+ * Returns:
+ *   int - 1 on success or 0 on failure
+ */
+static int copy_asset(FILE* out, asset* a)
+{
+	char buffer[8192];
+	size_t n;
+	unsigned long size = 0;
+	FILE* in = fopen(a->name, "rb");
+
+	if (in == NULL)
+	{
+		fprintf(stderr, "cannot read %s\n", a->name);
+		return 0;
+	}
+
+	while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+	{
+		if (fwrite(buffer, 1, n, out) != n)
+		{
+			fclose(in);
+			return 0;
+		}
+
+		size += n;
+	}
+
+	fclose(in);
+	a->size = (uint32_t)size;
+
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+	int i;
+	long pos;
+	FILE* out;
+	fl_pack_header header;
+	asset_list list = { NULL, 0, 0 };
+
+	if (argc < 3)
+	{
+		fprintf(stderr, "usage: %s <pack> <directory>...\n", argv[0]);
+		return 1;
+	}
+
+	for (i = 2; i < argc; i++)
+	{
+		if (!add_directory(&list, argv[i]))
+			return 1;
+	}
+
+	/* The engine searches the index by name. */
+	qsort(list.items, list.count, sizeof(asset), compare_assets);
+
+	out = fopen(argv[1], "wb");
+
+	if (out == NULL)
+	{
+		fprintf(stderr, "cannot write %s\n", argv[1]);
+		return 1;
+	}
+
+	memcpy(header.magic, FLURMP_PACK_MAGIC, 4);
+	header.version = FLURMP_PACK_VERSION;
+	header.count = (uint32_t)list.count;
+	header.reserved = 0;
+
+	/* Write the contents after room for the index,
+	   then go back and write the index. */
+	pos = (long)(sizeof(fl_pack_header) + sizeof(fl_pack_entry) * list.count);
+	fseek(out, pos, SEEK_SET);
+
+	for (i = 0; i < list.count; i++)
+	{
+		pos = pad(out, pos);
+		list.items[i].offset = (uint32_t)pos;
+
+		if (!copy_asset(out, &(list.items[i])))
+		{
+			fclose(out);
+			remove(argv[1]);
+			return 1;
+		}
+
+		pos += (long)list.items[i].size;
+	}
+
+	fseek(out, 0, SEEK_SET);
+	fwrite(&header, sizeof(header), 1, out);
+
+	for (i = 0; i < list.count; i++)
+	{
+		fl_pack_entry entry;
+
+		memcpy(entry.name, list.items[i].name, FLURMP_PACK_NAME_LENGTH);
+		entry.offset = list.items[i].offset;
+		entry.size = list.items[i].size;
+		fwrite(&entry, sizeof(entry), 1, out);
+	}
+
+	if (fclose(out))
+	{
+		fprintf(stderr, "cannot write %s\n", argv[1]);
+		return 1;
+	}
+
+	printf("packed %d assets, %ld bytes\n", list.count, pos);
+	free(list.items);
+
+	return 0;
+}
@@ -72,8 +72,9 @@ typedef struct fl_context fl_context;
  * Three principal operations should be performed on each entity
  * during each iteration of the main loop:
  * 1. update: change the current state of the entity
- * 2. collide: handle collisions with other entities
- * 3. render: draw the entity to the screen
+ * 2. move: integrate the entity's body, if its type has one
+ * 3. collide: handle collisions with other entities
+ * 4. render: draw the entity to the screen
  *
  * An entity whose state never changes during an update is said to
  * be inert (e.g. a static piece of ground on which the player stands).
@@ -83,6 +84,14 @@ typedef struct fl_context fl_context;
  */
 typedef struct fl_entity fl_entity;
 
+/**
+ * A reference to an entity that remains safe to hold after the entity
+ * is gone. A handle names a slot in the context's entity table along
+ * with the generation of the slot when the entity was added. Removing
+ * the entity advances the generation, so old handles no longer resolve.
+ */
+typedef struct fl_handle fl_handle;
+
 /**
  * An entity type contains information common to all entities of
  * a particular category.
@@ -175,6 +184,14 @@ typedef struct fl_data_panel fl_data_panel;
  */
 typedef struct fl_animation fl_animation;
 
+/**
+ * A body type describes how the entities of a type move: how gravity
+ * pulls them and how friction slows them. Entities of a type with a
+ * body type are moved together with every other body in the context,
+ * rather than each moving itself in its update.
+ */
+typedef struct fl_body_type fl_body_type;
+
 /**
  * A schedule is an action or series of actions to that take place over
  * the course of a specified number of iterations of the main loop.
@@ -262,6 +279,70 @@ void fl_destroy_context(fl_context* context);
  */
 void fl_add_entity(fl_context* context, fl_entity* entity);
 
+/**
+ * Finds the entity referred to by a handle.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_handle - a handle to an entity
+ *
+ * Returns:
+ *   fl_entity - the entity, or NULL if it has been removed
+ */
+fl_entity* fl_get_entity(fl_context* context, fl_handle handle);
+
+/**
+ * Removes an entity from the current context.
+ * Handles to the entity stop resolving immediately, but its memory
+ * is only reclaimed when the context next compacts its entities,
+ * so this is safe to call while entities are being updated.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_handle - a handle to an entity
+ */
+void fl_despawn_entity(fl_context* context, fl_handle handle);
+
+/**
+ * Requests that an entity be added to the current context at the end
+ * of the update. Entity callbacks should use this instead of
+ * fl_add_entity. The handle resolves immediately, but the entity is
+ * neither updated nor rendered until it has been added.
+ * The context takes ownership of the entity, unless the request fails.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_entity - an entity
+ *
+ * Returns:
+ *   fl_handle - a handle to the entity, or a null handle on failure
+ */
+fl_handle fl_queue_spawn(fl_context* context, fl_entity* entity);
+
+/**
+ * Requests that an entity be removed from the current context at the
+ * end of the update. Unlike fl_despawn_entity, handles to the entity
+ * keep resolving until then, so every callback in the update sees the
+ * same set of entities.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_handle - a handle to an entity
+ */
+void fl_queue_despawn(fl_context* context, fl_handle handle);
+
+/**
+ * Requests that an entity become an entity of another type at the end
+ * of the update. The entity keeps its handle, position and velocity,
+ * but loses its animator.
+ *
+ * Params:
+ *   fl_context - a Flurmp context
+ *   fl_handle - a handle to an entity
+ *   int - the new entity type
+ */
+void fl_queue_type_change(fl_context* context, fl_handle handle, int type);
+
 /**
  * Determines if two entities have collided.
  *